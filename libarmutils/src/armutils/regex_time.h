@@ -39,6 +39,19 @@
  */
 /*@{*/
 
+/**
+ *  Compiled fast path scanner step for a regex/time pattern.
+ */
+typedef struct {
+
+    char         code;      /**< time format code, or 0 for a literal      */
+    char         chr;       /**< literal character, '.' matches any char   */
+    char         min;       /**< minimum number of digits                  */
+    char         max;       /**< maximum number of digits (0 = no limit)   */
+    char         frac;      /**< optional fractional part allowed          */
+
+} RETimeStep;
+
 /**
  *  Regular Expression with Time Format Codes.
  */
@@ -51,6 +64,9 @@ typedef struct {
     regex_t      preg;      /**< compiled regular expression          */
     int          flags;     /**< reserved for control flags           */
 
+    int          nsteps;    /**< number of fast path scanner steps    */
+    RETimeStep  *steps;     /**< fast path scanner, NULL if the
+                                 pattern requires the regex           */
 } RETime;
 
 /**
@@ -212,6 +212,459 @@ static int __retime_parse(RETime *retime, const char *pattern)
     return(1);
 }
 
+/**
+ *  PRIVATE: Compile the fast path scanner for a regex/time pattern.
+ *
+ *  Most time string patterns used in practice contain only time format codes
+ *  and plain literal characters (i.e. '%Y-%m-%d %H:%M:%S'). These patterns
+ *  can be matched by scanning the digits directly instead of running the
+ *  regular expression on every string. This function builds the list of
+ *  scanner steps for such patterns.
+ *
+ *  The scanner is only used for patterns that have exactly one way to match
+ *  a string starting at the first character. Patterns containing regex
+ *  special characters, or variable width fields that are not followed by a
+ *  terminating literal character or whitespace, are left to the regular
+ *  expression.
+ *
+ *  @param  retime   pointer to the RETime structure to use.
+ *  @param  pattern  the time string pattern
+ *
+ *  @retval  1  if succesful, or the pattern requires the regex
+ *  @retval  0  if a memory allocation error occurred
+ */
+static int __retime_compile_fast(RETime *retime, const char *pattern)
+{
+    RETimeStep *steps;
+    RETimeStep *step;
+    RETimeStep *next;
+    const char *sp;
+    int         nsteps;
+    int         zero;
+    int         si;
+
+    steps = calloc(strlen(pattern) + 1, sizeof(RETimeStep));
+    if (!steps) return(0);
+
+    nsteps = 0;
+
+    for (sp = pattern; *sp != '\0'; ++sp) {
+
+        step = &steps[nsteps++];
+
+        if (*sp != '%') {
+
+            if (strchr("[]{}()*+?^$|\\", *sp)) {
+                free(steps);
+                return(1);
+            }
+
+            step->chr = *sp;
+            continue;
+        }
+
+        ++sp;
+
+        zero = 0;
+        if (*sp == '0') {
+            zero = 1;
+            ++sp;
+        }
+
+        step->code = *sp;
+        step->min  = (zero) ? 0 : 1;
+
+        switch (*sp) {
+            case 'C': step->min = 2; step->max = 2; break;
+            case 'd':
+            case 'e':
+            case 'H':
+            case 'm':
+            case 'M':
+            case 'y': step->max = 2; break;
+            case 'h': step->max = 4; break;
+            case 'j': step->max = 3; break;
+            case 'Y': step->min = 4; step->max = 4; break;
+            case 'q':
+            case 's': step->min = 1; step->frac = !zero; break;
+            case 'S': step->max = 2; step->frac = !zero; break;
+            case 'n':
+            case 't': break;
+            case '%': step->code = 0; step->chr = '%'; break;
+            default:
+                /* invalid codes are reported by __retime_parse() */
+                free(steps);
+                return(1);
+        }
+
+        if (zero && step->max) step->min = step->max;
+    }
+
+    /* Make sure every variable width field is terminated by a literal
+     * character that can not be part of the field itself. */
+
+    for (si = 0; si < nsteps; ++si) {
+
+        step = &steps[si];
+        if (!step->code) continue;
+
+        next = (si + 1 < nsteps) ? &steps[si + 1] : NULL;
+
+        if (step->code == 'n' || step->code == 't') {
+
+            if (!next) continue;
+
+            if (next->code == 'n' || next->code == 't' ||
+                (!next->code &&
+                 (next->chr == '.' || isspace((unsigned char)next->chr)))) {
+
+                free(steps);
+                return(1);
+            }
+        }
+        else if (step->min != step->max || step->frac) {
+
+            if (!next) continue;
+
+            if (next->code == 'n' || next->code == 't') continue;
+
+            if (next->code || next->chr == '.' ||
+                isdigit((unsigned char)next->chr)) {
+
+                free(steps);
+                return(1);
+            }
+        }
+    }
+
+    retime->steps  = steps;
+    retime->nsteps = nsteps;
+
+    return(1);
+}
+
+/**
+ *  PRIVATE: Clear the results of a previous regex/time pattern match.
+ *
+ *  @param  res  pointer to the RETimeRes structure
+ */
+static void __retime_clear_res(RETimeRes *res)
+{
+    res->year       = -1;
+    res->month      = -1;
+    res->mday       = -1;
+    res->hour       = -1;
+    res->min        = -1;
+    res->sec        = -1;
+    res->usec       = -1;
+    res->century    = -1;
+    res->yy         = -1;
+    res->yday       = -1;
+    res->hhmm       = -1;
+    res->secs1970   = -1;
+    res->tv.tv_sec  = -1;
+    res->tv.tv_usec = -1;
+}
+
+/**
+ *  PRIVATE: Get the microseconds from a fractional seconds string.
+ *
+ *  @param  chrp  pointer to the '.' character in the substring
+ *
+ *  @return  the microseconds, 1000000 if the value rounds up
+ */
+static int __retime_frac_to_usec(const char *chrp)
+{
+    return((int)(atof(chrp) * 1.0E6 + 0.5));
+}
+
+/**
+ *  PRIVATE: Match a string using the fast path scanner.
+ *
+ *  The scanner only matches strings starting at the first character.
+ *  A return value of 0 means the regular expression must be used to
+ *  determine if the string matches the pattern.
+ *
+ *  @param  retime  pointer to the compiled RETime structure
+ *  @param  string  string to compare with the pattern
+ *  @param  res     pointer to the structure to store the results
+ *
+ *  @retval  1  if match
+ *  @retval  0  if the scanner could not match the string
+ */
+static int __retime_execute_fast(
+    RETime     *retime,
+    const char *string,
+    RETimeRes  *res)
+{
+    char        substr[RETIME_MAX_SUBSTR_LENGTH];
+    RETimeStep *step;
+    const char *cp;
+    const char *start;
+    const char *dot;
+    long long   value;
+    int         ndigits;
+    int         length;
+    int         usec;
+    int         si, mi;
+
+    cp = string;
+    mi = 0;
+
+    for (si = 0; si < retime->nsteps; ++si) {
+
+        step = &retime->steps[si];
+
+        if (!step->code) {
+            if (*cp == '\0') return(0);
+            if (step->chr != '.' && step->chr != *cp) return(0);
+            ++cp;
+            continue;
+        }
+
+        if (step->code == 'n' || step->code == 't') {
+            if (!isspace((unsigned char)*cp)) return(0);
+            while (isspace((unsigned char)*cp)) ++cp;
+            continue;
+        }
+
+        /* Scan the digits */
+
+        start   = cp;
+        value   = 0;
+        ndigits = 0;
+
+        while (isdigit((unsigned char)*cp) &&
+               (!step->max || ndigits < step->max)) {
+
+            if (ndigits == 18) return(0);
+
+            value = value * 10 + (*cp - '0');
+            ++ndigits;
+            ++cp;
+        }
+
+        if (ndigits < step->min) return(0);
+
+        /* Scan the optional fractional seconds */
+
+        dot  = NULL;
+        usec = -1;
+
+        if (step->frac && *cp == '.' && isdigit((unsigned char)cp[1])) {
+
+            dot = cp++;
+            while (isdigit((unsigned char)*cp)) ++cp;
+
+            length = cp - dot;
+            if (length >= RETIME_MAX_SUBSTR_LENGTH) return(0);
+
+            strncpy(substr, dot, length);
+            substr[length] = '\0';
+
+            usec = __retime_frac_to_usec(substr);
+        }
+
+        if (cp - start >= RETIME_MAX_SUBSTR_LENGTH) return(0);
+
+        ++mi;
+        res->pmatch[mi].rm_so = start - string;
+        res->pmatch[mi].rm_eo = cp    - string;
+
+        switch (step->code) {
+
+            case 'C': res->century = (int)value; break;
+            case 'd':
+            case 'e': res->mday    = (int)value; break;
+            case 'h': res->hhmm    = (int)value; break;
+            case 'H': res->hour    = (int)value; break;
+            case 'j': res->yday    = (int)value; break;
+            case 'm': res->month   = (int)value; break;
+            case 'M': res->min     = (int)value; break;
+            case 'y': res->yy      = (int)value; break;
+            case 'Y': res->year    = (int)value; break;
+
+            case 'q':
+            case 's':
+            case 'S':
+
+                if (step->code == 'q') {
+                    res->secs1970 = (time_t)(value - 2082844800LL);
+                }
+                else if (value > INT_MAX) {
+                    return(0);
+                }
+                else if (step->code == 's') {
+                    res->secs1970 = (time_t)value;
+                }
+                else {
+                    res->sec = (int)value;
+                }
+
+                if (dot) {
+                    res->usec = usec;
+                    if (res->usec == 1.0E6) {
+                        if (step->code == 'S') res->sec      += 1;
+                        else                   res->secs1970 += 1;
+                        res->usec = 0;
+                    }
+                }
+
+                break;
+
+            default:
+                return(0);
+        }
+    }
+
+    res->pmatch[0].rm_so = 0;
+    res->pmatch[0].rm_eo = cp - string;
+
+    return(1);
+}
+
+/**
+ *  PRIVATE: Match a string using the regular expression.
+ *
+ *  @param  retime  pointer to the compiled RETime structure
+ *  @param  string  string to compare with the regular expression
+ *  @param  res     pointer to the structure to store the results
+ *
+ *  @retval  1  if match
+ *  @retval  0  if no match
+ *  @retval -1  if an error occurred
+ */
+static int __retime_execute_regex(
+    RETime     *retime,
+    const char *string,
+    RETimeRes  *res)
+{
+    regex_t    *preg     = &(retime->preg);
+    size_t      nsubs    = retime->nsubs;
+    regmatch_t *pmatch   = res->pmatch;
+    size_t      nmatch   = nsubs + 1;
+
+    char        substr[RETIME_MAX_SUBSTR_LENGTH];
+    int         status;
+    int         length;
+    char       *chrp;
+    size_t      mi;
+
+    /* Check for match */
+
+    status = re_execute(preg, string, nmatch, pmatch, 0);
+    if (status  < 0) return(-1);
+    if (status == 0) return (0);
+
+    /* Set the results in the RETimeRes structure */
+
+    for (mi = 1; mi < nmatch; mi++) {
+
+        if (pmatch[mi].rm_so == -1) return(0);
+
+        length = pmatch[mi].rm_eo - pmatch[mi].rm_so;
+
+        if (length >= RETIME_MAX_SUBSTR_LENGTH) {
+
+            ERROR( ARMUTILS_LIB_NAME,
+                "Invalid time string: '%s'\n"
+                " -> length of subexpression '%d' exceeds the maximum substring length '%d'\n",
+                string, mi, RETIME_MAX_SUBSTR_LENGTH);
+
+            return(-1);
+        }
+
+        strncpy(substr, (string + pmatch[mi].rm_so), length);
+        substr[length] = '\0';
+
+        switch (retime->codes[mi]) {
+
+            case 'C': // century number (year/100) as a 2-digit integer
+                res->century = atoi(substr);
+                break;
+            case 'd': // day number in the month (1-31).
+            case 'e': // day number in the month (1-31).
+                res->mday = atoi(substr);
+                break;
+            case 'h': // hour * 100 + minute (0-2400; 2400 is used by CDLs)
+                res->hhmm = atoi(substr);
+                break;
+            case 'H': // hour (0-23)
+                res->hour = atoi(substr);
+                break;
+            case 'j': // day number in the year (1-366).
+                res->yday = atoi(substr);
+                break;
+            case 'm': // month number (1-12)
+                res->month = atoi(substr);
+                break;
+            case 'M': // minute (0-59)
+                res->min = atoi(substr);
+                break;
+            case 'q': // seconds since Epoch, 1904-01-01 00:00:00 +0000 (UTC)
+
+                res->secs1970 = (time_t)(atoll(substr) - 2082844800LL);
+
+                chrp = strchr(substr, '.');
+                if (chrp) {
+                    res->usec = __retime_frac_to_usec(chrp);
+                    if (res->usec == 1.0E6) {
+                        res->secs1970 += 1;
+                        res->usec      = 0;
+                    }
+                }
+
+                break;
+
+            case 's': // seconds since Epoch, 1970-01-01 00:00:00 +0000 (UTC)
+
+                res->secs1970 = atoi(substr);
+
+                chrp = strchr(substr, '.');
+                if (chrp) {
+                    res->usec = __retime_frac_to_usec(chrp);
+                    if (res->usec == 1.0E6) {
+                        res->secs1970 += 1;
+                        res->usec      = 0;
+                    }
+                }
+
+                break;
+
+            case 'S': // second (0-60; 60 may occur for leap seconds)
+
+                res->sec = atoi(substr);
+
+                chrp = strchr(substr, '.');
+                if (chrp) {
+                    res->usec = __retime_frac_to_usec(chrp);
+                    if (res->usec == 1.0E6) {
+                        res->sec  += 1;
+                        res->usec  = 0;
+                    }
+                }
+
+                break;
+            case 'y': // year within century (0-99)
+                res->yy = atoi(substr);
+                break;
+            case 'Y': // year with century as a 4-digit integer
+                res->year = atoi(substr);
+                break;
+            default:
+
+                ERROR( ARMUTILS_LIB_NAME,
+                    "Internal error in retime_execute() function\n"
+                    " -> unsupported match code found: '%c'\n",
+                    retime->codes[mi]);
+
+                return(-1);
+        }
+    }
+
+    return(1);
+}
+
 /*******************************************************************************
  *  Public Functions
  */
@@ -248,6 +701,11 @@ static int __retime_parse(RETime *retime, const char *pattern)
  *
  *  See the regex(7) man page for the descriptions of the regex patterns.
  *
+ *  Patterns that only contain time format codes and literal characters are
+ *  also compiled into a simple digit scanner. The scanner is tried first by
+ *  retime_execute(), and the regular expression is only used for strings
+ *  the scanner can not match.
+ *
  *  The memory used by the returned RETime structure is dynamically allocated
  *  and must be freed by the calling process using the retime_free() function.
  *
@@ -295,6 +753,10 @@ RETime *retime_compile(const char *pattern, int flags)
         return((RETime *)NULL);
     }
 
+    /* Build the fast path scanner if the pattern allows it */
+
+    if (!__retime_compile_fast(retime, pattern)) goto MEMORY_ERROR;
+
     /* Compile the regular expression */
 
     preg = &(retime->preg);
@@ -386,144 +848,24 @@ MEMORY_ERROR:
  */
 int retime_execute(RETime *retime, const char *string, RETimeRes *res)
 {
-    regex_t    *preg     = &(retime->preg);
-    size_t      nsubs    = retime->nsubs;
-    regmatch_t *pmatch   = res->pmatch;
-    size_t      nmatch   = nsubs + 1;
-
-    char        substr[RETIME_MAX_SUBSTR_LENGTH];
-    int         status;
-    int         length;
-    char       *chrp;
-    size_t      mi;
+    int status;
 
     /* Clear previous result */
 
-    res->year       = -1;
-    res->month      = -1;
-    res->mday       = -1;
-    res->hour       = -1;
-    res->min        = -1;
-    res->sec        = -1;
-    res->usec       = -1;
-    res->century    = -1;
-    res->yy         = -1;
-    res->yday       = -1;
-    res->hhmm       = -1;
-    res->secs1970   = -1;
-    res->tv.tv_sec  = -1;
-    res->tv.tv_usec = -1;
+    __retime_clear_res(res);
 
     /* Check for match */
 
-    status = re_execute(preg, string, nmatch, pmatch, 0);
-    if (status  < 0) return(-1);
-    if (status == 0) return (0);
-
-    /* Set the results in the RETimeRes structure */
-
-    for (mi = 1; mi < nmatch; mi++) {
-
-        if (pmatch[mi].rm_so == -1) return(0);
-
-        length = pmatch[mi].rm_eo - pmatch[mi].rm_so;
-
-        if (length >= RETIME_MAX_SUBSTR_LENGTH) {
-
-            ERROR( ARMUTILS_LIB_NAME,
-                "Invalid time string: '%s'\n"
-                " -> length of subexpression '%d' exceeds the maximum substring length '%d'\n",
-                string, mi, RETIME_MAX_SUBSTR_LENGTH);
-
-            return(-1);
-        }
-
-        strncpy(substr, (string + pmatch[mi].rm_so), length);
-        substr[length] = '\0';
-
-        switch (retime->codes[mi]) {
-
-            case 'C': // century number (year/100) as a 2-digit integer
-                res->century = atoi(substr);
-                break;
-            case 'd': // day number in the month (1-31).
-            case 'e': // day number in the month (1-31).
-                res->mday = atoi(substr);
-                break;
-            case 'h': // hour * 100 + minute (0-2400; 2400 is used by CDLs)
-                res->hhmm = atoi(substr);
-                break;
-            case 'H': // hour (0-23)
-                res->hour = atoi(substr);
-                break;
-            case 'j': // day number in the year (1-366).
-                res->yday = atoi(substr);
-                break;
-            case 'm': // month number (1-12)
-                res->month = atoi(substr);
-                break;
-            case 'M': // minute (0-59)
-                res->min = atoi(substr);
-                break;
-            case 'q': // seconds since Epoch, 1904-01-01 00:00:00 +0000 (UTC)
-
-                res->secs1970 = (time_t)(atoll(substr) - 2082844800LL);
-
-                chrp = strchr(substr, '.');
-                if (chrp) {
-                    res->usec = (int)(atof(chrp) * 1.0E6 + 0.5);
-                    if (res->usec == 1.0E6) {
-                        res->secs1970 += 1;
-                        res->usec      = 0;
-                    }
-                }
-
-                break;
-
-            case 's': // seconds since Epoch, 1970-01-01 00:00:00 +0000 (UTC)
-
-                res->secs1970 = atoi(substr);
-
-                chrp = strchr(substr, '.');
-                if (chrp) {
-                    res->usec = (int)(atof(chrp) * 1.0E6 + 0.5);
-                    if (res->usec == 1.0E6) {
-                        res->secs1970 += 1;
-                        res->usec      = 0;
-                    }
-                }
-
-                break;
-
-            case 'S': // second (0-60; 60 may occur for leap seconds)
-
-                res->sec = atoi(substr);
-
-                chrp = strchr(substr, '.');
-                if (chrp) {
-                    res->usec = (int)(atof(chrp) * 1.0E6 + 0.5);
-                    if (res->usec == 1.0E6) {
-                        res->sec  += 1;
-                        res->usec  = 0;
-                    }
-                }
+    status = 0;
 
-                break;
-            case 'y': // year within century (0-99)
-                res->yy = atoi(substr);
-                break;
-            case 'Y': // year with century as a 4-digit integer
-                res->year = atoi(substr);
-                break;
-            default:
-
-                ERROR( ARMUTILS_LIB_NAME,
-                    "Internal error in retime_execute() function\n"
-                    " -> unsupported match code found: '%c'\n",
-                    retime->codes[mi]);
+    if (retime->steps) {
+        status = __retime_execute_fast(retime, string, res);
+        if (!status) __retime_clear_res(res);
+    }
 
-                return(-1);
-        }
+    if (!status) {
+        status = __retime_execute_regex(retime, string, res);
+        if (status <= 0) return(status);
     }
 
     /* Verify ranges and compute missing values where possible */
@@ -592,6 +934,7 @@ void retime_free(RETime *retime)
         if (retime->tspattern) free(retime->tspattern);
         if (retime->codes)     free(retime->codes);
         if (retime->pattern)   free(retime->pattern);
+        if (retime->steps)     free(retime->steps);
         regfree(&(retime->preg));
         free(retime);
     }
@@ -614,23 +957,48 @@ void retime_free(RETime *retime)
  */
 time_t retime_get_secs1970(RETimeRes *res)
 {
-    struct tm tm_time;
-
-    memset(&tm_time, 0, sizeof(struct tm));
+    long long year;
+    long long month;
+    long long nyears;
+    long long era;
+    long long yoe;
+    long long doy;
+    long long days;
 
     if (res->secs1970 == -1) {
 
         if (res->year == -1) return(-1);
 
-        tm_time.tm_year = res->year - 1900;
+        /* Use the same defaults and normalization as timegm() would
+         * with a zeroed struct tm: January if the month is not set,
+         * day 0 (the last day of the previous month) if the day is
+         * not set, and out of range months roll into the year. */
+
+        year  = res->year;
+        month = (res->month != -1) ? res->month - 1 : 0;
+
+        if (month < 0 || month > 11) {
+            nyears = (month < 0) ? -((11 - month) / 12) : month / 12;
+            year  += nyears;
+            month -= nyears * 12;
+        }
+
+        /* Days since 1970-01-01 for the first day of the month */
+
+        if (month < 2) year -= 1;
+
+        era  = (year >= 0 ? year : year - 399) / 400;
+        yoe  = year - era * 400;
+        doy  = (153 * (month + ((month < 2) ? 10 : -2)) + 2) / 5;
+        days = era * 146097 + yoe * 365 + yoe/4 - yoe/100 + doy - 719468;
 
-        if (res->month != -1) tm_time.tm_mon  = res->month - 1;
-        if (res->mday  != -1) tm_time.tm_mday = res->mday;
-        if (res->hour  != -1) tm_time.tm_hour = res->hour;
-        if (res->min   != -1) tm_time.tm_min  = res->min;
-        if (res->sec   != -1) tm_time.tm_sec  = res->sec;
+        if (res->mday != -1) days += res->mday - 1;
+        else                 days -= 1;
 
-        res->secs1970 = timegm(&tm_time);
+        res->secs1970 = (time_t)(days * 86400
+                      + ((res->hour != -1) ? res->hour * 3600 : 0)
+                      + ((res->min  != -1) ? res->min  * 60   : 0)
+                      + ((res->sec  != -1) ? res->sec         : 0));
     }
 
     return(res->secs1970);
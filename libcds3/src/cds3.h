@@ -231,10 +231,14 @@ struct CDSGroup {
     CDSVarGroup **vargroups;    /**< array of variable group pointers */
 
     void         *transform_params; /**< transformation parameters          */
+
+    void         *obj_index;    /**< name index of the child objects  */
+    void         *arena;        /**< definition arena (root group)    */
 };
 
 CDSGroup   *cds_define_group(CDSGroup *parent, const char *name);
 int         cds_delete_group(CDSGroup *group);
+int         cds_enable_arena(CDSGroup *group);
 CDSGroup   *cds_get_group   (CDSGroup *parent, const char *name);
 int         cds_rename_group(CDSGroup *group, const char *name);
 
@@ -418,6 +422,10 @@ struct CDSVar {
     /* default fill value */
 
     void        *default_fill;   /**< default fill value                 */
+
+    /* attribute name index */
+
+    void        *obj_index;      /**< name index of the attributes       */
 };
 
 CDSVar *cds_define_var(
@@ -1103,6 +1111,11 @@ int     cds_get_unit_converter(
             const char       *to_units,
             CDSUnitConverter *converter);
 
+void    cds_get_unit_converter_stats(
+            size_t *hits,
+            size_t *misses,
+            size_t *nentries);
+
 int     cds_init_unit_system(const char *xml_db_path);
 
 int     cds_map_symbol_to_unit(const char *symbol, const char *unit_name);
@@ -1206,6 +1219,26 @@ int    *cds_qc_limit_checks(
             int          max_flag,
             int         *qc_flags);
 
+int    *cds_qc_limit_delta_checks(
+            CDSDataType  data_type,
+            size_t       ndims,
+            size_t      *dim_lengths,
+            void        *data_vp,
+            size_t       nmissings,
+            void        *missings_vp,
+            int          missing_flag,
+            void        *min_vp,
+            int          min_flag,
+            void        *max_vp,
+            int          max_flag,
+            size_t       ndeltas,
+            void        *deltas_vp,
+            int          delta_flag,
+            void        *prev_sample_vp,
+            int         *prev_qc_flags,
+            int          bad_flags,
+            int         *qc_flags);
+
 int    *cds_qc_time_offset_checks(
             CDSDataType  data_type,
             size_t       noffsets,
@@ -0,0 +1,495 @@
+/*******************************************************************************
+*
+*  COPYRIGHT (C) 2010 Battelle Memorial Institute.  All Rights Reserved.
+*
+********************************************************************************
+*
+*  Author:
+*     name:  Brian Ermold
+*     phone: (509) 375-2277
+*     email: brian.ermold@pnl.gov
+*
+********************************************************************************
+*
+*  REPOSITORY INFORMATION:
+*    $Revision$
+*    $Author$
+*    $Date$
+*
+********************************************************************************
+*
+*  NOTE: DOXYGEN is used to generate documentation for this file.
+*
+*******************************************************************************/
+
+/** @file cds_arena.c
+ *  CDS Definition Arenas.
+ *
+ *  When an arena has been enabled for a root group (see cds_enable_arena()),
+ *  the object structures, names, child object arrays, variable dimension
+ *  arrays, and attribute values of every object in the tree are carved out
+ *  of a list of large memory blocks owned by the root group. Freeing these
+ *  individually becomes a no-op, and all of the blocks are released at once
+ *  when the root group is deleted.
+ *
+ *  Variable data, default fill values, data indexes, object paths, user
+ *  data, and transformation parameters are still allocated separately and
+ *  freed as usual. Object paths are left out because they are created on
+ *  demand by cds_get_object_path(), which is also used in error messages
+ *  from the transformation worker threads.
+ */
+
+#include "cds3.h"
+#include "cds_private.h"
+
+/*******************************************************************************
+ *  Private Data and Functions
+ */
+/** @privatesection */
+
+/** Alignment of all arena allocations. */
+#define CDS_ARENA_ALIGN     16
+
+/** Size of the first arena block. */
+#define CDS_ARENA_MIN_BLOCK (16 * 1024)
+
+/** Maximum size of an arena block (larger requests get their own block). */
+#define CDS_ARENA_MAX_BLOCK (1024 * 1024)
+
+/** Minimum capacity of a child object array allocated from an arena. */
+#define CDS_ARENA_MIN_ARRAY 4
+
+/** Round a size up to the arena alignment. */
+#define CDS_ARENA_ROUND(size) \
+    (((size) + CDS_ARENA_ALIGN - 1) & ~((size_t)CDS_ARENA_ALIGN - 1))
+
+/**
+ *  PRIVATE: CDS Arena Block.
+ */
+typedef struct CDSArenaBlock {
+    struct CDSArenaBlock *next;  /**< next block in the list         */
+    size_t                size;  /**< usable size of the block       */
+    size_t                used;  /**< number of bytes handed out     */
+} CDSArenaBlock;
+
+/** Offset of the usable memory in an arena block. */
+#define CDS_ARENA_HEADER CDS_ARENA_ROUND(sizeof(CDSArenaBlock))
+
+/**
+ *  PRIVATE: CDS Arena.
+ */
+struct CDSArena {
+    CDSArenaBlock *blocks;      /**< list of blocks, current block first */
+    size_t         block_size;  /**< size of the next block to allocate  */
+};
+
+/**
+ *  PRIVATE: Allocate a new arena block.
+ *
+ *  @param  size - usable size of the block
+ *
+ *  @return
+ *    - pointer to the new block
+ *    - NULL if a memory allocation error occurred
+ */
+static CDSArenaBlock *_cds_arena_new_block(size_t size)
+{
+    CDSArenaBlock *block;
+
+    /* The blocks are never reused so calloc gives us zeroed allocations */
+
+    block = (CDSArenaBlock *)calloc(1, CDS_ARENA_HEADER + size);
+    if (!block) {
+        return((CDSArenaBlock *)NULL);
+    }
+
+    block->size = size;
+
+    return(block);
+}
+
+/**
+ *  PRIVATE: Create a CDS Arena.
+ *
+ *  @return
+ *    - pointer to the new arena
+ *    - NULL if a memory allocation error occurred
+ */
+CDSArena *_cds_arena_create(void)
+{
+    CDSArena *arena;
+
+    arena = (CDSArena *)calloc(1, sizeof(CDSArena));
+    if (!arena) {
+        return((CDSArena *)NULL);
+    }
+
+    arena->block_size = CDS_ARENA_MIN_BLOCK;
+
+    return(arena);
+}
+
+/**
+ *  PRIVATE: Destroy a CDS Arena.
+ *
+ *  This frees all of the memory handed out by the arena.
+ *
+ *  @param  arena - pointer to the arena
+ */
+void _cds_arena_destroy(CDSArena *arena)
+{
+    CDSArenaBlock *block;
+    CDSArenaBlock *next;
+
+    if (arena) {
+
+        for (block = arena->blocks; block; block = next) {
+            next = block->next;
+            free(block);
+        }
+
+        free(arena);
+    }
+}
+
+/**
+ *  PRIVATE: Allocate zeroed memory from a CDS Arena.
+ *
+ *  @param  arena - pointer to the arena
+ *  @param  size  - number of bytes to allocate
+ *
+ *  @return
+ *    - pointer to the allocated memory
+ *    - NULL if a memory allocation error occurred
+ */
+void *_cds_arena_alloc(CDSArena *arena, size_t size)
+{
+    CDSArenaBlock *block = arena->blocks;
+    void          *ptr;
+
+    size = (size) ? CDS_ARENA_ROUND(size) : CDS_ARENA_ALIGN;
+
+    if (!block || block->used + size > block->size) {
+
+        if (size > arena->block_size / 4) {
+
+            /* Give large requests a block of their own and link it in
+             * behind the current block so the space left in the current
+             * block is not wasted. */
+
+            block = _cds_arena_new_block(size);
+            if (!block) {
+                return((void *)NULL);
+            }
+
+            block->used = size;
+
+            if (arena->blocks) {
+                block->next = arena->blocks->next;
+                arena->blocks->next = block;
+            }
+            else {
+                arena->blocks = block;
+            }
+
+            return((void *)((char *)block + CDS_ARENA_HEADER));
+        }
+
+        block = _cds_arena_new_block(arena->block_size);
+        if (!block) {
+            return((void *)NULL);
+        }
+
+        block->next   = arena->blocks;
+        arena->blocks = block;
+
+        if (arena->block_size < CDS_ARENA_MAX_BLOCK) {
+            arena->block_size *= 2;
+        }
+    }
+
+    ptr = (void *)((char *)block + CDS_ARENA_HEADER + block->used);
+    block->used += size;
+
+    return(ptr);
+}
+
+/**
+ *  PRIVATE: Get the arena used by the tree a CDS Object belongs to.
+ *
+ *  @param  cds_object - pointer to a CDS Object
+ *
+ *  @return
+ *    - pointer to the arena
+ *    - NULL if an arena has not been enabled for the root group
+ */
+CDSArena *_cds_get_arena(void *cds_object)
+{
+    CDSObject *object = (CDSObject *)cds_object;
+
+    if (!object) {
+        return((CDSArena *)NULL);
+    }
+
+    while (object->parent) {
+        object = object->parent;
+    }
+
+    if (object->obj_type != CDS_GROUP) {
+        return((CDSArena *)NULL);
+    }
+
+    return((CDSArena *)((CDSGroup *)object)->arena);
+}
+
+/**
+ *  PRIVATE: Allocate zeroed memory for a CDS Object tree.
+ *
+ *  @param  cds_object - pointer to the CDS Object the memory is for,
+ *                       or to its parent if it has not been created yet
+ *  @param  size       - number of bytes to allocate
+ *
+ *  @return
+ *    - pointer to the allocated memory
+ *    - NULL if a memory allocation error occurred
+ */
+void *_cds_alloc(void *cds_object, size_t size)
+{
+    CDSArena *arena = _cds_get_arena(cds_object);
+
+    if (arena) {
+        return(_cds_arena_alloc(arena, size));
+    }
+
+    return(calloc(1, size));
+}
+
+/**
+ *  PRIVATE: Grow an array of object pointers in a CDS Object tree.
+ *
+ *  Arrays allocated from an arena are grown in powers of two so that
+ *  defining objects one at a time does not copy the array on every call.
+ *  The capacity is derived from the current length, which can only under
+ *  estimate it after objects have been removed from the array.
+ *
+ *  @param  cds_object - pointer to the CDS Object that owns the array
+ *  @param  array      - pointer to the array
+ *  @param  old_length - current number of elements in the array
+ *  @param  new_length - required number of elements in the array
+ *  @param  size       - size of an element in the array
+ *
+ *  @return
+ *    - pointer to the resized array
+ *    - NULL if a memory allocation error occurred
+ */
+void *_cds_realloc_array(
+    void   *cds_object,
+    void   *array,
+    size_t  old_length,
+    size_t  new_length,
+    size_t  size)
+{
+    CDSArena *arena = _cds_get_arena(cds_object);
+    size_t    capacity;
+    void     *new_array;
+
+    if (!arena) {
+        return(realloc(array, new_length * size));
+    }
+
+    capacity = CDS_ARENA_MIN_ARRAY;
+
+    if (array) {
+
+        while (capacity < old_length) capacity *= 2;
+
+        if (new_length <= capacity) {
+            return(array);
+        }
+    }
+
+    while (capacity < new_length) capacity *= 2;
+
+    new_array = _cds_arena_alloc(arena, capacity * size);
+
+    if (new_array && array && old_length) {
+        memcpy(new_array, array, old_length * size);
+    }
+
+    return(new_array);
+}
+
+/**
+ *  PRIVATE: Duplicate a string for a CDS Object tree.
+ *
+ *  @param  cds_object - pointer to the CDS Object the string is for,
+ *                       or to its parent if it has not been created yet
+ *  @param  string     - pointer to the string to duplicate
+ *
+ *  @return
+ *    - pointer to the new string
+ *    - NULL if a memory allocation error occurred
+ */
+char *_cds_strdup(void *cds_object, const char *string)
+{
+    CDSArena *arena = _cds_get_arena(cds_object);
+    size_t    length;
+    char     *new_string;
+
+    if (!arena) {
+        return(strdup(string));
+    }
+
+    length     = strlen(string) + 1;
+    new_string = (char *)_cds_arena_alloc(arena, length);
+
+    if (new_string) {
+        memcpy(new_string, string, length);
+    }
+
+    return(new_string);
+}
+
+/**
+ *  PRIVATE: Move dynamically allocated memory into a CDS Object tree.
+ *
+ *  This is used for values created by functions that always use malloc,
+ *  like cds_copy_array() and msngr_format_va_list(). If the tree uses an
+ *  arena the value is copied into it, with one extra zeroed byte to keep
+ *  character strings terminated, and the original memory is freed.
+ *
+ *  @param  cds_object - pointer to the CDS Object the memory is for
+ *  @param  ptr        - pointer to the dynamically allocated memory
+ *  @param  nbytes     - number of bytes to keep
+ *
+ *  @return
+ *    - pointer to the memory owned by the tree
+ *    - NULL if a memory allocation error occurred (ptr is left untouched)
+ */
+void *_cds_adopt(void *cds_object, void *ptr, size_t nbytes)
+{
+    CDSArena *arena = _cds_get_arena(cds_object);
+    void     *new_ptr;
+
+    if (!arena || !ptr) {
+        return(ptr);
+    }
+
+    new_ptr = _cds_arena_alloc(arena, nbytes + 1);
+    if (!new_ptr) {
+        return((void *)NULL);
+    }
+
+    memcpy(new_ptr, ptr, nbytes);
+    free(ptr);
+
+    return(new_ptr);
+}
+
+/**
+ *  PRIVATE: Free memory allocated for a CDS Object tree.
+ *
+ *  This is a no-op if the tree uses an arena.
+ *
+ *  @param  cds_object - pointer to the CDS Object the memory belongs to
+ *  @param  ptr        - pointer to the memory to free
+ */
+void _cds_free(void *cds_object, void *ptr)
+{
+    if (ptr && !_cds_get_arena(cds_object)) {
+        free(ptr);
+    }
+}
+
+/*******************************************************************************
+ *  Public Functions
+ */
+/** @publicsection */
+
+/**
+ *  Use an arena for the definitions in a CDS tree.
+ *
+ *  This must be called on a root group before anything is defined in it.
+ *  From then on the groups, dimensions, attributes, variables, and
+ *  attribute values defined in the tree are allocated from large blocks
+ *  owned by the root group, and deleting the root group frees them all
+ *  at once instead of one object at a time. Memory used by objects that
+ *  are deleted or renamed before then is not reused.
+ *
+ *  Variable data is still allocated and freed separately.
+ *
+ *  Error messages from this function are sent to the message
+ *  handler (see msngr_init_log() and msngr_init_mail()).
+ *
+ *  @param  group - pointer to the root group
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if:
+ *        - the group is not a root group
+ *        - the group is not empty
+ *        - a memory allocation error occurred
+ */
+int cds_enable_arena(CDSGroup *group)
+{
+    CDSArena *arena;
+    char     *name;
+
+    if (group->arena) {
+        return(1);
+    }
+
+    if (group->parent) {
+
+        ERROR( CDS_LIB_NAME,
+            "Could not enable arena for group: %s\n"
+            " -> not a root group\n",
+            cds_get_object_path(group));
+
+        return(0);
+    }
+
+    if (group->ndims || group->natts || group->nvars ||
+        group->ngroups || group->nvargroups) {
+
+        ERROR( CDS_LIB_NAME,
+            "Could not enable arena for group: %s\n"
+            " -> the group is not empty\n",
+            cds_get_object_path(group));
+
+        return(0);
+    }
+
+    arena = _cds_arena_create();
+    if (!arena) {
+
+        ERROR( CDS_LIB_NAME,
+            "Could not enable arena for group: %s\n"
+            " -> memory allocation error\n",
+            cds_get_object_path(group));
+
+        return(0);
+    }
+
+    /* The group name was allocated before the arena existed */
+
+    name = (char *)_cds_arena_alloc(arena, strlen(group->name) + 1);
+    if (!name) {
+
+        ERROR( CDS_LIB_NAME,
+            "Could not enable arena for group: %s\n"
+            " -> memory allocation error\n",
+            cds_get_object_path(group));
+
+        _cds_arena_destroy(arena);
+        return(0);
+    }
+
+    strcpy(name, group->name);
+    free(group->name);
+
+    group->name  = name;
+    group->arena = (void *)arena;
+
+    return(1);
+}
@@ -65,7 +65,7 @@ int _cds_change_att_value(
          * ensure character strings are derminated by a trailing \0...
          */
 
-        new_value = calloc(length+1, type_size);
+        new_value = _cds_alloc(att, (length+1) * type_size);
         if (!new_value) {
             return(0);
         }
@@ -78,7 +78,7 @@ int _cds_change_att_value(
     /* Set the value in the attribute structure */
 
     if (att->value.vp) {
-        free(att->value.vp);
+        _cds_free(att, att->value.vp);
     }
 
     att->type     = type;
@@ -112,19 +112,19 @@ CDSAtt *_cds_create_att(
 {
     CDSAtt *att;
 
-    att = (CDSAtt *)calloc(1, sizeof(CDSAtt));
+    att = (CDSAtt *)_cds_alloc(parent, sizeof(CDSAtt));
     if (!att) {
         return((CDSAtt *)NULL);
     }
 
     if (!_cds_init_object_members(att, CDS_ATT, parent, name)) {
-        free(att);
+        _cds_free(parent, att);
         return((CDSAtt *)NULL);
     }
 
     if (!_cds_change_att_value(att, type, length, value)) {
         _cds_free_object_members(att);
-        free(att);
+        _cds_free(parent, att);
         return((CDSAtt *)NULL);
     }
 
@@ -214,8 +214,8 @@ CDSAtt *_cds_define_att(
 
     /* Allocate space for a new attribute */
 
-    atts = (CDSAtt **)realloc(
-        *attsp, (*nattsp + 2) * sizeof(CDSAtt *));
+    atts = (CDSAtt **)_cds_realloc_array(parent, *attsp,
+        *nattsp + 1, *nattsp + 2, sizeof(CDSAtt *));
 
     if (!atts) {
 
@@ -247,6 +247,8 @@ CDSAtt *_cds_define_att(
     (*nattsp)++;
     atts[*nattsp] = (CDSAtt *)NULL;
 
+    _cds_index_object(atts[*nattsp - 1]);
+
     return(atts[*nattsp - 1]);
 }
 
@@ -261,11 +263,11 @@ void _cds_destroy_att(CDSAtt *att)
 {
     if (att) {
 
-        if (att->value.vp) free(att->value.vp);
+        if (att->value.vp) _cds_free(att, att->value.vp);
 
         _cds_free_object_members(att);
 
-        free(att);
+        _cds_free(att, att);
     }
 }
 
@@ -296,6 +298,8 @@ int _cds_set_att_value(
     void        *value)
 {
     void  *new_value = (void *)NULL;
+    int    converted = 0;
+    void  *att_value;
     size_t type_size;
 
     /* Create the new attribute value */
@@ -312,7 +316,7 @@ int _cds_set_att_value(
         if (type == CDS_CHAR) {
 
             if (att->type == CDS_CHAR) {
-                new_value = calloc(length+1, sizeof(char));
+                new_value = _cds_alloc(att, (length+1) * sizeof(char));
                 if (!new_value) {
                     length = (size_t)-1;
                 }
@@ -323,6 +327,7 @@ int _cds_set_att_value(
             else {
                 new_value = cds_string_to_array(
                     (const char *)value, att->type, &length, NULL);
+                converted = 1;
             }
         }
         else if (att->type == CDS_CHAR) {
@@ -330,6 +335,7 @@ int _cds_set_att_value(
             if (new_value) {
                 length = strlen(new_value) + 1;
             }
+            converted = 1;
         }
         else {
             new_value = cds_copy_array(
@@ -338,11 +344,12 @@ int _cds_set_att_value(
             if (!new_value) {
                 length = (size_t)-1;
             }
+            converted = 1;
         }
     }
     else if (length) {
         type_size = cds_data_type_size(att->type);
-        new_value = calloc(length+1, type_size);
+        new_value = _cds_alloc(att, (length+1) * type_size);
     }
     else {
         new_value = (void *)NULL;
@@ -358,10 +365,30 @@ int _cds_set_att_value(
         return(0);
     }
 
+    /* Values created by the conversion functions are always malloced */
+
+    if (converted && new_value) {
+
+        type_size = cds_data_type_size(att->type);
+        att_value = _cds_adopt(att, new_value, length * type_size);
+
+        if (!att_value) {
+
+            ERROR( CDS_LIB_NAME,
+                "Could not set attribute value for: %s\n"
+                " -> memory allocation error\n", cds_get_object_path(att));
+
+            free(new_value);
+            return(0);
+        }
+
+        new_value = att_value;
+    }
+
     /* Set the value in the attribute structure */
 
     if (att->value.vp) {
-        free(att->value.vp);
+        _cds_free(att, att->value.vp);
     }
 
     att->length   = length;
@@ -549,7 +576,7 @@ int cds_change_att_text(
 
     if (!format) {
 
-        if (att->value.vp) free(att->value.vp);
+        if (att->value.vp) _cds_free(att, att->value.vp);
 
         att->type     = CDS_CHAR;
         att->length   = 0;
@@ -591,7 +618,9 @@ int cds_change_att_va_list(
     const char *format,
     va_list     args)
 {
-    char *att_text;
+    char   *att_text;
+    char   *att_value;
+    size_t  length;
 
     /* Check if the attribute is locked */
 
@@ -609,7 +638,7 @@ int cds_change_att_va_list(
 
     if (!format) {
 
-        if (att->value.vp) free(att->value.vp);
+        if (att->value.vp) _cds_free(att, att->value.vp);
 
         att->type     = CDS_CHAR;
         att->length   = 0;
@@ -633,11 +662,24 @@ int cds_change_att_va_list(
 
     /* Change the attribute value */
 
-    if (att->value.vp) free(att->value.vp);
+    length    = strlen(att_text) + 1;
+    att_value = _cds_adopt(att, att_text, length);
+
+    if (!att_value) {
+
+        ERROR( CDS_LIB_NAME,
+            "Could not change attribute value for: %s\n"
+            " -> memory allocation error\n", cds_get_object_path(att));
+
+        free(att_text);
+        return(0);
+    }
+
+    if (att->value.vp) _cds_free(att, att->value.vp);
 
     att->type     = CDS_CHAR;
-    att->length   = strlen(att_text) + 1;
-    att->value.cp = att_text;
+    att->length   = length;
+    att->value.cp = att_value;
 
     return(1);
 }
@@ -987,11 +1029,13 @@ CDSAtt *cds_get_att(void *parent, const char *name)
 
     if (parent_object->obj_type == CDS_GROUP) {
         group = (CDSGroup *)parent;
-        att   = _cds_get_object((void **)group->atts, group->natts, name);
+        att   = _cds_find_object(group, CDS_ATT,
+            (void **)group->atts, group->natts, name);
     }
     else if (parent_object->obj_type == CDS_VAR) {
         var = (CDSVar *)parent;
-        att = _cds_get_object((void **)var->atts, var->natts, name);
+        att = _cds_find_object(var, CDS_ATT,
+            (void **)var->atts, var->natts, name);
     }
 
     return(att);
@@ -1271,7 +1315,7 @@ int cds_rename_att(CDSAtt *att, const char *name)
 
     /* Rename the attribute */
 
-    new_name = strdup(name);
+    new_name = _cds_strdup(att, name);
     if (!new_name) {
 
         ERROR( CDS_LIB_NAME,
@@ -1282,9 +1326,13 @@ int cds_rename_att(CDSAtt *att, const char *name)
         return(0);
     }
 
-    free(att->name);
+    _cds_unindex_object(att);
+
+    _cds_free(att, att->name);
     att->name = new_name;
 
+    _cds_index_object(att);
+
     return(1);
 }
 
@@ -1424,7 +1472,7 @@ int cds_set_att_text(
     if (!format) {
 
         if (att->value.vp) {
-            free(att->value.vp);
+            _cds_free(att, att->value.vp);
         }
 
         att->length   = 0;
@@ -1481,7 +1529,7 @@ int cds_set_att_va_list(
     if (!format) {
 
         if (att->value.vp) {
-            free(att->value.vp);
+            _cds_free(att, att->value.vp);
         }
 
         att->length   = 0;
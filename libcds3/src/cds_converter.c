@@ -459,6 +459,7 @@ int cds_convert_var(
     size_t         length;
     int            flags;
     void          *datap;
+    void          *out_datap;
     int            ai;
 
     /* Check if a conversion is needed */
@@ -576,8 +577,22 @@ int cds_convert_var(
             }
 
             if (datap != att->value.vp) {
-                free(att->value.vp);
-                att->value.vp = datap;
+
+                out_datap = _cds_adopt(att, datap, att->length * dc->out_size);
+
+                if (!out_datap) {
+
+                    ERROR( CDS_LIB_NAME,
+                        "Could not convert variable data for: %s\n"
+                        " -> memory allocation error\n",
+                        cds_get_object_path(var));
+
+                    free(datap);
+                    return(0);
+                }
+
+                _cds_free(att, att->value.vp);
+                att->value.vp = out_datap;
             }
 
             att->type = dc->out_type;
@@ -54,6 +54,7 @@ int _cds_copy_att_value(
 {
     _CDSConverter *dc = (_CDSConverter *)converter;
     void          *value;
+    void          *dest_value;
 
     if (converter) {
 
@@ -73,13 +74,30 @@ int _cds_copy_att_value(
             return(0);
         }
 
+        dest_value = _cds_adopt(
+            dest_att, value, src_att->length * dc->out_size);
+
+        if (!dest_value) {
+
+            ERROR( CDS_LIB_NAME,
+                "Could not copy attribute value\n"
+                " -> from: %s\n"
+                " -> to:   %s\n"
+                " -> memory allocation error\n",
+                cds_get_object_path(src_att),
+                cds_get_object_path(dest_att));
+
+            free(value);
+            return(0);
+        }
+
         if (dest_att->value.vp) {
-            free(dest_att->value.vp);
+            _cds_free(dest_att, dest_att->value.vp);
         }
 
         dest_att->type     = dc->out_type;
         dest_att->length   = src_att->length;
-        dest_att->value.vp = value;
+        dest_att->value.vp = dest_value;
     }
     else {
 
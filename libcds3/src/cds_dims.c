@@ -57,13 +57,13 @@ CDSDim *_cds_create_dim(
 {
     CDSDim *dim;
 
-    dim = (CDSDim *)calloc(1, sizeof(CDSDim));
+    dim = (CDSDim *)_cds_alloc(group, sizeof(CDSDim));
     if (!dim) {
         return((CDSDim *)NULL);
     }
 
     if (!_cds_init_object_members(dim, CDS_DIM, group, name)) {
-        free(dim);
+        _cds_free(group, dim);
         return((CDSDim *)NULL);
     }
 
@@ -84,7 +84,7 @@ void _cds_destroy_dim(CDSDim *dim)
 {
     if (dim) {
         _cds_free_object_members(dim);
-        free(dim);
+        _cds_free(dim, dim);
     }
 }
 
@@ -271,7 +271,8 @@ CDSDim *cds_define_dim(
 
     /* Check if a dimension with this name already exists */
 
-    dim = _cds_get_object((void **)group->dims, group->ndims, name);
+    dim = _cds_find_object(group, CDS_DIM,
+        (void **)group->dims, group->ndims, name);
     if (dim) {
 
         if ((is_unlimited == dim->is_unlimited) &&
@@ -304,8 +305,8 @@ CDSDim *cds_define_dim(
 
     /* Allocate space for a new dimension */
 
-    dims = (CDSDim **)realloc(
-        group->dims, (group->ndims + 2) * sizeof(CDSDim *));
+    dims = (CDSDim **)_cds_realloc_array(group, group->dims,
+        group->ndims + 1, group->ndims + 2, sizeof(CDSDim *));
 
     if (!dims) {
 
@@ -337,6 +338,8 @@ CDSDim *cds_define_dim(
     group->ndims++;
     group->dims[group->ndims] = (CDSDim *)NULL;
 
+    _cds_index_object(group->dims[group->ndims - 1]);
+
     return(group->dims[group->ndims - 1]);
 }
 
@@ -418,7 +421,8 @@ CDSDim *cds_get_dim(CDSGroup *group, const char *name)
 {
     CDSDim *dim;
 
-    dim = _cds_get_object((void **)group->dims, group->ndims, name);
+    dim = _cds_find_object(group, CDS_DIM,
+        (void **)group->dims, group->ndims, name);
 
     if (!dim && group->parent) {
         dim = cds_get_dim((CDSGroup *)group->parent, name);
@@ -506,7 +510,7 @@ int cds_rename_dim(CDSDim *dim, const char *name)
 
     /* Create the new dimension name */
 
-    new_name = strdup(name);
+    new_name = _cds_strdup(dim, name);
     if (!new_name) {
 
         ERROR( CDS_LIB_NAME,
@@ -528,8 +532,12 @@ int cds_rename_dim(CDSDim *dim, const char *name)
 
     /* Rename the dimension */
 
-    free(dim->name);
+    _cds_unindex_object(dim);
+
+    _cds_free(dim, dim->name);
     dim->name = new_name;
 
+    _cds_index_object(dim);
+
     return(1);
 }
@@ -51,13 +51,13 @@ CDSGroup *_cds_create_group(CDSGroup *parent, const char *name)
 {
     CDSGroup *group;
 
-    group = (CDSGroup *)calloc(1, sizeof(CDSGroup));
+    group = (CDSGroup *)_cds_alloc(parent, sizeof(CDSGroup));
     if (!group) {
         return((CDSGroup *)NULL);
     }
 
     if (!_cds_init_object_members(group, CDS_GROUP, parent, name)) {
-        free(group);
+        _cds_free(parent, group);
         return((CDSGroup *)NULL);
     }
 
@@ -81,44 +81,54 @@ void _cds_destroy_group(CDSGroup *group)
             for (id = 0; id < group->nvargroups; id++) {
                 _cds_destroy_vargroup(group->vargroups[id]);
             }
-            free(group->vargroups);
+            _cds_free(group, group->vargroups);
         }
 
         if (group->groups) {
             for (id = 0; id < group->ngroups; id++) {
                 _cds_destroy_group(group->groups[id]);
             }
-            free(group->groups);
+            _cds_free(group, group->groups);
         }
 
         if (group->vars) {
             for (id = 0; id < group->nvars; id++) {
                 _cds_destroy_var(group->vars[id]);
             }
-            free(group->vars);
+            _cds_free(group, group->vars);
         }
 
         if (group->dims) {
             for (id = 0; id < group->ndims; id++) {
                 _cds_destroy_dim(group->dims[id]);
             }
-            free(group->dims);
+            _cds_free(group, group->dims);
         }
 
         if (group->atts) {
             for (id = 0; id < group->natts; id++) {
                 _cds_destroy_att(group->atts[id]);
             }
-            free(group->atts);
+            _cds_free(group, group->atts);
         }
 
         if (group->transform_params) {
             _cds_free_transform_params(group->transform_params);
         }
 
+        _cds_free_object_index(group->obj_index);
+
         _cds_free_object_members(group);
 
-        free(group);
+        /* The root group owns the arena everything else came from */
+
+        if (group->arena) {
+            _cds_arena_destroy(group->arena);
+            free(group);
+        }
+        else {
+            _cds_free(group, group);
+        }
     }
 }
 
@@ -191,8 +201,8 @@ CDSGroup *cds_define_group(CDSGroup *parent, const char *name)
 
     /* Allocate space for a new group */
 
-    groups = (CDSGroup **)realloc(
-        parent->groups, (parent->ngroups + 2) * sizeof(CDSGroup *));
+    groups = (CDSGroup **)_cds_realloc_array(parent, parent->groups,
+        parent->ngroups + 1, parent->ngroups + 2, sizeof(CDSGroup *));
 
     if (!groups) {
 
@@ -223,6 +233,8 @@ CDSGroup *cds_define_group(CDSGroup *parent, const char *name)
     parent->ngroups++;
     parent->groups[parent->ngroups] = (CDSGroup *)NULL;
 
+    _cds_index_object(parent->groups[parent->ngroups - 1]);
+
     return(parent->groups[parent->ngroups - 1]);
 }
 
@@ -298,7 +310,8 @@ CDSGroup *cds_get_group(CDSGroup *parent, const char *name)
 {
     CDSGroup *group;
 
-    group = _cds_get_object((void **)parent->groups, parent->ngroups, name);
+    group = _cds_find_object(parent, CDS_GROUP,
+        (void **)parent->groups, parent->ngroups, name);
 
     return(group);
 }
@@ -363,7 +376,7 @@ int cds_rename_group(CDSGroup *group, const char *name)
 
     /* Rename the group */
 
-    new_name = strdup(name);
+    new_name = _cds_strdup(group, name);
     if (!new_name) {
 
         ERROR( CDS_LIB_NAME,
@@ -374,8 +387,12 @@ int cds_rename_group(CDSGroup *group, const char *name)
         return(0);
     }
 
-    free(group->name);
+    _cds_unindex_object(group);
+
+    _cds_free(group, group->name);
     group->name = new_name;
 
+    _cds_index_object(group);
+
     return(1);
 }
@@ -29,6 +29,11 @@
 #include "cds3.h"
 #include "cds_private.h"
 
+#include <pthread.h>
+
+/** Mutex protecting the cached object paths (see cds_get_object_path). */
+static pthread_mutex_t _ObjPathMutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*******************************************************************************
  *  Private Functions
  */
@@ -61,7 +66,7 @@ void _cds_free_object_members(void *cds_object)
         free(object->user_data);
     }
 
-    free(object->name);
+    _cds_free(object, object->name);
 }
 
 /**
@@ -88,7 +93,11 @@ int _cds_init_object_members(
         object->obj_type = obj_type;
         object->obj_path = (char *)NULL;
         object->parent   = parent;
-        object->name     = strdup(name);
+        object->name     = _cds_strdup(object, name);
+
+        if (!object->name) {
+            return(0);
+        }
     }
 
     return(1);
@@ -121,6 +130,444 @@ void *_cds_get_object(void **array, int nobjects, const char *name)
     return((void *)NULL);
 }
 
+/** Minimum number of objects in an array before it is indexed. */
+#define CDS_INDEX_THRESHOLD  16
+
+/**
+ *  Hash table used to lookup the objects in one of the arrays of a parent
+ *  object by name.
+ *
+ *  The table uses open addressing with linear probing and stores the object
+ *  pointers, so it is not affected if the order of the objects in the array
+ *  is changed. The number of indexed objects is compared to the number of
+ *  objects in the array to detect arrays that have been modified outside
+ *  of the define, delete, and rename functions.
+ */
+typedef struct {
+    int         nobjects; /**< number of objects in the table       */
+    size_t      nslots;   /**< number of slots in the table (2^n)   */
+    CDSObject **slots;    /**< array of slots                       */
+} CDSIndexTable;
+
+/**
+ *  Name indexes for all object arrays of a CDSGroup or CDSVar,
+ *  this is the structure pointed to by the obj_index member.
+ */
+typedef struct {
+    CDSIndexTable *tables[CDS_VARGROUP + 1]; /**< tables by object type */
+} CDSObjectIndex;
+
+/**
+ *  PRIVATE: Hash an object name.
+ *
+ *  @param  name - object name
+ *
+ *  @return  hash value
+ */
+static size_t _cds_hash_name(const char *name)
+{
+    size_t hash = 2166136261u;
+
+    while (*name) {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+
+    return(hash);
+}
+
+/**
+ *  PRIVATE: Get the object array a parent uses for an object type.
+ *
+ *  @param  parent   - pointer to the parent object
+ *  @param  obj_type - type of the objects in the array
+ *  @param  array    - output: pointer to the array of objects
+ *  @param  nobjects - output: number of objects in the array
+ *
+ *  @return
+ *    - pointer to the obj_index member of the parent
+ *    - NULL if this type of object array is not indexed
+ */
+static void **_cds_get_object_array(
+    CDSObject     *parent,
+    CDSObjectType  obj_type,
+    CDSObject   ***array,
+    int           *nobjects)
+{
+    CDSGroup *group;
+    CDSVar   *var;
+
+    if (!parent) {
+        return((void **)NULL);
+    }
+
+    if (parent->obj_type == CDS_GROUP) {
+
+        group = (CDSGroup *)parent;
+
+        switch (obj_type) {
+            case CDS_GROUP:
+                *array    = (CDSObject **)group->groups;
+                *nobjects = group->ngroups;
+                break;
+            case CDS_DIM:
+                *array    = (CDSObject **)group->dims;
+                *nobjects = group->ndims;
+                break;
+            case CDS_ATT:
+                *array    = (CDSObject **)group->atts;
+                *nobjects = group->natts;
+                break;
+            case CDS_VAR:
+                *array    = (CDSObject **)group->vars;
+                *nobjects = group->nvars;
+                break;
+            case CDS_VARGROUP:
+                *array    = (CDSObject **)group->vargroups;
+                *nobjects = group->nvargroups;
+                break;
+            default:
+                return((void **)NULL);
+        }
+
+        return(&(group->obj_index));
+    }
+
+    if (parent->obj_type == CDS_VAR && obj_type == CDS_ATT) {
+
+        var       = (CDSVar *)parent;
+        *array    = (CDSObject **)var->atts;
+        *nobjects = var->natts;
+
+        return(&(var->obj_index));
+    }
+
+    return((void **)NULL);
+}
+
+/**
+ *  PRIVATE: Free an index table.
+ *
+ *  @param  table - pointer to the index table
+ */
+static void _cds_free_index_table(CDSIndexTable *table)
+{
+    if (table) {
+        if (table->slots) free(table->slots);
+        free(table);
+    }
+}
+
+/**
+ *  PRIVATE: Add an object to an index table.
+ *
+ *  The table is grown as necessary to keep it at most half full.
+ *
+ *  @param  table  - pointer to the index table
+ *  @param  object - pointer to the object
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if a memory allocation error occurred
+ */
+static int _cds_index_table_add(CDSIndexTable *table, CDSObject *object)
+{
+    CDSObject **slots;
+    size_t      nslots;
+    size_t      mask;
+    size_t      si, oi;
+
+    if ((size_t)(table->nobjects + 1) * 2 > table->nslots) {
+
+        nslots = (table->nslots) ? table->nslots * 2 : 64;
+        slots  = (CDSObject **)calloc(nslots, sizeof(CDSObject *));
+
+        if (!slots) {
+            return(0);
+        }
+
+        mask = nslots - 1;
+
+        for (oi = 0; oi < table->nslots; ++oi) {
+            if (table->slots[oi]) {
+                si = _cds_hash_name(table->slots[oi]->name) & mask;
+                while (slots[si]) si = (si + 1) & mask;
+                slots[si] = table->slots[oi];
+            }
+        }
+
+        if (table->slots) free(table->slots);
+
+        table->slots  = slots;
+        table->nslots = nslots;
+    }
+
+    mask = table->nslots - 1;
+    si   = _cds_hash_name(object->name) & mask;
+
+    while (table->slots[si]) si = (si + 1) & mask;
+
+    table->slots[si] = object;
+    table->nobjects += 1;
+
+    return(1);
+}
+
+/**
+ *  PRIVATE: Remove an object from an index table.
+ *
+ *  The objects following the removed object in the probe sequence are
+ *  shifted back so no tombstones are needed.
+ *
+ *  @param  table  - pointer to the index table
+ *  @param  object - pointer to the object
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if the object was not found in the table
+ */
+static int _cds_index_table_remove(CDSIndexTable *table, CDSObject *object)
+{
+    size_t mask = table->nslots - 1;
+    size_t si, ni, hi;
+
+    si = _cds_hash_name(object->name) & mask;
+
+    while (table->slots[si] != object) {
+        if (!table->slots[si]) return(0);
+        si = (si + 1) & mask;
+    }
+
+    table->slots[si] = (CDSObject *)NULL;
+
+    for (ni = (si + 1) & mask; table->slots[ni]; ni = (ni + 1) & mask) {
+
+        hi = _cds_hash_name(table->slots[ni]->name) & mask;
+
+        /* Move the object back if its home slot is not
+         * cyclically between the empty slot and its slot */
+
+        if ((ni > si && (hi <= si || hi > ni)) ||
+            (ni < si && (hi <= si && hi > ni))) {
+
+            table->slots[si] = table->slots[ni];
+            table->slots[ni] = (CDSObject *)NULL;
+            si = ni;
+        }
+    }
+
+    table->nobjects -= 1;
+
+    return(1);
+}
+
+/**
+ *  PRIVATE: Create an index table for an array of objects.
+ *
+ *  @param  array    - pointer to the array of objects
+ *  @param  nobjects - number of objects in the array
+ *
+ *  @return
+ *    - pointer to the new index table
+ *    - NULL if a memory allocation error occurred
+ */
+static CDSIndexTable *_cds_create_index_table(
+    CDSObject **array,
+    int         nobjects)
+{
+    CDSIndexTable *table;
+    int            oi;
+
+    table = (CDSIndexTable *)calloc(1, sizeof(CDSIndexTable));
+    if (!table) {
+        return((CDSIndexTable *)NULL);
+    }
+
+    for (oi = 0; oi < nobjects; ++oi) {
+        if (!_cds_index_table_add(table, array[oi])) {
+            _cds_free_index_table(table);
+            return((CDSIndexTable *)NULL);
+        }
+    }
+
+    return(table);
+}
+
+/**
+ *  PRIVATE: Free the name indexes of a CDSGroup or CDSVar.
+ *
+ *  @param  obj_index - the obj_index member of the CDSGroup or CDSVar
+ */
+void _cds_free_object_index(void *obj_index)
+{
+    CDSObjectIndex *index = (CDSObjectIndex *)obj_index;
+    int             ti;
+
+    if (index) {
+        for (ti = 0; ti <= CDS_VARGROUP; ++ti) {
+            _cds_free_index_table(index->tables[ti]);
+        }
+        free(index);
+    }
+}
+
+/**
+ *  PRIVATE: Add a CDS Object to the name index of its parent.
+ *
+ *  This function must be called after the object has been added to the
+ *  parent's object array, or after it has been renamed. The index is
+ *  created when the number of objects in the array reaches the indexing
+ *  threshold. If a memory allocation error occurs the index is dropped
+ *  and the lookups will fall back to a linear search.
+ *
+ *  @param  cds_object - pointer to the CDS Object
+ */
+void _cds_index_object(void *cds_object)
+{
+    CDSObject       *object = (CDSObject *)cds_object;
+    CDSObject      **array;
+    int              nobjects;
+    void           **obj_indexp;
+    CDSObjectIndex  *index;
+    CDSIndexTable  **tablep;
+
+    obj_indexp = _cds_get_object_array(
+        object->parent, object->obj_type, &array, &nobjects);
+
+    if (!obj_indexp) return;
+
+    index = (CDSObjectIndex *)*obj_indexp;
+
+    if (!index) {
+
+        if (nobjects < CDS_INDEX_THRESHOLD) return;
+
+        index = (CDSObjectIndex *)calloc(1, sizeof(CDSObjectIndex));
+        if (!index) return;
+
+        *obj_indexp = (void *)index;
+    }
+
+    tablep = &(index->tables[object->obj_type]);
+
+    if (*tablep && (*tablep)->nobjects + 1 == nobjects) {
+        if (_cds_index_table_add(*tablep, object)) return;
+    }
+
+    /* Rebuild the index table if it is missing or out of sync */
+
+    _cds_free_index_table(*tablep);
+
+    *tablep = (nobjects < CDS_INDEX_THRESHOLD)
+        ? (CDSIndexTable *)NULL
+        : _cds_create_index_table(array, nobjects);
+}
+
+/**
+ *  PRIVATE: Remove a CDS Object from the name index of its parent.
+ *
+ *  This function must be called while the object is still in the parent's
+ *  object array, and before it is renamed.
+ *
+ *  @param  cds_object - pointer to the CDS Object
+ */
+void _cds_unindex_object(void *cds_object)
+{
+    CDSObject       *object = (CDSObject *)cds_object;
+    CDSObject      **array;
+    int              nobjects;
+    void           **obj_indexp;
+    CDSObjectIndex  *index;
+    CDSIndexTable  **tablep;
+
+    obj_indexp = _cds_get_object_array(
+        object->parent, object->obj_type, &array, &nobjects);
+
+    if (!obj_indexp || !*obj_indexp) return;
+
+    index  = (CDSObjectIndex *)*obj_indexp;
+    tablep = &(index->tables[object->obj_type]);
+
+    if (!*tablep) return;
+
+    if ((*tablep)->nobjects == nobjects &&
+        _cds_index_table_remove(*tablep, object)) {
+
+        return;
+    }
+
+    /* The index table is out of sync, it will be
+     * rebuilt the next time an object is added */
+
+    _cds_free_index_table(*tablep);
+    *tablep = (CDSIndexTable *)NULL;
+}
+
+/**
+ *  PRIVATE: Find a child object of a CDSGroup or CDSVar by name.
+ *
+ *  The parent's name index is used if one has been created and it is
+ *  in sync with the object array, otherwise this function falls back to
+ *  a linear search using _cds_get_object(). This function never modifies
+ *  the index, so it is safe to call from multiple threads as long as the
+ *  parent is not being modified at the same time.
+ *
+ *  @param  parent   - pointer to the parent CDSGroup or CDSVar
+ *  @param  obj_type - type of object to find
+ *  @param  array    - pointer to the parent's array of objects of that type
+ *  @param  nobjects - number of objects in the array
+ *  @param  name     - name of the object to return
+ *
+ *  @return
+ *    - pointer to the CDS Object
+ *    - NULL if not found
+ */
+void *_cds_find_object(
+    void          *parent,
+    CDSObjectType  obj_type,
+    void         **array,
+    int            nobjects,
+    const char    *name)
+{
+    CDSObject      *object = (CDSObject *)parent;
+    CDSObjectIndex *index  = (CDSObjectIndex *)NULL;
+    CDSIndexTable  *table;
+    size_t          mask;
+    size_t          si;
+
+    if (!name || !array || !nobjects) {
+        return((void *)NULL);
+    }
+
+    if (object) {
+        if (object->obj_type == CDS_GROUP) {
+            index = (CDSObjectIndex *)((CDSGroup *)object)->obj_index;
+        }
+        else if (object->obj_type == CDS_VAR) {
+            index = (CDSObjectIndex *)((CDSVar *)object)->obj_index;
+        }
+    }
+
+    if (!index ||
+        !(table = index->tables[obj_type]) ||
+        table->nobjects != nobjects) {
+
+        return(_cds_get_object(array, nobjects, name));
+    }
+
+    mask = table->nslots - 1;
+    si   = _cds_hash_name(name) & mask;
+
+    while (table->slots[si]) {
+        if (strcmp(table->slots[si]->name, name) == 0) {
+            return((void *)table->slots[si]);
+        }
+        si = (si + 1) & mask;
+    }
+
+    return((void *)NULL);
+}
+
 /**
  *  PRIVATE: Get the name of a CDS Object Type.
  *
@@ -173,6 +620,8 @@ void _cds_remove_object(void **array, int *nobjects, void *object)
 
     if (array && nobjects) {
 
+        _cds_unindex_object(object);
+
         for (i = 0; i < *nobjects; i++) {
             if (array[i] == object) break;
         }
@@ -196,6 +645,10 @@ void _cds_remove_object(void **array, int *nobjects, void *object)
  *  The memory used by the returned string must not be freed
  *  by the calling process.
  *
+ *  The path is built once and cached in the object. This function can be
+ *  called from the transform worker threads, so the cache is only read and
+ *  set while holding a mutex.
+ *
  *  @param  cds_object - pointer to a CDSDim, CDSAtt, CDSVar
  *                       CDSGroup, or CDSVarGroup
  *
@@ -218,8 +671,12 @@ const char *cds_get_object_path(void *cds_object)
 
     /* Check if we have already created the path to this object */
 
-    if (object->obj_path) {
-        return(object->obj_path);
+    pthread_mutex_lock(&_ObjPathMutex);
+    path = object->obj_path;
+    pthread_mutex_unlock(&_ObjPathMutex);
+
+    if (path) {
+        return(path);
     }
 
     /* Figure out how much memory we will need */
@@ -278,8 +735,21 @@ const char *cds_get_object_path(void *cds_object)
         object = object->parent;
     }
 
+    /* Another thread may have cached the path while we were building it */
+
     object = cds_object;
-    object->obj_path = path;
+
+    pthread_mutex_lock(&_ObjPathMutex);
+
+    if (object->obj_path) {
+        free(path);
+        path = object->obj_path;
+    }
+    else {
+        object->obj_path = path;
+    }
+
+    pthread_mutex_unlock(&_ObjPathMutex);
 
     return(path);
 }
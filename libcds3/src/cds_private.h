@@ -33,6 +33,26 @@
 
 /** @privatesection */
 
+/*****  Arena Functions  *****/
+
+typedef struct CDSArena CDSArena;
+
+CDSArena   *_cds_arena_create(void);
+void        _cds_arena_destroy(CDSArena *arena);
+void       *_cds_arena_alloc(CDSArena *arena, size_t size);
+
+CDSArena   *_cds_get_arena(void *cds_object);
+void       *_cds_alloc(void *cds_object, size_t size);
+void       *_cds_realloc_array(
+                void   *cds_object,
+                void   *array,
+                size_t  old_length,
+                size_t  new_length,
+                size_t  size);
+char       *_cds_strdup(void *cds_object, const char *string);
+void       *_cds_adopt(void *cds_object, void *ptr, size_t nbytes);
+void        _cds_free(void *cds_object, void *ptr);
+
 /*****  Object Functions  *****/
 
 void        _cds_free_object_members(void *cds_object);
@@ -46,12 +66,56 @@ void       *_cds_get_object(void **array, int nobjects, const char *name);
 const char *_cds_obj_type_name(CDSObjectType obj_type);
 void        _cds_remove_object(void **array, int *nobjects, void *object);
 
+void       *_cds_find_object(
+                void          *parent,
+                CDSObjectType  obj_type,
+                void         **array,
+                int            nobjects,
+                const char    *name);
+
+void        _cds_free_object_index(void *obj_index);
+void        _cds_index_object(void *cds_object);
+void        _cds_unindex_object(void *cds_object);
+
 /*****  Data Type Functions  *****/
 
 void       *_cds_data_type_min(CDSDataType type);
 void       *_cds_data_type_max(CDSDataType type);
 void       *_cds_default_fill_value(CDSDataType type);
 
+/*****  SIMD Functions  *****/
+
+size_t      _cds_copy_array_simd(
+                CDSDataType  in_type,
+                size_t       length,
+                void        *in_data,
+                CDSDataType  out_type,
+                void        *out_data,
+                size_t       nmap,
+                void        *in_map,
+                void        *out_map,
+                void        *out_min,
+                void        *orv_min,
+                void        *out_max,
+                void        *orv_max);
+
+size_t      _cds_convert_units_simd(
+                double       slope,
+                double       intercept,
+                int          single_ok,
+                CDSDataType  in_type,
+                size_t       length,
+                void        *in_data,
+                CDSDataType  out_type,
+                void        *out_data,
+                size_t       nmap,
+                void        *in_map,
+                void        *out_map,
+                void        *out_min,
+                void        *orv_min,
+                void        *out_max,
+                void        *orv_max);
+
 /*****  Group Functions  *****/
 
 CDSGroup   *_cds_create_group(CDSGroup *parent, const char *name);
@@ -1417,4 +1481,63 @@ else if (value > max) *flagsp |= max_flag;
     } \
 }
 
+/**
+*  Macro used by cds_qc_limit_delta_checks() to perform the missing, min, max,
+*  and sample to sample delta checks in a single pass over the data.
+*/
+#define CDS_QC_LIMIT_DELTA_CHECKS(data_t, abs_t, abs_f) \
+{ \
+    data_t *datap       = (data_t *)data_vp; \
+    data_t *missings    = (data_t *)missings_vp; \
+    data_t *prev_datap  = (data_t *)prev_sample_vp; \
+    int    *prev_flagsp = prev_qc_flags; \
+    int    *flagsp      = qc_flags; \
+    data_t  min         = (min_vp)    ? *((data_t *)min_vp)    : 0; \
+    data_t  max         = (max_vp)    ? *((data_t *)max_vp)    : 0; \
+    data_t  max_delta   = (deltas_vp) ? *((data_t *)deltas_vp) : 0; \
+    int     has_min     = (min_vp)    ? 1 : 0; \
+    int     has_max     = (max_vp)    ? 1 : 0; \
+    int     has_delta   = (deltas_vp && max_delta > 0) ? 1 : 0; \
+    int     check_delta; \
+    int     flags; \
+    data_t  value; \
+    size_t  si, vi, mi; \
+\
+    if (!missings) nmissings = 0; \
+\
+    for (si = 0; si < sample_count; ++si) { \
+\
+        check_delta = (has_delta && prev_datap) ? 1 : 0; \
+\
+        for (vi = 0; vi < sample_size; ++vi) { \
+\
+            value = datap[vi]; \
+            flags = flagsp[vi]; \
+\
+            for (mi = 0; mi < nmissings; ++mi) { \
+                if (value == missings[mi]) break; \
+            } \
+\
+            if      (mi != nmissings)            flags |= missing_flag; \
+            else if (has_min && value < min)     flags |= min_flag; \
+            else if (has_max && value > max)     flags |= max_flag; \
+\
+            if (check_delta && \
+                !(flags           & bad_flags) && \
+                !(prev_flagsp[vi] & bad_flags) && \
+                abs_f((abs_t)(value - prev_datap[vi])) > max_delta) { \
+\
+                flags |= delta_flag; \
+            } \
+\
+            flagsp[vi] = flags; \
+        } \
+\
+        prev_datap   = datap; \
+        prev_flagsp  = flagsp; \
+        datap       += sample_size; \
+        flagsp      += sample_size; \
+    } \
+}
+
 #endif /* _CDS_PRIVATE_ */
@@ -0,0 +1,700 @@
+/*******************************************************************************
+*
+*  COPYRIGHT (C) 2010 Battelle Memorial Institute.  All Rights Reserved.
+*
+********************************************************************************
+*
+*  Author:
+*     name:  Brian Ermold
+*     phone: (509) 375-2277
+*     email: brian.ermold@pnl.gov
+*
+********************************************************************************
+*
+*  REPOSITORY INFORMATION:
+*    $Revision$
+*    $Author$
+*    $Date$
+*
+********************************************************************************
+*
+*  NOTE: DOXYGEN is used to generate documentation for this file.
+*
+*******************************************************************************/
+
+/** @file cds_simd.c
+ *  SIMD Data Copy and Conversion Functions.
+ *
+ *  These are fast paths for the most common type conversions done by
+ *  cds_copy_array(), and for the linear unit conversions done by
+ *  cds_convert_units(). The input values are widened to doubles, the
+ *  missing value and range checks are done using compare masks and blends,
+ *  and the results are narrowed back to the output type. The scalar macros
+ *  in cds_private.h are still used for everything else, including the last
+ *  few values that do not fill a full vector.
+ *
+ *  All values of the supported input and output types are exactly
+ *  representable as doubles, so the results are identical to the ones
+ *  produced by the CDS_COPY_ARRAY and CDS_CONVERT_UNITS macros.
+ */
+
+#include "cds3.h"
+#include "cds_private.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CDS_HAVE_SIMD 1
+#include <math.h>
+#include <string.h>
+#include <immintrin.h>
+#endif
+
+#ifdef CDS_HAVE_SIMD
+
+/*******************************************************************************
+ *  Private Data and Functions
+ */
+/** @privatesection */
+
+/**
+ *  Values used by the SIMD kernels.
+ *
+ *  Checks that are not being done are disabled by using values that can
+ *  never match, so the kernels do not need any data-dependent branches.
+ */
+typedef struct {
+
+    double imv;    /**< input missing value, or NaN                         */
+    double omv;    /**< output missing value                                */
+    double min;    /**< valid min value, or -Inf                            */
+    double ormin;  /**< value to use for values less than min               */
+    double max;    /**< valid max value, or +Inf                            */
+    double ormax;  /**< value to use for values greater than max            */
+
+    double slope;      /**< unit conversion slope                           */
+    double intercept;  /**< unit conversion intercept                       */
+
+} _SIMDCopyParams;
+
+/** SIMD instruction sets: 0 = not checked yet, 1 = SSE2, 2 = AVX2 */
+static int _SIMDLevel = 0;
+
+static int _cds_simd_level(void)
+{
+    if (!_SIMDLevel) {
+        __builtin_cpu_init();
+        _SIMDLevel = (__builtin_cpu_supports("avx2")) ? 2 : 1;
+    }
+
+    return(_SIMDLevel);
+}
+
+static double _cds_simd_value(CDSDataType type, void *vp)
+{
+    switch (type) {
+        case CDS_SHORT:  return((double)*(short *)vp);
+        case CDS_INT:    return((double)*(int *)vp);
+        case CDS_FLOAT:  return((double)*(float *)vp);
+        case CDS_DOUBLE: return(*(double *)vp);
+        default:         return(0.0);
+    }
+}
+
+static void _cds_simd_init_params(
+    _SIMDCopyParams *params,
+    CDSDataType      in_type,
+    CDSDataType      out_type,
+    size_t           nmap,
+    void            *in_map,
+    void            *out_map,
+    void            *out_min,
+    void            *orv_min,
+    void            *out_max,
+    void            *orv_max)
+{
+    if (nmap) {
+        params->imv = _cds_simd_value(in_type,  in_map);
+        params->omv = _cds_simd_value(out_type, out_map);
+    }
+    else {
+        params->imv = NAN;
+        params->omv = 0.0;
+    }
+
+    if (orv_min) {
+        params->min   = _cds_simd_value(out_type, out_min);
+        params->ormin = _cds_simd_value(out_type, orv_min);
+    }
+    else {
+        params->min   = -INFINITY;
+        params->ormin = 0.0;
+    }
+
+    if (orv_max) {
+        params->max   = _cds_simd_value(out_type, out_max);
+        params->ormax = _cds_simd_value(out_type, orv_max);
+    }
+    else {
+        params->max   = INFINITY;
+        params->ormax = 0.0;
+    }
+
+    params->slope     = 1.0;
+    params->intercept = 0.0;
+}
+
+static int _cds_simd_type(CDSDataType type)
+{
+    return(type == CDS_SHORT || type == CDS_INT ||
+           type == CDS_FLOAT || type == CDS_DOUBLE);
+}
+
+/*****  SSE2 Kernels  *****/
+
+#define SSE2_FUNC static inline __attribute__((always_inline, target("sse2")))
+
+SSE2_FUNC __m128d _sse2_load_short(const void *p)
+{
+    int     pair;
+    __m128i x;
+
+    memcpy(&pair, p, sizeof(int));
+    x = _mm_cvtsi32_si128(pair);
+    x = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+
+    return(_mm_cvtepi32_pd(x));
+}
+
+SSE2_FUNC __m128d _sse2_load_int(const void *p)
+{
+    return(_mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *)p)));
+}
+
+SSE2_FUNC __m128d _sse2_load_float(const void *p)
+{
+    return(_mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)p))));
+}
+
+SSE2_FUNC __m128d _sse2_load_double(const void *p)
+{
+    return(_mm_loadu_pd((const double *)p));
+}
+
+SSE2_FUNC __m128d _sse2_blend(__m128d a, __m128d b, __m128d mask)
+{
+    return(_mm_or_pd(_mm_and_pd(mask, b), _mm_andnot_pd(mask, a)));
+}
+
+SSE2_FUNC __m128d _sse2_round(__m128d v)
+{
+    __m128d half = _mm_set1_pd(0.5);
+    __m128d neg  = _mm_cmplt_pd(v, _mm_setzero_pd());
+
+    return(_mm_add_pd(v, _sse2_blend(half, _mm_set1_pd(-0.5), neg)));
+}
+
+SSE2_FUNC __m128d _sse2_noround(__m128d v)
+{
+    return(v);
+}
+
+SSE2_FUNC __m128d _sse2_double(__m128d v)
+{
+    return(v);
+}
+
+SSE2_FUNC __m128d _sse2_single(__m128d v)
+{
+    return(_mm_cvtps_pd(_mm_cvtpd_ps(v)));
+}
+
+SSE2_FUNC void _sse2_store_short(void *p, __m128d v)
+{
+    __m128i x = _mm_cvttpd_epi32(v);
+    int     pair;
+
+    /* truncate to 16 bits the same way the scalar cast does */
+
+    x    = _mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 2, 0));
+    pair = _mm_cvtsi128_si32(x);
+    memcpy(p, &pair, sizeof(int));
+}
+
+SSE2_FUNC void _sse2_store_int(void *p, __m128d v)
+{
+    _mm_storel_epi64((__m128i *)p, _mm_cvttpd_epi32(v));
+}
+
+SSE2_FUNC void _sse2_store_float(void *p, __m128d v)
+{
+    _mm_storel_epi64((__m128i *)p, _mm_castps_si128(_mm_cvtpd_ps(v)));
+}
+
+SSE2_FUNC void _sse2_store_double(void *p, __m128d v)
+{
+    _mm_storeu_pd((double *)p, v);
+}
+
+SSE2_FUNC __m128d _sse2_linear(__m128d x, __m128d slope, __m128d intercept)
+{
+    return(_mm_add_pd(_mm_mul_pd(x, slope), intercept));
+}
+
+/* The range checks are done on the input values, and the rounding after
+ * the out-of-range values have been replaced, as in CDS_COPY_ARRAY. */
+
+#define SSE2_COPY_LOOP(in_t, out_t, LOAD, ROUND, STORE) \
+for (i = 0; i + 2 <= length; i += 2) { \
+    x = LOAD((in_t *)in_data + i); \
+    v = _sse2_blend(x, ormax, _mm_cmpgt_pd(x, max)); \
+    v = _sse2_blend(v, ormin, _mm_cmplt_pd(x, min)); \
+    v = _sse2_blend(v, omv,   _mm_cmpeq_pd(x, imv)); \
+    STORE((out_t *)out_data + i, ROUND(v)); \
+}
+
+__attribute__((target("sse2")))
+static size_t _cds_copy_array_sse2(
+    CDSDataType      in_type,
+    size_t           length,
+    void            *in_data,
+    CDSDataType      out_type,
+    void            *out_data,
+    _SIMDCopyParams *params)
+{
+    __m128d imv   = _mm_set1_pd(params->imv);
+    __m128d omv   = _mm_set1_pd(params->omv);
+    __m128d min   = _mm_set1_pd(params->min);
+    __m128d ormin = _mm_set1_pd(params->ormin);
+    __m128d max   = _mm_set1_pd(params->max);
+    __m128d ormax = _mm_set1_pd(params->ormax);
+    __m128d x, v;
+    size_t  i = 0;
+
+    if (out_type == CDS_DOUBLE) {
+        switch (in_type) {
+            case CDS_SHORT:  SSE2_COPY_LOOP(short,  double, _sse2_load_short,  _sse2_noround, _sse2_store_double); break;
+            case CDS_INT:    SSE2_COPY_LOOP(int,    double, _sse2_load_int,    _sse2_noround, _sse2_store_double); break;
+            case CDS_FLOAT:  SSE2_COPY_LOOP(float,  double, _sse2_load_float,  _sse2_noround, _sse2_store_double); break;
+            case CDS_DOUBLE: SSE2_COPY_LOOP(double, double, _sse2_load_double, _sse2_noround, _sse2_store_double); break;
+            default: break;
+        }
+    }
+    else {
+        switch (out_type) {
+            case CDS_SHORT:  SSE2_COPY_LOOP(double, short,  _sse2_load_double, _sse2_round,   _sse2_store_short);  break;
+            case CDS_INT:    SSE2_COPY_LOOP(double, int,    _sse2_load_double, _sse2_round,   _sse2_store_int);    break;
+            case CDS_FLOAT:  SSE2_COPY_LOOP(double, float,  _sse2_load_double, _sse2_noround, _sse2_store_float);  break;
+            default: break;
+        }
+    }
+
+    return(i);
+}
+
+/* For unit conversions the rounding and range checks are done on the
+ * converted values, as in the CDS_CONVERT_UNITS macros. Conversions that
+ * CDS_CONVERT_UNITS_FLOAT does in single precision round the result to
+ * float before the checks. */
+
+#define SSE2_CONVERT_LOOP(in_t, out_t, LOAD, PREC, ROUND, STORE) \
+for (i = 0; i + 2 <= length; i += 2) { \
+    x = LOAD((in_t *)in_data + i); \
+    y = ROUND(PREC(_sse2_linear(x, slope, intercept))); \
+    v = _sse2_blend(y, ormax, _mm_cmpgt_pd(y, max)); \
+    v = _sse2_blend(v, ormin, _mm_cmplt_pd(y, min)); \
+    v = _sse2_blend(v, omv,   _mm_cmpeq_pd(x, imv)); \
+    STORE((out_t *)out_data + i, v); \
+}
+
+#define SSE2_CONVERT_TO(in_t, LOAD, FLOAT_PREC) \
+switch (out_type) { \
+    case CDS_SHORT:  SSE2_CONVERT_LOOP(in_t, short,  LOAD, _sse2_double, _sse2_round,   _sse2_store_short);  break; \
+    case CDS_INT:    SSE2_CONVERT_LOOP(in_t, int,    LOAD, _sse2_double, _sse2_round,   _sse2_store_int);    break; \
+    case CDS_FLOAT:  SSE2_CONVERT_LOOP(in_t, float,  LOAD, FLOAT_PREC,   _sse2_noround, _sse2_store_float);  break; \
+    case CDS_DOUBLE: SSE2_CONVERT_LOOP(in_t, double, LOAD, _sse2_double, _sse2_noround, _sse2_store_double); break; \
+    default: break; \
+}
+
+__attribute__((target("sse2")))
+static size_t _cds_convert_units_sse2(
+    CDSDataType      in_type,
+    size_t           length,
+    void            *in_data,
+    CDSDataType      out_type,
+    void            *out_data,
+    _SIMDCopyParams *params)
+{
+    __m128d imv       = _mm_set1_pd(params->imv);
+    __m128d omv       = _mm_set1_pd(params->omv);
+    __m128d min       = _mm_set1_pd(params->min);
+    __m128d ormin     = _mm_set1_pd(params->ormin);
+    __m128d max       = _mm_set1_pd(params->max);
+    __m128d ormax     = _mm_set1_pd(params->ormax);
+    __m128d slope     = _mm_set1_pd(params->slope);
+    __m128d intercept = _mm_set1_pd(params->intercept);
+    __m128d x, y, v;
+    size_t  i = 0;
+
+    switch (in_type) {
+        case CDS_SHORT:  SSE2_CONVERT_TO(short,  _sse2_load_short,  _sse2_single); break;
+        case CDS_INT:    SSE2_CONVERT_TO(int,    _sse2_load_int,    _sse2_double); break;
+        case CDS_FLOAT:  SSE2_CONVERT_TO(float,  _sse2_load_float,  _sse2_single); break;
+        case CDS_DOUBLE: SSE2_CONVERT_TO(double, _sse2_load_double, _sse2_double); break;
+        default: break;
+    }
+
+    return(i);
+}
+
+/*****  AVX2 Kernels  *****/
+
+#define AVX2_FUNC static inline __attribute__((always_inline, target("avx2")))
+
+AVX2_FUNC __m256d _avx2_load_short(const void *p)
+{
+    __m128i x = _mm_loadl_epi64((const __m128i *)p);
+    return(_mm256_cvtepi32_pd(_mm_cvtepi16_epi32(x)));
+}
+
+AVX2_FUNC __m256d _avx2_load_int(const void *p)
+{
+    return(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *)p)));
+}
+
+AVX2_FUNC __m256d _avx2_load_float(const void *p)
+{
+    return(_mm256_cvtps_pd(_mm_loadu_ps((const float *)p)));
+}
+
+AVX2_FUNC __m256d _avx2_load_double(const void *p)
+{
+    return(_mm256_loadu_pd((const double *)p));
+}
+
+AVX2_FUNC __m256d _avx2_round(__m256d v)
+{
+    __m256d neg = _mm256_cmp_pd(v, _mm256_setzero_pd(), _CMP_LT_OQ);
+    return(_mm256_add_pd(v,
+        _mm256_blendv_pd(_mm256_set1_pd(0.5), _mm256_set1_pd(-0.5), neg)));
+}
+
+AVX2_FUNC __m256d _avx2_noround(__m256d v)
+{
+    return(v);
+}
+
+AVX2_FUNC __m256d _avx2_double(__m256d v)
+{
+    return(v);
+}
+
+AVX2_FUNC __m256d _avx2_single(__m256d v)
+{
+    return(_mm256_cvtps_pd(_mm256_cvtpd_ps(v)));
+}
+
+AVX2_FUNC void _avx2_store_short(void *p, __m256d v)
+{
+    __m128i x = _mm256_cvttpd_epi32(v);
+
+    /* truncate to 16 bits the same way the scalar cast does */
+
+    x = _mm_shuffle_epi8(x,
+        _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1));
+
+    _mm_storel_epi64((__m128i *)p, x);
+}
+
+AVX2_FUNC void _avx2_store_int(void *p, __m256d v)
+{
+    _mm_storeu_si128((__m128i *)p, _mm256_cvttpd_epi32(v));
+}
+
+AVX2_FUNC void _avx2_store_float(void *p, __m256d v)
+{
+    _mm_storeu_ps((float *)p, _mm256_cvtpd_ps(v));
+}
+
+AVX2_FUNC void _avx2_store_double(void *p, __m256d v)
+{
+    _mm256_storeu_pd((double *)p, v);
+}
+
+AVX2_FUNC __m256d _avx2_linear(__m256d x, __m256d slope, __m256d intercept)
+{
+    return(_mm256_add_pd(_mm256_mul_pd(x, slope), intercept));
+}
+
+#define AVX2_COPY_LOOP(in_t, out_t, LOAD, ROUND, STORE) \
+for (i = 0; i + 4 <= length; i += 4) { \
+    x = LOAD((in_t *)in_data + i); \
+    v = _mm256_blendv_pd(x, ormax, _mm256_cmp_pd(x, max, _CMP_GT_OQ)); \
+    v = _mm256_blendv_pd(v, ormin, _mm256_cmp_pd(x, min, _CMP_LT_OQ)); \
+    v = _mm256_blendv_pd(v, omv,   _mm256_cmp_pd(x, imv, _CMP_EQ_OQ)); \
+    STORE((out_t *)out_data + i, ROUND(v)); \
+}
+
+__attribute__((target("avx2")))
+static size_t _cds_copy_array_avx2(
+    CDSDataType      in_type,
+    size_t           length,
+    void            *in_data,
+    CDSDataType      out_type,
+    void            *out_data,
+    _SIMDCopyParams *params)
+{
+    __m256d imv   = _mm256_set1_pd(params->imv);
+    __m256d omv   = _mm256_set1_pd(params->omv);
+    __m256d min   = _mm256_set1_pd(params->min);
+    __m256d ormin = _mm256_set1_pd(params->ormin);
+    __m256d max   = _mm256_set1_pd(params->max);
+    __m256d ormax = _mm256_set1_pd(params->ormax);
+    __m256d x, v;
+    size_t  i = 0;
+
+    if (out_type == CDS_DOUBLE) {
+        switch (in_type) {
+            case CDS_SHORT:  AVX2_COPY_LOOP(short,  double, _avx2_load_short,  _avx2_noround, _avx2_store_double); break;
+            case CDS_INT:    AVX2_COPY_LOOP(int,    double, _avx2_load_int,    _avx2_noround, _avx2_store_double); break;
+            case CDS_FLOAT:  AVX2_COPY_LOOP(float,  double, _avx2_load_float,  _avx2_noround, _avx2_store_double); break;
+            case CDS_DOUBLE: AVX2_COPY_LOOP(double, double, _avx2_load_double, _avx2_noround, _avx2_store_double); break;
+            default: break;
+        }
+    }
+    else {
+        switch (out_type) {
+            case CDS_SHORT:  AVX2_COPY_LOOP(double, short,  _avx2_load_double, _avx2_round,   _avx2_store_short);  break;
+            case CDS_INT:    AVX2_COPY_LOOP(double, int,    _avx2_load_double, _avx2_round,   _avx2_store_int);    break;
+            case CDS_FLOAT:  AVX2_COPY_LOOP(double, float,  _avx2_load_double, _avx2_noround, _avx2_store_float);  break;
+            default: break;
+        }
+    }
+
+    return(i);
+}
+
+#define AVX2_CONVERT_LOOP(in_t, out_t, LOAD, PREC, ROUND, STORE) \
+for (i = 0; i + 4 <= length; i += 4) { \
+    x = LOAD((in_t *)in_data + i); \
+    y = ROUND(PREC(_avx2_linear(x, slope, intercept))); \
+    v = _mm256_blendv_pd(y, ormax, _mm256_cmp_pd(y, max, _CMP_GT_OQ)); \
+    v = _mm256_blendv_pd(v, ormin, _mm256_cmp_pd(y, min, _CMP_LT_OQ)); \
+    v = _mm256_blendv_pd(v, omv,   _mm256_cmp_pd(x, imv, _CMP_EQ_OQ)); \
+    STORE((out_t *)out_data + i, v); \
+}
+
+#define AVX2_CONVERT_TO(in_t, LOAD, FLOAT_PREC) \
+switch (out_type) { \
+    case CDS_SHORT:  AVX2_CONVERT_LOOP(in_t, short,  LOAD, _avx2_double, _avx2_round,   _avx2_store_short);  break; \
+    case CDS_INT:    AVX2_CONVERT_LOOP(in_t, int,    LOAD, _avx2_double, _avx2_round,   _avx2_store_int);    break; \
+    case CDS_FLOAT:  AVX2_CONVERT_LOOP(in_t, float,  LOAD, FLOAT_PREC,   _avx2_noround, _avx2_store_float);  break; \
+    case CDS_DOUBLE: AVX2_CONVERT_LOOP(in_t, double, LOAD, _avx2_double, _avx2_noround, _avx2_store_double); break; \
+    default: break; \
+}
+
+__attribute__((target("avx2")))
+static size_t _cds_convert_units_avx2(
+    CDSDataType      in_type,
+    size_t           length,
+    void            *in_data,
+    CDSDataType      out_type,
+    void            *out_data,
+    _SIMDCopyParams *params)
+{
+    __m256d imv       = _mm256_set1_pd(params->imv);
+    __m256d omv       = _mm256_set1_pd(params->omv);
+    __m256d min       = _mm256_set1_pd(params->min);
+    __m256d ormin     = _mm256_set1_pd(params->ormin);
+    __m256d max       = _mm256_set1_pd(params->max);
+    __m256d ormax     = _mm256_set1_pd(params->ormax);
+    __m256d slope     = _mm256_set1_pd(params->slope);
+    __m256d intercept = _mm256_set1_pd(params->intercept);
+    __m256d x, y, v;
+    size_t  i = 0;
+
+    switch (in_type) {
+        case CDS_SHORT:  AVX2_CONVERT_TO(short,  _avx2_load_short,  _avx2_single); break;
+        case CDS_INT:    AVX2_CONVERT_TO(int,    _avx2_load_int,    _avx2_double); break;
+        case CDS_FLOAT:  AVX2_CONVERT_TO(float,  _avx2_load_float,  _avx2_single); break;
+        case CDS_DOUBLE: AVX2_CONVERT_TO(double, _avx2_load_double, _avx2_double); break;
+        default: break;
+    }
+
+    return(i);
+}
+
+#endif /* CDS_HAVE_SIMD */
+
+/**
+ *  PRIVATE: Copy the leading part of an array using SIMD instructions.
+ *
+ *  This function handles short, int, float, and double to double, and
+ *  double to short, int, and float conversions that use at most one
+ *  missing value mapping. The AVX2 kernels are used if the CPU supports
+ *  them, otherwise the SSE2 kernels are used.
+ *
+ *  The arguments are the same as for cds_copy_array() after the min/max
+ *  values have been adjusted, and the output array must already be
+ *  allocated. The values that are not copied by this function must be
+ *  copied using the CDS_COPY_ARRAY macro.
+ *
+ *  @return
+ *    - number of values copied
+ *    - 0 if this conversion is not supported
+ */
+size_t _cds_copy_array_simd(
+    CDSDataType  in_type,
+    size_t       length,
+    void        *in_data,
+    CDSDataType  out_type,
+    void        *out_data,
+    size_t       nmap,
+    void        *in_map,
+    void        *out_map,
+    void        *out_min,
+    void        *orv_min,
+    void        *out_max,
+    void        *orv_max)
+{
+#ifdef CDS_HAVE_SIMD
+    _SIMDCopyParams params;
+
+    if (nmap > 1 || length < 4) {
+        return(0);
+    }
+
+    if (out_type == CDS_DOUBLE) {
+        if (in_type != CDS_SHORT && in_type != CDS_INT &&
+            in_type != CDS_FLOAT && in_type != CDS_DOUBLE) {
+            return(0);
+        }
+    }
+    else if (in_type == CDS_DOUBLE) {
+        if (out_type != CDS_SHORT && out_type != CDS_INT &&
+            out_type != CDS_FLOAT) {
+            return(0);
+        }
+    }
+    else {
+        return(0);
+    }
+
+    _cds_simd_init_params(&params, in_type, out_type,
+        nmap, in_map, out_map, out_min, orv_min, out_max, orv_max);
+
+    if (_cds_simd_level() == 2) {
+        return(_cds_copy_array_avx2(
+            in_type, length, in_data, out_type, out_data, &params));
+    }
+
+    return(_cds_copy_array_sse2(
+        in_type, length, in_data, out_type, out_data, &params));
+#else
+    (void)in_type;
+    (void)length;
+    (void)in_data;
+    (void)out_type;
+    (void)out_data;
+    (void)nmap;
+    (void)in_map;
+    (void)out_map;
+    (void)out_min;
+    (void)orv_min;
+    (void)out_max;
+    (void)orv_max;
+
+    return(0);
+#endif
+}
+
+/**
+ *  PRIVATE: Convert the units of the leading part of an array using SIMD
+ *  instructions.
+ *
+ *  This function handles linear unit conversions (value * slope + intercept)
+ *  between the short, int, float, and double data types that use at most
+ *  one missing value mapping.
+ *
+ *  The short and float to float conversions are done in single precision
+ *  by the CDS_CONVERT_UNITS_FLOAT macro, so these are only supported if the
+ *  single precision UDUNITS-2 conversion is also known to be linear.
+ *
+ *  The other arguments are the same as for cds_convert_units() after the
+ *  min/max values have been adjusted, and the output array must already be
+ *  allocated. The values that are not converted by this function must be
+ *  converted using the CDS_CONVERT_UNITS macros.
+ *
+ *  @param  slope        - unit conversion slope
+ *  @param  intercept    - unit conversion intercept
+ *  @param  single_ok    - flag indicating that the single precision
+ *                         conversion is also linear
+ *
+ *  @return
+ *    - number of values converted
+ *    - 0 if this conversion is not supported
+ */
+size_t _cds_convert_units_simd(
+    double       slope,
+    double       intercept,
+    int          single_ok,
+    CDSDataType  in_type,
+    size_t       length,
+    void        *in_data,
+    CDSDataType  out_type,
+    void        *out_data,
+    size_t       nmap,
+    void        *in_map,
+    void        *out_map,
+    void        *out_min,
+    void        *orv_min,
+    void        *out_max,
+    void        *orv_max)
+{
+#ifdef CDS_HAVE_SIMD
+    _SIMDCopyParams params;
+
+    if (nmap > 1 || length < 4 ||
+        !_cds_simd_type(in_type) || !_cds_simd_type(out_type)) {
+
+        return(0);
+    }
+
+    if (out_type == CDS_FLOAT &&
+        (in_type == CDS_SHORT || in_type == CDS_FLOAT) &&
+        !single_ok) {
+
+        return(0);
+    }
+
+    _cds_simd_init_params(&params, in_type, out_type,
+        nmap, in_map, out_map, out_min, orv_min, out_max, orv_max);
+
+    params.slope     = slope;
+    params.intercept = intercept;
+
+    if (_cds_simd_level() == 2) {
+        return(_cds_convert_units_avx2(
+            in_type, length, in_data, out_type, out_data, &params));
+    }
+
+    return(_cds_convert_units_sse2(
+        in_type, length, in_data, out_type, out_data, &params));
+#else
+    (void)slope;
+    (void)intercept;
+    (void)single_ok;
+    (void)in_type;
+    (void)length;
+    (void)in_data;
+    (void)out_type;
+    (void)out_data;
+    (void)nmap;
+    (void)in_map;
+    (void)out_map;
+    (void)out_min;
+    (void)orv_min;
+    (void)out_max;
+    (void)orv_max;
+
+    return(0);
+#endif
+}
@@ -30,9 +30,11 @@
 #include "cds_private.h"
 #include "../config.h"
 
+#include <ctype.h>
 #include <errno.h>
 #include UDUNITS_INCLUDE
 #include <math.h>
+#include <pthread.h>
 
 /*******************************************************************************
  *  Private Data and Functions
@@ -43,7 +45,8 @@
 #define UDUNITS_ERROR(sender, status, ...) \
     _cds_udunits_error(sender, __func__, __FILE__, __LINE__, status, __VA_ARGS__)
 
-static ut_system *_UnitSystem;
+static ut_system      *_UnitSystem;
+static pthread_mutex_t _UnitSystemMutex = PTHREAD_MUTEX_INITIALIZER;
 
 typedef struct {
     char *symbol;
@@ -53,6 +56,179 @@ typedef struct {
 static size_t     _NumMapSymbols = 0;
 static SymbolMap *_MapSymbols    = (SymbolMap *)NULL;
 
+/**
+ *  CDS unit converter.
+ *
+ *  Most unit conversions are linear (value * slope + intercept). For these
+ *  the slope and intercept are saved so cds_convert_units() can convert the
+ *  data using the SIMD kernels instead of calling UDUNITS-2 for every value.
+ */
+typedef struct {
+
+    cv_converter *uc;         /* UDUNITS-2 units converter                    */
+    int           linear;     /* flag: conversion is value * slope + intercept */
+    int           single_ok;  /* flag: single precision conversion is linear  */
+    double        slope;      /* slope of a linear conversion                 */
+    double        intercept;  /* intercept of a linear conversion             */
+    int           refcount;   /* number of references to this converter       */
+
+} _CDSUnitConverter;
+
+/**
+ *  Unit converter cache entry.
+ *
+ *  Entries with a NULL converter are used to cache unit pairs that are
+ *  equal and do not need to be converted.
+ */
+typedef struct _UnitCacheEntry {
+
+    char                   *from_units; /* normalized from_units string      */
+    char                   *to_units;   /* normalized to_units string        */
+    unsigned int            hash;       /* hash of the unit strings          */
+    _CDSUnitConverter      *converter;  /* units converter, or NULL if equal */
+    struct _UnitCacheEntry *next;       /* next entry in the hash bucket     */
+
+} _UnitCacheEntry;
+
+/** Number of hash buckets in the unit converter cache. */
+#define UNIT_CACHE_BUCKETS 256
+
+/** Max number of unit pairs to cache before the cache is flushed. */
+#define UNIT_CACHE_MAX_ENTRIES 4096
+
+static _UnitCacheEntry *_UnitCache[UNIT_CACHE_BUCKETS];
+static size_t           _UnitCacheEntries = 0;
+static size_t           _UnitCacheHits    = 0;
+static size_t           _UnitCacheMisses  = 0;
+static pthread_mutex_t  _UnitCacheMutex   = PTHREAD_MUTEX_INITIALIZER;
+
+/** Number of values used to check for linear unit conversions. */
+#define NUM_LINEAR_PROBES 16
+
+/** Values used to check for linear unit conversions. */
+static double _LinearProbes[NUM_LINEAR_PROBES] = {
+    -9999.0, -273.15, -40.0, -1.0, -0.0, 0.0, 0.001, 0.1,
+    0.5, 1.0, 7.25, 273.15, 1013.25, 86400.0, 123456.789, 1.0e20
+};
+
+/**
+ *  Check if a linear conversion matches a UDUNITS-2 converter.
+ *
+ *  The conversion is done using the same SIMD kernels used by
+ *  cds_convert_units() so the results must be bit-for-bit identical.
+ *
+ *  @param  uc        - UDUNITS-2 units converter
+ *  @param  slope     - slope of the linear conversion
+ *  @param  intercept - intercept of the linear conversion
+ *  @param  single    - check the single precision conversion
+ *
+ *  @return
+ *    - 1 if the results match for all probe values
+ *    - 0 if they do not
+ */
+static int _cds_check_linear_conversion(
+    cv_converter *uc,
+    double        slope,
+    double        intercept,
+    int           single)
+{
+    double dvals[NUM_LINEAR_PROBES];
+    float  fin[NUM_LINEAR_PROBES];
+    float  fvals[NUM_LINEAR_PROBES];
+    int    pi;
+
+    if (!isfinite(slope) || !isfinite(intercept)) {
+        return(0);
+    }
+
+    if (single) {
+
+        for (pi = 0; pi < NUM_LINEAR_PROBES; pi++) {
+            fin[pi] = (float)_LinearProbes[pi];
+        }
+
+        if (_cds_convert_units_simd(slope, intercept, 1,
+            CDS_FLOAT, NUM_LINEAR_PROBES, fin, CDS_FLOAT, fvals,
+            0, NULL, NULL, NULL, NULL, NULL, NULL) != NUM_LINEAR_PROBES) {
+
+            return(0);
+        }
+
+        for (pi = 0; pi < NUM_LINEAR_PROBES; pi++) {
+            if (fvals[pi] != cv_convert_float(uc, fin[pi])) {
+                return(0);
+            }
+        }
+    }
+    else {
+
+        if (_cds_convert_units_simd(slope, intercept, 0,
+            CDS_DOUBLE, NUM_LINEAR_PROBES, _LinearProbes, CDS_DOUBLE, dvals,
+            0, NULL, NULL, NULL, NULL, NULL, NULL) != NUM_LINEAR_PROBES) {
+
+            return(0);
+        }
+
+        for (pi = 0; pi < NUM_LINEAR_PROBES; pi++) {
+            if (dvals[pi] != cv_convert_double(uc, _LinearProbes[pi])) {
+                return(0);
+            }
+        }
+    }
+
+    return(1);
+}
+
+/**
+ *  Determine if a unit conversion is linear.
+ *
+ *  UDUNITS-2 does not provide a way to get the slope and intercept of a
+ *  conversion, so they are computed from the converted values of -0 and 1
+ *  and then checked against the UDUNITS-2 results for a set of probe
+ *  values. Converting -0 gives an intercept of -0 for scale conversions,
+ *  which keeps the sign of zero values the same as UDUNITS-2 does. Because
+ *  the slope computed this way can be off by an ulp if the intercept is not
+ *  zero (e.g. degC to K), the slope and its reciprocal rounded to 12
+ *  significant digits are also tried.
+ *
+ *  The linear flags will not be set if the conversion is not linear
+ *  (e.g. logarithmic units), or if the linear conversion does not produce
+ *  identical results.
+ *
+ *  @param  converter - pointer to the CDS unit converter
+ */
+static void _cds_check_linear_converter(_CDSUnitConverter *converter)
+{
+    cv_converter *uc = converter->uc;
+    double        intercept;
+    double        slopes[3];
+    char          string[64];
+    int           si;
+
+    intercept = cv_convert_double(uc, -0.0);
+    slopes[0] = cv_convert_double(uc, 1.0) - intercept;
+
+    snprintf(string, 64, "%.12g", slopes[0]);
+    slopes[1] = atof(string);
+
+    snprintf(string, 64, "%.12g", 1.0 / slopes[0]);
+    slopes[2] = 1.0 / atof(string);
+
+    for (si = 0; si < 3; si++) {
+
+        if (_cds_check_linear_conversion(uc, slopes[si], intercept, 0)) {
+
+            converter->linear    = 1;
+            converter->slope     = slopes[si];
+            converter->intercept = intercept;
+            converter->single_ok =
+                _cds_check_linear_conversion(uc, slopes[si], intercept, 1);
+
+            return;
+        }
+    }
+}
+
 /**
  *  Get the error message string for a UDUNITS-2 status value.
  *
@@ -263,6 +439,237 @@ static int _cds_map_symbols(void)
     return(1);
 }
 
+/**
+ *  Release a reference to a unit converter.
+ *
+ *  The unit cache mutex must be locked when this function is called.
+ *
+ *  @param  converter - pointer to the CDS unit converter
+ */
+static void _cds_release_unit_converter(_CDSUnitConverter *converter)
+{
+    if (--converter->refcount == 0) {
+        cv_free(converter->uc);
+        free(converter);
+    }
+}
+
+/**
+ *  Remove all entries from the unit converter cache.
+ *
+ *  Converters that are still being used will be freed when they are
+ *  released by cds_free_unit_converter().
+ */
+static void _cds_flush_unit_cache(void)
+{
+    _UnitCacheEntry *entry;
+    _UnitCacheEntry *next;
+    int              bi;
+
+    pthread_mutex_lock(&_UnitCacheMutex);
+
+    for (bi = 0; bi < UNIT_CACHE_BUCKETS; bi++) {
+
+        for (entry = _UnitCache[bi]; entry; entry = next) {
+
+            next = entry->next;
+
+            if (entry->converter) {
+                _cds_release_unit_converter(entry->converter);
+            }
+
+            free(entry->from_units);
+            free(entry->to_units);
+            free(entry);
+        }
+
+        _UnitCache[bi] = (_UnitCacheEntry *)NULL;
+    }
+
+    _UnitCacheEntries = 0;
+
+    pthread_mutex_unlock(&_UnitCacheMutex);
+}
+
+/**
+ *  Strip the leading and trailing white space from a units string.
+ *
+ *  @param  units  - units string
+ *  @param  length - output: length of the normalized units string
+ *
+ *  @return  pointer to the start of the normalized units string
+ */
+static const char *_cds_normalize_units(const char *units, size_t *length)
+{
+    const char *end;
+
+    while (isspace(*units)) ++units;
+
+    end = units + strlen(units);
+    while (end > units && isspace(*(end - 1))) --end;
+
+    *length = end - units;
+
+    return(units);
+}
+
+/**
+ *  Compute the hash of a unit string pair.
+ */
+static unsigned int _cds_hash_units(
+    const char *from_units,
+    size_t      from_length,
+    const char *to_units,
+    size_t      to_length)
+{
+    unsigned int hash = 5381;
+    size_t       ci;
+
+    for (ci = 0; ci < from_length; ++ci) {
+        hash = ((hash << 5) + hash) + (unsigned char)from_units[ci];
+    }
+
+    hash = ((hash << 5) + hash);
+
+    for (ci = 0; ci < to_length; ++ci) {
+        hash = ((hash << 5) + hash) + (unsigned char)to_units[ci];
+    }
+
+    return(hash);
+}
+
+/**
+ *  Load the default UDUNITS-2 unit system if one has not been loaded.
+ *
+ *  The check and the load are done while holding the unit system mutex,
+ *  so threads that need the unit system at the same time will only load
+ *  it once.
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if an error occurred
+ */
+static int _cds_load_default_unit_system(void)
+{
+    int status = 1;
+
+    pthread_mutex_lock(&_UnitSystemMutex);
+
+    if (!_UnitSystem) {
+        status = cds_init_unit_system(NULL);
+    }
+
+    pthread_mutex_unlock(&_UnitSystemMutex);
+
+    return(status);
+}
+
+/**
+ *  Create a new UDUNITS-2 unit converter.
+ *
+ *  The unit cache mutex must be locked when this function is called.
+ *
+ *  @param  from_units - normalized units to convert from
+ *  @param  to_units   - normalized units to convert to
+ *  @param  converter  - output: units converter
+ *
+ *  @return
+ *    -  1 if successful
+ *    -  0 if the units are equal
+ *    - -1 if an error occurred
+ */
+static int _cds_create_unit_converter(
+    const char         *from_units,
+    const char         *to_units,
+    _CDSUnitConverter **converter)
+{
+    cv_converter *uc;
+    ut_unit      *from;
+    ut_unit      *to;
+    ut_status     status;
+
+    *converter = (_CDSUnitConverter *)NULL;
+
+    /* Parse from_units string */
+
+    from = ut_parse(_UnitSystem, from_units, UT_ASCII);
+
+    if (!from) {
+
+        status = ut_get_status();
+
+        UDUNITS_ERROR( CDS_LIB_NAME, status,
+            "Could not parse from_units string: '%s'\n", from_units);
+
+        return(-1);
+    }
+
+    /* Parse to_units string */
+
+    to = ut_parse(_UnitSystem, to_units, UT_ASCII);
+
+    if (!to) {
+
+        status = ut_get_status();
+
+        UDUNITS_ERROR( CDS_LIB_NAME, status,
+            "Could not parse to_units string: '%s'\n", to_units);
+
+        ut_free(from);
+
+        return(-1);
+    }
+
+    /* Check if the units are equal */
+
+    if (ut_compare(from, to) == 0) {
+
+        ut_free(from);
+        ut_free(to);
+
+        return(0);
+    }
+
+    /* Get units converter */
+
+    uc = ut_get_converter(from, to);
+
+    ut_free(from);
+    ut_free(to);
+
+    if (!uc) {
+
+        status = ut_get_status();
+
+        UDUNITS_ERROR( CDS_LIB_NAME, status,
+            "Could not get units converter for: '%s' to '%s'\n",
+            from_units, to_units);
+
+        return(-1);
+    }
+
+    *converter = (_CDSUnitConverter *)calloc(1, sizeof(_CDSUnitConverter));
+
+    if (!*converter) {
+
+        ERROR( CDS_LIB_NAME,
+            "Could not get units converter for: '%s' to '%s'\n"
+            " -> memory allocation error\n",
+            from_units, to_units);
+
+        cv_free(uc);
+
+        return(-1);
+    }
+
+    (*converter)->uc       = uc;
+    (*converter)->refcount = 1;
+
+    _cds_check_linear_converter(*converter);
+
+    return(1);
+}
+
 /*******************************************************************************
  *  Public Functions
  */
@@ -304,10 +711,8 @@ int cds_compare_units(
 
     /* Load the default units system if one has not already been loaded */
 
-    if (!_UnitSystem) {
-        if (!cds_init_unit_system(NULL)) {
-            return(-1);
-        }
+    if (!_cds_load_default_unit_system()) {
+        return(-1);
     }
 
     /* Parse from_units string */
@@ -423,16 +828,18 @@ void *cds_convert_units(
     void             *out_max,
     void             *orv_max)
 {
-    cv_converter *uc = (cv_converter *)converter;
-    CDSData       in;
-    CDSData       out;
-    CDSData       imap;
-    CDSData       omap;
-    CDSData       min;
-    CDSData       max;
-    CDSData       ormin;
-    CDSData       ormax;
-    size_t        out_size;
+    _CDSUnitConverter *cuc = (_CDSUnitConverter *)converter;
+    cv_converter      *uc;
+    CDSData            in;
+    CDSData            out;
+    CDSData            imap;
+    CDSData            omap;
+    CDSData            min;
+    CDSData            max;
+    CDSData            ormin;
+    CDSData            ormax;
+    size_t             out_size;
+    size_t             done;
 
     if (!converter) {
         return(cds_copy_array(
@@ -440,6 +847,8 @@ void *cds_convert_units(
             nmap, in_map, out_map, out_min, orv_min, out_max, orv_max));
     }
 
+    uc = cuc->uc;
+
     /* Allocate memory for the output array if one was not specified */
 
     if (!out_data) {
@@ -471,6 +880,27 @@ void *cds_convert_units(
         max.vp = _cds_data_type_max(out_type);
     }
 
+    /* Use the SIMD kernels for linear conversions, and leave any
+     * remaining values for the macros below. */
+
+    if (cuc->linear) {
+
+        done = _cds_convert_units_simd(
+            cuc->slope, cuc->intercept, cuc->single_ok,
+            in_type, length, in_data, out_type, out_data,
+            nmap, in_map, out_map, min.vp, ormin.vp, max.vp, ormax.vp);
+
+        if (done) {
+            if (done == length) {
+                return(out_data);
+            }
+
+            length -= done;
+            in.bp  += done * cds_data_type_size(in_type);
+            out.bp += done * cds_data_type_size(out_type);
+        }
+    }
+
     /* Do the unit conversion */
 
     switch (in_type) {
@@ -603,12 +1033,12 @@ void *cds_convert_unit_deltas(
     void             *in_map,
     void             *out_map)
 {
-    cv_converter *uc = (cv_converter *)converter;
-    CDSData in;
-    CDSData out;
-    CDSData imap;
-    CDSData omap;
-    size_t  out_size;
+    cv_converter *uc;
+    CDSData       in;
+    CDSData       out;
+    CDSData       imap;
+    CDSData       omap;
+    size_t        out_size;
 
     if (!converter) {
         return(cds_copy_array(
@@ -616,6 +1046,8 @@ void *cds_convert_unit_deltas(
             nmap, in_map, out_map, NULL, NULL, NULL, NULL));
     }
 
+    uc = ((_CDSUnitConverter *)converter)->uc;
+
     /* Allocate memory for the output array if one was not specified */
 
     if (!out_data) {
@@ -716,12 +1148,21 @@ void *cds_convert_unit_deltas(
 /**
  *  Free a UDUNITS-2 unit converter.
  *
+ *  Unit converters are shared through the unit converter cache, so this
+ *  only releases the reference returned by cds_get_unit_converter().
+ *  The converter is freed when it is no longer referenced by the cache
+ *  or any other callers.
+ *
  *  @param  unit_converter - pointer to the units converter
  */
 void cds_free_unit_converter(CDSUnitConverter unit_converter)
 {
-    if (unit_converter) {
-        cv_free((cv_converter *)unit_converter);
+    _CDSUnitConverter *converter = (_CDSUnitConverter *)unit_converter;
+
+    if (converter) {
+        pthread_mutex_lock(&_UnitCacheMutex);
+        _cds_release_unit_converter(converter);
+        pthread_mutex_unlock(&_UnitCacheMutex);
     }
 }
 
@@ -732,6 +1173,7 @@ void cds_free_unit_converter(CDSUnitConverter unit_converter)
  */
 void cds_free_unit_system(void)
 {
+    _cds_flush_unit_cache();
     _cds_free_symbols_map();
 
     if (_UnitSystem) {
@@ -750,7 +1192,15 @@ void cds_free_unit_system(void)
  *  used by the unit system by calling cds_free_unit_system() when no
  *  more unit conversions are necessary.
  *
- *  The memory used by the returned unit converter must also be freed
+ *  Unit converters are cached using the from_units and to_units strings
+ *  (with leading and trailing white space removed), so the units strings
+ *  only need to be parsed by UDUNITS-2 the first time a conversion is
+ *  requested. This function is thread safe, including the first call
+ *  that loads the default unit system. Loading a different unit system
+ *  with cds_init_unit_system(), or freeing it with cds_free_unit_system(),
+ *  is not, and must not be done while other threads are converting units.
+ *
+ *  The reference to the returned unit converter must also be released
  *  by calling cds_free_unit_converter().
  *
  *  Error messages from this function are sent to the message handler
@@ -770,10 +1220,15 @@ int cds_get_unit_converter(
     const char       *to_units,
     CDSUnitConverter *unit_converter)
 {
-    cv_converter *converter;
-    ut_unit      *from;
-    ut_unit      *to;
-    ut_status     status;
+    _CDSUnitConverter *converter;
+    _UnitCacheEntry   *entry;
+    const char        *from;
+    const char        *to;
+    size_t             from_length;
+    size_t             to_length;
+    unsigned int       hash;
+    int                bi;
+    int                status;
 
     *unit_converter = (CDSUnitConverter)NULL;
 
@@ -783,75 +1238,140 @@ int cds_get_unit_converter(
         return(0);
     }
 
+    from = _cds_normalize_units(from_units, &from_length);
+    to   = _cds_normalize_units(to_units,   &to_length);
+
+    if (from_length == to_length &&
+        strncmp(from, to, from_length) == 0) {
+
+        return(0);
+    }
+
     /* Load the default units system if one has not already been loaded */
 
-    if (!_UnitSystem) {
-        if (!cds_init_unit_system(NULL)) {
-            return(-1);
-        }
+    if (!_cds_load_default_unit_system()) {
+        return(-1);
     }
 
-    /* Parse from_units string */
+    /* Check if this converter has already been cached */
 
-    from = ut_parse(_UnitSystem, from_units, UT_ASCII);
+    hash = _cds_hash_units(from, from_length, to, to_length);
+    bi   = hash % UNIT_CACHE_BUCKETS;
 
-    if (!from) {
+    pthread_mutex_lock(&_UnitCacheMutex);
 
-        status = ut_get_status();
+    for (entry = _UnitCache[bi]; entry; entry = entry->next) {
 
-        UDUNITS_ERROR( CDS_LIB_NAME, status,
-            "Could not parse from_units string: '%s'\n", from_units);
+        if (entry->hash == hash &&
+            strncmp(entry->from_units, from, from_length) == 0 &&
+            entry->from_units[from_length] == '\0' &&
+            strncmp(entry->to_units, to, to_length) == 0 &&
+            entry->to_units[to_length] == '\0') {
 
-        return(-1);
+            break;
+        }
     }
 
-    /* Parse to_units string */
+    if (entry) {
 
-    to = ut_parse(_UnitSystem, to_units, UT_ASCII);
+        _UnitCacheHits += 1;
 
-    if (!to) {
+        if (entry->converter) {
+            entry->converter->refcount += 1;
+            *unit_converter = (CDSUnitConverter)entry->converter;
+            status = 1;
+        }
+        else {
+            status = 0;
+        }
 
-        status = ut_get_status();
+        pthread_mutex_unlock(&_UnitCacheMutex);
+        return(status);
+    }
 
-        UDUNITS_ERROR( CDS_LIB_NAME, status,
-            "Could not parse to_units string: '%s'\n", to_units);
+    _UnitCacheMisses += 1;
 
-        ut_free(from);
+    /* Create a new cache entry */
 
-        return(-1);
-    }
+    entry = (_UnitCacheEntry *)calloc(1, sizeof(_UnitCacheEntry));
 
-    /* Check if the units are equal */
+    if (!entry ||
+        !(entry->from_units = strndup(from, from_length)) ||
+        !(entry->to_units   = strndup(to,   to_length))) {
 
-    if (ut_compare(from, to) == 0) {
+        ERROR( CDS_LIB_NAME,
+            "Could not get units converter for: '%s' to '%s'\n"
+            " -> memory allocation error\n",
+            from_units, to_units);
 
-        ut_free(from);
-        ut_free(to);
+        if (entry) {
+            if (entry->from_units) free(entry->from_units);
+            free(entry);
+        }
 
-        return(0);
+        pthread_mutex_unlock(&_UnitCacheMutex);
+        return(-1);
     }
 
-    /* Get units converter */
+    /* Create the converter */
 
-    converter = ut_get_converter(from, to);
+    status = _cds_create_unit_converter(
+        entry->from_units, entry->to_units, &converter);
 
-    ut_free(from);
-    ut_free(to);
+    if (status < 0) {
+        free(entry->from_units);
+        free(entry->to_units);
+        free(entry);
+        pthread_mutex_unlock(&_UnitCacheMutex);
+        return(-1);
+    }
 
-    if (!converter) {
+    /* Add the entry to the cache, flushing it first if it is full */
 
-        status = ut_get_status();
+    if (_UnitCacheEntries >= UNIT_CACHE_MAX_ENTRIES) {
+        pthread_mutex_unlock(&_UnitCacheMutex);
+        _cds_flush_unit_cache();
+        pthread_mutex_lock(&_UnitCacheMutex);
+    }
 
-        UDUNITS_ERROR( CDS_LIB_NAME, status,
-            "Could not get units converter for: '%s' to '%s'\n",
-            from_units, to_units);
+    entry->hash      = hash;
+    entry->converter = converter;
+    entry->next      = _UnitCache[bi];
+    _UnitCache[bi]   = entry;
 
-        return(-1);
+    _UnitCacheEntries += 1;
+
+    if (converter) {
+        converter->refcount += 1;
+        *unit_converter = (CDSUnitConverter)converter;
     }
 
-    *unit_converter = (CDSUnitConverter)converter;
+    pthread_mutex_unlock(&_UnitCacheMutex);
 
-    return(1);
+    return(status);
+}
+
+/**
+ *  Get the unit converter cache statistics.
+ *
+ *  @param  hits     - output: number of cds_get_unit_converter() calls
+ *                     that found the converter in the cache
+ *  @param  misses   - output: number of cds_get_unit_converter() calls
+ *                     that had to create a new converter
+ *  @param  nentries - output: number of unit pairs currently cached
+ */
+void cds_get_unit_converter_stats(
+    size_t *hits,
+    size_t *misses,
+    size_t *nentries)
+{
+    pthread_mutex_lock(&_UnitCacheMutex);
+
+    if (hits)     *hits     = _UnitCacheHits;
+    if (misses)   *misses   = _UnitCacheMisses;
+    if (nentries) *nentries = _UnitCacheEntries;
+
+    pthread_mutex_unlock(&_UnitCacheMutex);
 }
 
 /**
@@ -967,6 +1487,10 @@ int cds_map_symbol_to_unit(const char *symbol, const char *name)
 
     ut_free(unit);
 
+    /* Cached converters may have used the old symbol mapping */
+
+    _cds_flush_unit_cache();
+
     if (status != UT_SUCCESS) {
 
         UDUNITS_ERROR( CDS_LIB_NAME, status,
@@ -1011,10 +1535,8 @@ time_t cds_validate_time_units(char *time_units)
 
     /* Load the default units system if one has not already been loaded */
 
-    if (!_UnitSystem) {
-        if (!cds_init_unit_system(NULL)) {
-            return(-1);
-        }
+    if (!_cds_load_default_unit_system()) {
+        return(-1);
     }
 
     /* Parse the seconds since 1970 string */
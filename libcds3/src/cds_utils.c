@@ -621,6 +621,7 @@ void *cds_copy_array(
     CDSData ormin;
     CDSData ormax;
     size_t  out_size;
+    size_t  done;
 
     /* Allocate memory for the output array if one was not specified */
 
@@ -674,6 +675,23 @@ void *cds_copy_array(
         return(out_data);
     }
 
+    /* Use the SIMD kernels for the most common conversions, and leave
+     * any remaining values for the macros below. */
+
+    done = _cds_copy_array_simd(
+        in_type, length, in_data, out_type, out_data,
+        nmap, in_map, out_map, min.vp, ormin.vp, max.vp, ormax.vp);
+
+    if (done) {
+        if (done == length) {
+            return(out_data);
+        }
+
+        length -= done;
+        in.bp  += done * cds_data_type_size(in_type);
+        out.bp += done * cds_data_type_size(out_type);
+    }
+
     /* Cast data from the input data array to the output data array */
 
     switch (in_type) {
@@ -1520,6 +1538,174 @@ int *cds_qc_limit_checks(
     return(qc_flags);
 }
 
+/**
+ *  Perform QC limit and delta checks on an array of data values.
+ *
+ *  This function does the same checks as cds_qc_limit_checks() followed by
+ *  cds_qc_delta_checks(), but the missing, min, max, and sample to sample
+ *  delta checks are all done in a single pass over the data. The QC flags
+ *  are written directly into the qc_flags array, so no intermediate flag
+ *  arrays are needed. Delta checks across any of the other dimensions are
+ *  done after the first pass because they depend on the completed flags of
+ *  the neighboring values.
+ *
+ *  Memory will be allocated for the returned array of qc_flags if the output
+ *  array is NULL. In this case the calling process is responsible for freeing
+ *  the allocated memory.
+ *
+ *  @param  data_type      - data type of the data values
+ *  @param  ndims          - number of dimensions
+ *  @param  dim_lengths    - length of each dimension
+ *  @param  data_vp        - void pointer to the array of data values
+ *
+ *  @param  nmissings      - number of missing values
+ *  @param  missings_vp    - void pointer to the array of missing values,
+ *                           or NULL if there are no missing values
+ *  @param  missing_flag   - QC flag to use for missing values
+ *
+ *  @param  min_vp         - void pointer to the minimum value
+ *                           or NULL if there is no minimum value
+ *  @param  min_flag       - QC flag to use for values below the minimum
+ *
+ *  @param  max_vp         - void pointer to the maximum value
+ *                           or NULL if there is no maximum value
+ *  @param  max_flag       - QC flag to use for values above the maximum
+ *
+ *  @param  ndeltas        - number of delta values (must be <= ndims),
+ *                           or 0 if there are no delta checks
+ *  @param  deltas_vp      - void pointer to the array of delta values
+ *  @param  delta_flag     - QC flag to use for failed delta checks
+ *
+ *  @param  prev_sample_vp - void pointer to the data values from the previous
+ *                           sample or NULL if not available.
+ *  @param  prev_qc_flags  - array of QC values from the previous sample used to
+ *                           determine if the delta check should be preformed.
+ *
+ *  @param  bad_flags      - QC flags used to determine bad or missing values
+ *                           that should not be used for delta checks.
+ *
+ *  @param  qc_flags       - array of previously initialized qc_flags,
+ *                           or NULL to dynamically allocate memory for
+ *                           the returned array.
+ *
+ *  @return
+ *    - pointer to the array of qc_flags
+ *    - NULL if a memory allocation error occurred
+ */
+int *cds_qc_limit_delta_checks(
+    CDSDataType  data_type,
+    size_t       ndims,
+    size_t      *dim_lengths,
+    void        *data_vp,
+    size_t       nmissings,
+    void        *missings_vp,
+    int          missing_flag,
+    void        *min_vp,
+    int          min_flag,
+    void        *max_vp,
+    int          max_flag,
+    size_t       ndeltas,
+    void        *deltas_vp,
+    int          delta_flag,
+    void        *prev_sample_vp,
+    int         *prev_qc_flags,
+    int          bad_flags,
+    int         *qc_flags)
+{
+    size_t  sample_count = 1;
+    size_t  sample_size  = 1;
+    size_t  nvalues      = 1;
+    size_t *index        = (size_t *)NULL;
+    size_t *strides      = (size_t *)NULL;
+    int    *delta_flags  = (int *)NULL;
+    size_t  di;
+
+    /* Determine the sample size and count. */
+
+    if (ndims && dim_lengths) {
+        sample_count = dim_lengths[0];
+        for (di = 1; di < ndims; ++di) {
+            sample_size *= dim_lengths[di];
+        }
+    }
+
+    nvalues = sample_count * sample_size;
+
+    if (!ndeltas) {
+        deltas_vp = (void *)NULL;
+    }
+
+    /* Allocate memory for the qc_flags array if necessary */
+
+    if (!qc_flags) {
+        qc_flags = (int *)calloc(nvalues, sizeof(int));
+        if (!qc_flags) {
+            return((int *)NULL);
+        }
+    }
+
+    /* Perform the limit checks and the delta checks across
+     * the sample dimension */
+
+    switch (data_type) {
+        case CDS_DOUBLE: CDS_QC_LIMIT_DELTA_CHECKS(double,        double,  fabs);  break;
+        case CDS_FLOAT:  CDS_QC_LIMIT_DELTA_CHECKS(float,         float,   fabsf); break;
+        case CDS_INT:    CDS_QC_LIMIT_DELTA_CHECKS(int,           int,     abs);   break;
+        case CDS_SHORT:  CDS_QC_LIMIT_DELTA_CHECKS(short,         int,     abs);   break;
+        case CDS_BYTE:   CDS_QC_LIMIT_DELTA_CHECKS(signed char,   int,     abs);   break;
+        case CDS_CHAR:   CDS_QC_LIMIT_DELTA_CHECKS(unsigned char, int,     abs);   break;
+        default:
+            break;
+    }
+
+    /* Check if we are doing delta checks across any of the other dimensions  */
+
+    if (ndims   > 1 &&
+        ndeltas > 1 &&
+        deltas_vp) {
+
+        if (ndeltas > ndims) {
+            ndeltas = ndims;
+        }
+
+        /* Allocate memory for the strides, index, and delta flags arrays */
+
+        strides     = malloc(ndims * sizeof(size_t));
+        index       = malloc(ndims * sizeof(size_t));
+        delta_flags = malloc(ndeltas * sizeof(int));
+
+        if (!strides || !index || !delta_flags) {
+            if (strides)     free(strides);
+            if (index)       free(index);
+            if (delta_flags) free(delta_flags);
+            return((int *)NULL);
+        }
+
+        for (di = 0; di < ndeltas; ++di) {
+            delta_flags[di] = delta_flag;
+        }
+
+        /* Do the QC checks */
+
+        switch (data_type) {
+            case CDS_DOUBLE: CDS_QC_DELTA_CHECKS_ND(double,        double,  fabs);  break;
+            case CDS_FLOAT:  CDS_QC_DELTA_CHECKS_ND(float,         float,   fabsf); break;
+            case CDS_INT:    CDS_QC_DELTA_CHECKS_ND(int,           int,     abs);   break;
+            case CDS_SHORT:  CDS_QC_DELTA_CHECKS_ND(short,         int,     abs);   break;
+            case CDS_BYTE:   CDS_QC_DELTA_CHECKS_ND(signed char,   int,     abs);   break;
+            case CDS_CHAR:   CDS_QC_DELTA_CHECKS_ND(unsigned char, int,     abs);   break;
+            default:
+                break;
+        }
+
+        free(strides);
+        free(index);
+        free(delta_flags);
+    }
+
+    return(qc_flags);
+}
+
 /**
  *  Perform QC checks on an array of time offsets.
  *
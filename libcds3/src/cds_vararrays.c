@@ -50,13 +50,13 @@ CDSVarArray *_cds_create_vararray(CDSVarGroup *vargroup, const char *name)
 {
     CDSVarArray *vararray;
 
-    vararray = (CDSVarArray *)calloc(1, sizeof(CDSVarArray));
+    vararray = (CDSVarArray *)_cds_alloc(vargroup, sizeof(CDSVarArray));
     if (!vararray) {
         return((CDSVarArray *)NULL);
     }
 
     if (!_cds_init_object_members(vararray, CDS_VARARRAY, vargroup, name)) {
-        free(vararray);
+        _cds_free(vargroup, vararray);
         return((CDSVarArray *)NULL);
     }
 
@@ -75,7 +75,7 @@ void _cds_destroy_vararray(CDSVarArray *vararray)
     if (vararray) {
         if (vararray->vars) free(vararray->vars);
         _cds_free_object_members(vararray);
-        free(vararray);
+        _cds_free(vararray, vararray);
     }
 }
 
@@ -259,8 +259,8 @@ CDSVarArray *cds_define_vararray(CDSVarGroup *vargroup, const char *name)
 
     /* Allocate space for a new variable array */
 
-    vararrays = (CDSVarArray **)realloc(
-        vargroup->arrays, (vargroup->narrays + 2) * sizeof(CDSVarArray *));
+    vararrays = (CDSVarArray **)_cds_realloc_array(vargroup, vargroup->arrays,
+        vargroup->narrays + 1, vargroup->narrays + 2, sizeof(CDSVarArray *));
 
     if (!vararrays) {
 
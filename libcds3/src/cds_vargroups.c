@@ -50,13 +50,13 @@ CDSVarGroup *_cds_create_vargroup(CDSGroup *group, const char *name)
 {
     CDSVarGroup *vargroup;
 
-    vargroup = (CDSVarGroup *)calloc(1, sizeof(CDSVarGroup));
+    vargroup = (CDSVarGroup *)_cds_alloc(group, sizeof(CDSVarGroup));
     if (!vargroup) {
         return((CDSVarGroup *)NULL);
     }
 
     if (!_cds_init_object_members(vargroup, CDS_VARGROUP, group, name)) {
-        free(vargroup);
+        _cds_free(group, vargroup);
         return((CDSVarGroup *)NULL);
     }
 
@@ -80,12 +80,12 @@ void _cds_destroy_vargroup(CDSVarGroup *vargroup)
             for (i = 0; i < vargroup->narrays; i++) {
                 _cds_destroy_vararray(vargroup->arrays[i]);
             }
-            free(vargroup->arrays);
+            _cds_free(vargroup, vargroup->arrays);
         }
 
         _cds_free_object_members(vargroup);
 
-        free(vargroup);
+        _cds_free(vargroup, vargroup);
     }
 }
 
@@ -167,8 +167,8 @@ CDSVarGroup *cds_define_vargroup(CDSGroup *group, const char *name)
 
     /* Allocate space for a new variable group */
 
-    vargroups = (CDSVarGroup **)realloc(
-        group->vargroups, (group->nvargroups + 2) * sizeof(CDSVarGroup *));
+    vargroups = (CDSVarGroup **)_cds_realloc_array(group, group->vargroups,
+        group->nvargroups + 1, group->nvargroups + 2, sizeof(CDSVarGroup *));
 
     if (!vargroups) {
 
@@ -199,6 +199,8 @@ CDSVarGroup *cds_define_vargroup(CDSGroup *group, const char *name)
     group->nvargroups++;
     group->vargroups[group->nvargroups] = (CDSVarGroup *)NULL;
 
+    _cds_index_object(group->vargroups[group->nvargroups - 1]);
+
     return(group->vargroups[group->nvargroups - 1]);
 }
 
@@ -259,7 +261,7 @@ CDSVarGroup *cds_get_vargroup(CDSGroup *group, const char *name)
 {
     CDSVarGroup *vargroup;
 
-    vargroup = _cds_get_object(
+    vargroup = _cds_find_object(group, CDS_VARGROUP,
         (void **)group->vargroups, group->nvargroups, name);
 
     return(vargroup);
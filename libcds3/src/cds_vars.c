@@ -58,13 +58,13 @@ CDSVar *_cds_create_var(
 {
     CDSVar *var;
 
-    var = (CDSVar *)calloc(1, sizeof(CDSVar));
+    var = (CDSVar *)_cds_alloc(group, sizeof(CDSVar));
     if (!var) {
         return((CDSVar *)NULL);
     }
 
     if (!_cds_init_object_members(var, CDS_VAR, group, name)) {
-        free(var);
+        _cds_free(group, var);
         return((CDSVar *)NULL);
     }
 
@@ -89,20 +89,22 @@ void _cds_destroy_var(CDSVar *var)
     if (var) {
 
         if (var->default_fill)   free(var->default_fill);
-        if (var->dims)           free(var->dims);
+        if (var->dims)           _cds_free(var, var->dims);
 
         if (var->atts) {
             for (ai = 0; ai < var->natts; ai++) {
                 _cds_destroy_att(var->atts[ai]);
             }
-            free(var->atts);
+            _cds_free(var, var->atts);
         }
 
         cds_delete_var_data(var);
 
+        _cds_free_object_index(var->obj_index);
+
         _cds_free_object_members(var);
 
-        free(var);
+        _cds_free(var, var);
     }
 }
 
@@ -193,7 +195,7 @@ CDSVar *cds_define_var(
 
     /* Create the array of dimension pointers */
 
-    dims = (CDSDim **)calloc(ndims+1, sizeof(CDSDim *));
+    dims = (CDSDim **)_cds_alloc(group, (ndims+1) * sizeof(CDSDim *));
 
     if (!dims) {
 
@@ -216,7 +218,7 @@ CDSVar *cds_define_var(
                 " -> dimension not defined: %s\n",
                 cds_get_object_path(group), name, dim_names[di]);
 
-            free(dims);
+            _cds_free(group, dims);
             return((CDSVar *)NULL);
         }
 
@@ -227,15 +229,15 @@ CDSVar *cds_define_var(
                 " -> unlimited dimension must be first: %s\n",
                 cds_get_object_path(group), name, dim_names[di]);
 
-            free(dims);
+            _cds_free(group, dims);
             return((CDSVar *)NULL);
         }
     }
 
     /* Allocate space for a new variable */
 
-    vars = (CDSVar **)realloc(
-        group->vars, (group->nvars + 2) * sizeof(CDSVar *));
+    vars = (CDSVar **)_cds_realloc_array(group, group->vars,
+        group->nvars + 1, group->nvars + 2, sizeof(CDSVar *));
 
     if (!vars) {
 
@@ -267,6 +269,8 @@ CDSVar *cds_define_var(
     group->nvars++;
     group->vars[group->nvars] = (CDSVar *)NULL;
 
+    _cds_index_object(group->vars[group->nvars - 1]);
+
     return(group->vars[group->nvars - 1]);
 }
 
@@ -445,7 +449,8 @@ CDSVar *cds_get_var(CDSGroup *group, const char *name)
 {
     CDSVar *var;
 
-    var = _cds_get_object((void **)group->vars, group->nvars, name);
+    var = _cds_find_object(group, CDS_VAR,
+        (void **)group->vars, group->nvars, name);
 
     return(var);
 }
@@ -510,7 +515,7 @@ int cds_rename_var(CDSVar *var, const char *name)
 
     /* Rename the variable */
 
-    new_name = strdup(name);
+    new_name = _cds_strdup(var, name);
     if (!new_name) {
 
         ERROR( CDS_LIB_NAME,
@@ -521,9 +526,13 @@ int cds_rename_var(CDSVar *var, const char *name)
         return(0);
     }
 
-    free(var->name);
+    _cds_unindex_object(var);
+
+    _cds_free(var, var->name);
     var->name = new_name;
 
+    _cds_index_object(var);
+
     return(1);
 }
 
@@ -0,0 +1,237 @@
+/*******************************************************************************
+*
+*  COPYRIGHT (C) 2016 Battelle Memorial Institute.  All Rights Reserved.
+*
+********************************************************************************
+*
+*  Author:
+*     name:  Brian Ermold
+*     phone: (509) 375-2277
+*     email: brian.ermold@pnl.gov
+*
+********************************************************************************
+*
+*  REPOSITORY INFORMATION:
+*    $Revision$
+*    $Author$
+*    $Date$
+*
+********************************************************************************
+*
+*  NOTE: DOXYGEN is used to generate documentation for this file.
+*
+*******************************************************************************/
+
+/** @file dsproc_map_bench.c
+ *  Benchmark for dsproc_map_datasets().
+ *
+ *  This maps an input dataset with many variables to an output dataset
+ *  with the same variables, which is dominated by the CDS name lookups
+ *  done for every variable and attribute. It is not part of the build,
+ *  and does not need a database connection. To compare the linear object
+ *  lookups with the CDS name index, run it against a libcds3 built with a
+ *  CDS_INDEX_THRESHOLD (cds_objects.c) larger than the number of objects,
+ *  which disables the index, and against the normal build:
+ *
+ *    cc -o dsproc_map_bench dsproc_map_bench.c -I../src -I$PREFIX/include \
+ *       -L$PREFIX/lib -ldsproc3 -ldsdb3 -ldbconn -lncds3 -lcds3 -ltrans \
+ *       -larmutils -lmsngr -lnetcdf -lm -lpthread
+ *
+ *    ./dsproc_map_bench [iterations] [nvars] [natts]
+ *
+ *  The defaults are 10 iterations of a 600 variable dataset with 20
+ *  attributes per variable, 60 samples per variable, and a companion QC
+ *  variable for each variable.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dsproc3.h"
+#include "dsproc_private.h"
+
+extern DSProc *_DSProc; /**< Internal DSProc structure */
+
+/** Number of samples in the input dataset. */
+#define BENCH_NSAMPLES  60
+
+/** Start of the benchmark processing interval (2020-01-01 00:00:00). */
+#define BENCH_BEGIN  1577836800
+
+/**
+ *  Create a dataset with nvars variables and their QC variables.
+ *
+ *  @param  parent   - pointer to the parent group, or NULL
+ *  @param  name     - name of the dataset
+ *  @param  nvars    - number of variables
+ *  @param  natts    - number of attributes per variable
+ *  @param  has_data - add BENCH_NSAMPLES samples of data to the variables
+ *
+ *  @return
+ *    - pointer to the new dataset
+ *    - NULL if an error occurred
+ */
+static CDSGroup *_bench_create_dataset(
+    CDSGroup   *parent,
+    const char *name,
+    int         nvars,
+    int         natts,
+    int         has_data)
+{
+    const char *dim_names[] = { "time" };
+    float       data[BENCH_NSAMPLES];
+    int         qc_data[BENCH_NSAMPLES];
+    char        obj_name[64];
+    CDSGroup   *dataset;
+    CDSVar     *var;
+    CDSVar     *qc_var;
+    float       value;
+    int         vi, ai, si;
+
+    for (si = 0; si < BENCH_NSAMPLES; ++si) {
+        data[si]    = (float)si;
+        qc_data[si] = 0;
+    }
+
+    dataset = cds_define_group(parent, name);
+    if (!dataset) return((CDSGroup *)NULL);
+
+    if (!cds_define_dim(dataset, "time", (has_data) ? BENCH_NSAMPLES : 0, 1)) {
+        return((CDSGroup *)NULL);
+    }
+
+    for (ai = 0; ai < 20; ++ai) {
+        snprintf(obj_name, 64, "global_att_%d", ai);
+        if (!cds_define_att_text(dataset, obj_name, "value %d", ai)) {
+            return((CDSGroup *)NULL);
+        }
+    }
+
+    for (vi = 0; vi < nvars; ++vi) {
+
+        snprintf(obj_name, 64, "measurement_variable_%03d", vi);
+
+        var = cds_define_var(dataset, obj_name, CDS_FLOAT, 1, dim_names);
+        if (!var) return((CDSGroup *)NULL);
+
+        for (ai = 0; ai < natts; ++ai) {
+
+            snprintf(obj_name, 64, "attribute_name_%02d", ai);
+            value = (float)ai;
+
+            if (!cds_define_att(var, obj_name, CDS_FLOAT, 1, &value)) {
+                return((CDSGroup *)NULL);
+            }
+        }
+
+        snprintf(obj_name, 64, "qc_measurement_variable_%03d", vi);
+
+        qc_var = cds_define_var(dataset, obj_name, CDS_INT, 1, dim_names);
+        if (!qc_var) return((CDSGroup *)NULL);
+
+        if (!cds_define_att_text(qc_var, "long_name", "Quality check results")) {
+            return((CDSGroup *)NULL);
+        }
+
+        if (has_data) {
+
+            if (!cds_set_var_data(var,
+                CDS_FLOAT, 0, BENCH_NSAMPLES, NULL, data)) {
+
+                return((CDSGroup *)NULL);
+            }
+
+            if (!cds_set_var_data(qc_var,
+                CDS_INT, 0, BENCH_NSAMPLES, NULL, qc_data)) {
+
+                return((CDSGroup *)NULL);
+            }
+        }
+    }
+
+    return(dataset);
+}
+
+int main(int argc, char **argv)
+{
+    int         niters = (argc > 1) ? atoi(argv[1]) : 10;
+    int         nvars  = (argc > 2) ? atoi(argv[2]) : 600;
+    int         natts  = (argc > 3) ? atoi(argv[3]) : 20;
+    DataStream *ds;
+    CDSGroup   *in_parent;
+    CDSGroup   *in_dataset;
+    CDSVar     *var;
+    char        message[256];
+    int         iter;
+    int         vi;
+
+    /* Create a minimal process with one output datastream */
+
+    _DSProc = (DSProc *)calloc(1, sizeof(DSProc));
+    ds      = (DataStream *)calloc(1, sizeof(DataStream));
+
+    if (!_DSProc || !ds) {
+        fprintf(stderr, "%s: Memory allocation error\n", argv[0]);
+        return(1);
+    }
+
+    _DSProc->interval_begin = BENCH_BEGIN;
+    _DSProc->interval_end   = BENCH_BEGIN + 86400;
+    _DSProc->ndatastreams   = 1;
+    _DSProc->datastreams    = &ds;
+
+    ds->name = "benchC1.b1";
+    ds->role = DSR_OUTPUT;
+
+    /* Create the input and output datasets */
+
+    in_parent = cds_define_group(NULL, "ret_data");
+    if (!in_parent) {
+        fprintf(stderr, "%s: Could not create datasets\n", argv[0]);
+        return(1);
+    }
+
+    in_dataset  = _bench_create_dataset(in_parent, "input", nvars, natts, 1);
+    ds->out_cds = _bench_create_dataset(NULL, "output", nvars, natts, 0);
+
+    if (!in_dataset || !ds->out_cds) {
+        fprintf(stderr, "%s: Could not create datasets\n", argv[0]);
+        return(1);
+    }
+
+    for (vi = 0; vi < in_dataset->nvars; ++vi) {
+
+        var = in_dataset->vars[vi];
+
+        if (!dsproc_add_var_output_target(var, 0, var->name)) {
+            fprintf(stderr, "%s: Could not add output target for: %s\n",
+                argv[0], var->name);
+            return(1);
+        }
+    }
+
+    /* Map the input dataset to the output dataset */
+
+    benchmark_init();
+    benchmark(stdout, "Datasets created");
+
+    for (iter = 0; iter < niters; ++iter) {
+
+        if (!dsproc_map_datasets(in_parent, ds->out_cds, 0)) {
+            fprintf(stderr, "%s: Could not map datasets: %s\n",
+                argv[0], dsproc_get_status());
+            return(1);
+        }
+    }
+
+    snprintf(message, 256,
+        "dsproc_map_datasets: %d calls, %d variables, %d attributes each",
+        niters, nvars, natts);
+
+    benchmark(stdout, message);
+
+    cds_delete_group(in_parent);
+
+    return(0);
+}
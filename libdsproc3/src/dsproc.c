@@ -26,6 +26,7 @@
  *  Data System Process Library Functions.
  */
 
+#include <pthread.h>
 #include <signal.h>
 #include <sys/resource.h>
 
@@ -69,10 +70,25 @@ static int    _RealTimeMode = 0;       /**< real time mode flag              */
 /** maximum wait time for input data when running in real-time mode */
 static time_t _MaxRealTimeWait = 3 * 86400;
 
+/** key for the status buffers used by the ingest threads */
+static pthread_key_t  _ThreadStatusKey;
+static pthread_once_t _ThreadStatusOnce = PTHREAD_ONCE_INIT;
+
 /*******************************************************************************
  *  Static Functions Visible Only To This Module
  */
 
+static void _create_thread_status_key(void)
+{
+    pthread_key_create(&_ThreadStatusKey, NULL);
+}
+
+static char *_get_thread_status(void)
+{
+    pthread_once(&_ThreadStatusOnce, _create_thread_status_key);
+    return((char *)pthread_getspecific(_ThreadStatusKey));
+}
+
 static char *_get_logs_root()
 {
     int status;
@@ -1489,6 +1505,23 @@ static int _set_next_real_time_end(void)
  *  Private Functions Visible Only To This Library
  */
 
+/**
+ *  Private: Set the status buffer used by the calling thread.
+ *
+ *  Once a buffer has been set, dsproc_set_status() and dsproc_get_status()
+ *  will use it instead of the process status when they are called from
+ *  this thread. This is used by the ingest threads so the hook functions
+ *  they run do not overwrite the process status used by the main thread.
+ *
+ *  @param  buffer - status buffer of at least DSPROC_STATUS_LENGTH
+ *                   characters, or NULL to use the process status again
+ */
+void _dsproc_set_thread_status(char *buffer)
+{
+    pthread_once(&_ThreadStatusOnce, _create_thread_status_key);
+    pthread_setspecific(_ThreadStatusKey, buffer);
+}
+
 /**
  *  Free all memory used by the internal _DSProc structure.
  */
@@ -1515,6 +1548,8 @@ void _dsproc_destroy(void)
         DEBUG_LV1( DSPROC_LIB_NAME,
             "Freeing internal memory\n");
 
+        _dsproc_free_prefetch();
+
         if (_DSProc->site)      free((void *)_DSProc->site);
         if (_DSProc->facility)  free((void *)_DSProc->facility);
         if (_DSProc->name)      free((void *)_DSProc->name);
@@ -1538,6 +1573,8 @@ void _dsproc_destroy(void)
             cds_delete_group(_DSProc->trans_data);
         }
 
+        trans_free_plan_cache();
+
         if (_DSProc->location)    dsdb_free_process_location(_DSProc->location);
         if (_DSProc->dsc_inputs)  dsdb_free_ds_classes(_DSProc->dsc_inputs);
         if (_DSProc->dsc_outputs) dsdb_free_ds_classes(_DSProc->dsc_outputs);
@@ -3673,6 +3710,12 @@ void dsproc_print_info(FILE *fp)
  */
 const char *dsproc_get_status(void)
 {
+    char *thread_status = _get_thread_status();
+
+    if (thread_status) {
+        return(thread_status);
+    }
+
     return(_DSProc->status);
 }
 
@@ -3683,17 +3726,24 @@ const char *dsproc_get_status(void)
  */
 void dsproc_set_status(const char *status)
 {
+    char *status_buffer = _get_thread_status();
+
+    if (!status_buffer) {
+        status_buffer = (char *)_DSProc->status;
+    }
+
     if (status) {
         DEBUG_LV1( DSPROC_LIB_NAME,
             "Setting status to: '%s'\n", status);
 
-        strncpy((char *)_DSProc->status, status, 511);
+        strncpy(status_buffer, status, DSPROC_STATUS_LENGTH - 1);
+        status_buffer[DSPROC_STATUS_LENGTH - 1] = '\0';
     }
     else {
         DEBUG_LV1( DSPROC_LIB_NAME,
             "Clearing last status string\n");
 
-        strcpy((char *)_DSProc->status, "");
+        strcpy(status_buffer, "");
     }
 }
 
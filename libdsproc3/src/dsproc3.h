@@ -161,6 +161,23 @@ void dsproc_set_process_file_hook(
         const char *input_dir,
         const char *file_name));
 
+void dsproc_set_parse_file_hook(
+    int (*parse_file_hook)(
+        void        *user_data,
+        const char  *input_dir,
+        const char  *file_name,
+        void       **file_data),
+    void (*free_file_data)(
+        void        *user_data,
+        void        *file_data));
+
+void dsproc_set_store_file_hook(
+    int (*store_file_hook)(
+        void       *user_data,
+        const char *input_dir,
+        const char *file_name,
+        void       *file_data));
+
 void dsproc_set_custom_qc_hook(
     int (*custom_qc_hook)(
         void       *user_data,
@@ -437,6 +454,11 @@ void    dsproc_set_datastream_split_mode(
             double    split_start,
             double    split_interval);
 
+void    dsproc_set_datastream_storage_policy(
+            int ds_id,
+            int flags,
+            int deflate_level);
+
 /*@}*/
 
 /******************************************************************************/
@@ -769,6 +791,42 @@ int dsproc_consolidate_var_qc(
 
 unsigned int dsproc_get_bad_qc_mask(CDSVar *qc_var);
 
+/**
+ *  Rolling Statistics Window.
+ */
+typedef struct {
+
+    double  shift;  /**< value subtracted from all values in the window */
+    double  sum;    /**< sum of the shifted values in the window        */
+    double  sumsq;  /**< sum of the squared shifted values              */
+    size_t  count;  /**< number of values in the window                 */
+
+} RollingStats;
+
+#define ROLLING_WINDOW_SAMPLES 0 /**< window is a number of good samples */
+#define ROLLING_WINDOW_SECONDS 1 /**< window is a number of seconds      */
+
+void    dsproc_rolling_stats_init(RollingStats *stats);
+void    dsproc_rolling_stats_add(RollingStats *stats, double value);
+void    dsproc_rolling_stats_remove(RollingStats *stats, double value);
+
+size_t  dsproc_rolling_stats_get(
+            RollingStats *stats,
+            double       *mean,
+            double       *stdev);
+
+int     dsproc_rolling_mean_stdev(
+            size_t        nsamples,
+            const double *data,
+            double        missing_value,
+            const double *times,
+            double        window,
+            int           window_type,
+            int           exclude_current,
+            double       *mean,
+            double       *stdev,
+            size_t       *counts);
+
 /*@}*/
 
 /******************************************************************************/
@@ -1246,6 +1304,11 @@ int         dsproc_split_csv_string(char *strp, char delim, int length, char **l
  */
 /*@{*/
 
+/**
+ *  Typed column buffer (see dsproc_set_csv_typed_columns()).
+ */
+typedef struct CSVColumn CSVColumn;
+
 /**
  *  CSV Parsing Structure.
  */
@@ -1293,8 +1356,31 @@ typedef struct
     int          tro_threshold;   /**< threshold used to detect time rollovers */
     time_t       tro_offset;      /**< offset used to track time rollovers     */
 
+    FILE        *stream_fp;       /**< file pointer used in streaming mode     */
+    size_t       chunk_size;      /**< number of bytes to read per chunk       */
+    size_t       stream_nbytes;   /**< number of bytes in the file_data buffer */
+    size_t       stream_used;     /**< number of bytes used by loaded lines    */
+    int          stream_eof;      /**< end of file was reached                 */
+    int          stream_nrecs;    /**< records parsed in all previous batches  */
+    timeval_t    stream_prev_tv;  /**< last record time of the previous batch  */
+    off_t        stream_offset;   /**< file offset of the file_data buffer     */
+
+    char        *ckpt_path;       /**< path to the checkpoint file             */
+    off_t        ckpt_header;     /**< length of the header lines              */
+    off_t        ckpt_offset;     /**< file offset to resume parsing from      */
+    timeval_t    ckpt_time;       /**< time of the last checkpointed record    */
+    int          ckpt_found;      /**< header length found for current file    */
+    off_t        ckpt_partial;    /**< offset of an unterminated last line     */
+
+    CSVColumn  **columns;         /**< typed column buffers for each field     */
+    int          ncolumns;        /**< number of fields in the columns array   */
+
 } CSVParser;
 
+/** Default number of bytes to read per chunk in streaming mode. */
+#define CSV_CHUNK_SIZE  (16 * 1024 * 1024)
+
+void        dsproc_close_csv_file(CSVParser *csv);
 void        dsproc_free_csv_parser(CSVParser *csv);
 
 char      **dsproc_get_csv_field_strvals(CSVParser *csv, const char *name);
@@ -1307,8 +1393,15 @@ time_t      dsproc_get_csv_file_name_time(
 char       *dsproc_get_next_csv_line(CSVParser *csv);
 
 CSVParser  *dsproc_init_csv_parser(CSVParser *csv);
+int         dsproc_load_csv_chunk(CSVParser *csv);
 int         dsproc_load_csv_file(CSVParser *csv, const char *path, const char *name);
 
+int         dsproc_open_csv_file(
+                CSVParser  *csv,
+                const char *path,
+                const char *name,
+                size_t      chunk_size);
+
 int         dsproc_parse_csv_header(CSVParser *csv, const char *linep);
 int         dsproc_parse_csv_record(CSVParser *csv, char *linep, int flags);
 
@@ -1316,6 +1409,8 @@ int         dsproc_print_csv(FILE *fp, CSVParser *csv);
 int         dsproc_print_csv_header(FILE *fp, CSVParser *csv);
 int         dsproc_print_csv_record(FILE *fp, CSVParser *csv);
 
+int         dsproc_set_csv_checkpoint(CSVParser *csv, int ds_id);
+
 int         dsproc_set_csv_column_name(
                 CSVParser  *csv,
                 int         index,
@@ -1336,6 +1431,14 @@ int         dsproc_set_csv_time_patterns(
                 int          npatterns,
                 const char **patterns);
 
+int         dsproc_stream_csv_records(
+                CSVParser  *csv,
+                int         batch_size,
+                int       (*callback)(CSVParser *csv, void *user_data),
+                void       *user_data);
+
+int         dsproc_update_csv_checkpoint(CSVParser *csv);
+
 /*@}*/
 
 /******************************************************************************/
@@ -1345,7 +1448,10 @@ int         dsproc_set_csv_time_patterns(
 /*@{*/
 
 /** Mapping flag to specify that existing data should be overwritten */
-#define CSV_OVERWRITE  0x1
+#define CSV_OVERWRITE      0x1
+
+/** Typed column flag to keep the string values of unmapped fields */
+#define CSV_KEEP_UNMAPPED  0x2
 
 /**
  *  Structure used to map a string to a data value.
@@ -1402,6 +1508,12 @@ int     dsproc_map_csv_to_cds_by_index(
             int         cds_start,
             int         flags);
 
+int     dsproc_set_csv_typed_columns(
+            CSVParser  *csv,
+            CSV2CDSMap *map,
+            CDSGroup   *cds,
+            int         flags);
+
 /*@}*/
 
 /******************************************************************************/
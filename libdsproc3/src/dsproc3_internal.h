@@ -159,17 +159,37 @@ void dsproc_disable_dynamic_metric_vars(int flag);
 void dsproc_disable_lock_file(void);
 void dsproc_disable_mail_messages(void);
 
+int  dsproc_get_cds_arena_mode(void);
 int  dsproc_get_dynamic_dods_mode(void);
 int  dsproc_get_force_mode(void);
+int  dsproc_get_ingest_threads(void);
+int  dsproc_get_output_recycle_mode(void);
 int  dsproc_get_real_time_mode(void);
 int  dsproc_get_reprocessing_mode(void);
+int  dsproc_get_retriever_prefetch(void);
+int  dsproc_get_retriever_threads(void);
+int  dsproc_get_time_index_mode(void);
+int  dsproc_get_transform_threads(void);
 
+void dsproc_set_cds_arena_mode(int mode);
 void dsproc_set_dynamic_dods_mode(int mode);
 void dsproc_set_force_mode(int mode);
+void dsproc_set_ingest_threads(int nthreads);
 int  dsproc_set_log_dir(const char *log_dir);
+void dsproc_set_output_recycle_mode(int mode);
 void dsproc_set_processing_interval(time_t begin_time, time_t end_time);
 void dsproc_set_real_time_mode(int mode, float max_wait);
 void dsproc_set_reprocessing_mode(int mode);
+void dsproc_set_retriever_prefetch(int depth);
+void dsproc_set_retriever_threads(int nthreads);
+void dsproc_set_time_index_mode(int mode);
+void dsproc_set_transform_threads(int nthreads);
+int  dsproc_set_retriever_dim_subset(
+        int         ds_id,
+        const char *dim_name,
+        size_t      start,
+        size_t      count,
+        ptrdiff_t   stride);
 void dsproc_set_retriever_time_offsets(
         int    ds_id,
         time_t begin_offset,
@@ -450,6 +470,9 @@ void dsproc_set_overlap_filtering_mode(int mode);
 int dsproc_exclude_from_standard_qc_checks(
         const char *var_name);
 
+int  dsproc_get_qc_threads(void);
+void dsproc_set_qc_threads(int nthreads);
+
 int dsproc_qc_delta_checks(
         CDSVar *var,
         CDSVar *qc_var,
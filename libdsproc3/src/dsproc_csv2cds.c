@@ -28,12 +28,609 @@
  */
 
 #include "dsproc3.h"
+#include "dsproc_private.h"
 
 /*******************************************************************************
  *  Private Data and Functions
  */
 /** @privatesection */
 
+/** Typed column value flag for missing values. */
+#define CSV_VALUE_MISSING  1
+
+/** Typed column value flag for values that could not be converted. */
+#define CSV_VALUE_INVALID  2
+
+/**
+ *  Hash table used to look up missing value and string map entries.
+ */
+typedef struct {
+
+    int           nocase;  /**< use case insensitive comparisons     */
+    unsigned int  mask;    /**< number of slots - 1                  */
+    const char  **keys;    /**< key strings, NULL for empty slots    */
+    int          *index;   /**< index of the key in the source list  */
+
+} _CSVLookup;
+
+/**
+ *  Typed column buffer used to convert CSV values while they are parsed.
+ *
+ *  Columns with a type of CDS_NAT are not stored at all.
+ */
+struct CSVColumn {
+
+    CDSDataType   type;         /**< data type of the output variable      */
+    size_t        type_size;    /**< size of the data type                 */
+    CDSData       data;         /**< converted values                      */
+    char         *flags;        /**< CSV_VALUE_MISSING or CSV_VALUE_INVALID */
+    int           nalloced;     /**< number of values allocated            */
+
+    CSV2CDSMap   *map;          /**< map entry used to convert the values  */
+    _CSVLookup    missing_lut;  /**< lookup table for the missing values   */
+    _CSVLookup    str_map_lut;  /**< lookup table for the string map       */
+};
+
+/** Exact powers of ten used by the fast numeric parser. */
+static const double _CSVPow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ *  Private: Hash a string for a CSV lookup table.
+ *
+ *  @param  strp    pointer to the string
+ *  @param  nocase  ignore case
+ *
+ *  @return  hash value
+ */
+static unsigned int _csv_lookup_hash(const char *strp, int nocase)
+{
+    unsigned int hash = 5381;
+
+    if (nocase) {
+        for (; *strp; ++strp) {
+            hash = hash * 33 + (unsigned char)tolower((unsigned char)*strp);
+        }
+    }
+    else {
+        for (; *strp; ++strp) {
+            hash = hash * 33 + (unsigned char)*strp;
+        }
+    }
+
+    return(hash);
+}
+
+/**
+ *  Private: Free the memory used by a CSV lookup table.
+ *
+ *  @param  lut  pointer to the lookup table
+ */
+static void _csv_lookup_free(_CSVLookup *lut)
+{
+    if (lut->keys)  free(lut->keys);
+    if (lut->index) free(lut->index);
+
+    lut->keys  = (const char **)NULL;
+    lut->index = (int *)NULL;
+    lut->mask  = 0;
+}
+
+/**
+ *  Private: Find a string in a CSV lookup table.
+ *
+ *  @param  lut   pointer to the lookup table
+ *  @param  strp  pointer to the string
+ *
+ *  @retval  index  index of the matching entry in the source list
+ *  @retval  -1     if not found
+ */
+static int _csv_lookup_find(_CSVLookup *lut, const char *strp)
+{
+    unsigned int slot;
+
+    if (!lut->keys) return(-1);
+
+    slot = _csv_lookup_hash(strp, lut->nocase) & lut->mask;
+
+    while (lut->keys[slot]) {
+
+        if (lut->nocase) {
+            if (strcasecmp(strp, lut->keys[slot]) == 0) {
+                return(lut->index[slot]);
+            }
+        }
+        else if (strcmp(strp, lut->keys[slot]) == 0) {
+            return(lut->index[slot]);
+        }
+
+        slot = (slot + 1) & lut->mask;
+    }
+
+    return(-1);
+}
+
+/**
+ *  Private: Create a CSV lookup table.
+ *
+ *  The first matching entry in the list is returned by _csv_lookup_find(),
+ *  the same as a linear search through the list would.
+ *
+ *  @param  lut     pointer to the lookup table
+ *  @param  nkeys   number of keys
+ *  @param  keys    pointer to the first key string
+ *  @param  stride  number of bytes between the key string pointers
+ *  @param  nocase  use case insensitive comparisons
+ *
+ *  @retval  1  if successful
+ *  @retval  0  if a memory allocation error occurred
+ */
+static int _csv_lookup_create(
+    _CSVLookup   *lut,
+    int           nkeys,
+    const char  **keys,
+    size_t        stride,
+    int           nocase)
+{
+    const char   *key;
+    unsigned int  size;
+    unsigned int  slot;
+    int           ki;
+
+    for (size = 8; size < (unsigned int)nkeys * 2; size *= 2);
+
+    lut->nocase = nocase;
+    lut->mask   = size - 1;
+    lut->keys   = (const char **)calloc(size, sizeof(const char *));
+    lut->index  = (int *)calloc(size, sizeof(int));
+
+    if (!lut->keys || !lut->index) {
+        _csv_lookup_free(lut);
+        return(0);
+    }
+
+    for (ki = 0; ki < nkeys; ++ki) {
+
+        key = *(const char **)((const char *)keys + ki * stride);
+
+        if (_csv_lookup_find(lut, key) >= 0) continue;
+
+        slot = _csv_lookup_hash(key, nocase) & lut->mask;
+
+        while (lut->keys[slot]) {
+            slot = (slot + 1) & lut->mask;
+        }
+
+        lut->keys[slot]  = key;
+        lut->index[slot] = ki;
+    }
+
+    return(1);
+}
+
+/**
+ *  Private: Parse a simple decimal number.
+ *
+ *  This is a locale independent fast path for strings of the form
+ *  [+-]digits[.digits][(e|E)[+-]digits]. The result is only returned if
+ *  it can be computed exactly with one rounding (at most 15 significant
+ *  digits and a power of ten exponent no larger than 22), so it is always
+ *  identical to the value returned by strtod().
+ *
+ *  @param  strp   pointer to the string
+ *  @param  value  output: the parsed value
+ *
+ *  @retval  1  if successful
+ *  @retval  0  if the string must be parsed by strtod()
+ */
+static int _csv_parse_double(const char *strp, double *value)
+{
+    unsigned long long mant    = 0;
+    int                ndigits = 0;
+    int                exp10   = 0;
+    int                negative;
+    int                eneg;
+    int                eval;
+    const char        *start;
+
+    negative = (*strp == '-');
+    if (*strp == '-' || *strp == '+') ++strp;
+
+    /* Skip leading zeros, they are not significant */
+
+    start = strp;
+    while (*strp == '0') ++strp;
+
+    for (; *strp >= '0' && *strp <= '9'; ++strp) {
+        if (++ndigits > 15) return(0);
+        mant = mant * 10 + (*strp - '0');
+    }
+
+    if (*strp == '.') {
+
+        ++strp;
+
+        if (!mant) {
+            for (; *strp == '0'; ++strp) --exp10;
+        }
+
+        for (; *strp >= '0' && *strp <= '9'; ++strp) {
+            if (++ndigits > 15) return(0);
+            mant   = mant * 10 + (*strp - '0');
+            exp10 -= 1;
+        }
+
+        /* Require at least one digit before or after the decimal point */
+
+        if (strp - start == 1) return(0);
+    }
+    else if (strp == start) {
+        return(0);
+    }
+
+    if (*strp == 'e' || *strp == 'E') {
+
+        ++strp;
+
+        eneg = (*strp == '-');
+        if (*strp == '-' || *strp == '+') ++strp;
+
+        if (*strp < '0' || *strp > '9') return(0);
+
+        for (eval = 0; *strp >= '0' && *strp <= '9'; ++strp) {
+            if (eval > 1000) return(0);
+            eval = eval * 10 + (*strp - '0');
+        }
+
+        exp10 += (eneg) ? -eval : eval;
+    }
+
+    if (*strp != '\0') return(0);
+
+    if (!mant) {
+        *value = (negative) ? -0.0 : 0.0;
+        return(1);
+    }
+
+    if (exp10 < -22 || exp10 > 22) return(0);
+
+    *value = (exp10 < 0)
+        ? (double)mant / _CSVPow10[-exp10]
+        : (double)mant * _CSVPow10[exp10];
+
+    if (negative) *value = -*value;
+
+    return(1);
+}
+
+/**
+ *  Private: Convert a string to a double.
+ *
+ *  Same as atof(), but uses the fast path parser for simple numbers.
+ *
+ *  @param  strp  pointer to the string
+ *
+ *  @return  the converted value
+ */
+static double _csv_atof(const char *strp)
+{
+    double value;
+
+    if (_csv_parse_double(strp, &value)) {
+        return(value);
+    }
+
+    return(atof(strp));
+}
+
+/**
+ *  Private: Convert a string to an integer.
+ *
+ *  Same as atoi(), but uses a fast path parser for simple integers.
+ *
+ *  @param  strp  pointer to the string
+ *
+ *  @return  the converted value
+ */
+static int _csv_atoi(const char *strp)
+{
+    const char *chrp     = strp;
+    long long   value    = 0;
+    int         negative = 0;
+    int         ndigits  = 0;
+
+    if (*chrp == '-' || *chrp == '+') {
+        negative = (*chrp == '-');
+        ++chrp;
+    }
+
+    for (; *chrp >= '0' && *chrp <= '9'; ++chrp) {
+        if (++ndigits > 18) return(atoi(strp));
+        value = value * 10 + (*chrp - '0');
+    }
+
+    if (!ndigits || *chrp != '\0') {
+        return(atoi(strp));
+    }
+
+    return((int)(long)((negative) ? -value : value));
+}
+
+/**
+ *  Private: Free a typed column buffer.
+ *
+ *  @param  column  pointer to the CSVColumn
+ */
+static void _csv_free_column(CSVColumn *column)
+{
+    if (column) {
+        if (column->data.vp) free(column->data.vp);
+        if (column->flags)   free(column->flags);
+        _csv_lookup_free(&column->missing_lut);
+        _csv_lookup_free(&column->str_map_lut);
+        free(column);
+    }
+}
+
+/**
+ *  Private: Create a typed column buffer for a CSV2CDS map entry.
+ *
+ *  @param  map      pointer to the map entry
+ *  @param  type     data type of the output variable
+ *  @param  nrecs    number of values to allocate
+ *
+ *  @retval  column  pointer to the new CSVColumn
+ *  @retval  NULL    if a memory allocation error occurred
+ */
+static CSVColumn *_csv_create_column(
+    CSV2CDSMap  *map,
+    CDSDataType  type,
+    int          nrecs)
+{
+    CSVColumn *column;
+    int        nkeys;
+
+    column = (CSVColumn *)calloc(1, sizeof(CSVColumn));
+    if (!column) return((CSVColumn *)NULL);
+
+    column->type = type;
+    column->map  = map;
+
+    if (!map) return(column);
+
+    column->type_size = cds_data_type_size(type);
+
+    if (nrecs < 1) nrecs = 1;
+
+    column->data.vp  = malloc(nrecs * column->type_size);
+    column->flags    = (char *)calloc(nrecs, sizeof(char));
+    column->nalloced = nrecs;
+
+    if (!column->data.vp || !column->flags) goto MEMORY_ERROR;
+
+    if (map->csv_missings) {
+
+        for (nkeys = 0; map->csv_missings[nkeys]; ++nkeys);
+
+        if (!_csv_lookup_create(&column->missing_lut,
+            nkeys, (const char **)map->csv_missings, sizeof(const char *), 0)) {
+
+            goto MEMORY_ERROR;
+        }
+    }
+
+    if (map->str_map) {
+
+        for (nkeys = 0; map->str_map[nkeys].strval; ++nkeys);
+
+        if (!_csv_lookup_create(&column->str_map_lut,
+            nkeys, &(map->str_map[0].strval), sizeof(CSVStrMap), 1)) {
+
+            goto MEMORY_ERROR;
+        }
+    }
+
+    return(column);
+
+MEMORY_ERROR:
+
+    _csv_free_column(column);
+    return((CSVColumn *)NULL);
+}
+
+/**
+ *  Private: Check if a typed column can be used for a CSV2CDS map entry.
+ *
+ *  @param  column   pointer to the CSVColumn
+ *  @param  map      pointer to the map entry
+ *  @param  cds_var  pointer to the output variable
+ *
+ *  @retval  1  if the column values were converted the same way
+ *  @retval  0  if they were not
+ */
+static int _csv_column_matches(
+    CSVColumn  *column,
+    CSV2CDSMap *map,
+    CDSVar     *cds_var)
+{
+    if (column->type         != cds_var->type     ||
+        column->map->str_map    != map->str_map    ||
+        column->map->str_to_dbl != map->str_to_dbl ||
+        column->map->csv_missings != map->csv_missings) {
+
+        return(0);
+    }
+
+    return(1);
+}
+
+/**
+ *  Private: Free the typed column buffers in a CSVParser structure.
+ *
+ *  The string value arrays will not be restored for the fields that
+ *  used typed columns.
+ *
+ *  @param  csv  pointer to the CSVParser structure
+ */
+void _dsproc_free_csv_columns(CSVParser *csv)
+{
+    int fi;
+
+    if (csv->columns) {
+
+        for (fi = 0; fi < csv->ncolumns; ++fi) {
+            _csv_free_column(csv->columns[fi]);
+        }
+
+        free(csv->columns);
+    }
+
+    csv->columns  = (CSVColumn **)NULL;
+    csv->ncolumns = 0;
+}
+
+/**
+ *  Private: Disable the typed columns in a CSVParser structure.
+ *
+ *  The typed column buffers are freed and the string value arrays are
+ *  restored for the fields that used them.
+ *
+ *  @param  csv  pointer to the CSVParser structure
+ *
+ *  @retval  1  if successful
+ *  @retval  0  if a memory allocation error occurred
+ */
+int _dsproc_reset_csv_columns(CSVParser *csv)
+{
+    int fi;
+
+    if (!csv->columns) return(1);
+
+    _dsproc_free_csv_columns(csv);
+
+    for (fi = 0; fi < csv->nfields_alloced; ++fi) {
+
+        if (csv->values[fi]) continue;
+
+        csv->values[fi] = (char **)calloc(csv->nrecs_alloced, sizeof(char *));
+        if (!csv->values[fi]) return(0);
+    }
+
+    return(1);
+}
+
+/**
+ *  Private: Grow the typed column buffers in a CSVParser structure.
+ *
+ *  @param  csv    pointer to the CSVParser structure
+ *  @param  nrecs  number of records to allocate
+ *
+ *  @retval  1  if successful
+ *  @retval  0  if a memory allocation error occurred
+ */
+int _dsproc_realloc_csv_columns(CSVParser *csv, int nrecs)
+{
+    CSVColumn *column;
+    void      *data;
+    char      *flags;
+    int        fi;
+
+    for (fi = 0; fi < csv->ncolumns; ++fi) {
+
+        column = csv->columns[fi];
+
+        if (!column || !column->map || column->nalloced >= nrecs) continue;
+
+        data = realloc(column->data.vp, nrecs * column->type_size);
+        if (!data) return(0);
+        column->data.vp = data;
+
+        flags = (char *)realloc(column->flags, nrecs * sizeof(char));
+        if (!flags) return(0);
+        column->flags = flags;
+
+        column->nalloced = nrecs;
+    }
+
+    return(1);
+}
+
+/**
+ *  Private: Convert a CSV value and store it in a typed column.
+ *
+ *  Values that cannot be converted are flagged, and the error is reported
+ *  if the record is mapped to the output dataset.
+ *
+ *  @param  column  pointer to the CSVColumn
+ *  @param  strval  the CSV string value
+ *  @param  ri      record index
+ */
+void _dsproc_set_csv_column_value(
+    CSVColumn  *column,
+    const char *strval,
+    int         ri)
+{
+    CSV2CDSMap *map = column->map;
+    double      dblval;
+    int         status;
+    int         smi;
+
+    if (!map) return;
+
+    if (!strval || *strval == '\0' ||
+        (map->csv_missings &&
+         _csv_lookup_find(&column->missing_lut, strval) >= 0)) {
+
+        column->flags[ri] = CSV_VALUE_MISSING;
+        return;
+    }
+
+    column->flags[ri] = 0;
+
+    if (map->str_map) {
+
+        smi = _csv_lookup_find(&column->str_map_lut, strval);
+        if (smi < 0) {
+            column->flags[ri] = CSV_VALUE_INVALID;
+            return;
+        }
+
+        dblval = map->str_map[smi].dblval;
+    }
+    else if (map->str_to_dbl) {
+
+        dblval = map->str_to_dbl(strval, &status);
+        if (!status) {
+            column->flags[ri] = CSV_VALUE_INVALID;
+            return;
+        }
+    }
+    else {
+
+        switch (column->type) {
+            case CDS_BYTE:   column->data.bp[ri] = (signed char)_csv_atoi(strval); break;
+            case CDS_SHORT:  column->data.sp[ri] = (short)_csv_atoi(strval);       break;
+            case CDS_INT:    column->data.ip[ri] = (int)_csv_atoi(strval);         break;
+            case CDS_FLOAT:  column->data.fp[ri] = (float)_csv_atof(strval);       break;
+            case CDS_DOUBLE: column->data.dp[ri] = (double)_csv_atof(strval);      break;
+            default: break;
+        }
+
+        return;
+    }
+
+    switch (column->type) {
+        case CDS_BYTE:   column->data.bp[ri] = (signed char)dblval; break;
+        case CDS_SHORT:  column->data.sp[ri] = (short)dblval;       break;
+        case CDS_INT:    column->data.ip[ri] = (int)dblval;         break;
+        case CDS_FLOAT:  column->data.fp[ri] = (float)dblval;       break;
+        case CDS_DOUBLE: column->data.dp[ri] = (double)dblval;      break;
+        default: break;
+    }
+}
+
 /*******************************************************************************
  *  Public Functions
  */
@@ -98,6 +695,13 @@ int dsproc_map_csv_to_cds(
     return(status);
 }
 
+/**
+ *  Macro used by dsproc_map_csv_to_cds_by_index to check for missing values.
+ */
+#define CSV_IS_MISSING(strval) \
+    (!(strval) || *(strval) == '\0' || \
+     (csv_missings && _csv_lookup_find(&missing_lut, (strval)) >= 0))
+
 /**
  *  Macro used by dsproc_map_csv_to_cds_by_index.
  */
@@ -105,54 +709,26 @@ int dsproc_map_csv_to_cds(
 if (csv_str_map) { \
     for (ri = 0; ri < csv_count; ++ri) { \
         csvi = csv_indexes[ri]; \
-        is_missing = 0; \
-        if (!csv_strvals[csvi] || *csv_strvals[csvi] == '\0') { \
-            is_missing = 1; \
-        } \
-        else if (csv_missings) { \
-            for (mvi = 0; csv_missings[mvi]; ++mvi) { \
-                if (strcmp(csv_strvals[csvi], csv_missings[mvi]) == 0) { \
-                    is_missing = 1; \
-                    break; \
-                } \
-            } \
-        } \
-        if (is_missing) { \
+        if (CSV_IS_MISSING(csv_strvals[csvi])) { \
             *data_p++ = *miss_p; \
         } \
         else { \
-            for (smi = 0; csv_str_map[smi].strval; ++smi) { \
-                if (strcasecmp(csv_strvals[csvi], csv_str_map[smi].strval) == 0) { \
-                    *data_p++ = (data_t)csv_str_map[smi].dblval; \
-                    break; \
-                } \
-            } \
-            if (!csv_str_map[smi].strval) { \
+            smi = _csv_lookup_find(&str_map_lut, csv_strvals[csvi]); \
+            if (smi < 0) { \
                 ERROR( DSPROC_LIB_NAME, \
                     "Invalid '%s' value '%s' in file: %s\n", \
                     csv_name, csv_strvals[csvi], csv->file_name); \
                     dsproc_set_status(DSPROC_ECSV2CDS); \
-                return(0); \
+                goto MAP_ERROR; \
             } \
+            *data_p++ = (data_t)csv_str_map[smi].dblval; \
         } \
     } \
 } \
 else if (csv_str_to_dbl) { \
     for (ri = 0; ri < csv_count; ++ri) { \
         csvi = csv_indexes[ri]; \
-        is_missing = 0; \
-        if (!csv_strvals[csvi] || *csv_strvals[csvi] == '\0') { \
-            is_missing = 1; \
-        } \
-        else if (csv_missings) { \
-            for (mvi = 0; csv_missings[mvi]; ++mvi) { \
-                if (strcmp(csv_strvals[csvi], csv_missings[mvi]) == 0) { \
-                    is_missing = 1; \
-                    break; \
-                } \
-            } \
-        } \
-        if (is_missing) { \
+        if (CSV_IS_MISSING(csv_strvals[csvi])) { \
             *data_p++ = *miss_p; \
         } \
         else { \
@@ -162,7 +738,7 @@ else if (csv_str_to_dbl) { \
                     "Invalid '%s' value '%s' in file: %s\n", \
                     csv_name, csv_strvals[csvi], csv->file_name); \
                     dsproc_set_status(DSPROC_ECSV2CDS); \
-                return(0); \
+                goto MAP_ERROR; \
             } \
         } \
     } \
@@ -170,19 +746,7 @@ else if (csv_str_to_dbl) { \
 else { \
     for (ri = 0; ri < csv_count; ++ri) { \
         csvi = csv_indexes[ri]; \
-        is_missing = 0; \
-        if (!csv_strvals[csvi] || *csv_strvals[csvi] == '\0') { \
-            is_missing = 1; \
-        } \
-        else if (csv_missings) { \
-            for (mvi = 0; csv_missings[mvi]; ++mvi) { \
-                if (strcmp(csv_strvals[csvi], csv_missings[mvi]) == 0) { \
-                    is_missing = 1; \
-                    break; \
-                } \
-            } \
-        } \
-        if (is_missing) { \
+        if (CSV_IS_MISSING(csv_strvals[csvi])) { \
             *data_p++ = *miss_p; \
         } \
         else { \
@@ -191,6 +755,22 @@ else { \
     } \
 }
 
+/**
+ *  Macro used by dsproc_map_csv_to_cds_by_index to copy typed column values.
+ */
+#define CSV_COLUMN_TO_CDS(data_p, col_p, miss_p) \
+for (ri = 0; ri < csv_count; ++ri) { \
+    csvi = csv_indexes[ri]; \
+    if (column->flags[csvi] == CSV_VALUE_INVALID) { \
+        ERROR( DSPROC_LIB_NAME, \
+            "Invalid '%s' value in record %d of file: %s\n", \
+            csv_name, csv->stream_nrecs + csvi + 1, csv->file_name); \
+            dsproc_set_status(DSPROC_ECSV2CDS); \
+        goto MAP_ERROR; \
+    } \
+    *data_p++ = (column->flags[csvi]) ? *miss_p : col_p[csvi]; \
+}
+
 /**
  *  Map CSVParser data to variables in a CDSGroup using CSV record indexes.
  *
@@ -231,6 +811,7 @@ int dsproc_map_csv_to_cds_by_index(
                     CDSData      cds_missing,
                     CDSData      cds_datap);
     char        **csv_strvals;
+    CSVColumn    *column;
     const char   *cds_name;
     const char   *cds_units;
     CDSVar       *cds_var;
@@ -244,9 +825,11 @@ int dsproc_map_csv_to_cds_by_index(
     size_t        sample_size;
     size_t        type_size;
     size_t        nbytes;
-    int           is_missing;
     float         mv;
-    int           mi, mvi, ri, smi, csvi;
+    int           mi, mvi, ri, smi, csvi, fi;
+
+    _CSVLookup    missing_lut;
+    _CSVLookup    str_map_lut;
 
     CDSUnitConverter unit_converter;
 
@@ -277,11 +860,27 @@ int dsproc_map_csv_to_cds_by_index(
 
         skip_debug_msg = 0;
 
+        memset(&missing_lut, 0, sizeof(_CSVLookup));
+        memset(&str_map_lut, 0, sizeof(_CSVLookup));
+
         /* Get the CSV field */
 
         csv_strvals = dsproc_get_csv_field_strvals(csv, csv_name);
+        column      = (CSVColumn *)NULL;
+
+        if (!csv_strvals && csv->columns) {
 
-        if (!csv_strvals) {
+            for (fi = 0; fi < csv->ncolumns; ++fi) {
+                if (csv->columns[fi] && csv->columns[fi]->map &&
+                    strcmp(csv->headers[fi], csv_name) == 0) {
+
+                    column = csv->columns[fi];
+                    break;
+                }
+            }
+        }
+
+        if (!csv_strvals && !column) {
 
             ERROR( DSPROC_LIB_NAME,
                 "Required column '%s' not found in CSV file: %s\n",
@@ -383,6 +982,17 @@ for (ri = 0; ri < csv_count; ++ri) {
             return(0);
         }
 
+        if (column && !_csv_column_matches(column, &map[mi], cds_var)) {
+
+            ERROR( DSPROC_LIB_NAME,
+                "Could not map CSV column '%s' to variable: %s\n"
+                " -> typed column does not match the CSV to CDS map entry\n",
+                csv_name, cds_name);
+
+            dsproc_set_status(DSPROC_ECSV2CDS);
+            return(0);
+        }
+
         /* Check if data already exists in the CDS variable */
 
         if (cds_var->sample_count > (size_t)cds_start) {
@@ -460,6 +1070,30 @@ for (ri = 0; ri < csv_count; ++ri) {
             cds_get_default_fill_value(cds_var->type, cds_missing.vp);
         }
 
+        /* Create the missing value and string map lookup tables */
+
+        if (csv_missings) {
+
+            for (mvi = 0; csv_missings[mvi]; ++mvi);
+
+            if (!_csv_lookup_create(&missing_lut,
+                mvi, (const char **)csv_missings, sizeof(const char *), 0)) {
+
+                goto MEMORY_ERROR;
+            }
+        }
+
+        if (csv_str_map && !csv_set_data && !column) {
+
+            for (smi = 0; csv_str_map[smi].strval; ++smi);
+
+            if (!_csv_lookup_create(&str_map_lut,
+                smi, &(csv_str_map[0].strval), sizeof(CSVStrMap), 1)) {
+
+                goto MEMORY_ERROR;
+            }
+        }
+
         /* Map the data from the CSV field to the CDS variable */
 
         if (!skip_debug_msg) {
@@ -469,19 +1103,22 @@ for (ri = 0; ri < csv_count; ++ri) {
         }
 
         cds_data.vp = cds_alloc_var_data(cds_var, cds_start, csv_count);
-        if (!cds_data.vp) {
-
-            ERROR( DSPROC_LIB_NAME,
-                "Memory allocation error mapping CSV dataset to CDS dataset\n");
-
-            dsproc_set_status(DSPROC_ENOMEM);
-            if (cds_missing.vp) free(cds_missing.vp);
-            return(0);
-        }
+        if (!cds_data.vp) goto MEMORY_ERROR;
 
         cds_data_start = cds_data.vp;
 
-        if (csv_set_data) {
+        if (column) {
+
+            switch (cds_var->type) {
+                case CDS_BYTE:   CSV_COLUMN_TO_CDS(cds_data.bp, column->data.bp, cds_missing.bp); break;
+                case CDS_SHORT:  CSV_COLUMN_TO_CDS(cds_data.sp, column->data.sp, cds_missing.sp); break;
+                case CDS_INT:    CSV_COLUMN_TO_CDS(cds_data.ip, column->data.ip, cds_missing.ip); break;
+                case CDS_FLOAT:  CSV_COLUMN_TO_CDS(cds_data.fp, column->data.fp, cds_missing.fp); break;
+                case CDS_DOUBLE: CSV_COLUMN_TO_CDS(cds_data.dp, column->data.dp, cds_missing.dp); break;
+                default: break;
+            }
+        }
+        else if (csv_set_data) {
 
             sample_size = cds_var_sample_size(cds_var);
             type_size   = cds_data_type_size(cds_var->type);
@@ -499,10 +1136,7 @@ for (ri = 0; ri < csv_count; ++ri) {
                     cds_missing,
                     cds_data);
 
-                if (status == 0) {
-                    if (cds_missing.vp) free(cds_missing.vp);
-                    return(0);
-                }
+                if (status == 0) goto MAP_ERROR;
 
                 cds_data.vp += nbytes;
             }
@@ -515,23 +1149,9 @@ for (ri = 0; ri < csv_count; ++ri) {
 
                 memset(cds_data.cp, *cds_missing.cp, sample_size);
 
-                csvi       = csv_indexes[ri];
-                is_missing = 0;
-
-                if (!csv_strvals[csvi] || *csv_strvals[csvi] == '\0') {
-                    is_missing = 1;
-                }
-                else if (csv_missings) {
-
-                    for (mvi = 0; csv_missings[mvi]; ++mvi) {
-                        if (strcmp(csv_strvals[csvi], csv_missings[mvi]) == 0) {
-                            is_missing = 1;
-                            break;
-                        }
-                    }
-                }
+                csvi = csv_indexes[ri];
 
-                if (!is_missing) {
+                if (!CSV_IS_MISSING(csv_strvals[csvi])) {
                     strncpy(cds_data.cp, csv_strvals[csvi], sample_size);
                 }
 
@@ -541,11 +1161,11 @@ for (ri = 0; ri < csv_count; ++ri) {
         else {
 
             switch (cds_var->type) {
-                case CDS_BYTE:   CSV_MAP_TO_CDS(signed char, cds_data.bp, cds_missing.bp, atoi); break;
-                case CDS_SHORT:  CSV_MAP_TO_CDS(short,       cds_data.sp, cds_missing.sp, atoi); break;
-                case CDS_INT:    CSV_MAP_TO_CDS(int,         cds_data.ip, cds_missing.ip, atoi); break;
-                case CDS_FLOAT:  CSV_MAP_TO_CDS(float,       cds_data.fp, cds_missing.fp, atof); break;
-                case CDS_DOUBLE: CSV_MAP_TO_CDS(double,      cds_data.dp, cds_missing.dp, atof); break;
+                case CDS_BYTE:   CSV_MAP_TO_CDS(signed char, cds_data.bp, cds_missing.bp, _csv_atoi); break;
+                case CDS_SHORT:  CSV_MAP_TO_CDS(short,       cds_data.sp, cds_missing.sp, _csv_atoi); break;
+                case CDS_INT:    CSV_MAP_TO_CDS(int,         cds_data.ip, cds_missing.ip, _csv_atoi); break;
+                case CDS_FLOAT:  CSV_MAP_TO_CDS(float,       cds_data.fp, cds_missing.fp, _csv_atof); break;
+                case CDS_DOUBLE: CSV_MAP_TO_CDS(double,      cds_data.dp, cds_missing.dp, _csv_atof); break;
                 default:
 
                     ERROR( DSPROC_LIB_NAME,
@@ -554,8 +1174,7 @@ for (ri = 0; ri < csv_count; ++ri) {
                         cds->name, cds_var->name, (int)cds_var->type);
 
                     dsproc_set_status(DSPROC_ECSV2CDS);
-                    if (cds_missing.vp) free(cds_missing.vp);
-                    return(0);
+                    goto MAP_ERROR;
             }
         }
 
@@ -582,7 +1201,159 @@ for (ri = 0; ri < csv_count; ++ri) {
         }
 
         if (cds_missing.vp) free(cds_missing.vp);
+
+        _csv_lookup_free(&missing_lut);
+        _csv_lookup_free(&str_map_lut);
     }
 
     return(1);
+
+MEMORY_ERROR:
+
+    ERROR( DSPROC_LIB_NAME,
+        "Memory allocation error mapping CSV dataset to CDS dataset\n");
+
+    dsproc_set_status(DSPROC_ENOMEM);
+
+MAP_ERROR:
+
+    if (cds_missing.vp) free(cds_missing.vp);
+
+    _csv_lookup_free(&missing_lut);
+    _csv_lookup_free(&str_map_lut);
+
+    return(0);
+}
+
+/**
+ *  Convert the mapped CSV fields to typed columns while they are parsed.
+ *
+ *  By default dsproc_parse_csv_record() stores a pointer to every value
+ *  in the record, and the values are converted to the output data types
+ *  by dsproc_map_csv_to_cds(). When typed columns are enabled the values
+ *  of the mapped fields are converted to the data types of the output
+ *  variables as each record is parsed, and the string pointer arrays for
+ *  these fields are not allocated. The string values of fields that are
+ *  not in the map are not stored unless the CSV_KEEP_UNMAPPED flag is set.
+ *
+ *  This function must be called after the header line has been parsed and
+ *  before any records are parsed. Parsing a new header line disables the
+ *  typed columns. Fields mapped to character variables, fields that use
+ *  a set_data function, and fields that are mapped to more than one
+ *  variable are still stored as strings.
+ *
+ *  The csv field values returned by dsproc_get_csv_field_strvals() will
+ *  be NULL for typed and unmapped fields. The map and the string maps and
+ *  missing value lists it references must not be freed until the typed
+ *  columns are no longer needed.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  csv    pointer to the CSVParser structure
+ *  @param  map    pointer to the CSV2CDS Map structure,
+ *                 or NULL to disable typed columns
+ *  @param  cds    pointer to the output CDSGroup structure
+ *  @param  flags  control flags:
+ *                   - CSV_KEEP_UNMAPPED: keep the string values of
+ *                     fields that are not in the map
+ *
+ *  @retval  1  if successful
+ *  @retval  0  if an error occurred
+ */
+int dsproc_set_csv_typed_columns(
+    CSVParser  *csv,
+    CSV2CDSMap *map,
+    CDSGroup   *cds,
+    int         flags)
+{
+    CSVColumn  **columns;
+    CSVColumn   *column;
+    CSV2CDSMap  *fmap;
+    CDSVar      *cds_var;
+    CDSDataType  type;
+    int          nmapped;
+    int          fi, mi;
+
+    if (csv->nrecs > 0) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not set typed columns for CSV file: %s\n"
+            " -> records have already been parsed\n",
+            csv->file_name);
+
+        dsproc_set_status(DSPROC_ECSVPARSER);
+
+        return(0);
+    }
+
+    /* Restore the string value arrays for the previous typed columns */
+
+    if (!_dsproc_reset_csv_columns(csv)) goto MEMORY_ERROR;
+
+    if (!map) return(1);
+
+    columns = (CSVColumn **)calloc(csv->nfields, sizeof(CSVColumn *));
+    if (!columns) goto MEMORY_ERROR;
+
+    csv->columns  = columns;
+    csv->ncolumns = csv->nfields;
+
+    for (fi = 0; fi < csv->nfields; ++fi) {
+
+        /* Find the map entry for this field */
+
+        fmap    = (CSV2CDSMap *)NULL;
+        nmapped = 0;
+
+        for (mi = 0; map[mi].csv_name; ++mi) {
+            if (strcmp(map[mi].csv_name, csv->headers[fi]) == 0) {
+                fmap = &map[mi];
+                nmapped++;
+            }
+        }
+
+        if (nmapped == 0) {
+
+            if (flags & CSV_KEEP_UNMAPPED) continue;
+
+            /* The field is not stored */
+
+            column = _csv_create_column((CSV2CDSMap *)NULL, CDS_NAT, 0);
+        }
+        else {
+
+            if (nmapped > 1 || fmap->set_data) continue;
+
+            /* Variables created using dynamic DODs are floats */
+
+            cds_var = cds_get_var(cds, fmap->cds_name);
+            type    = (cds_var) ? cds_var->type : CDS_FLOAT;
+
+            if (type == CDS_CHAR || type == CDS_NAT) continue;
+
+            column = _csv_create_column(fmap, type, csv->nrecs_alloced);
+        }
+
+        if (!column) goto MEMORY_ERROR;
+
+        columns[fi] = column;
+
+        if (csv->values[fi]) {
+            free(csv->values[fi]);
+            csv->values[fi] = (char **)NULL;
+        }
+    }
+
+    return(1);
+
+MEMORY_ERROR:
+
+    ERROR( DSPROC_LIB_NAME,
+        "Memory allocation error setting typed columns for CSV file: %s\n",
+        csv->file_name);
+
+    dsproc_set_status(DSPROC_ENOMEM);
+
+    return(0);
 }
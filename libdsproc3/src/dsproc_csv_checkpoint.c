@@ -0,0 +1,438 @@
+/*******************************************************************************
+*
+*  COPYRIGHT (C) 2016 Battelle Memorial Institute.  All Rights Reserved.
+*
+********************************************************************************
+*
+*  Author:
+*     name:  Brian Ermold
+*     phone: (509) 375-2277
+*     email: brian.ermold@pnl.gov
+*
+********************************************************************************
+*
+*  REPOSITORY INFORMATION:
+*    $Revision$
+*    $Author$
+*    $Date$
+*
+********************************************************************************
+*
+*  NOTE: DOXYGEN is used to generate documentation for this file.
+*
+*******************************************************************************/
+
+/** @file dsproc_csv_checkpoint.c
+ *  CSV Ingest Checkpoints.
+ *
+ *  Near real-time ingests often process raw files that are still being
+ *  appended to. Without checkpoints the entire file has to be read and
+ *  parsed every time the ingest runs, and the records that have already
+ *  been stored are then filtered out again. A checkpoint records how far
+ *  into a raw file the stored records go so the next run of the ingest
+ *  only has to read the header lines and the data appended since then.
+ *
+ *  The checkpoints for all raw files are kept in a small text file in
+ *  the output datastream directory. Each line contains the inode and size
+ *  of the raw file when the checkpoint was written, the length of the
+ *  header lines, the offset of the first line that has not been stored,
+ *  the time of the last stored record, and the name of the raw file.
+ *  A checkpoint is only used if the raw file has the same inode and has
+ *  not gotten smaller, otherwise the file is parsed from the beginning.
+ */
+
+#include <inttypes.h>
+
+#include "dsproc3.h"
+#include "dsproc_private.h"
+
+/** @privatesection */
+
+/*******************************************************************************
+ *  Static Data and Functions Visible Only To This Module
+ */
+
+/** Name of the checkpoint file in the output datastream directory. */
+#define CSV_CHECKPOINT_FILE_NAME  ".dsproc_csv_checkpoint"
+
+/** Maximum length of a line in the checkpoint file. */
+#define CSV_CHECKPOINT_LINE_MAX   (PATH_MAX + 256)
+
+/**
+ *  CSV file checkpoint.
+ */
+typedef struct {
+
+    uintmax_t  inode;   /**< inode of the raw file                      */
+    intmax_t   size;    /**< size of the raw file                       */
+    intmax_t   header;  /**< length of the header lines                 */
+    intmax_t   offset;  /**< offset of the first line not yet stored    */
+    timeval_t  time;    /**< time of the last stored record             */
+    char      *name;    /**< name of the raw file (points into the line) */
+
+} CSVCheckpoint;
+
+/**
+ *  Static: Parse a line from the checkpoint file.
+ *
+ *  The trailing newline is removed from the line, and the name in the
+ *  checkpoint structure will point to the file name in the line.
+ *
+ *  @param  line        the line read from the checkpoint file
+ *  @param  checkpoint  output: the parsed checkpoint
+ *
+ *  @retval  1  if successful
+ *  @retval  0  if the line is not a valid checkpoint
+ */
+static int _csv_parse_checkpoint(char *line, CSVCheckpoint *checkpoint)
+{
+    long  tv_sec;
+    long  tv_usec;
+    char *chrp;
+    int   length;
+
+    if ((chrp = strchr(line, '\n'))) *chrp = '\0';
+
+    length = 0;
+
+    if (sscanf(line, "%ju %jd %jd %jd %ld %ld %n",
+        &checkpoint->inode,
+        &checkpoint->size,
+        &checkpoint->header,
+        &checkpoint->offset,
+        &tv_sec, &tv_usec, &length) != 6 || length == 0) {
+
+        return(0);
+    }
+
+    if (line[length] == '\0'        ||
+        checkpoint->header < 0      ||
+        checkpoint->offset < checkpoint->header ||
+        checkpoint->size   < checkpoint->offset) {
+
+        return(0);
+    }
+
+    checkpoint->time.tv_sec  = tv_sec;
+    checkpoint->time.tv_usec = tv_usec;
+    checkpoint->name         = line + length;
+
+    return(1);
+}
+
+/**
+ *  Static: Write a checkpoint to the checkpoint file.
+ *
+ *  @param  fp          pointer to the open checkpoint file
+ *  @param  checkpoint  pointer to the checkpoint
+ *
+ *  @retval  1  if successful
+ *  @retval  0  if an error occurred
+ */
+static int _csv_write_checkpoint(FILE *fp, CSVCheckpoint *checkpoint)
+{
+    if (fprintf(fp, "%ju %jd %jd %jd %ld %ld %s\n",
+        checkpoint->inode,
+        checkpoint->size,
+        checkpoint->header,
+        checkpoint->offset,
+        (long)checkpoint->time.tv_sec,
+        (long)checkpoint->time.tv_usec,
+        checkpoint->name) < 0) {
+
+        return(0);
+    }
+
+    return(1);
+}
+
+/*******************************************************************************
+ *  Private Functions Visible Only To This Library
+ */
+
+/**
+ *  Private: Read the checkpoint for the CSV file opened in streaming mode.
+ *
+ *  This function is called by dsproc_open_csv_file() after the file stats
+ *  have been set in the CSVParser structure. Errors reading the checkpoint
+ *  file are not fatal, the file will simply be parsed from the beginning.
+ *
+ *  @param  csv  pointer to the CSVParser structure
+ *
+ *  @retval  1  if parsing will resume from the checkpoint
+ *  @retval  0  if the file will be parsed from the beginning
+ */
+int _dsproc_read_csv_checkpoint(CSVParser *csv)
+{
+    char           line[CSV_CHECKPOINT_LINE_MAX];
+    CSVCheckpoint  checkpoint;
+    FILE          *fp;
+    int            found;
+
+    csv->ckpt_header  = 0;
+    csv->ckpt_offset  = 0;
+    csv->ckpt_found   = 0;
+    csv->ckpt_partial = 0;
+
+    if (!csv->ckpt_path) return(0);
+
+    fp = fopen(csv->ckpt_path, "r");
+    if (!fp) return(0);
+
+    found = 0;
+
+    while (fgets(line, CSV_CHECKPOINT_LINE_MAX, fp)) {
+
+        if (!_csv_parse_checkpoint(line, &checkpoint)) continue;
+
+        if (strcmp(checkpoint.name, csv->file_name) == 0) {
+            found = 1;
+            break;
+        }
+    }
+
+    fclose(fp);
+
+    if (!found) return(0);
+
+    if (checkpoint.inode != (uintmax_t)csv->file_stats.st_ino ||
+        checkpoint.size  >  (intmax_t)csv->file_stats.st_size) {
+
+        LOG( DSPROC_LIB_NAME,
+            "Ignoring checkpoint for: %s\n"
+            " -> file was replaced or truncated\n",
+            csv->file_name);
+
+        return(0);
+    }
+
+    if (checkpoint.offset == 0) return(0);
+
+    csv->ckpt_header = (off_t)checkpoint.header;
+    csv->ckpt_offset = (off_t)checkpoint.offset;
+    csv->ckpt_time   = checkpoint.time;
+
+    LOG( DSPROC_LIB_NAME,
+        "Resuming from checkpoint at byte %jd of %jd\n",
+        (intmax_t)csv->ckpt_offset, (intmax_t)csv->file_stats.st_size);
+
+    return(1);
+}
+
+/*******************************************************************************
+ *  Public Functions
+ */
+/** @publicsection */
+
+/**
+ *  Enable checkpoints for the CSV files opened in streaming mode.
+ *
+ *  When checkpoints are enabled, dsproc_open_csv_file() will look for a
+ *  checkpoint for the file in the output datastream directory, and if one
+ *  is found dsproc_stream_csv_records() will skip all the records before
+ *  it. Only the header lines and the data appended to the file since the
+ *  checkpoint was written will be read. The ingest must call
+ *  dsproc_update_csv_checkpoint() after the records have been stored.
+ *
+ *  A last line in the file that does not end with a newline is parsed
+ *  when the end of the file is reached, but the checkpoint is set to the
+ *  start of that line. If the rest of the line is written to the file
+ *  later, the next run of the ingest will parse the completed line again.
+ *  The stored record is then dropped as a duplicate if its values did not
+ *  change. If the line had been cut off in the middle of a value, the
+ *  completed record will overlap the stored one and be reported as such.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  csv    pointer to the CSVParser structure
+ *  @param  ds_id  ID of the output datastream to store the checkpoints in,
+ *                 or -1 to disable checkpoints
+ *
+ *  @retval  1  if successful
+ *  @retval  0  if an error occurred
+ */
+int dsproc_set_csv_checkpoint(CSVParser *csv, int ds_id)
+{
+    const char *ds_path;
+    size_t      length;
+
+    if (csv->ckpt_path) {
+        free(csv->ckpt_path);
+        csv->ckpt_path = (char *)NULL;
+    }
+
+    if (ds_id < 0) return(1);
+
+    ds_path = dsproc_datastream_path(ds_id);
+    if (!ds_path) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not enable CSV checkpoints\n"
+            " -> output datastream path has not been set\n");
+
+        dsproc_set_status(DSPROC_ECSVPARSER);
+
+        return(0);
+    }
+
+    length = strlen(ds_path) + strlen(CSV_CHECKPOINT_FILE_NAME) + 2;
+
+    csv->ckpt_path = (char *)malloc(length * sizeof(char));
+    if (!csv->ckpt_path) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Memory allocation error enabling CSV checkpoints\n");
+
+        dsproc_set_status(DSPROC_ENOMEM);
+
+        return(0);
+    }
+
+    sprintf(csv->ckpt_path, "%s/%s", ds_path, CSV_CHECKPOINT_FILE_NAME);
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "Enabled CSV checkpoints: %s\n", csv->ckpt_path);
+
+    return(1);
+}
+
+/**
+ *  Update the checkpoint for the CSV file opened in streaming mode.
+ *
+ *  This function should be called after the records parsed by
+ *  dsproc_stream_csv_records() have been stored. It can be called from
+ *  the callback function after each batch has been stored, or after
+ *  dsproc_stream_csv_records() returns. The checkpoint will point to the
+ *  line following the last record parsed.
+ *
+ *  The checkpoints for files that no longer exist in the input directory
+ *  are removed from the checkpoint file. The checkpoint file is written to
+ *  a temporary file that is then renamed, so an interrupted update will
+ *  never leave a partially written checkpoint file behind.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  csv  pointer to the CSVParser structure
+ *
+ *  @retval  1  if successful
+ *  @retval  0  if an error occurred
+ */
+int dsproc_update_csv_checkpoint(CSVParser *csv)
+{
+    char           line[CSV_CHECKPOINT_LINE_MAX];
+    char           file_path[PATH_MAX];
+    char          *tmp_path;
+    CSVCheckpoint  checkpoint;
+    CSVCheckpoint  current;
+    FILE          *in_fp;
+    FILE          *out_fp;
+    int            status;
+
+    if (!csv->ckpt_path || !csv->file_name) return(1);
+
+    /* Create the checkpoint for the current file */
+
+    current.inode  = (uintmax_t)csv->file_stats.st_ino;
+    current.size   = (intmax_t)csv->file_stats.st_size;
+    current.header = (intmax_t)csv->ckpt_header;
+    current.offset = (intmax_t)_dsproc_csv_line_offset(csv, csv->linenum);
+    current.name   = csv->file_name;
+
+    /* An unterminated last line may still be being written to the file,
+     * so make sure it will be parsed again by the next run */
+
+    if (csv->ckpt_partial > 0 && current.offset > (intmax_t)csv->ckpt_partial) {
+        current.offset = (intmax_t)csv->ckpt_partial;
+    }
+
+    if (csv->nrecs > 0 && csv->tvs) {
+        current.time = csv->tvs[csv->nrecs - 1];
+    }
+    else {
+        current.time = csv->stream_prev_tv;
+    }
+
+    /* The file may have grown since it was opened */
+
+    if (current.size < current.offset) {
+        current.size = current.offset;
+    }
+
+    tmp_path = (char *)malloc((strlen(csv->ckpt_path) + 32) * sizeof(char));
+    if (!tmp_path) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Memory allocation error updating CSV checkpoint for: %s\n",
+            csv->file_name);
+
+        dsproc_set_status(DSPROC_ENOMEM);
+
+        return(0);
+    }
+
+    sprintf(tmp_path, "%s.%d", csv->ckpt_path, (int)getpid());
+
+    out_fp = fopen(tmp_path, "w");
+    if (!out_fp) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not open CSV checkpoint file: %s\n"
+            " -> %s\n", tmp_path, strerror(errno));
+
+        dsproc_set_status(DSPROC_EFILEOPEN);
+
+        free(tmp_path);
+        return(0);
+    }
+
+    /* Copy the checkpoints for all other files that still exist */
+
+    status = _csv_write_checkpoint(out_fp, &current);
+
+    in_fp = fopen(csv->ckpt_path, "r");
+    if (in_fp) {
+
+        while (status && fgets(line, CSV_CHECKPOINT_LINE_MAX, in_fp)) {
+
+            if (!_csv_parse_checkpoint(line, &checkpoint) ||
+                strcmp(checkpoint.name, csv->file_name) == 0) {
+
+                continue;
+            }
+
+            snprintf(file_path, PATH_MAX, "%s/%s",
+                csv->file_path, checkpoint.name);
+
+            if (access(file_path, F_OK) != 0) continue;
+
+            status = _csv_write_checkpoint(out_fp, &checkpoint);
+        }
+
+        fclose(in_fp);
+    }
+
+    if (fclose(out_fp) != 0) status = 0;
+
+    if (!status || rename(tmp_path, csv->ckpt_path) != 0) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not write CSV checkpoint file: %s\n"
+            " -> %s\n", csv->ckpt_path, strerror(errno));
+
+        dsproc_set_status(DSPROC_EFILEWRITE);
+
+        unlink(tmp_path);
+        free(tmp_path);
+        return(0);
+    }
+
+    free(tmp_path);
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "Updated CSV checkpoint for %s at byte %jd\n",
+        csv->file_name, current.offset);
+
+    return(1);
+}
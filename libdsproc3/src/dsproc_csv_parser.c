@@ -28,12 +28,206 @@
  */
 
 #include "dsproc3.h"
+#include "dsproc_private.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define DSPROC_CSV_SIMD 1
+#include <stdint.h>
+#include <immintrin.h>
+#endif
 
 /*******************************************************************************
  *  Private Data and Functions
  */
 /** @privatesection */
 
+/**
+ *  Structural character scanner.
+ *
+ *  The scanner finds the delimiter, quote, and null characters in 64 byte
+ *  blocks using SIMD compares, and keeps the bit mask for the current block
+ *  so consecutive searches in the same string (fields in a record, lines in
+ *  a chunk) only visit the structural characters instead of every byte.
+ *  The blocks are aligned to 64 bytes so the loads never cross a page
+ *  boundary, even when they read past the end of the string.
+ *
+ *  The scalar loop in dsproc_find_csv_delim() is used on platforms without
+ *  SIMD support.
+ */
+typedef struct {
+
+    char        delim;  /**< delimiter character                            */
+#ifdef DSPROC_CSV_SIMD
+    const char *base;   /**< start of the current 64 byte aligned block     */
+    uint64_t    mask;   /**< structural characters in the current block     */
+#endif
+
+} _CSVScan;
+
+#ifdef DSPROC_CSV_SIMD
+
+/** Block mask function for the SIMD instruction set supported by the CPU */
+static uint64_t (*_CSVBlockMask)(const char *base, char delim) = NULL;
+
+__attribute__((target("sse2"), no_sanitize_address))
+static uint64_t _csv_block_mask_sse2(const char *base, char delim)
+{
+    const __m128i vd = _mm_set1_epi8(delim);
+    const __m128i vq = _mm_set1_epi8('"');
+    const __m128i va = _mm_set1_epi8('\'');
+    const __m128i vz = _mm_setzero_si128();
+    uint64_t      mask = 0;
+    __m128i       v;
+    int           bi;
+
+    for (bi = 0; bi < 4; ++bi) {
+
+        v = _mm_load_si128((const __m128i *)(base + bi * 16));
+
+        v = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, vd), _mm_cmpeq_epi8(v, vq)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vz)));
+
+        mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(v) << (bi * 16);
+    }
+
+    return(mask);
+}
+
+__attribute__((target("avx2"), no_sanitize_address))
+static uint64_t _csv_block_mask_avx2(const char *base, char delim)
+{
+    const __m256i vd = _mm256_set1_epi8(delim);
+    const __m256i vq = _mm256_set1_epi8('"');
+    const __m256i va = _mm256_set1_epi8('\'');
+    const __m256i vz = _mm256_setzero_si256();
+    __m256i       v0, v1;
+
+    v0 = _mm256_load_si256((const __m256i *)base);
+    v1 = _mm256_load_si256((const __m256i *)(base + 32));
+
+    v0 = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v0, vd), _mm256_cmpeq_epi8(v0, vq)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v0, va), _mm256_cmpeq_epi8(v0, vz)));
+
+    v1 = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v1, vd), _mm256_cmpeq_epi8(v1, vq)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v1, va), _mm256_cmpeq_epi8(v1, vz)));
+
+    return((uint64_t)(uint32_t)_mm256_movemask_epi8(v0)
+        | ((uint64_t)(uint32_t)_mm256_movemask_epi8(v1) << 32));
+}
+
+/**
+ *  Private: Load the structural character mask for the block containing strp.
+ *
+ *  @param  scan  pointer to the scanner
+ *  @param  strp  pointer to the first character to scan
+ */
+static void _csv_scan_load(_CSVScan *scan, const char *strp)
+{
+    if (!_CSVBlockMask) {
+        __builtin_cpu_init();
+        _CSVBlockMask = (__builtin_cpu_supports("avx2"))
+            ? _csv_block_mask_avx2 : _csv_block_mask_sse2;
+    }
+
+    scan->base = (const char *)((uintptr_t)strp & ~(uintptr_t)63);
+    scan->mask = _CSVBlockMask(scan->base, scan->delim)
+               & (~(uint64_t)0 << (strp - scan->base));
+}
+
+#endif /* DSPROC_CSV_SIMD */
+
+/**
+ *  Private: Initialize a structural character scanner.
+ *
+ *  @param  scan   pointer to the scanner
+ *  @param  strp   pointer to the string that will be scanned
+ *  @param  delim  delimiter character
+ */
+static void _csv_scan_init(_CSVScan *scan, const char *strp, char delim)
+{
+    scan->delim = delim;
+
+#ifdef DSPROC_CSV_SIMD
+    _csv_scan_load(scan, strp);
+#else
+    strp = strp; // prevent compiler warning
+#endif
+}
+
+/**
+ *  Private: Find the next delimiter using a structural character scanner.
+ *
+ *  This returns the same result as dsproc_find_csv_delim(strp, delim).
+ *  The characters at and after strp must not have been changed since
+ *  the scanner was last used.
+ *
+ *  @param  scan  pointer to the scanner
+ *  @param  strp  pointer to the first character to search
+ *
+ *  @retval  strp  pointer to the next delimiter in the string
+ *  @retval  NULL  if not found
+ */
+static char *_csv_scan_find(_CSVScan *scan, const char *strp)
+{
+#ifdef DSPROC_CSV_SIMD
+    const char *base;
+    uint64_t    mask;
+    char        quote;
+    char        chr;
+    int         bi;
+
+    /* Discard structural characters before strp */
+
+    if (strp < scan->base || strp >= scan->base + 64) {
+        _csv_scan_load(scan, strp);
+    }
+    else {
+        scan->mask &= ~(uint64_t)0 << (strp - scan->base);
+    }
+
+    base  = scan->base;
+    mask  = scan->mask;
+    quote = '\0';
+
+    for (;;) {
+
+        while (mask) {
+
+            bi    = __builtin_ctzll(mask);
+            chr   = base[bi];
+            mask &= mask - 1;
+
+            if (chr == '\0') {
+                scan->base = base;
+                scan->mask = mask;
+                return((char *)NULL);
+            }
+            else if (quote) {
+                if (chr == quote) {
+                    quote = '\0';
+                }
+            }
+            else if (chr == scan->delim) {
+                scan->base = base;
+                scan->mask = mask;
+                return((char *)(base + bi));
+            }
+            else if (chr == '"' || chr == '\'') {
+                quote = chr;
+            }
+        }
+
+        base += 64;
+        mask  = _CSVBlockMask(base, scan->delim);
+    }
+#else
+    return(dsproc_find_csv_delim(strp, scan->delim));
+#endif
+}
+
 /**
  *  Private: Create the array of time column indexes in a CSVParser structure.
  *
@@ -183,7 +377,7 @@ int _csv_parse_record_time(
             return(-1);
         }
 
-        time_string = csv->values[fi][record_index];
+        time_string = csv->rec_buff[fi];
 
         /* Parse time string */
 
@@ -333,9 +527,11 @@ int _csv_parse_record_time(
 
     /* Check for time rollovers if the file date was used */
 
-    if (used_file_date && record_index > 0) {
+    if (used_file_date &&
+        (record_index > 0 || csv->stream_nrecs > 0 || csv->ckpt_offset > 0)) {
 
-        prev_time = csv->tvs[record_index - 1];
+        prev_time = (record_index > 0)
+            ? csv->tvs[record_index - 1] : csv->stream_prev_tv;
 
         if (TV_LT(rec_time, prev_time)) {
 
@@ -436,6 +632,8 @@ static int _csv_realloc_data(CSVParser *csv, int nfields, int nrecs)
 
         for (fi = 0; fi < prev_nfields; ++fi) {
 
+            if (fi < csv->ncolumns && csv->columns[fi]) continue;
+
             csv->values[fi] = (char **)realloc(csv->values[fi], nrecs * sizeof(char *));
             if (!csv->values[fi]) return(0);
 
@@ -452,6 +650,12 @@ static int _csv_realloc_data(CSVParser *csv, int nfields, int nrecs)
             memset(csv->tvs + prev_nrecs, 0, nelems * sizeof(timeval_t));
         }
 
+        /* realloc memory for typed columns if applicable */
+
+        if (csv->columns) {
+            if (!_dsproc_realloc_csv_columns(csv, nrecs)) return(0);
+        }
+
         csv->nrecs_alloced = nrecs;
     }
 
@@ -492,11 +696,223 @@ static int _csv_realloc_data(CSVParser *csv, int nfields, int nrecs)
     return(1);
 }
 
+/**
+ *  Private: Set the line pointers for the data in the file_data buffer.
+ *
+ *  The newline characters (and carriage returns preceding them) are
+ *  replaced with null terminators. If this is not the final block of data
+ *  in the file, any trailing characters after the last newline are not
+ *  added to the lines array. This function must not be called with an
+ *  empty buffer.
+ *
+ *  @param  csv     pointer to the CSVParser structure
+ *  @param  nbytes  number of bytes in the file_data buffer
+ *  @param  final   specifies if this is the last block of data in the file
+ *  @param  nused   output: number of bytes used by the lines
+ *
+ *  @retval  nlines  number of lines found
+ *  @retval  -1      if a memory allocation error occurs
+ */
+static int _csv_set_line_pointers(
+    CSVParser *csv,
+    size_t     nbytes,
+    int        final,
+    size_t    *nused)
+{
+    _CSVScan scan;
+    char    *startp;
+    char    *chrp;
+    int      nlines;
+    int      li;
+
+    startp = csv->file_data;
+    li     = 0;
+
+    _csv_scan_init(&scan, startp, '\n');
+
+    for (;;) {
+
+        /* The final block always has at least one line, even if it
+         * starts with a null character */
+
+        chrp = _csv_scan_find(&scan, startp);
+        if (!chrp && (!final || (*startp == '\0' && li))) break;
+
+        if (li >= csv->nlines_alloced) {
+
+            /* Estimate the total number of lines we will need:
+             *
+             *  = (sizeof_file / nbytes_read) * nlines_read
+             */
+
+            nlines = csv->nlines_guess;
+
+            if (li) {
+                nlines += (nbytes / (startp - csv->file_data)) * li;
+            }
+
+            csv->lines = (char **)realloc(csv->lines, nlines * sizeof(char *));
+            if (!csv->lines) {
+                csv->nlines_alloced = 0;
+                return(-1);
+            }
+
+            csv->nlines_alloced = nlines;
+        }
+
+        csv->lines[li++] = startp;
+
+        if (!chrp) {
+            startp = strchr(startp, '\0');
+            break;
+        }
+
+        /* Handle carriage returns */
+
+        if (chrp != csv->file_data && *(chrp - 1) == '\r') {
+            *(chrp - 1) = '\0';
+        }
+
+        *chrp++ = '\0';
+
+        startp = chrp;
+        if (*startp == '\0') break; // end of data
+    }
+
+    *nused = startp - csv->file_data;
+
+    return(li);
+}
+
+/**
+ *  Private: Discard the records parsed in the current streaming batch.
+ *
+ *  The time of the last record is saved so time rollovers can still
+ *  be detected for the first record in the next batch.
+ *
+ *  @param  csv  pointer to the CSVParser structure
+ */
+static void _csv_next_batch(CSVParser *csv)
+{
+    if (csv->nrecs > 0) {
+
+        if (csv->ntc && csv->tvs) {
+            csv->stream_prev_tv = csv->tvs[csv->nrecs - 1];
+        }
+
+        csv->stream_nrecs += csv->nrecs;
+        csv->nrecs         = 0;
+    }
+}
+
+/**
+ *  Private: Get the file offset of a line in a CSV file opened in streaming mode.
+ *
+ *  @param  csv      pointer to the CSVParser structure
+ *  @param  linenum  index of the line in the current chunk, if this is equal
+ *                   to the number of lines in the chunk the offset of the
+ *                   first line after the chunk is returned.
+ *
+ *  @return  file offset of the line
+ */
+off_t _dsproc_csv_line_offset(CSVParser *csv, int linenum)
+{
+    if (linenum < csv->nlines) {
+        return(csv->stream_offset + (csv->lines[linenum] - csv->file_data));
+    }
+
+    return(csv->stream_offset + csv->stream_used);
+}
+
+/**
+ *  Private: Skip the lines that were stored before the last checkpoint.
+ *
+ *  This is only done the first time dsproc_stream_csv_records() is called
+ *  for a file, when the current line is the first line after the header.
+ *  The lines in the current chunk before the checkpoint are skipped, and
+ *  if the checkpoint is past the end of the current chunk the file is
+ *  positioned at the checkpoint so the next chunk will start there.
+ *  The time of the last stored record is used to detect time rollovers
+ *  in the first record after the checkpoint.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  csv  pointer to the CSVParser structure
+ *
+ *  @retval  1   if successful
+ *  @retval  -1  if an error occurred
+ */
+static int _csv_skip_to_checkpoint(CSVParser *csv)
+{
+    if (csv->ckpt_found) return(1);
+
+    /* Remember the length of the header lines for the next checkpoint */
+
+    csv->ckpt_header = _dsproc_csv_line_offset(csv, csv->linenum);
+    csv->ckpt_found  = 1;
+
+    if (csv->ckpt_offset <= csv->ckpt_header) {
+        csv->ckpt_offset = 0;
+        return(1);
+    }
+
+    csv->stream_prev_tv = csv->ckpt_time;
+
+    while (csv->linenum < csv->nlines &&
+           _dsproc_csv_line_offset(csv, csv->linenum) < csv->ckpt_offset) {
+
+        csv->linenum += 1;
+    }
+
+    if (csv->linenum < csv->nlines) {
+        return(1);
+    }
+
+    if (fseeko(csv->stream_fp, csv->ckpt_offset, SEEK_SET) != 0) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not seek to checkpoint in CSV file: %s\n"
+            " -> %s\n", csv->file_name, strerror(errno));
+
+        dsproc_set_status(DSPROC_EFILEREAD);
+
+        return(-1);
+    }
+
+    csv->stream_offset = csv->ckpt_offset;
+    csv->stream_nbytes = 0;
+    csv->stream_used   = 0;
+    csv->stream_eof    = 0;
+    csv->nlines        = 0;
+    csv->linenum       = 0;
+
+    return(1);
+}
+
 /*******************************************************************************
  *  Public Functions
  */
 /** @publicsection */
 
+/**
+ *  Close a CSV file opened in streaming mode.
+ *
+ *  @param  csv  pointer to the CSVParser structure
+ */
+void dsproc_close_csv_file(CSVParser *csv)
+{
+    if (csv->stream_fp) {
+        fclose(csv->stream_fp);
+        csv->stream_fp = (FILE *)NULL;
+    }
+
+    csv->stream_nbytes = 0;
+    csv->stream_used   = 0;
+    csv->stream_eof    = 0;
+    csv->stream_offset = 0;
+}
+
 /**
  *  Free all memory used by a CSVParser structure.
  *
@@ -508,6 +924,11 @@ void dsproc_free_csv_parser(CSVParser *csv)
 
     if (csv) {
 
+        if (csv->stream_fp) fclose(csv->stream_fp);
+        if (csv->ckpt_path) free(csv->ckpt_path);
+
+        _dsproc_free_csv_columns(csv);
+
         if (csv->file_name) free(csv->file_name);
         if (csv->file_path) free(csv->file_path);
         if (csv->file_data) free(csv->file_data);
@@ -657,7 +1078,8 @@ time_t dsproc_get_csv_file_name_time(
  *  @param  name  column name as specified in the header.
  *
  *  @retval  vals  array of string pointers to the column values
- *  @retval  NULL  if the column name was not found
+ *  @retval  NULL  if the column name was not found, or the column
+ *                 values are stored in a typed column
  */
 char **dsproc_get_csv_field_strvals(CSVParser *csv, const char *name)
 {
@@ -737,6 +1159,10 @@ CSVParser *dsproc_init_csv_parser(CSVParser *csv)
         }
 
         csv->tro_offset = 0;
+
+        dsproc_close_csv_file(csv);
+
+        csv->stream_nrecs = 0;
     }
     else {
 
@@ -762,6 +1188,172 @@ CSVParser *dsproc_init_csv_parser(CSVParser *csv)
     return(csv);
 }
 
+/**
+ *  Load the next chunk of lines from a CSV file opened in streaming mode.
+ *
+ *  This function reads the next block of complete lines from a file opened
+ *  using dsproc_open_csv_file(). Any partial line at the end of the previous
+ *  chunk is carried over to the new chunk, and the chunk buffer will grow
+ *  if a single line is larger than the chunk size.
+ *
+ *  The lines and records from the previous chunk are discarded, so all
+ *  record values must be consumed before this function is called again
+ *  (see dsproc_stream_csv_records()).
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  csv  pointer to the CSVParser structure
+ *
+ *  @retval  nlines  number of lines loaded
+ *  @retval  0       if the end of the file was reached
+ *  @retval  -1      if an error occurred
+ */
+int dsproc_load_csv_chunk(CSVParser *csv)
+{
+    size_t  nleft;
+    size_t  nbytes;
+    size_t  nwant;
+    size_t  nread;
+    size_t  nused;
+    char   *data;
+    int     nlines;
+    int     unterminated;
+
+    if (!csv->stream_fp) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not load next chunk of CSV file: %s\n"
+            " -> file has not been opened in streaming mode\n",
+            (csv->file_name) ? csv->file_name : "NULL");
+
+        dsproc_set_status(DSPROC_ECSVPARSER);
+
+        return(-1);
+    }
+
+    /* Discard the records and lines from the previous chunk */
+
+    _csv_next_batch(csv);
+
+    csv->nlines  = 0;
+    csv->linenum = 0;
+    csv->linep   = (char *)NULL;
+
+    /* Move the partial line at the end of the previous chunk
+     * to the start of the buffer */
+
+    nleft = csv->stream_nbytes - csv->stream_used;
+
+    if (nleft && csv->stream_used) {
+        memmove(csv->file_data, csv->file_data + csv->stream_used, nleft);
+    }
+
+    csv->stream_offset += csv->stream_used;
+    csv->stream_nbytes  = nleft;
+    csv->stream_used   = 0;
+
+    for (;;) {
+
+        /* Make sure the buffer can hold another chunk */
+
+        nbytes = nleft + csv->chunk_size;
+
+        if (nbytes > (size_t)csv->nbytes_alloced) {
+
+            data = (char *)realloc(csv->file_data, (nbytes + 1) * sizeof(char));
+            if (!data) {
+
+                ERROR( DSPROC_LIB_NAME,
+                    "Memory allocation error loading CSV file: %s\n",
+                    csv->file_name);
+
+                dsproc_set_status(DSPROC_ENOMEM);
+
+                return(-1);
+            }
+
+            csv->file_data      = data;
+            csv->nbytes_alloced = nbytes;
+        }
+
+        /* Read the next chunk */
+
+        nread = 0;
+        nwant = csv->chunk_size;
+
+        /* Only read the header lines if we are resuming from a checkpoint */
+
+        if (csv->ckpt_offset > 0 &&
+            csv->stream_offset + (off_t)nleft < csv->ckpt_header &&
+            csv->stream_offset + (off_t)(nleft + nwant) > csv->ckpt_header) {
+
+            nwant = csv->ckpt_header - csv->stream_offset - nleft;
+        }
+
+        if (!csv->stream_eof) {
+
+            nread = fread(csv->file_data + nleft, 1, nwant, csv->stream_fp);
+
+            if (nread < nwant) {
+
+                if (ferror(csv->stream_fp)) {
+
+                    ERROR( DSPROC_LIB_NAME,
+                        "Could not read CSV file: %s\n"
+                        " -> %s\n", csv->file_name, strerror(errno));
+
+                    dsproc_set_status(DSPROC_EFILEREAD);
+
+                    return(-1);
+                }
+
+                csv->stream_eof = 1;
+            }
+        }
+
+        nleft += nread;
+        csv->file_data[nleft] = '\0';
+        csv->stream_nbytes    = nleft;
+
+        if (nleft == 0) return(0);
+
+        /* Set the line pointers for all complete lines, and the last line
+         * in the file if we have reached the end of the file. In checkpoint
+         * mode remember where an unterminated last line starts, because the
+         * rest of it may still be written to the file. */
+
+        unterminated = (csv->stream_eof && csv->file_data[nleft - 1] != '\n');
+
+        nlines = _csv_set_line_pointers(csv, nleft, csv->stream_eof, &nused);
+        if (nlines < 0) {
+
+            ERROR( DSPROC_LIB_NAME,
+                "Memory allocation error loading CSV file: %s\n",
+                csv->file_name);
+
+            dsproc_set_status(DSPROC_ENOMEM);
+
+            return(-1);
+        }
+
+        if (csv->ckpt_path && unterminated && nlines > 0) {
+
+            csv->ckpt_partial = csv->stream_offset
+                + (csv->lines[nlines - 1] - csv->file_data);
+        }
+
+        if (nlines > 0 || csv->stream_eof) break;
+
+        /* The current line is longer than the chunk size */
+    }
+
+    csv->nlines      = nlines;
+    csv->stream_used = nused;
+
+    return(csv->nlines);
+}
+
 /**
  *  Load a CSV data file into a CSVParser structure.
  *
@@ -780,14 +1372,13 @@ int dsproc_load_csv_file(CSVParser *csv, const char *path, const char *name)
     char     full_path[PATH_MAX];
     size_t   nread;
     size_t   nbytes;
+    size_t   nused;
     FILE    *fp;
-    char    *chrp;
     int      nlines;
-    int      li;
 
     /* Initialize the CSVParser structure if necessary */
 
-    if (csv->nlines != 0) {
+    if (csv->nlines != 0 || csv->stream_fp || csv->file_path) {
         if (!dsproc_init_csv_parser(csv)) {
             return(-1);
         }
@@ -901,56 +1492,120 @@ int dsproc_load_csv_file(CSVParser *csv, const char *path, const char *name)
 
     /* Set the line pointers */
 
-    chrp = csv->file_data;
-    csv->lines[0] = chrp;
+    nlines = _csv_set_line_pointers(csv, nbytes, 1, &nused);
+    if (nlines < 0) {
 
-    li = 1;
-    while ((chrp = dsproc_find_csv_delim(chrp, '\n'))) {
+        ERROR( DSPROC_LIB_NAME,
+            "Memory allocation error loading CSV file: %s\n",
+            csv->file_name);
 
-        if (chrp != csv->file_data) {
+        dsproc_set_status(DSPROC_ENOMEM);
 
-            /* Handle carriage returns */
+        return(-1);
+    }
 
-            if (*(chrp - 1) == '\r') {
-                *(chrp - 1) = '\0';
-            }
+    csv->nlines = nlines;
+
+    return(csv->nlines);
+}
+
+/**
+ *  Open a CSV data file for streaming.
+ *
+ *  In streaming mode the file is read in chunks of complete lines instead
+ *  of being loaded into memory all at once. This keeps the memory used by
+ *  the CSVParser bounded by the chunk size regardless of the file size.
+ *  The first and subsequent chunks are loaded using dsproc_load_csv_chunk(),
+ *  and dsproc_stream_csv_records() can be used to parse the records in
+ *  batches after the header line has been parsed.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  csv         pointer to the CSVParser structure created by dsproc_init_csv_parser()
+ *  @param  path        path to the location of the file
+ *  @param  name        the name of the file
+ *  @param  chunk_size  number of bytes to read per chunk,
+ *                      or 0 to use the default (CSV_CHUNK_SIZE)
+ *
+ *  @retval  1   if successful
+ *  @retval  -1  if an error occurred
+ */
+int dsproc_open_csv_file(
+    CSVParser  *csv,
+    const char *path,
+    const char *name,
+    size_t      chunk_size)
+{
+    char full_path[PATH_MAX];
+
+    /* Initialize the CSVParser structure if necessary */
+
+    if (csv->nlines != 0 || csv->stream_fp || csv->file_path) {
+        if (!dsproc_init_csv_parser(csv)) {
+            return(-1);
         }
+    }
 
-        *chrp++ = '\0';
-        if (*chrp == '\0') break; // end of file
+    csv->stream_nrecs   = 0;
+    csv->stream_offset  = 0;
+    csv->chunk_size     = (chunk_size) ? chunk_size : CSV_CHUNK_SIZE;
 
-        if (li >= csv->nlines_alloced) {
+    memset(&csv->stream_prev_tv, 0, sizeof(timeval_t));
 
-            /* Estimate the total number of lines we will need:
-             *
-             *  = (sizeof_file / nbytes_read) * nlines_read
-             */
+    /* Set the file name and path in the CSVParser structure */
 
-            nlines = (nbytes / (chrp - csv->file_data)) * li
-                   + csv->nlines_guess;
+    if (!(csv->file_path = strdup(path)) ||
+        !(csv->file_name = strdup(name))) {
 
-            csv->lines   = (char **)realloc(csv->lines, nlines * sizeof(char *));
+        ERROR( DSPROC_LIB_NAME,
+            "Memory allocation error opening CSV file: %s\n",
+            name);
 
-            if (!csv->lines) {
+        dsproc_set_status(DSPROC_ENOMEM);
 
-                ERROR( DSPROC_LIB_NAME,
-                    "Memory allocation error loading CSV file: %s\n",
-                    csv->file_name);
+        return(-1);
+    }
 
-                dsproc_set_status(DSPROC_ENOMEM);
+    snprintf(full_path, PATH_MAX, "%s/%s", path, name);
 
-                return(-1);
-            }
+    if (csv->ft_result) {
+        free(csv->ft_result);
+        csv->ft_result = (RETimeRes *)NULL;
+    }
 
-            csv->nlines_alloced = nlines;
-        }
+    /* Get the CSV file status */
 
-        csv->lines[li++] = chrp;
+    if (stat(full_path, &csv->file_stats) < 0) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not get file status for: %s\n"
+            " -> %s\n", full_path, strerror(errno));
+
+        dsproc_set_status(DSPROC_EFILESTATS);
+
+        return(-1);
     }
 
-    csv->nlines = li;
+    /* Open the file */
 
-    return(csv->nlines);
+    csv->stream_fp = fopen(full_path, "r");
+    if (!csv->stream_fp) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not open file: %s\n"
+            " -> %s\n", csv->file_name, strerror(errno));
+
+        dsproc_set_status(DSPROC_EFILEOPEN);
+
+        return(-1);
+    }
+
+    /* Check for a checkpoint if checkpoints are enabled */
+
+    _dsproc_read_csv_checkpoint(csv);
+
+    return(1);
 }
 
 /**
@@ -988,6 +1643,19 @@ int dsproc_parse_csv_header(CSVParser *csv, const char *linep)
 
     count = dsproc_count_csv_delims(linep, delim) + 1;
 
+    /* Disable typed columns set for the previous header */
+
+    if (!_dsproc_reset_csv_columns(csv)) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Memory allocation error parsing CSV header for file: %s\n",
+            csv->file_name);
+
+        dsproc_set_status(DSPROC_ENOMEM);
+
+        return(-1);
+    }
+
     /* Make a copy of the header line */
 
     if (csv->header_data) free(csv->header_data);
@@ -1108,7 +1776,7 @@ int dsproc_parse_csv_record(CSVParser *csv, char *linep, int flags)
 
     if (csv->nrecs == csv->nrecs_alloced) {
 
-        if (!_csv_realloc_data(csv, csv->nfields, csv->nrecs * 1.5)) {
+        if (!_csv_realloc_data(csv, csv->nfields, (csv->nrecs + 1) * 1.5)) {
 
             ERROR( DSPROC_LIB_NAME,
                 "Memory allocation error parsing CSV record #%d for file: %s\n",
@@ -1136,10 +1804,26 @@ int dsproc_parse_csv_record(CSVParser *csv, char *linep, int flags)
         return(0);
     }
 
-    /* Set the record value pointers */
+    /* Set the record value pointers, or convert the values
+     * if typed columns have been enabled */
 
-    for (fi = 0; fi < nfields; ++fi) {
-        csv->values[fi][csv->nrecs] = csv->rec_buff[fi];
+    if (csv->columns) {
+
+        for (fi = 0; fi < nfields; ++fi) {
+
+            if (fi < csv->ncolumns && csv->columns[fi]) {
+                _dsproc_set_csv_column_value(
+                    csv->columns[fi], csv->rec_buff[fi], csv->nrecs);
+            }
+            else {
+                csv->values[fi][csv->nrecs] = csv->rec_buff[fi];
+            }
+        }
+    }
+    else {
+        for (fi = 0; fi < nfields; ++fi) {
+            csv->values[fi][csv->nrecs] = csv->rec_buff[fi];
+        }
     }
 
     /* Get the record time if a time format string was specified. */
@@ -1407,6 +2091,98 @@ MEMORY_ERROR:
     return(0);
 }
 
+/**
+ *  Parse the records in a CSV file opened in streaming mode in batches.
+ *
+ *  This function parses the remaining lines in the current chunk and all
+ *  subsequent chunks of a file opened using dsproc_open_csv_file(). The
+ *  header line must already have been parsed. The callback function is
+ *  called every time batch_size records have been parsed, before the next
+ *  chunk is loaded, and after the last record in the file. The records in
+ *  the current batch are available in the CSVParser structure as usual
+ *  (csv->nrecs, csv->values, csv->tvs), and can be mapped to a CDS group
+ *  using dsproc_map_csv_to_cds(). The records are discarded when the
+ *  callback function returns.
+ *
+ *  The callback function must return 1 to continue, 0 to stop processing
+ *  the file, or -1 if an error occurred.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  csv         pointer to the CSVParser structure
+ *  @param  batch_size  maximum number of records per batch,
+ *                      or 0 to use one batch per chunk
+ *  @param  callback    function called for each batch of records
+ *  @param  user_data   user data passed to the callback function
+ *
+ *  @retval  nrecs  total number of records parsed
+ *  @retval  -1     if an error occurred
+ */
+int dsproc_stream_csv_records(
+    CSVParser  *csv,
+    int         batch_size,
+    int       (*callback)(CSVParser *csv, void *user_data),
+    void       *user_data)
+{
+    char *linep;
+    int   nlines;
+    int   status;
+
+    if (!csv->stream_fp) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not stream records from CSV file: %s\n"
+            " -> file has not been opened in streaming mode\n",
+            (csv->file_name) ? csv->file_name : "NULL");
+
+        dsproc_set_status(DSPROC_ECSVPARSER);
+
+        return(-1);
+    }
+
+    if (csv->ckpt_path) {
+        if (_csv_skip_to_checkpoint(csv) < 0) return(-1);
+    }
+
+    for (;;) {
+
+        /* Parse the remaining lines in the current chunk */
+
+        while ((linep = dsproc_get_next_csv_line(csv))) {
+
+            status = dsproc_parse_csv_record(csv, linep, 0);
+            if (status < 0) return(-1);
+
+            if (batch_size > 0 && csv->nrecs >= batch_size) {
+
+                status = callback(csv, user_data);
+                _csv_next_batch(csv);
+
+                if (status <= 0) return((status < 0) ? -1 : csv->stream_nrecs);
+            }
+        }
+
+        /* Flush the current batch before the chunk buffer is reused */
+
+        if (csv->nrecs > 0) {
+
+            status = callback(csv, user_data);
+            _csv_next_batch(csv);
+
+            if (status <= 0) return((status < 0) ? -1 : csv->stream_nrecs);
+        }
+
+        /* Load the next chunk */
+
+        nlines = dsproc_load_csv_chunk(csv);
+        if (nlines <  0) return(-1);
+        if (nlines == 0) break;
+    }
+
+    return(csv->stream_nrecs);
+}
+
 /*******************************************************************************
  *  Parsing Utilities
  */
@@ -1423,11 +2199,14 @@ MEMORY_ERROR:
  */
 int dsproc_count_csv_delims(const char *strp, char delim)
 {
-    int nfound = 0;
+    _CSVScan scan;
+    int      nfound = 0;
 
     strp = dsproc_skip_csv_whitespace(strp, delim);
 
-    while ((strp = dsproc_find_csv_delim(strp, delim))) {
+    _csv_scan_init(&scan, strp, delim);
+
+    while ((strp = _csv_scan_find(&scan, strp))) {
         ++strp;
         ++nfound;
         strp = dsproc_skip_csv_whitespace(strp, delim);
@@ -1449,6 +2228,13 @@ int dsproc_count_csv_delims(const char *strp, char delim)
  */
 char *dsproc_find_csv_delim(const char *strp, char delim)
 {
+#ifdef DSPROC_CSV_SIMD
+    _CSVScan scan;
+
+    _csv_scan_init(&scan, strp, delim);
+
+    return(_csv_scan_find(&scan, strp));
+#else
     char quote = '\0';
 
     for (; *strp != '\0'; ++strp) {
@@ -1467,6 +2253,7 @@ char *dsproc_find_csv_delim(const char *strp, char delim)
     }
 
     return((char *)NULL);
+#endif
 }
 
 /**
@@ -1513,10 +2300,11 @@ char *dsproc_skip_csv_whitespace(const char *strp, char delim)
  */
 int dsproc_split_csv_string(char *strp, char delim, int length, char **list)
 {
-    char *startp;
-    char *endp;
-    char *delimp;
-    int   nfound;
+    _CSVScan scan;
+    char    *startp;
+    char    *endp;
+    char    *delimp;
+    int      nfound;
 
     /* Skip leading white-space */
 
@@ -1525,7 +2313,9 @@ int dsproc_split_csv_string(char *strp, char delim, int length, char **list)
 
     nfound = 0;
 
-    while ((delimp = dsproc_find_csv_delim(startp, delim))) {
+    _csv_scan_init(&scan, startp, delim);
+
+    while ((delimp = _csv_scan_find(&scan, startp))) {
 
         if (delimp != startp) {
 
@@ -1692,9 +2482,15 @@ int dsproc_print_csv_record(FILE *fp, CSVParser *csv)
 
     for (ri = 0; ri < csv->nrecs; ++ri) {
 
-        fprintf(fp, "%s", csv->values[0][ri]);
-        for (fi = 1; fi < csv->nfields; ++fi) {
-            fprintf(fp, "%c%s", delim, csv->values[fi][ri]);
+        for (fi = 0; fi < csv->nfields; ++fi) {
+
+            if (fi) fputc(delim, fp);
+
+            /* String values are not stored for typed columns */
+
+            if (csv->values[fi]) {
+                fprintf(fp, "%s", csv->values[fi][ri]);
+            }
         }
         fprintf(fp, "\n");
     }
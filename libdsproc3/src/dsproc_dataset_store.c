@@ -40,6 +40,121 @@ extern DSProc *_DSProc; /**< Internal DSProc structure */
  *  Static Functions Visible Only To This Module
  */
 
+/**
+ *  Static: Record the storage policy in the output dataset.
+ *
+ *  The storage policy is only used for NetCDF-4 files, as specified
+ *  by the global _Format attribute.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  ds      - pointer to the DataStream structure
+ *  @param  dataset - pointer to the output dataset
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if an error occurred
+ */
+static int _dsproc_set_storage_policy_att(
+    DataStream *ds,
+    CDSGroup   *dataset)
+{
+    CDSAtt     *format_att;
+    const char *chunking;
+    char        policy[256];
+
+    if (!ds->storage_flags) return(1);
+
+    format_att = cds_get_att(dataset, "_Format");
+
+    if (!format_att                   ||
+        format_att->type != CDS_CHAR  ||
+        !format_att->value.cp         ||
+        strncmp(format_att->value.cp, "netCDF-4", 8) != 0) {
+
+        return(1);
+    }
+
+    if (ds->storage_flags & NCDS_CHUNK_PROFILES) {
+        chunking = "profiles";
+    }
+    else if (ds->storage_flags & NCDS_CHUNK_TIME_SERIES) {
+        chunking = "time series";
+    }
+    else {
+        chunking = "library default";
+    }
+
+    if (ds->storage_flags & NCDS_DEFLATE_FLOATS) {
+        snprintf(policy, 256,
+            "chunking: %s, compression: deflate level %d with shuffle "
+            "for large float and double variables", chunking, ds->deflate_level);
+    }
+    else {
+        snprintf(policy, 256,
+            "chunking: %s, compression: none", chunking);
+    }
+
+    return(dsproc_set_att(
+        dataset, 1, "storage_policy", CDS_CHAR, strlen(policy) + 1, policy));
+}
+
+/**
+ *  Static: Get the expected number of records in a new output file.
+ *
+ *  This is used to size the record dimension of the chunks created by the
+ *  storage policy, so later appends to the file can still be read
+ *  efficiently. The sample interval is estimated from the times of the
+ *  records being stored, and the file is expected to be filled up to the
+ *  next split time. Files that are not appended to will only hold the
+ *  records being stored.
+ *
+ *  @param  times      - times of the records in the output dataset
+ *  @param  si         - index of the first record stored in the file
+ *  @param  ei         - index of the last record stored in the file
+ *  @param  split_time - next split time, or 0 if the file will not be
+ *                       appended to
+ *
+ *  @return
+ *    - expected number of records in the file
+ *    - 0 if it could not be determined
+ */
+static size_t _dsproc_get_expected_file_records(
+    timeval_t *times,
+    int        si,
+    int        ei,
+    time_t     split_time)
+{
+    size_t  count = ei - si + 1;
+    double  span;
+    double  interval;
+    double  nrecords;
+
+    if (!split_time) {
+        return(count);
+    }
+
+    if (count < 2) {
+        return(0);
+    }
+
+    span     = TV_DOUBLE(times[ei]) - TV_DOUBLE(times[si]);
+    interval = span / (double)(count - 1);
+
+    if (interval <= 0.0) {
+        return(0);
+    }
+
+    nrecords = ((double)split_time - TV_DOUBLE(times[si])) / interval;
+
+    if (nrecords < (double)count) {
+        return(count);
+    }
+
+    return((size_t)(nrecords + 0.5));
+}
+
 /**
  *  Static: Get the next time the output file should be split at.
  *
@@ -677,6 +792,7 @@ int dsproc_store_dataset(
     char        timestamp[32];
     char        full_path[PATH_MAX];
     int         ncid;
+    NCDSStoragePolicy storage_policy;
 
     size_t      ds_start;
     size_t      nc_start;
@@ -850,6 +966,15 @@ int dsproc_store_dataset(
         goto UPDATE_DS_STATS;
     }
 
+    /************************************************************
+    *  Record the NetCDF-4 storage policy in the output dataset
+    *  so a policy change will force a new file to be created.
+    *************************************************************/
+
+    if (!_dsproc_set_storage_policy_att(ds, out_dataset)) {
+        goto ERROR_EXIT;
+    }
+
     /************************************************************
     *  Filter out samples in the output dataset that are duplicates
     *  of previously stored data, and verify that the remaining
@@ -1140,11 +1265,18 @@ int dsproc_store_dataset(
                     ds->name, begin_ts, end_ts, full_path);
             }
 
+            storage_policy.flags         = ds->storage_flags;
+            storage_policy.deflate_level = ds->deflate_level;
+            storage_policy.nrecords      = _dsproc_get_expected_file_records(
+                out_times, si, ei, split_time);
+
             if (reproc_mode) {
-                ncid = ncds_create_file(out_dataset, full_path, 0, 0, 1);
+                ncid = ncds_create_file_with_policy(
+                    out_dataset, full_path, 0, 0, 1, &storage_policy);
             }
             else {
-                ncid = ncds_create_file(out_dataset, full_path, NC_NOCLOBBER, 0, 1);
+                ncid = ncds_create_file_with_policy(
+                    out_dataset, full_path, NC_NOCLOBBER, 0, 1, &storage_policy);
             }
 
             if (!ncid) {
@@ -37,6 +37,252 @@ extern DSProc *_DSProc; /**< Internal DSProc structure */
  *  Static Functions Visible Only To This Module
  */
 
+static int _OutputRecycleMode = -1; /**< -1 = not set yet */
+
+/**
+ *  Static: Reset the attributes of a recycled output dataset object.
+ *
+ *  Attributes that were added to the recycled object at runtime and are
+ *  not defined in the DSDOD are deleted. The values and definition locks
+ *  of the remaining attributes are then reset to the values defined in the
+ *  DSDOD. Only the attributes with values that differ from the DSDOD
+ *  values are changed.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  \param   object      pointer to the recycled group or variable
+ *  \param   dod_object  pointer to the DSDOD group or variable
+ *
+ *  \retval   1  if successful
+ *  \retval   0  if the attributes do not match the DSDOD attributes
+ *  \retval  -1  if an error occurred
+ */
+static int _dsproc_reset_recycled_atts(void *object, void *dod_object)
+{
+    CDSObject *parent = (CDSObject *)object;
+    int       *natts;
+    CDSAtt  ***atts;
+    int        dod_natts;
+    CDSAtt   **dod_atts;
+    CDSAtt    *att;
+    CDSAtt    *dod_att;
+    size_t     nbytes;
+    int        parent_lock;
+    int        deleted;
+    int        ai;
+
+    if (parent->obj_type == CDS_GROUP) {
+        natts     = &(((CDSGroup *)object)->natts);
+        atts      = &(((CDSGroup *)object)->atts);
+        dod_natts = ((CDSGroup *)dod_object)->natts;
+        dod_atts  = ((CDSGroup *)dod_object)->atts;
+    }
+    else {
+        natts     = &(((CDSVar *)object)->natts);
+        atts      = &(((CDSVar *)object)->atts);
+        dod_natts = ((CDSVar *)dod_object)->natts;
+        dod_atts  = ((CDSVar *)dod_object)->atts;
+    }
+
+    /* Delete the attributes that were added at runtime */
+
+    for (ai = *natts - 1; ai >= 0; --ai) {
+
+        att = (*atts)[ai];
+
+        if (cds_get_att(dod_object, att->name)) {
+            continue;
+        }
+
+        parent_lock      = parent->def_lock;
+        parent->def_lock = 0;
+        att->def_lock    = 0;
+
+        deleted = cds_delete_att(att);
+
+        parent->def_lock = parent_lock;
+
+        if (!deleted) return(0);
+    }
+
+    /* Reset the values of the attributes defined in the DSDOD */
+
+    if (*natts != dod_natts) {
+        return(0);
+    }
+
+    for (ai = 0; ai < dod_natts; ++ai) {
+
+        att     = (*atts)[ai];
+        dod_att = dod_atts[ai];
+
+        if (strcmp(att->name, dod_att->name) != 0) {
+            return(0);
+        }
+
+        nbytes = dod_att->length * cds_data_type_size(dod_att->type);
+
+        if (att->type   != dod_att->type   ||
+            att->length != dod_att->length ||
+            (nbytes && memcmp(att->value.vp, dod_att->value.vp, nbytes) != 0)) {
+
+            att->def_lock = 0;
+
+            if (!cds_change_att_value(att,
+                dod_att->type, dod_att->length, dod_att->value.vp)) {
+
+                dsproc_set_status(DSPROC_ENOMEM);
+                return(-1);
+            }
+        }
+
+        att->def_lock = dod_att->def_lock;
+    }
+
+    return(1);
+}
+
+/**
+ *  Static: Reset a recycled output dataset to its DSDOD definition.
+ *
+ *  The output dataset from the previous processing interval can be reused
+ *  if it still has the same dimensions and variables as the DSDOD, and
+ *  all the attributes defined in the DSDOD. Attributes added at runtime
+ *  are deleted, the dimension lengths, attribute values, and definition
+ *  locks are reset to the DSDOD values, all sample counts are reset to 0,
+ *  and the data defined in the DSDOD is copied back into the variables.
+ *  The memory allocated for the variable data is kept, and will be reused
+ *  for the new processing interval if it is large enough.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  \param   dataset  pointer to the recycled dataset
+ *  \param   dod      pointer to the DSDOD dataset
+ *
+ *  \retval   1  if successful
+ *  \retval   0  if the dataset no longer matches the DSDOD
+ *  \retval  -1  if an error occurred
+ */
+static int _dsproc_reset_recycled_dataset(CDSGroup *dataset, CDSGroup *dod)
+{
+    CDSDim *dim;
+    CDSDim *dod_dim;
+    CDSVar *var;
+    CDSVar *dod_var;
+    int     status;
+    int     di, vi;
+
+    /* Check that nothing was added, removed, or renamed */
+
+    if (dataset->ngroups    || dod->ngroups    ||
+        dataset->nvargroups || dod->nvargroups ||
+        dataset->ndims != dod->ndims ||
+        dataset->nvars != dod->nvars) {
+
+        return(0);
+    }
+
+    for (di = 0; di < dod->ndims; ++di) {
+
+        dim     = dataset->dims[di];
+        dod_dim = dod->dims[di];
+
+        if (strcmp(dim->name, dod_dim->name) != 0 ||
+            dim->is_unlimited != dod_dim->is_unlimited) {
+
+            return(0);
+        }
+    }
+
+    for (vi = 0; vi < dod->nvars; ++vi) {
+
+        var     = dataset->vars[vi];
+        dod_var = dod->vars[vi];
+
+        if (strcmp(var->name, dod_var->name) != 0 ||
+            var->type  != dod_var->type ||
+            var->ndims != dod_var->ndims) {
+
+            return(0);
+        }
+
+        for (di = 0; di < var->ndims; ++di) {
+            if (strcmp(var->dims[di]->name, dod_var->dims[di]->name) != 0) {
+                return(0);
+            }
+        }
+    }
+
+    /* The allocated sample counts are no longer valid for variables that
+     * have a static dimension whose length was changed at runtime */
+
+    for (vi = 0; vi < dod->nvars; ++vi) {
+
+        var     = dataset->vars[vi];
+        dod_var = dod->vars[vi];
+
+        for (di = 0; di < var->ndims; ++di) {
+
+            if (!var->dims[di]->is_unlimited &&
+                var->dims[di]->length != dod_var->dims[di]->length) {
+
+                cds_delete_var_data(var);
+                break;
+            }
+        }
+    }
+
+    for (di = 0; di < dod->ndims; ++di) {
+        dataset->dims[di]->length   = dod->dims[di]->length;
+        dataset->dims[di]->def_lock = dod->dims[di]->def_lock;
+    }
+
+    cds_reset_sample_counts(dataset, 1, 1);
+
+    /* Reset the attribute values */
+
+    status = _dsproc_reset_recycled_atts(dataset, dod);
+
+    if (status <= 0) {
+        return(status);
+    }
+
+    for (vi = 0; vi < dod->nvars; ++vi) {
+
+        var     = dataset->vars[vi];
+        dod_var = dod->vars[vi];
+
+        status = _dsproc_reset_recycled_atts(var, dod_var);
+
+        if (status <= 0) {
+            return(status);
+        }
+    }
+
+    /* Restore the data defined in the DSDOD */
+
+    for (vi = 0; vi < dod->nvars; ++vi) {
+
+        var     = dataset->vars[vi];
+        dod_var = dod->vars[vi];
+
+        if (!dod_var->sample_count) {
+            continue;
+        }
+
+        if (!cds_set_var_data(var, dod_var->type,
+            0, dod_var->sample_count, NULL, dod_var->data.vp)) {
+
+            dsproc_set_status(DSPROC_ENOMEM);
+            return(-1);
+        }
+    }
+
+    return(1);
+}
+
 /*******************************************************************************
  *  Private Functions Visible Only To This Library
  */
@@ -123,6 +369,7 @@ CDSGroup *dsproc_create_output_dataset(
     DataStream *ds = _DSProc->datastreams[ds_id];
     int         copy_flags;
     int         status;
+    int         recycled;
 
     if (dsproc_get_dynamic_dods_mode()) {
         copy_flags = 0;
@@ -171,6 +418,39 @@ CDSGroup *dsproc_create_output_dataset(
     }
     else {
 
+        /* Reuse the dataset from the previous processing interval
+         * if it still matches the DSDOD */
+
+        if (ds->recycled_cds) {
+
+            recycled = _dsproc_reset_recycled_dataset(
+                ds->recycled_cds, ds->dsdod->cds_group);
+
+            if (recycled < 0) {
+                _dsproc_free_datastream_recycled_cds(ds);
+                return((CDSGroup *)NULL);
+            }
+
+            if (recycled) {
+
+                DEBUG_LV1( DSPROC_LIB_NAME,
+                    " - reusing dataset from previous processing interval\n");
+
+                ds->out_cds      = ds->recycled_cds;
+                ds->recycled_cds = (CDSGroup *)NULL;
+            }
+            else {
+
+                DEBUG_LV1( DSPROC_LIB_NAME,
+                    " - previous dataset no longer matches the DOD\n");
+
+                _dsproc_free_datastream_recycled_cds(ds);
+            }
+        }
+    }
+
+    if (!ds->out_cds) {
+
         /* Create the dataset by cloning the dsdod dataset */
 
         status = cds_copy_group(
@@ -347,6 +627,63 @@ int dsproc_dataset_pass_through(
     return(1);
 }
 
+/**
+ *  Get the output dataset recycle mode.
+ *
+ *  If the mode has not been set using dsproc_set_output_recycle_mode(),
+ *  the DSPROC_RECYCLE_OUTPUT environment variable will be checked.
+ *
+ *  \retval  1  if the output datasets are recycled
+ *  \retval  0  if the output datasets are recreated for every interval
+ *
+ *  \see dsproc_set_output_recycle_mode()
+ */
+int dsproc_get_output_recycle_mode(void)
+{
+    const char *env;
+
+    if (_OutputRecycleMode < 0) {
+
+        env = getenv("DSPROC_RECYCLE_OUTPUT");
+
+        if (env && *env) {
+            _OutputRecycleMode = (atoi(env) > 0) ? 1 : 0;
+        }
+        else {
+            _OutputRecycleMode = 0;
+        }
+    }
+
+    return(_OutputRecycleMode);
+}
+
+/**
+ *  Set the output dataset recycle mode.
+ *
+ *  By default the output datasets are cloned from the DSDODs for every
+ *  processing interval, and deleted after they have been stored. When
+ *  recycle mode is enabled the output dataset is kept after it has been
+ *  stored, and reset to the DSDOD definition when it is needed for the
+ *  next processing interval instead of being cloned again. The memory
+ *  allocated for the variable data is also reused when the data for the
+ *  new interval fits.
+ *
+ *  A dataset is only reused if its dimensions, variables, and attributes
+ *  still match the DSDOD, otherwise a new one is cloned. Datasets are never
+ *  recycled in dynamic DOD mode.
+ *
+ *  \param  mode  1 to enable, or 0 to disable
+ *
+ *  \see dsproc_get_output_recycle_mode()
+ */
+void dsproc_set_output_recycle_mode(int mode)
+{
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "Setting output dataset recycle mode to: %d\n", mode);
+
+    _OutputRecycleMode = (mode > 0) ? 1 : 0;
+}
+
 /*******************************************************************************
  *  Public Functions
  */
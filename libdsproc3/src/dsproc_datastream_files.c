@@ -414,6 +414,10 @@ static int _dsproc_refresh_dsfile_info(DSFile *dsfile)
             dsproc_set_status(DSPROC_ENCREAD);
             return(-1);
         }
+
+        dsfile->stats = file_stats;
+
+        _dsproc_update_dsdir_index(dsfile);
     }
 
     dsfile->stats = file_stats;
@@ -421,6 +425,79 @@ static int _dsproc_refresh_dsfile_info(DSFile *dsfile)
     return(1);
 }
 
+/**
+ *  Static: Get the number of times and time range of a datastream file.
+ *
+ *  If the file has not changed since the times were last read, the cached
+ *  values in the DSFile structure will be used. Otherwise the file time
+ *  index will be checked, and the times will only be read from the file
+ *  if a valid index entry was not found. The timevals array in the DSFile
+ *  structure is *not* guaranteed to be loaded when this function returns,
+ *  use _dsproc_refresh_dsfile_info() for that.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  dsfile     - pointer to the DSFile structure.
+ *  @param  ntimes     - output: number of times in the file
+ *  @param  begin_time - output: time of the first sample in the file
+ *  @param  end_time   - output: time of the last sample in the file
+ *
+ *  @return
+ *    -  1 if successful
+ *    -  0 if an error occurred
+ */
+static int _dsproc_get_dsfile_range(
+    DSFile    *dsfile,
+    int       *ntimes,
+    timeval_t *begin_time,
+    timeval_t *end_time)
+{
+    struct stat file_stats;
+
+    if (dsproc_get_time_index_mode()) {
+
+        if (stat(dsfile->full_path, &file_stats) != 0 ) {
+
+            ERROR( DSPROC_LIB_NAME,
+                "Could not stat data file: %s\n"
+                " -> %s\n", dsfile->full_path, strerror(errno));
+
+            dsproc_set_status(DSPROC_EFILESTATS);
+            return(0);
+        }
+
+        if (dsfile->stats.st_mtime        != file_stats.st_mtime       ||
+#ifdef __APPLE__
+            dsfile->stats.st_mtimespec.tv_sec  != file_stats.st_mtimespec.tv_sec ||
+            dsfile->stats.st_mtimespec.tv_nsec != file_stats.st_mtimespec.tv_nsec) {
+#else
+            dsfile->stats.st_mtim.tv_sec  != file_stats.st_mtim.tv_sec ||
+            dsfile->stats.st_mtim.tv_nsec != file_stats.st_mtim.tv_nsec) {
+#endif
+            if (_dsproc_get_dsdir_index_times(
+                dsfile->dir, dsfile->name, &file_stats,
+                ntimes, begin_time, end_time)) {
+
+                return(1);
+            }
+        }
+    }
+
+    if (_dsproc_refresh_dsfile_info(dsfile) <= 0) {
+        return(0);
+    }
+
+    *ntimes = dsfile->ntimes;
+
+    if (dsfile->ntimes > 0) {
+        *begin_time = dsfile->timevals[0];
+        *end_time   = dsfile->timevals[dsfile->ntimes - 1];
+    }
+
+    return(1);
+}
+
 /*******************************************************************************
  *  Private Functions Visible Only To This Library
  */
@@ -582,6 +659,10 @@ void _dsproc_free_dsdir(DSDir *dir)
 
     if (dir) {
 
+        /* The index is pruned using the file list, so free it first */
+
+        if (dir->index) _dsproc_free_dsdir_index(dir);
+
         if (dir->dsfiles) {
 
             for (fi = 0; fi < dir->ndsfiles; fi++) {
@@ -713,6 +794,8 @@ int _dsproc_find_dsfiles(
     DSFile    *dsfile;
     timeval_t  file_begin;
     timeval_t  file_end;
+    int        ntimes;
+    int        status;
     int        fi;
 
     /* Initialize variables */
@@ -764,17 +847,22 @@ int _dsproc_find_dsfiles(
             return(-1);
         }
 
-        if (!_dsproc_refresh_dsfile_info(dsfile)) {
+        /* Use the time range from the file time index if the file has
+         * not been opened yet, the entire file only needs to be read
+         * if it is one of the files being returned. */
+
+        status = _dsproc_get_dsfile_range(
+            dsfile, &ntimes, &file_begin, &file_end);
+
+        if (status <= 0) {
+            free(dsfiles);
             return(-1);
         }
 
-        if (dsfile->ntimes == 0) {
+        if (ntimes == 0) {
             continue;
         }
 
-        file_begin = dsfile->timevals[0];
-        file_end   = dsfile->timevals[dsfile->ntimes - 1];
-
         if (!begin_timeval || !begin_timeval->tv_sec) {
 
             /* We want the last file containing data prior to the end_timeval */
@@ -811,6 +899,16 @@ int _dsproc_find_dsfiles(
 
     } /* end loop over file names */
 
+    /* Make sure all information is loaded for the files being returned */
+
+    for (fi = 0; fi < ndsfiles; fi++) {
+
+        if (_dsproc_refresh_dsfile_info(dsfiles[fi]) <= 0) {
+            free(dsfiles);
+            return(-1);
+        }
+    }
+
     if (ndsfiles) {
         *dsfile_list = dsfiles;
     }
@@ -1603,3 +1701,48 @@ void dsproc_set_datastream_split_mode(
     ds->split_start    = split_start;
     ds->split_interval = split_interval;
 }
+
+/**
+ *  Set the storage policy for NetCDF-4 output files.
+ *
+ *  The storage policy selects the chunk shapes and compression used for
+ *  the variables in new NetCDF-4 output files (see
+ *  ncds_create_file_with_policy() for the available flags). The record
+ *  dimension of the chunks is sized for the number of records each file
+ *  is expected to hold, as estimated from the sample interval of the data
+ *  and the file splitting mode. The policy is also recorded in the global
+ *  storage_policy attribute of the output files, so changing the policy
+ *  will force a new file to be created.
+ *
+ *  The storage policy is not used for other output file formats.
+ *
+ *  @param  ds_id         - datastream ID
+ *  @param  flags         - storage policy flags:
+ *                            - NCDS_CHUNK_TIME_SERIES
+ *                            - NCDS_CHUNK_PROFILES
+ *                            - NCDS_DEFLATE_FLOATS
+ *  @param  deflate_level - deflate level (1-9) used by NCDS_DEFLATE_FLOATS
+ */
+void dsproc_set_datastream_storage_policy(
+    int ds_id,
+    int flags,
+    int deflate_level)
+{
+    DataStream *ds = _DSProc->datastreams[ds_id];
+
+    if (deflate_level < 1) deflate_level = 1;
+    if (deflate_level > 9) deflate_level = 9;
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "%s: Setting datastream storage policy:\n"
+        "  - chunking:    %s\n"
+        "  - compression: %s (level %d)\n",
+        ds->name,
+        (flags & NCDS_CHUNK_PROFILES)    ? "profiles" :
+        (flags & NCDS_CHUNK_TIME_SERIES) ? "time series" : "default",
+        (flags & NCDS_DEFLATE_FLOATS)    ? "deflate floats" : "none",
+        deflate_level);
+
+    ds->storage_flags = flags;
+    ds->deflate_level = deflate_level;
+}
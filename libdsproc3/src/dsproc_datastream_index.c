@@ -0,0 +1,703 @@
+/*******************************************************************************
+*
+*  COPYRIGHT (C) 2016 Battelle Memorial Institute.  All Rights Reserved.
+*
+********************************************************************************
+*
+*  Author:
+*     name:  Brian Ermold
+*     phone: (509) 375-2277
+*     email: brian.ermold@pnl.gov
+*
+********************************************************************************
+*
+*  REPOSITORY INFORMATION:
+*    $Revision$
+*    $Author$
+*    $Date$
+*
+********************************************************************************
+*
+*  NOTE: DOXYGEN is used to generate documentation for this file.
+*
+*******************************************************************************/
+
+/** @file dsproc_datastream_index.c
+ *  Datastream File Time Index.
+ *
+ *  Finding the files that contain data for a time range requires the begin
+ *  and end times of the files, and getting these requires opening each file
+ *  and reading the time variable. The time index is a small binary file
+ *  kept in the datastream directory that records the number of times and
+ *  the begin and end times of each file, along with the size, inode, and
+ *  modification time of the file when the times were read. An entry is only
+ *  used if the file has not changed, so the index never has to be trusted
+ *  over the file itself. The index is only an optimization and all errors
+ *  reading or writing it are ignored.
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+
+#include "dsproc3.h"
+#include "dsproc_private.h"
+
+extern DSProc *_DSProc; /**< Internal DSProc structure */
+
+/** @privatesection */
+
+/*******************************************************************************
+ *  Static Data and Functions Visible Only To This Module
+ */
+
+/** Name of the index file in the datastream directory. */
+#define DSINDEX_FILE_NAME  ".dsproc_time_index"
+
+/** Magic string at the start of the index file. */
+#define DSINDEX_MAGIC      "DSTIDX01"
+
+/** Initial number of hash buckets, must be a power of two. */
+#define DSINDEX_NBUCKETS   1024
+
+/**
+ *  Index entry as it is stored in the index file.
+ */
+typedef struct {
+
+    int64_t  size;        /**< file size                           */
+    int64_t  mtime_sec;   /**< file modification time, seconds     */
+    int64_t  mtime_nsec;  /**< file modification time, nanoseconds */
+    uint64_t inode;       /**< file inode number                   */
+    int64_t  base_time;   /**< base time of the file               */
+    int64_t  begin_sec;   /**< time of the first sample, seconds   */
+    int64_t  begin_usec;  /**< time of the first sample, usecs     */
+    int64_t  end_sec;     /**< time of the last sample, seconds    */
+    int64_t  end_usec;    /**< time of the last sample, usecs      */
+    int32_t  ntimes;      /**< number of times in the file         */
+    int32_t  time_dimid;  /**< ID of the time dimension            */
+    int32_t  time_varid;  /**< ID of the time variable             */
+    uint32_t name_length; /**< length of the file name that follows */
+
+} DSIndexRecord;
+
+/**
+ *  Index file header.
+ */
+typedef struct {
+
+    char     magic[8];    /**< DSINDEX_MAGIC                       */
+    uint32_t record_size; /**< sizeof(DSIndexRecord)               */
+    uint32_t nentries;    /**< number of entries in the file       */
+
+} DSIndexHeader;
+
+/**
+ *  Index entry in memory.
+ */
+typedef struct DSIndexEntry {
+
+    char                *name;   /**< file name                        */
+    uint32_t             hash;   /**< hash of the file name            */
+    DSIndexRecord        record; /**< index record                     */
+    int                  seen;   /**< flag indicating the file was
+                                      found in the directory scan      */
+    struct DSIndexEntry *next;   /**< next entry in the hash bucket    */
+
+} DSIndexEntry;
+
+/**
+ *  Datastream directory time index.
+ */
+struct DSIndex {
+
+    int            loaded;     /**< flag indicating the file was read  */
+    int            dirty;      /**< flag indicating entries changed    */
+    size_t         nentries;   /**< number of entries                  */
+    size_t         nbuckets;   /**< number of hash buckets             */
+    DSIndexEntry **buckets;    /**< hash buckets                       */
+};
+
+static int _TimeIndexMode = -1; /**< -1 = not set yet */
+
+/**
+ *  Static: Hash a file name.
+ */
+static uint32_t _dsproc_hash_index_name(const char *name)
+{
+    uint32_t hash = 5381;
+
+    while (*name) {
+        hash = ((hash << 5) + hash) + (unsigned char)*name++;
+    }
+
+    return(hash);
+}
+
+/**
+ *  Static: Get the full path to the index file for a directory.
+ *
+ *  @return
+ *    - full path to the index file, this must be freed by the caller
+ *    - NULL if a memory allocation error occurred
+ */
+static char *_dsproc_get_index_path(DSDir *dir)
+{
+    size_t  length;
+    char   *path;
+
+    length = strlen(dir->path) + strlen(DSINDEX_FILE_NAME) + 2;
+    path   = (char *)malloc(length * sizeof(char));
+
+    if (path) {
+        sprintf(path, "%s/%s", dir->path, DSINDEX_FILE_NAME);
+    }
+
+    return(path);
+}
+
+/**
+ *  Static: Find an entry in the index.
+ */
+static DSIndexEntry *_dsproc_find_index_entry(
+    DSIndex    *index,
+    const char *name,
+    uint32_t    hash)
+{
+    DSIndexEntry *entry;
+
+    entry = index->buckets[hash & (index->nbuckets - 1)];
+
+    for (; entry; entry = entry->next) {
+        if (entry->hash == hash && strcmp(entry->name, name) == 0) {
+            return(entry);
+        }
+    }
+
+    return((DSIndexEntry *)NULL);
+}
+
+/**
+ *  Static: Add a new entry to the index.
+ *
+ *  The hash table is doubled in size when the number of entries
+ *  exceeds the number of buckets.
+ *
+ *  @return
+ *    - pointer to the new entry
+ *    - NULL if a memory allocation error occurred
+ */
+static DSIndexEntry *_dsproc_add_index_entry(
+    DSIndex    *index,
+    const char *name,
+    uint32_t    hash)
+{
+    DSIndexEntry  *entry;
+    DSIndexEntry  *next;
+    DSIndexEntry **buckets;
+    size_t         nbuckets;
+    size_t         bi;
+
+    if (index->nentries >= index->nbuckets) {
+
+        nbuckets = index->nbuckets * 2;
+        buckets  = (DSIndexEntry **)calloc(nbuckets, sizeof(DSIndexEntry *));
+
+        if (buckets) {
+
+            for (bi = 0; bi < index->nbuckets; bi++) {
+                for (entry = index->buckets[bi]; entry; entry = next) {
+                    next = entry->next;
+                    entry->next = buckets[entry->hash & (nbuckets - 1)];
+                    buckets[entry->hash & (nbuckets - 1)] = entry;
+                }
+            }
+
+            free(index->buckets);
+
+            index->buckets  = buckets;
+            index->nbuckets = nbuckets;
+        }
+    }
+
+    entry = (DSIndexEntry *)calloc(1, sizeof(DSIndexEntry));
+    if (!entry) return((DSIndexEntry *)NULL);
+
+    if (!(entry->name = strdup(name))) {
+        free(entry);
+        return((DSIndexEntry *)NULL);
+    }
+
+    bi = hash & (index->nbuckets - 1);
+
+    entry->hash        = hash;
+    entry->next        = index->buckets[bi];
+    index->buckets[bi] = entry;
+    index->nentries   += 1;
+
+    return(entry);
+}
+
+/**
+ *  Static: Check if an index record matches the current file stats.
+ */
+static int _dsproc_index_record_matches(
+    DSIndexRecord *record,
+    struct stat   *stats)
+{
+    if (record->size      != (int64_t)stats->st_size   ||
+        record->inode     != (uint64_t)stats->st_ino   ||
+#ifdef __APPLE__
+        record->mtime_sec  != (int64_t)stats->st_mtimespec.tv_sec ||
+        record->mtime_nsec != (int64_t)stats->st_mtimespec.tv_nsec) {
+#else
+        record->mtime_sec  != (int64_t)stats->st_mtim.tv_sec ||
+        record->mtime_nsec != (int64_t)stats->st_mtim.tv_nsec) {
+#endif
+        return(0);
+    }
+
+    return(1);
+}
+
+/**
+ *  Static: Read the index file for a directory.
+ *
+ *  A missing, truncated, or incompatible index file is treated the
+ *  same as an empty index.
+ */
+static void _dsproc_read_dsdir_index(DSDir *dir)
+{
+    DSIndex       *index = dir->index;
+    DSIndexHeader  header;
+    DSIndexRecord  record;
+    DSIndexEntry  *entry;
+    char          *path;
+    char           name[PATH_MAX];
+    FILE          *fp;
+    uint32_t       ei;
+
+    index->loaded = 1;
+
+    if (!(path = _dsproc_get_index_path(dir))) return;
+
+    fp = fopen(path, "r");
+    free(path);
+
+    if (!fp) return;
+
+    if (fread(&header, sizeof(DSIndexHeader), 1, fp) != 1 ||
+        memcmp(header.magic, DSINDEX_MAGIC, 8) != 0         ||
+        header.record_size != sizeof(DSIndexRecord)) {
+
+        fclose(fp);
+        return;
+    }
+
+    for (ei = 0; ei < header.nentries; ei++) {
+
+        if (fread(&record, sizeof(DSIndexRecord), 1, fp) != 1 ||
+            record.name_length == 0                             ||
+            record.name_length >= PATH_MAX                      ||
+            fread(name, record.name_length, 1, fp) != 1) {
+
+            break;
+        }
+
+        name[record.name_length] = '\0';
+
+        entry = _dsproc_add_index_entry(
+            index, name, _dsproc_hash_index_name(name));
+
+        if (!entry) break;
+
+        entry->record = record;
+    }
+
+    fclose(fp);
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "%s: Loaded %d entries from file time index\n",
+        dir->path, (int)index->nentries);
+}
+
+/**
+ *  Static: Remove the entries for files that are no longer in the directory.
+ *
+ *  Entries are only kept for files found in the last scan of the directory,
+ *  so the index does not keep growing as files are deleted or moved out of
+ *  the datastream directory. Nothing is removed if the directory has not
+ *  been scanned.
+ */
+static void _dsproc_prune_dsdir_index(DSDir *dir)
+{
+    DSIndex       *index = dir->index;
+    DSIndexEntry **prevp;
+    DSIndexEntry  *entry;
+    size_t         nremoved;
+    size_t         bi;
+    int            fi;
+
+    if (!dir->files) return;
+
+    for (fi = 0; fi < dir->nfiles; fi++) {
+
+        entry = _dsproc_find_index_entry(
+            index, dir->files[fi], _dsproc_hash_index_name(dir->files[fi]));
+
+        if (entry) entry->seen = 1;
+    }
+
+    nremoved = 0;
+
+    for (bi = 0; bi < index->nbuckets; bi++) {
+
+        prevp = &(index->buckets[bi]);
+
+        while ((entry = *prevp)) {
+
+            if (entry->seen) {
+                entry->seen = 0;
+                prevp = &(entry->next);
+                continue;
+            }
+
+            *prevp = entry->next;
+            free(entry->name);
+            free(entry);
+            nremoved += 1;
+        }
+    }
+
+    if (nremoved) {
+
+        index->nentries -= nremoved;
+        index->dirty     = 1;
+
+        DEBUG_LV1( DSPROC_LIB_NAME,
+            "%s: Removed %d stale entries from file time index\n",
+            dir->path, (int)nremoved);
+    }
+}
+
+/**
+ *  Static: Compare two index entries by name for qsort.
+ */
+static int _dsproc_compare_index_entries(const void *p1, const void *p2)
+{
+    return(strcmp(
+        (*(DSIndexEntry **)p1)->name,
+        (*(DSIndexEntry **)p2)->name));
+}
+
+/**
+ *  Static: Write the index file for a directory.
+ *
+ *  The entries are sorted by file name and written to a temporary file
+ *  that is then renamed over the index file, so other processes reading
+ *  the index will never see a partially written file. Nothing is written
+ *  if the directory is not writable.
+ */
+static void _dsproc_write_dsdir_index(DSDir *dir)
+{
+    DSIndex        *index = dir->index;
+    DSIndexHeader   header;
+    DSIndexEntry  **entries;
+    DSIndexEntry   *entry;
+    char           *path;
+    char           *tmp_path;
+    FILE           *fp;
+    size_t          nentries;
+    size_t          bi, ei;
+    int             status;
+
+    if (access(dir->path, W_OK) != 0) return;
+
+    entries = (DSIndexEntry **)malloc(index->nentries * sizeof(DSIndexEntry *));
+    path    = _dsproc_get_index_path(dir);
+    tmp_path = (path) ? (char *)malloc(strlen(path) + 32) : (char *)NULL;
+
+    if (!entries || !path || !tmp_path) goto CLEANUP;
+
+    nentries = 0;
+
+    for (bi = 0; bi < index->nbuckets; bi++) {
+        for (entry = index->buckets[bi]; entry; entry = entry->next) {
+            entries[nentries++] = entry;
+        }
+    }
+
+    qsort(entries, nentries, sizeof(DSIndexEntry *),
+        _dsproc_compare_index_entries);
+
+    sprintf(tmp_path, "%s.%d", path, (int)getpid());
+
+    if (!(fp = fopen(tmp_path, "w"))) goto CLEANUP;
+
+    memset(&header, 0, sizeof(DSIndexHeader));
+    memcpy(header.magic, DSINDEX_MAGIC, 8);
+    header.record_size = sizeof(DSIndexRecord);
+    header.nentries    = (uint32_t)nentries;
+
+    status = (fwrite(&header, sizeof(DSIndexHeader), 1, fp) == 1);
+
+    for (ei = 0; status && ei < nentries; ei++) {
+
+        entries[ei]->record.name_length = strlen(entries[ei]->name);
+
+        status = (fwrite(&(entries[ei]->record),
+                         sizeof(DSIndexRecord), 1, fp) == 1) &&
+                 (fwrite(entries[ei]->name,
+                         entries[ei]->record.name_length, 1, fp) == 1);
+    }
+
+    if (fclose(fp) != 0) status = 0;
+
+    if (!status || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+    }
+    else {
+        index->dirty = 0;
+
+        DEBUG_LV1( DSPROC_LIB_NAME,
+            "%s: Wrote %d entries to file time index\n",
+            dir->path, (int)nentries);
+    }
+
+CLEANUP:
+
+    if (entries)  free(entries);
+    if (path)     free(path);
+    if (tmp_path) free(tmp_path);
+}
+
+/*******************************************************************************
+ *  Private Functions Visible Only To This Library
+ */
+
+/**
+ *  Private: Free the time index for a datastream directory.
+ *
+ *  Entries for files that were not found in the last scan of the directory
+ *  are removed, and the index file will be updated first if any entries
+ *  were added, changed, or removed. This must be called before the file
+ *  list in the DSDir structure is freed.
+ *
+ *  @param  dir - pointer to the DSDir structure.
+ */
+void _dsproc_free_dsdir_index(DSDir *dir)
+{
+    DSIndex      *index = dir->index;
+    DSIndexEntry *entry;
+    DSIndexEntry *next;
+    size_t        bi;
+
+    if (!index) return;
+
+    if (index->loaded) {
+        _dsproc_prune_dsdir_index(dir);
+    }
+
+    if (index->dirty) {
+        _dsproc_write_dsdir_index(dir);
+    }
+
+    for (bi = 0; bi < index->nbuckets; bi++) {
+        for (entry = index->buckets[bi]; entry; entry = next) {
+            next = entry->next;
+            free(entry->name);
+            free(entry);
+        }
+    }
+
+    free(index->buckets);
+    free(index);
+
+    dir->index = (DSIndex *)NULL;
+}
+
+/**
+ *  Private: Get the time range of a file from the time index.
+ *
+ *  The entry for the file is only used if the size, inode, and
+ *  modification time of the file have not changed since the entry
+ *  was created.
+ *
+ *  @param  dir        - pointer to the DSDir structure
+ *  @param  name       - name of the file
+ *  @param  stats      - current stats of the file
+ *  @param  ntimes     - output: number of times in the file
+ *  @param  begin_time - output: time of the first sample in the file
+ *  @param  end_time   - output: time of the last sample in the file
+ *
+ *  @return
+ *    - 1 if a valid entry was found
+ *    - 0 if not found or the index is disabled
+ */
+int _dsproc_get_dsdir_index_times(
+    DSDir       *dir,
+    const char  *name,
+    struct stat *stats,
+    int         *ntimes,
+    timeval_t   *begin_time,
+    timeval_t   *end_time)
+{
+    DSIndexEntry *entry;
+
+    if (!dsproc_get_time_index_mode()) return(0);
+
+    if (!dir->index) {
+
+        dir->index = (DSIndex *)calloc(1, sizeof(DSIndex));
+        if (!dir->index) return(0);
+
+        dir->index->nbuckets = DSINDEX_NBUCKETS;
+        dir->index->buckets  = (DSIndexEntry **)calloc(
+            DSINDEX_NBUCKETS, sizeof(DSIndexEntry *));
+
+        if (!dir->index->buckets) {
+            free(dir->index);
+            dir->index = (DSIndex *)NULL;
+            return(0);
+        }
+    }
+
+    if (!dir->index->loaded) {
+        _dsproc_read_dsdir_index(dir);
+    }
+
+    entry = _dsproc_find_index_entry(
+        dir->index, name, _dsproc_hash_index_name(name));
+
+    if (!entry || !_dsproc_index_record_matches(&(entry->record), stats)) {
+        return(0);
+    }
+
+    *ntimes              = entry->record.ntimes;
+    begin_time->tv_sec   = (time_t)entry->record.begin_sec;
+    begin_time->tv_usec  = (suseconds_t)entry->record.begin_usec;
+    end_time->tv_sec     = (time_t)entry->record.end_sec;
+    end_time->tv_usec    = (suseconds_t)entry->record.end_usec;
+
+    return(1);
+}
+
+/**
+ *  Private: Update the time index entry for a file.
+ *
+ *  This function should be called after the times have been read from
+ *  the file and the file stats have been set in the DSFile structure.
+ *
+ *  @param  dsfile - pointer to the DSFile structure
+ */
+void _dsproc_update_dsdir_index(DSFile *dsfile)
+{
+    DSDir         *dir = dsfile->dir;
+    DSIndexEntry  *entry;
+    DSIndexRecord  record;
+    uint32_t       hash;
+
+    if (!dir->index || !dir->index->loaded) return;
+
+    memset(&record, 0, sizeof(DSIndexRecord));
+
+    record.size       = (int64_t)dsfile->stats.st_size;
+    record.inode      = (uint64_t)dsfile->stats.st_ino;
+#ifdef __APPLE__
+    record.mtime_sec  = (int64_t)dsfile->stats.st_mtimespec.tv_sec;
+    record.mtime_nsec = (int64_t)dsfile->stats.st_mtimespec.tv_nsec;
+#else
+    record.mtime_sec  = (int64_t)dsfile->stats.st_mtim.tv_sec;
+    record.mtime_nsec = (int64_t)dsfile->stats.st_mtim.tv_nsec;
+#endif
+    record.base_time  = (int64_t)dsfile->base_time;
+    record.ntimes     = dsfile->ntimes;
+    record.time_dimid = dsfile->time_dimid;
+    record.time_varid = dsfile->time_varid;
+
+    if (dsfile->ntimes > 0) {
+        record.begin_sec  = (int64_t)dsfile->timevals[0].tv_sec;
+        record.begin_usec = (int64_t)dsfile->timevals[0].tv_usec;
+        record.end_sec    = (int64_t)dsfile->timevals[dsfile->ntimes-1].tv_sec;
+        record.end_usec   = (int64_t)dsfile->timevals[dsfile->ntimes-1].tv_usec;
+    }
+
+    hash  = _dsproc_hash_index_name(dsfile->name);
+    entry = _dsproc_find_index_entry(dir->index, dsfile->name, hash);
+
+    if (entry) {
+        record.name_length = entry->record.name_length;
+        if (memcmp(&record, &(entry->record), sizeof(DSIndexRecord)) == 0) {
+            return;
+        }
+    }
+    else {
+        entry = _dsproc_add_index_entry(dir->index, dsfile->name, hash);
+        if (!entry) return;
+    }
+
+    entry->record     = record;
+    dir->index->dirty = 1;
+}
+
+/** @publicsection */
+
+/*******************************************************************************
+ *  Internal Functions Visible To The Public
+ */
+
+/**
+ *  Get the datastream file time index mode.
+ *
+ *  If the mode has not been set using the --time-index command line option
+ *  or dsproc_set_time_index_mode(), the DSPROC_TIME_INDEX environment
+ *  variable will be checked.
+ *
+ *  @return
+ *    - 1 if the time index is enabled
+ *    - 0 if the time index is disabled
+ *
+ *  @see dsproc_set_time_index_mode()
+ */
+int dsproc_get_time_index_mode(void)
+{
+    const char *env;
+
+    if (_TimeIndexMode < 0) {
+
+        env = getenv("DSPROC_TIME_INDEX");
+
+        if (env && *env) {
+            _TimeIndexMode = (atoi(env) > 0) ? 1 : 0;
+        }
+        else {
+            _TimeIndexMode = 0;
+        }
+    }
+
+    return(_TimeIndexMode);
+}
+
+/**
+ *  Set the datastream file time index mode.
+ *
+ *  When enabled, the begin and end times of the files in the datastream
+ *  directories are remembered in a hidden index file in each directory.
+ *  This allows the files that contain data for a processing interval to
+ *  be found without opening all of the neighboring files, which can make
+ *  a big difference for directories with a very large number of files.
+ *  The index entries are validated against the current size, inode, and
+ *  modification time of each file before they are used. The index files
+ *  are updated when the datastream directories are freed, which requires
+ *  write permission on the directories.
+ *
+ *  @param  mode - 1 to enable, or 0 to disable
+ *
+ *  @see dsproc_get_time_index_mode()
+ */
+void dsproc_set_time_index_mode(int mode)
+{
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "Setting datastream file time index mode to: %d\n", mode);
+
+    _TimeIndexMode = (mode > 0) ? 1 : 0;
+}
@@ -142,6 +142,19 @@ void _dsproc_free_datastream_out_cds(DataStream *ds)
 {
     if (ds && ds->out_cds) {
 
+        /* Keep the dataset around for the next processing interval
+         * if the output datasets are being recycled */
+
+        if (dsproc_get_output_recycle_mode() &&
+            !dsproc_get_dynamic_dods_mode()) {
+
+            _dsproc_free_datastream_recycled_cds(ds);
+
+            ds->recycled_cds = ds->out_cds;
+            ds->out_cds      = (CDSGroup *)NULL;
+            return;
+        }
+
         cds_set_definition_lock(ds->out_cds, 0);
         cds_delete_group(ds->out_cds);
 
@@ -149,6 +162,22 @@ void _dsproc_free_datastream_out_cds(DataStream *ds)
     }
 }
 
+/**
+ *  Private: Free the recycled output dataset in a DataStream structure.
+ *
+ *  @param  ds - pointer to the DataStream structure
+ */
+void _dsproc_free_datastream_recycled_cds(DataStream *ds)
+{
+    if (ds && ds->recycled_cds) {
+
+        cds_set_definition_lock(ds->recycled_cds, 0);
+        cds_delete_group(ds->recycled_cds);
+
+        ds->recycled_cds = (CDSGroup *)NULL;
+    }
+}
+
 /**
  *  Private: Free the output dataset in a DataStream structure.
  *
@@ -184,6 +213,7 @@ void _dsproc_free_datastream(DataStream *ds)
 
         if (ds->fetched_cds) _dsproc_free_datastream_fetched_cds(ds);
         if (ds->out_cds)     _dsproc_free_datastream_out_cds(ds);
+        if (ds->recycled_cds) _dsproc_free_datastream_recycled_cds(ds);
 
         if (ds->ret_cache)   _dsproc_free_ret_ds_cache(ds->ret_cache);
         if (ds->dsvar_dqrs)  _dsproc_free_dsvar_dqrs(ds->dsvar_dqrs);
@@ -72,6 +72,65 @@ static int (*_process_file_hook)(
     const char *input_dir,
     const char *file_name);
 
+static int (*_parse_file_hook)(
+    void       *user_data,
+    const char *input_dir,
+    const char *file_name,
+    void      **file_data);
+
+static void (*_free_file_data)(
+    void       *user_data,
+    void       *file_data);
+
+static int (*_store_file_hook)(
+    void       *user_data,
+    const char *input_dir,
+    const char *file_name,
+    void       *file_data);
+
+/**
+ *  Static: Handle an error returned by a file hook function.
+ *
+ *  @param hook_name - name of the hook function
+ *  @param input_dir - full path to the input directory
+ *  @param file_name - name of the file being processed
+ *
+ *  @return
+ *    -  0 if the force option is enabled and the file was moved
+ *    - -1 if the process should exit.
+ */
+static int _dsproc_file_hook_error(
+    const char *hook_name,
+    const char *input_dir,
+    const char *file_name)
+{
+    const char *status_text;
+
+    status_text = dsproc_get_status();
+    if (status_text[0] == '\0') {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Error message not set by %s function\n", hook_name);
+
+        dsproc_set_status("Unknown Data Processing Error (check logs)");
+    }
+
+    /* If the force option is enabled we need to try to move
+     * the file and continue processing. */
+
+    if (dsproc_get_force_mode() && !dsproc_is_fatal(errno)) {
+
+        LOG( DSPROC_LIB_NAME,
+            "FORCE: Forcing ingest to continue\n");
+
+        if (dsproc_force_rename_bad(input_dir, file_name)) {
+            return(0);
+        }
+    }
+
+    return(-1);
+}
+
 static int (*_custom_qc_hook)(
         void       *user_data,
         int         ds_id,
@@ -407,15 +466,13 @@ int _dsproc_run_process_file_hook(
     const char *input_dir,
     const char *file_name)
 {
-    int         force_mode = dsproc_get_force_mode();
-    const char *status_text;
-    int         status;
+    int status;
 
     status = 1;
 
     if (_process_file_hook) {
 
-        if (force_mode) {
+        if (dsproc_get_force_mode()) {
             dsproc_set_status(NULL);
         }
 
@@ -426,34 +483,135 @@ int _dsproc_run_process_file_hook(
             _user_data, input_dir, file_name);
 
         if (status < 0) {
+            status = _dsproc_file_hook_error(
+                "process_file_hook", input_dir, file_name);
+        }
 
-            status_text = dsproc_get_status();
-            if (status_text[0] == '\0') {
+        DEBUG_LV1( DSPROC_LIB_NAME,
+            "----- EXITING PROCESS FILE HOOK --------\n\n");
+    }
 
-                ERROR( DSPROC_LIB_NAME,
-                    "Error message not set by process_file_hook function\n");
+    return(status);
+}
 
-                dsproc_set_status("Unknown Data Processing Error (check logs)");
-            }
+/**
+ *  Private: Check if the parse_file_hook and store_file_hook functions are set.
+ *
+ *  @return
+ *    - 1 if both functions have been set
+ *    - 0 if they have not been set
+ */
+int _dsproc_has_parse_file_hook(void)
+{
+    return((_parse_file_hook && _store_file_hook) ? 1 : 0);
+}
 
-            /* If the force option is enabled we need to try to move
-             * the file and continue processing. */
+/**
+ *  Private: Free the file data returned by the parse_file_hook function.
+ *
+ *  @param file_data - file data returned by the parse_file_hook function
+ */
+void _dsproc_free_file_data(void *file_data)
+{
+    if (file_data && _free_file_data) {
+        _free_file_data(_user_data, file_data);
+    }
+}
 
-            if (force_mode && !dsproc_is_fatal(errno)) {
+/**
+ *  Private: Run the parse_file_hook function.
+ *
+ *  This function can be called from the ingest worker threads, so it
+ *  does not generate any debug messages or update the process status.
+ *
+ *  @param input_dir - full path to the input directory
+ *  @param file_name - name of the file to parse
+ *  @param file_data - output: file data returned by the parse_file_hook
+ *
+ *  @return
+ *    -  1 if the file data should be stored
+ *    -  0 if processing should skip the current file
+ *    - -1 if an error occurred
+ */
+int _dsproc_run_parse_file_hook(
+    const char  *input_dir,
+    const char  *file_name,
+    void       **file_data)
+{
+    *file_data = (void *)NULL;
 
-                LOG( DSPROC_LIB_NAME,
-                    "FORCE: Forcing ingest to continue\n");
+    if (!_parse_file_hook) {
+        return(1);
+    }
 
-                if (dsproc_force_rename_bad(input_dir, file_name)) {
-                    status = 0;
-                }
-            }
-        }
+    return(_parse_file_hook(_user_data, input_dir, file_name, file_data));
+}
 
-        DEBUG_LV1( DSPROC_LIB_NAME,
-            "----- EXITING PROCESS FILE HOOK --------\n\n");
+/**
+ *  Private: Run the store_file_hook function.
+ *
+ *  This function must be called from the main thread in file order. The
+ *  file data is freed before this function returns.
+ *
+ *  @param input_dir    - full path to the input directory
+ *  @param file_name    - name of the file to store
+ *  @param parse_status - value returned by the parse_file_hook function
+ *  @param parse_errno  - errno set by the parse_file_hook function
+ *  @param file_data    - file data returned by the parse_file_hook function
+ *
+ *  @return
+ *    -  1 if processing should continue normally
+ *    -  0 if processing should skip the current file
+ *         and continue on to the next one.
+ *    - -1 if a fatal error occurred and the process should exit.
+ */
+int _dsproc_run_store_file_hook(
+    const char *input_dir,
+    const char *file_name,
+    int         parse_status,
+    int         parse_errno,
+    void       *file_data)
+{
+    int status;
+
+    if (parse_status < 0) {
+
+        _dsproc_free_file_data(file_data);
+
+        /* The file may have been parsed by an ingest thread, so restore
+         * the errno it set before checking if the error was fatal. */
+
+        errno = parse_errno;
+
+        return(_dsproc_file_hook_error(
+            "parse_file_hook", input_dir, file_name));
     }
 
+    if (parse_status == 0 || !_store_file_hook) {
+        _dsproc_free_file_data(file_data);
+        return(parse_status);
+    }
+
+    if (dsproc_get_force_mode()) {
+        dsproc_set_status(NULL);
+    }
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "\n----- ENTERING STORE FILE HOOK ---------\n");
+
+    status = _store_file_hook(
+        _user_data, input_dir, file_name, file_data);
+
+    _dsproc_free_file_data(file_data);
+
+    if (status < 0) {
+        status = _dsproc_file_hook_error(
+            "store_file_hook", input_dir, file_name);
+    }
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "----- EXITING STORE FILE HOOK ----------\n\n");
+
     return(status);
 }
 
@@ -772,6 +930,100 @@ void dsproc_set_process_file_hook(
     _process_file_hook = process_file_hook;
 }
 
+/**
+ *  Ingest: Set the file parsing function used by parallel ingests.
+ *
+ *  This function must be called from the main function before dsproc_main()
+ *  is called, or from the init_process_hook() function.
+ *
+ *  The parse_file_hook and store_file_hook functions split the work done
+ *  by a process_file_hook into a stage that reads the input file and maps
+ *  it into memory, and a stage that stores the data to the output
+ *  datastreams and moves the raw file. When both functions have been set
+ *  they are used instead of the process_file_hook function, and the files
+ *  can be parsed concurrently by the number of threads specified by
+ *  dsproc_set_ingest_threads(). The store_file_hook function is always
+ *  called from the main thread in file order.
+ *
+ *  The specified parse_file_hook function will be called once for every
+ *  file found in the input directory, and it must take the following arguments:
+ *
+ *    - void        *user_data: value returned by the init_process_hook() function
+ *    - const char  *input_dir: full path to the input directory
+ *    - const char  *file_name: name of the file to parse
+ *    - void       **file_data: output: pointer to the parsed file data
+ *
+ *  And must return:
+ *
+ *    -  1 if the file data should be stored
+ *    -  0 if processing should skip the current file
+ *         and continue on to the next one.
+ *    - -1 if a fatal error occurred and the process should exit.
+ *
+ *  When more than one ingest thread is used the parse_file_hook function
+ *  runs concurrently with the other parse_file_hook calls and with the
+ *  store_file_hook function. It must only use its own CSVParser, CDSGroup,
+ *  and other data structures, and must not access the output datasets or
+ *  the datastream functions. Messages can be sent, but they may be
+ *  interleaved with the messages from the other threads.
+ *
+ *  The free_file_data function will be called after the file data has been
+ *  stored, or if the ingest stops before the file data could be stored.
+ *
+ *  @param parse_file_hook - the file parsing function
+ *  @param free_file_data  - function used to free the parsed file data
+ */
+void dsproc_set_parse_file_hook(
+    int (*parse_file_hook)(
+        void        *user_data,
+        const char  *input_dir,
+        const char  *file_name,
+        void       **file_data),
+    void (*free_file_data)(
+        void        *user_data,
+        void        *file_data))
+{
+    _parse_file_hook = parse_file_hook;
+    _free_file_data  = free_file_data;
+}
+
+/**
+ *  Ingest: Set the file storing function used by parallel ingests.
+ *
+ *  This function must be called from the main function before dsproc_main()
+ *  is called, or from the init_process_hook() function.
+ *
+ *  The specified store_file_hook function will be called from the main
+ *  thread in file order for every file successfully parsed by the
+ *  parse_file_hook function (see dsproc_set_parse_file_hook()). It should
+ *  map the parsed file data to the output datasets, store them, and move
+ *  the raw file using dsproc_rename() after the data has been stored.
+ *  It must take the following arguments:
+ *
+ *    - void       *user_data: value returned by the init_process_hook() function
+ *    - const char *input_dir: full path to the input directory
+ *    - const char *file_name: name of the file to store
+ *    - void       *file_data: file data returned by the parse_file_hook function
+ *
+ *  And must return:
+ *
+ *    -  1 if processing should continue normally
+ *    -  0 if processing should skip the current file
+ *         and continue on to the next one.
+ *    - -1 if a fatal error occurred and the process should exit.
+ *
+ *  @param store_file_hook - the file storing function
+ */
+void dsproc_set_store_file_hook(
+    int (*store_file_hook)(
+        void       *user_data,
+        const char *input_dir,
+        const char *file_name,
+        void       *file_data))
+{
+    _store_file_hook = store_file_hook;
+}
+
 /**
  *  Ingest: Set the custom QC function.
  *
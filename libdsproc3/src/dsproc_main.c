@@ -26,6 +26,10 @@
  *  DSProc Main Entry Functions.
  */
 
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
 #include "dsproc3.h"
 #include "dsproc_private.h"
 
@@ -33,10 +37,351 @@
 
 // static time_t _CompileDate = 0; /**< compile date of client process */
 
+static int _IngestThreads = -1; /**< -1 = not set yet */
+
 /*******************************************************************************
  *  Static Functions Visible Only To This Module
  */
 
+/** Parse status of a file that has not been parsed yet. */
+#define INGEST_PENDING  -2
+
+/**
+ *  Pool of threads used to parse the input files.
+ */
+typedef struct {
+
+    const char      *input_dir;   /**< full path to the input directory     */
+    char           **files;       /**< list of input files                  */
+    int              nfiles;      /**< number of input files                */
+    int              next;        /**< index of the next file to parse      */
+    int              stored;      /**< number of files passed to store hook */
+    int              window;      /**< max files parsed ahead of the store  */
+    int              stop;        /**< flag telling the threads to exit     */
+    int             *status;      /**< parse status of each file            */
+    void           **data;        /**< parsed data of each file             */
+    char           **status_text; /**< status message set by a failed parse */
+    int             *parse_errno; /**< errno set by a failed parse          */
+    pthread_mutex_t  mutex;       /**< mutex protecting the pool            */
+    pthread_cond_t   cond;        /**< signaled when a file has been parsed
+                                       or stored                            */
+} IngestPool;
+
+/**
+ *  Static: Ingest thread used to parse the input files.
+ *
+ *  Files are parsed in order, but never more than pool->window files
+ *  ahead of the last file passed to the store_file_hook function.
+ *
+ *  The parse_file_hook function runs with a thread local status buffer,
+ *  so it does not overwrite the process status used by the main thread.
+ *  If it fails, the status message and errno are saved in the pool so
+ *  they can be restored by the main thread when the file is stored.
+ *
+ *  @param  arg - pointer to the IngestPool
+ *
+ *  @return NULL
+ */
+static void *_dsproc_ingest_thread(void *arg)
+{
+    IngestPool *pool = (IngestPool *)arg;
+    char        status_buffer[DSPROC_STATUS_LENGTH];
+    char       *status_text;
+    int         parse_errno;
+    void       *data;
+    int         status;
+    int         fi;
+
+    memset(status_buffer, 0, DSPROC_STATUS_LENGTH);
+    _dsproc_set_thread_status(status_buffer);
+
+    pthread_mutex_lock(&pool->mutex);
+
+    for (;;) {
+
+        while (!pool->stop &&
+               pool->next < pool->nfiles &&
+               pool->next >= pool->stored + pool->window) {
+
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+        }
+
+        if (pool->stop || pool->next >= pool->nfiles) {
+            break;
+        }
+
+        fi = pool->next++;
+
+        pthread_mutex_unlock(&pool->mutex);
+
+        status_buffer[0] = '\0';
+        errno = 0;
+
+        status = _dsproc_run_parse_file_hook(
+            pool->input_dir, pool->files[fi], &data);
+
+        parse_errno = errno;
+        status_text = (char *)NULL;
+
+        if (status < 0 && status_buffer[0] != '\0') {
+            status_text = strdup(status_buffer);
+        }
+
+        pthread_mutex_lock(&pool->mutex);
+
+        pool->data[fi]        = data;
+        pool->status_text[fi] = status_text;
+        pool->parse_errno[fi] = parse_errno;
+        pool->status[fi]      = status;
+
+        pthread_cond_broadcast(&pool->cond);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    _dsproc_set_thread_status(NULL);
+
+    return((void *)NULL);
+}
+
+/**
+ *  Static: Wait for the parse_file_hook to finish for the specified file.
+ *
+ *  If none of the ingest threads have started parsing the file yet, it
+ *  will be parsed by the calling thread. If the file was parsed by an
+ *  ingest thread and the parse failed, the status message it set is
+ *  restored as the process status.
+ *
+ *  @param  pool        - pointer to the IngestPool
+ *  @param  fi          - index of the file in the file list
+ *  @param  data        - output: the parsed file data
+ *  @param  parse_errno - output: errno set by the parse_file_hook function
+ *
+ *  @return value returned by the parse_file_hook function
+ */
+static int _dsproc_ingest_wait(
+    IngestPool  *pool,
+    int          fi,
+    void       **data,
+    int         *parse_errno)
+{
+    char *status_text;
+    int   status;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    if (fi >= pool->next) {
+
+        pool->next = fi + 1;
+
+        pthread_mutex_unlock(&pool->mutex);
+
+        if (dsproc_get_force_mode()) {
+            dsproc_set_status(NULL);
+        }
+
+        errno = 0;
+
+        status = _dsproc_run_parse_file_hook(
+            pool->input_dir, pool->files[fi], data);
+
+        *parse_errno = errno;
+
+        return(status);
+    }
+
+    while (pool->status[fi] == INGEST_PENDING) {
+        pthread_cond_wait(&pool->cond, &pool->mutex);
+    }
+
+    status                = pool->status[fi];
+    status_text           = pool->status_text[fi];
+    *parse_errno          = pool->parse_errno[fi];
+    *data                 = pool->data[fi];
+    pool->data[fi]        = (void *)NULL;
+    pool->status_text[fi] = (char *)NULL;
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (status < 0) {
+        dsproc_set_status(status_text);
+    }
+
+    if (status_text) free(status_text);
+
+    return(status);
+}
+
+/**
+ *  Static: Parse the input files concurrently and store them in order.
+ *
+ *  The input files are parsed by the parse_file_hook function using the
+ *  number of threads returned by dsproc_get_ingest_threads(). The parsed
+ *  data is then passed to the store_file_hook function by the main thread
+ *  in file order so the output datastreams are still appended to correctly,
+ *  and the raw files are only moved after their data has been stored.
+ *
+ *  @param  input_dir - full path to the input directory
+ *  @param  nfiles    - number of input files
+ *  @param  files     - list of input files
+ */
+static void _dsproc_ingest_files(
+    const char  *input_dir,
+    int          nfiles,
+    char       **files)
+{
+    IngestPool   pool;
+    pthread_t   *threads;
+    int          nthreads;
+    int          nstarted;
+    void        *data;
+    time_t       loop_start;
+    time_t       loop_end;
+    time_t       time_remaining;
+    int          parse_errno;
+    int          status;
+    int          fi, ti;
+
+    nthreads = dsproc_get_ingest_threads();
+
+    if (nthreads > nfiles) {
+        nthreads = nfiles;
+    }
+
+    memset(&pool, 0, sizeof(IngestPool));
+
+    pool.input_dir   = input_dir;
+    pool.files       = files;
+    pool.nfiles      = nfiles;
+    pool.window      = 2 * nthreads;
+    pool.status      = (int *)malloc(nfiles * sizeof(int));
+    pool.data        = (void **)calloc(nfiles, sizeof(void *));
+    pool.status_text = (char **)calloc(nfiles, sizeof(char *));
+    pool.parse_errno = (int *)calloc(nfiles, sizeof(int));
+    threads          = (pthread_t *)calloc(nthreads, sizeof(pthread_t));
+
+    if (!pool.status || !pool.data ||
+        !pool.status_text || !pool.parse_errno || !threads) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not allocate memory for ingest thread pool\n");
+
+        dsproc_set_status(DSPROC_ENOMEM);
+        goto CLEANUP;
+    }
+
+    for (fi = 0; fi < nfiles; fi++) {
+        pool.status[fi] = INGEST_PENDING;
+    }
+
+    pthread_mutex_init(&pool.mutex, NULL);
+    pthread_cond_init(&pool.cond, NULL);
+
+    /* The main thread parses the next file itself if none of the
+     * ingest threads have started it yet */
+
+    nstarted = 0;
+
+    if (nthreads > 1) {
+
+        DEBUG_LV1( DSPROC_LIB_NAME,
+            "Parsing %d input files using %d threads\n",
+            nfiles, nthreads);
+
+        for (ti = 0; ti < nthreads; ti++) {
+            if (pthread_create(
+                &threads[ti], NULL, _dsproc_ingest_thread, &pool) != 0) {
+                break;
+            }
+            nstarted = ti + 1;
+        }
+    }
+
+    /* Loop over all input files */
+
+    loop_start  = 0;
+    loop_end    = 0;
+
+    for (fi = 0; fi < nfiles; fi++) {
+
+        /* Check the run time */
+
+        time_remaining = dsproc_get_time_remaining();
+
+        if (time_remaining >= 0) {
+
+            if (time_remaining == 0) {
+                break;
+            }
+            else if (loop_end - loop_start > time_remaining) {
+
+                LOG( DSPROC_LIB_NAME,
+                    "\nStopping ingest before max run time of %d seconds is exceeded\n",
+                    (int)dsproc_get_max_run_time());
+
+                dsproc_set_status(DSPROC_ERUNTIME);
+                break;
+            }
+        }
+
+        /* Wait for the file to be parsed */
+
+        loop_start = time(NULL);
+
+        status = _dsproc_ingest_wait(&pool, fi, &data, &parse_errno);
+
+        /* Store the file */
+
+        DEBUG_LV1_BANNER( DSPROC_LIB_NAME,
+            "PROCESSING FILE #%d: %s\n", fi + 1, files[fi]);
+
+        LOG( DSPROC_LIB_NAME,
+            "\nProcessing: %s/%s\n", input_dir, files[fi]);
+
+        dsproc_set_input_dir(input_dir);
+        dsproc_set_input_source(files[fi]);
+
+        status = _dsproc_run_store_file_hook(
+            input_dir, files[fi], status, parse_errno, data);
+
+        pthread_mutex_lock(&pool.mutex);
+        pool.stored = fi + 1;
+        pthread_cond_broadcast(&pool.cond);
+        pthread_mutex_unlock(&pool.mutex);
+
+        if (status == -1) break;
+
+        loop_end = time(NULL);
+    }
+
+    /* Stop the ingest threads and free any data that was not stored */
+
+    pthread_mutex_lock(&pool.mutex);
+    pool.stop = 1;
+    pthread_cond_broadcast(&pool.cond);
+    pthread_mutex_unlock(&pool.mutex);
+
+    for (ti = 0; ti < nstarted; ti++) {
+        pthread_join(threads[ti], NULL);
+    }
+
+    for (fi = 0; fi < nfiles; fi++) {
+        _dsproc_free_file_data(pool.data[fi]);
+        if (pool.status_text[fi]) free(pool.status_text[fi]);
+    }
+
+    pthread_cond_destroy(&pool.cond);
+    pthread_mutex_destroy(&pool.mutex);
+
+CLEANUP:
+
+    if (pool.status)      free(pool.status);
+    if (pool.data)        free(pool.data);
+    if (pool.status_text) free(pool.status_text);
+    if (pool.parse_errno) free(pool.parse_errno);
+    if (threads)          free(threads);
+}
+
 /**
  *  Static: Main Ingest file processing loop.
  */
@@ -121,6 +466,15 @@ static void _dsproc_ingest_main_loop()
 
     input_dir = dsproc_datastream_path(dsid);
 
+    /* Use the parallel ingest driver if the parse_file_hook
+     * and store_file_hook functions have been set */
+
+    if (_dsproc_has_parse_file_hook()) {
+        _dsproc_ingest_files(input_dir, nfiles, files);
+        dsproc_free_file_list(files);
+        return;
+    }
+
     /* Loop over all input files */
 
     loop_start  = 0;
@@ -205,6 +559,11 @@ static void _dsproc_vap_main_loop(int proc_model)
 
             if (status == -1) break;
             if (status ==  0) continue;
+
+            /* Start reading the input files for the next processing
+             * intervals while this one is being processed. */
+
+            _dsproc_prefetch_next_intervals();
         }
 
         /* Run the post_retrieval_hook function */
@@ -273,6 +632,8 @@ static void _dsproc_vap_main_loop(int proc_model)
         }
     }
 
+    _dsproc_free_prefetch();
+
     return;
 }
 
@@ -386,6 +747,67 @@ int dsproc_main(
     return(exit_value);
 }
 
+/**
+ *  Get the number of threads used to parse the ingest input files.
+ *
+ *  If the number of threads has not been set using the --ingest-threads
+ *  command line option or dsproc_set_ingest_threads(), the
+ *  DSPROC_INGEST_THREADS environment variable will be checked.
+ *
+ *  @return  number of ingest threads (1 = serial)
+ *
+ *  @see dsproc_set_ingest_threads()
+ */
+int dsproc_get_ingest_threads(void)
+{
+    const char *env;
+
+    if (_IngestThreads < 0) {
+
+        env = getenv("DSPROC_INGEST_THREADS");
+
+        if (env && *env) {
+            dsproc_set_ingest_threads(atoi(env));
+        }
+        else {
+            _IngestThreads = 1;
+        }
+    }
+
+    return(_IngestThreads);
+}
+
+/**
+ *  Set the number of threads used to parse the ingest input files.
+ *
+ *  This only applies to ingests that set both the parse_file_hook and
+ *  store_file_hook functions. When more than one thread is used, the
+ *  input files are parsed concurrently while the main thread stores the
+ *  parsed data in file order.
+ *
+ *  @param  nthreads - number of threads to use, 1 for serial mode,
+ *                     or 0 to use the number of online processors
+ *
+ *  @see dsproc_get_ingest_threads()
+ */
+void dsproc_set_ingest_threads(int nthreads)
+{
+    long nprocs;
+
+    if (nthreads == 0) {
+        nprocs   = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (nprocs > 0) ? (int)nprocs : 1;
+    }
+    else if (nthreads < 0) {
+        nthreads = 1;
+    }
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "Setting number of ingest threads to: %d\n", nthreads);
+
+    _IngestThreads = nthreads;
+}
+
 #if 0
 /**
  *  Get the compile date of the process.
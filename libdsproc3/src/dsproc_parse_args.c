@@ -250,6 +250,8 @@ static void _dsproc_vap_exit_usage(
 "\n"
 "    -a alias      - Specify the .db_connect alias to use (default: dsdb_data).\n"
 "    -h            - Display help message.\n"
+"    -j [threads]  - Number of threads to use to transform the retrieved data\n"
+"                    (default: number of processors).\n"
 "    -v            - Display process version.\n"
 "%s"
 "\n"
@@ -315,6 +317,7 @@ void _dsproc_ingest_parse_args(
     int          debug_level;
     int          prov_level;
     const char  *switches;
+    int          nthreads;
     char         c;
     int          ni;
 
@@ -330,6 +333,18 @@ void _dsproc_ingest_parse_args(
                 if (strcmp(*argv, "--dynamic-dods") == 0) {
                     dsproc_set_dynamic_dods_mode(1);
                 }
+                else if (strcmp(*argv, "--ingest-threads") == 0) {
+
+                    if (argc > 1 && isdigit(*(argv+1)[0])) {
+                        nthreads = atoi(*++argv);
+                        argc--;
+                    }
+                    else {
+                        nthreads = 0;
+                    }
+
+                    dsproc_set_ingest_threads(nthreads);
+                }
                 else if (strcmp(*argv, "--output-csv") == 0) {
                     dsproc_set_output_format(DSF_CSV);
                 }
@@ -517,6 +532,8 @@ void _dsproc_vap_parse_args(
     int          rt_mode;
     int          debug_level;
     float        max_real_time_wait;
+    int          prefetch_depth;
+    int          nthreads;
     int          prov_level;
     const char  *switches;
     char         c;
@@ -541,6 +558,33 @@ void _dsproc_vap_parse_args(
                 else if (strcmp(*argv, "--output-csv") == 0) {
                     dsproc_set_output_format(DSF_CSV);
                 }
+                else if (strcmp(*argv, "--prefetch") == 0) {
+
+                    if (argc > 1 && isdigit(*(argv+1)[0])) {
+                        prefetch_depth = atoi(*++argv);
+                        argc--;
+                    }
+                    else {
+                        prefetch_depth = 1;
+                    }
+
+                    dsproc_set_retriever_prefetch(prefetch_depth);
+                }
+                else if (strcmp(*argv, "--ret-threads") == 0) {
+
+                    if (argc > 1 && isdigit(*(argv+1)[0])) {
+                        nthreads = atoi(*++argv);
+                        argc--;
+                    }
+                    else {
+                        nthreads = 0;
+                    }
+
+                    dsproc_set_retriever_threads(nthreads);
+                }
+                else if (strcmp(*argv, "--time-index") == 0) {
+                    dsproc_set_time_index_mode(1);
+                }
                 else if (strcmp(*argv, "--real-time") == 0) {
 
                     if (argc > 1 && isdigit(*(argv+1)[0])) {
@@ -599,6 +643,16 @@ void _dsproc_vap_parse_args(
                     _dsproc_vap_exit_usage(
                         program_name, nproc_names, proc_names, 0);
                     break;
+                case 'j':
+                    if (argc > 1 && isdigit(*(argv+1)[0])) {
+                        nthreads = atoi(*++argv);
+                        argc--;
+                    }
+                    else {
+                        nthreads = 0;
+                    }
+                    dsproc_set_transform_threads(nthreads);
+                    break;
                 case 'f':
                     if (--argc == 0) goto MISSING_ARG;
                     if (!(_DSProc->facility = strdup(*++argv))) {
@@ -0,0 +1,850 @@
+/*******************************************************************************
+*
+*  COPYRIGHT (C) 2016 Battelle Memorial Institute.  All Rights Reserved.
+*
+********************************************************************************
+*
+*  Author:
+*     name:  Brian Ermold
+*     phone: (509) 375-2277
+*     email: brian.ermold@pnl.gov
+*
+********************************************************************************
+*
+*  REPOSITORY INFORMATION:
+*    $Revision$
+*    $Author$
+*    $Date$
+*
+********************************************************************************
+*
+*  NOTE: DOXYGEN is used to generate documentation for this file.
+*
+*******************************************************************************/
+
+/** @file dsproc_prefetch.c
+ *  Retriever Input File Prefetching.
+ *
+ *  The NetCDF library and the internal DSProc structures are not thread safe,
+ *  so the retrieval of the data for a processing interval must always be done
+ *  in the main thread. What can be done in parallel is getting the input
+ *  files for the upcoming processing intervals off of the disk (or network
+ *  storage) and into the system page cache while the current processing
+ *  interval is being transformed and stored. The file lists are determined
+ *  in the main thread using only the datastream directory listings, and the
+ *  full paths are handed off to a background thread that reads them.
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "dsproc3.h"
+#include "dsproc_private.h"
+
+extern DSProc *_DSProc; /**< Internal DSProc structure */
+
+/** @privatesection */
+
+/*******************************************************************************
+ *  Static Data and Functions Visible Only To This Module
+ */
+
+/** Size of the buffer used to read the prefetched files. */
+#define PREFETCH_BUFFER_SIZE   1048576
+
+/** Number of recently queued files to remember. */
+#define PREFETCH_HISTORY_SIZE  256
+
+/**
+ *  Prefetch request for one processing interval.
+ */
+typedef struct {
+
+    time_t  begin;   /**< begin time of the processing interval */
+    time_t  end;     /**< end time of the processing interval   */
+    int     nfiles;  /**< number of files in the list           */
+    char  **paths;   /**< full paths to the files to prefetch   */
+    int    *dsids;   /**< input datastream ID of each file      */
+
+} PrefetchRequest;
+
+static int              _PrefetchDepth   = 0;     /**< max queued intervals */
+static int              _PrefetchStarted = 0;     /**< thread started flag  */
+static int              _PrefetchStop    = 0;     /**< thread stop flag     */
+static pthread_t        _PrefetchThread;          /**< prefetch thread      */
+static pthread_mutex_t  _PrefetchMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   _PrefetchCond  = PTHREAD_COND_INITIALIZER;
+
+static PrefetchRequest *_PrefetchQueue = (PrefetchRequest *)NULL;
+static int              _PrefetchHead  = 0;  /**< index of next request     */
+static int              _PrefetchCount = 0;  /**< number of queued requests */
+static time_t           _PrefetchEnd   = 0;  /**< end of last queued interval */
+
+static char *_PrefetchHistory[PREFETCH_HISTORY_SIZE];
+static int   _PrefetchHistoryNext = 0;
+
+static int   _RetrieverThreads = -1; /**< -1 = not set yet */
+
+/**
+ *  Reader pool used to fetch the input files for the current interval.
+ */
+typedef struct {
+
+    PrefetchRequest *request;   /**< files to read                         */
+    char            *taken;     /**< flags for files taken by a reader     */
+    int             *limit;     /**< max concurrent reads per datastream   */
+    int             *active;    /**< current reads per datastream          */
+    int              remaining; /**< number of files not yet taken         */
+    pthread_mutex_t  mutex;     /**< pool mutex                            */
+    pthread_cond_t   cond;      /**< signaled when a read finishes         */
+
+} FetchPool;
+
+/**
+ *  Static: Free the memory used by a prefetch request.
+ */
+static void _dsproc_free_prefetch_request(PrefetchRequest *request)
+{
+    int fi;
+
+    if (request->paths) {
+        for (fi = 0; fi < request->nfiles; fi++) {
+            if (request->paths[fi]) free(request->paths[fi]);
+        }
+        free(request->paths);
+    }
+
+    if (request->dsids) free(request->dsids);
+
+    request->nfiles = 0;
+    request->paths  = (char **)NULL;
+    request->dsids  = (int *)NULL;
+}
+
+/**
+ *  Static: Check if a file was recently queued for prefetching.
+ *
+ *  The file will be added to the history list if it was not found.
+ *
+ *  @param  path - full path to the file
+ *
+ *  @return
+ *    - 1 if the file was recently queued
+ *    - 0 if the file was not found in the history list
+ */
+static int _dsproc_check_prefetch_history(const char *path)
+{
+    char *next;
+    int   hi;
+
+    for (hi = 0; hi < PREFETCH_HISTORY_SIZE; hi++) {
+        if (_PrefetchHistory[hi] && strcmp(_PrefetchHistory[hi], path) == 0) {
+            return(1);
+        }
+    }
+
+    next = strdup(path);
+    if (!next) return(0);
+
+    if (_PrefetchHistory[_PrefetchHistoryNext]) {
+        free(_PrefetchHistory[_PrefetchHistoryNext]);
+    }
+
+    _PrefetchHistory[_PrefetchHistoryNext] = next;
+    _PrefetchHistoryNext = (_PrefetchHistoryNext + 1) % PREFETCH_HISTORY_SIZE;
+
+    return(0);
+}
+
+/**
+ *  Static: Read a file into the system page cache.
+ *
+ *  The posix_fadvise() hint is not honored by all network file systems
+ *  so the file is also read through. The read will be abandoned if the
+ *  stop flag is set.
+ *
+ *  @param  path   - full path to the file
+ *  @param  buffer - scratch buffer of length PREFETCH_BUFFER_SIZE
+ */
+static void _dsproc_prefetch_file(const char *path, char *buffer)
+{
+    int     fd;
+    ssize_t nread;
+    int     stop;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+
+#ifdef POSIX_FADV_WILLNEED
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+
+    for (;;) {
+
+        nread = read(fd, buffer, PREFETCH_BUFFER_SIZE);
+        if (nread <= 0) break;
+
+        pthread_mutex_lock(&_PrefetchMutex);
+        stop = _PrefetchStop;
+        pthread_mutex_unlock(&_PrefetchMutex);
+
+        if (stop) break;
+    }
+
+    close(fd);
+}
+
+/**
+ *  Static: Prefetch thread main loop.
+ *
+ *  Messages must not be generated from this thread.
+ */
+static void *_dsproc_prefetch_thread(void *arg)
+{
+    char            *buffer = (char *)arg;
+    PrefetchRequest  request;
+    int              fi;
+
+    for (;;) {
+
+        pthread_mutex_lock(&_PrefetchMutex);
+
+        while (!_PrefetchStop && _PrefetchCount == 0) {
+            pthread_cond_wait(&_PrefetchCond, &_PrefetchMutex);
+        }
+
+        if (_PrefetchStop) {
+            pthread_mutex_unlock(&_PrefetchMutex);
+            break;
+        }
+
+        request = _PrefetchQueue[_PrefetchHead];
+
+        _PrefetchQueue[_PrefetchHead].nfiles = 0;
+        _PrefetchQueue[_PrefetchHead].paths  = (char **)NULL;
+        _PrefetchQueue[_PrefetchHead].dsids  = (int *)NULL;
+
+        _PrefetchHead   = (_PrefetchHead + 1) % _PrefetchDepth;
+        _PrefetchCount -= 1;
+
+        pthread_mutex_unlock(&_PrefetchMutex);
+
+        for (fi = 0; fi < request.nfiles; fi++) {
+            _dsproc_prefetch_file(request.paths[fi], buffer);
+        }
+
+        _dsproc_free_prefetch_request(&request);
+    }
+
+    free(buffer);
+
+    return((void *)NULL);
+}
+
+/**
+ *  Static: Start the prefetch thread.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages. The process status will *not* be set because the
+ *  prefetching is only an optimization.
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if an error occurred
+ */
+static int _dsproc_start_prefetch_thread(void)
+{
+    char *buffer;
+    int   status;
+
+    _PrefetchQueue = (PrefetchRequest *)calloc(
+        _PrefetchDepth, sizeof(PrefetchRequest));
+
+    buffer = (char *)malloc(PREFETCH_BUFFER_SIZE * sizeof(char));
+
+    if (!_PrefetchQueue || !buffer) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not start input file prefetch thread\n"
+            " -> memory allocation error\n");
+
+        if (_PrefetchQueue) free(_PrefetchQueue);
+        if (buffer)         free(buffer);
+
+        _PrefetchQueue = (PrefetchRequest *)NULL;
+        _PrefetchDepth = 0;
+        return(0);
+    }
+
+    _PrefetchHead  = 0;
+    _PrefetchCount = 0;
+    _PrefetchStop  = 0;
+
+    status = pthread_create(
+        &_PrefetchThread, NULL, _dsproc_prefetch_thread, buffer);
+
+    if (status != 0) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not start input file prefetch thread\n"
+            " -> %s\n", strerror(status));
+
+        free(_PrefetchQueue);
+        free(buffer);
+
+        _PrefetchQueue = (PrefetchRequest *)NULL;
+        _PrefetchDepth = 0;
+        return(0);
+    }
+
+    _PrefetchStarted = 1;
+
+    return(1);
+}
+
+/**
+ *  Static: Get the list of input files needed for a processing interval.
+ *
+ *  Only the file names are used to determine the file times so this
+ *  function will not open any of the input files.
+ *
+ *  @param  begin   - begin time of the processing interval
+ *  @param  end     - end time of the processing interval
+ *  @param  request - output: request to add the file paths to
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if a memory allocation error occurred
+ */
+static int _dsproc_get_prefetch_files(
+    time_t           begin,
+    time_t           end,
+    PrefetchRequest *request)
+{
+    DataStream *in_ds;
+    RetDsCache *cache;
+    time_t      begin_time;
+    time_t      end_time;
+    int         nfiles;
+    char      **files;
+    char      **new_paths;
+    int        *new_dsids;
+    char       *path;
+    size_t      length;
+    int         in_dsid;
+    int         fi;
+
+    request->begin  = begin;
+    request->end    = end;
+    request->nfiles = 0;
+    request->paths  = (char **)NULL;
+    request->dsids  = (int *)NULL;
+
+    for (in_dsid = 0; in_dsid < _DSProc->ndatastreams; in_dsid++) {
+
+        in_ds = _DSProc->datastreams[in_dsid];
+        cache = in_ds->ret_cache;
+
+        if (!cache || !in_ds->dir) {
+            continue;
+        }
+
+        /* Adjust times for the begin and end offsets and dependencies
+         * the same way it will be done by dsproc_retrieve_data(). */
+
+        begin_time = begin - cache->begin_offset;
+        end_time   = end   + cache->end_offset;
+
+        if (cache->dep_begin_date) {
+            if (cache->dep_begin_date > end_time) continue;
+            if (begin_time < cache->dep_begin_date)
+                begin_time = cache->dep_begin_date;
+        }
+
+        if (cache->dep_end_date) {
+            if (cache->dep_end_date < begin_time) continue;
+            if (end_time > cache->dep_end_date)
+                end_time = cache->dep_end_date;
+        }
+
+        nfiles = _dsproc_find_dsdir_files(
+            in_ds->dir, begin_time, end_time, &files);
+
+        if (nfiles <= 0) {
+            continue;
+        }
+
+        new_paths = (char **)realloc(request->paths,
+            (request->nfiles + nfiles) * sizeof(char *));
+
+        if (!new_paths) {
+            _dsproc_free_prefetch_request(request);
+            return(0);
+        }
+
+        request->paths = new_paths;
+
+        new_dsids = (int *)realloc(request->dsids,
+            (request->nfiles + nfiles) * sizeof(int));
+
+        if (!new_dsids) {
+            _dsproc_free_prefetch_request(request);
+            return(0);
+        }
+
+        request->dsids = new_dsids;
+
+        for (fi = 0; fi < nfiles; fi++) {
+
+            length = strlen(in_ds->dir->path) + strlen(files[fi]) + 2;
+            path   = (char *)malloc(length * sizeof(char));
+
+            if (!path) {
+                _dsproc_free_prefetch_request(request);
+                return(0);
+            }
+
+            sprintf(path, "%s/%s", in_ds->dir->path, files[fi]);
+
+            if (_dsproc_check_prefetch_history(path)) {
+                free(path);
+                continue;
+            }
+
+            request->dsids[request->nfiles]   = in_dsid;
+            request->paths[request->nfiles++] = path;
+        }
+    }
+
+    return(1);
+}
+
+/**
+ *  Static: Reader thread for the current interval fetch pool.
+ *
+ *  Each reader takes the next file whose datastream is below its limit of
+ *  concurrent reads, so a single datastream with many files cannot hold
+ *  more files open than allowed by dsproc_set_max_open_files().
+ *
+ *  Messages must not be generated from this thread.
+ */
+static void *_dsproc_fetch_thread(void *arg)
+{
+    FetchPool *pool = (FetchPool *)arg;
+    char      *buffer;
+    int        dsid;
+    int        fi;
+
+    buffer = (char *)malloc(PREFETCH_BUFFER_SIZE * sizeof(char));
+    if (!buffer) return((void *)NULL);
+
+    dsid = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while (pool->remaining > 0) {
+
+        for (fi = 0; fi < pool->request->nfiles; fi++) {
+            dsid = pool->request->dsids[fi];
+            if (!pool->taken[fi] && pool->active[dsid] < pool->limit[dsid]) {
+                break;
+            }
+        }
+
+        if (fi == pool->request->nfiles) {
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+            continue;
+        }
+
+        pool->taken[fi]     = 1;
+        pool->remaining    -= 1;
+        pool->active[dsid] += 1;
+
+        pthread_mutex_unlock(&pool->mutex);
+
+        _dsproc_prefetch_file(pool->request->paths[fi], buffer);
+
+        pthread_mutex_lock(&pool->mutex);
+
+        pool->active[dsid] -= 1;
+        pthread_cond_broadcast(&pool->cond);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    free(buffer);
+
+    return((void *)NULL);
+}
+
+/*******************************************************************************
+ *  Private Functions Visible Only To This Library
+ */
+
+/**
+ *  Private: Stop the prefetch thread and free all prefetch requests.
+ *
+ *  Any files that are currently being read will be abandoned.
+ */
+void _dsproc_free_prefetch(void)
+{
+    int ri, hi;
+
+    if (_PrefetchStarted) {
+
+        pthread_mutex_lock(&_PrefetchMutex);
+        _PrefetchStop = 1;
+        pthread_cond_signal(&_PrefetchCond);
+        pthread_mutex_unlock(&_PrefetchMutex);
+
+        pthread_join(_PrefetchThread, NULL);
+
+        _PrefetchStarted = 0;
+    }
+
+    if (_PrefetchQueue) {
+
+        for (ri = 0; ri < _PrefetchDepth; ri++) {
+            _dsproc_free_prefetch_request(&_PrefetchQueue[ri]);
+        }
+
+        free(_PrefetchQueue);
+        _PrefetchQueue = (PrefetchRequest *)NULL;
+    }
+
+    for (hi = 0; hi < PREFETCH_HISTORY_SIZE; hi++) {
+        if (_PrefetchHistory[hi]) {
+            free(_PrefetchHistory[hi]);
+            _PrefetchHistory[hi] = (char *)NULL;
+        }
+    }
+
+    _PrefetchHistoryNext = 0;
+    _PrefetchHead        = 0;
+    _PrefetchCount       = 0;
+    _PrefetchEnd         = 0;
+}
+
+/**
+ *  Private: Read the input files for the current processing interval.
+ *
+ *  This function is called by dsproc_retrieve_data() before any of the
+ *  input files are opened. When more than one retriever thread is used,
+ *  the input files for all datastreams are read into the system page cache
+ *  by a pool of reader threads so the open and read latencies overlap.
+ *  The number of files read concurrently from any one datastream is limited
+ *  by dsproc_set_max_open_files(). The files are then opened and the data
+ *  is retrieved in the main thread in the usual order, so the retrieved
+ *  data is the same as it would have been in serial mode.
+ *
+ *  Files that have already been queued for prefetching are skipped, and
+ *  errors are not fatal because this is only an optimization.
+ *
+ *  @param  begin - begin time of the processing interval
+ *  @param  end   - end time of the processing interval
+ */
+void _dsproc_fetch_interval_files(time_t begin, time_t end)
+{
+    PrefetchRequest  request;
+    FetchPool        pool;
+    pthread_t       *threads;
+    int              nthreads;
+    int              nstarted;
+    int              in_dsid;
+    int              ti;
+
+    nthreads = dsproc_get_retriever_threads();
+
+    if (nthreads <= 1 || !_DSProc->retriever) {
+        return;
+    }
+
+    if (!_dsproc_get_prefetch_files(begin, end, &request)) {
+
+        LOG( DSPROC_LIB_NAME,
+            "Could not read input files in parallel\n"
+            " -> memory allocation error\n");
+
+        return;
+    }
+
+    if (request.nfiles < 2) {
+        _dsproc_free_prefetch_request(&request);
+        return;
+    }
+
+    if (nthreads > request.nfiles) {
+        nthreads = request.nfiles;
+    }
+
+    memset(&pool, 0, sizeof(FetchPool));
+
+    pool.request   = &request;
+    pool.remaining = request.nfiles;
+    pool.taken     = (char *)calloc(request.nfiles, sizeof(char));
+    pool.limit     = (int *)calloc(_DSProc->ndatastreams, sizeof(int));
+    pool.active    = (int *)calloc(_DSProc->ndatastreams, sizeof(int));
+    threads        = (pthread_t *)calloc(nthreads, sizeof(pthread_t));
+
+    if (!pool.taken || !pool.limit || !pool.active || !threads) {
+
+        LOG( DSPROC_LIB_NAME,
+            "Could not read input files in parallel\n"
+            " -> memory allocation error\n");
+
+        goto CLEANUP;
+    }
+
+    for (in_dsid = 0; in_dsid < _DSProc->ndatastreams; in_dsid++) {
+
+        pool.limit[in_dsid] = 1;
+
+        if (_DSProc->datastreams[in_dsid]->dir &&
+            _DSProc->datastreams[in_dsid]->dir->max_open > 1) {
+
+            pool.limit[in_dsid] = _DSProc->datastreams[in_dsid]->dir->max_open;
+        }
+    }
+
+    pthread_mutex_init(&pool.mutex, NULL);
+    pthread_cond_init(&pool.cond, NULL);
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "Reading %d input files using %d threads\n",
+        request.nfiles, nthreads);
+
+    /* The main thread is one of the readers */
+
+    nstarted = 0;
+    for (ti = 1; ti < nthreads; ti++) {
+        if (pthread_create(
+            &threads[ti], NULL, _dsproc_fetch_thread, &pool) != 0) {
+            break;
+        }
+        nstarted = ti;
+    }
+
+    _dsproc_fetch_thread(&pool);
+
+    for (ti = 1; ti <= nstarted; ti++) {
+        pthread_join(threads[ti], NULL);
+    }
+
+    pthread_cond_destroy(&pool.cond);
+    pthread_mutex_destroy(&pool.mutex);
+
+CLEANUP:
+
+    if (pool.taken)  free(pool.taken);
+    if (pool.limit)  free(pool.limit);
+    if (pool.active) free(pool.active);
+    if (threads)     free(threads);
+
+    _dsproc_free_prefetch_request(&request);
+}
+
+/**
+ *  Private: Queue the input files for the upcoming processing intervals.
+ *
+ *  This function should be called after the data has been retrieved for
+ *  the current processing interval. The input files for the processing
+ *  intervals following the current one will be queued until the maximum
+ *  prefetch depth is reached, or the end of the processing period.
+ *
+ *  Errors are not fatal because the prefetching is only an optimization,
+ *  the prefetching will simply be disabled.
+ */
+void _dsproc_prefetch_next_intervals(void)
+{
+    PrefetchRequest request;
+    time_t          begin;
+    time_t          end;
+    int             tail;
+    int             queued;
+    char            ts1[32], ts2[32];
+
+    if (_PrefetchDepth <= 0      ||
+        !_DSProc->retriever      ||
+        _DSProc->proc_interval <= 0) {
+
+        return;
+    }
+
+    if (!_PrefetchStarted) {
+        if (!_dsproc_start_prefetch_thread()) return;
+    }
+
+    begin = _DSProc->interval_begin + _DSProc->proc_interval;
+
+    if (_PrefetchEnd > begin) {
+        begin = _PrefetchEnd;
+    }
+
+    for (;;) {
+
+        if (begin >= _DSProc->period_end ||
+            begin >= _DSProc->interval_begin
+                   + (_PrefetchDepth + 1) * _DSProc->proc_interval) {
+
+            break;
+        }
+
+        pthread_mutex_lock(&_PrefetchMutex);
+        queued = _PrefetchCount;
+        pthread_mutex_unlock(&_PrefetchMutex);
+
+        if (queued >= _PrefetchDepth) {
+            break;
+        }
+
+        end = begin + _DSProc->proc_interval;
+        if (end > _DSProc->period_end) {
+            end = _DSProc->period_end;
+        }
+
+        if (!_dsproc_get_prefetch_files(begin, end, &request)) {
+
+            ERROR( DSPROC_LIB_NAME,
+                "Could not queue input files for prefetching\n"
+                " -> memory allocation error\n"
+                " -> disabling input file prefetching\n");
+
+            _dsproc_free_prefetch();
+            _PrefetchDepth = 0;
+            return;
+        }
+
+        _PrefetchEnd = end;
+
+        if (request.nfiles == 0) {
+            begin = end;
+            continue;
+        }
+
+        DEBUG_LV1( DSPROC_LIB_NAME,
+            "Queued %d input files for prefetching: ['%s', '%s')\n",
+            request.nfiles,
+            format_secs1970(begin, ts1),
+            format_secs1970(end,   ts2));
+
+        pthread_mutex_lock(&_PrefetchMutex);
+
+        tail = (_PrefetchHead + _PrefetchCount) % _PrefetchDepth;
+        _PrefetchQueue[tail] = request;
+        _PrefetchCount += 1;
+
+        pthread_cond_signal(&_PrefetchCond);
+        pthread_mutex_unlock(&_PrefetchMutex);
+
+        begin = end;
+    }
+}
+
+/** @publicsection */
+
+/*******************************************************************************
+ *  Internal Functions Visible To The Public
+ */
+
+/**
+ *  Get the input file prefetch depth.
+ *
+ *  @return  maximum number of processing intervals to prefetch
+ *
+ *  @see dsproc_set_retriever_prefetch()
+ */
+int dsproc_get_retriever_prefetch(void)
+{
+    return(_PrefetchDepth);
+}
+
+/**
+ *  Set the input file prefetch depth.
+ *
+ *  The prefetch mode can be enabled using the --prefetch option on the
+ *  command line. When enabled, the input files needed by the retriever for
+ *  the next depth processing intervals will be read into the system page
+ *  cache by a background thread while the current processing interval is
+ *  being transformed, processed, and stored. This must be called before the
+ *  processing loop is started.
+ *
+ *  @param  depth - maximum number of processing intervals to prefetch
+ *                  (0 = disabled)
+ *
+ *  @see dsproc_get_retriever_prefetch()
+ */
+void dsproc_set_retriever_prefetch(int depth)
+{
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "Setting input file prefetch depth to: %d\n", depth);
+
+    if (_PrefetchStarted) {
+        _dsproc_free_prefetch();
+    }
+
+    _PrefetchDepth = (depth > 0) ? depth : 0;
+}
+
+/**
+ *  Get the number of threads used to read the input files.
+ *
+ *  If the number of threads has not been set using the --ret-threads
+ *  command line option or dsproc_set_retriever_threads(), the
+ *  DSPROC_RETRIEVER_THREADS environment variable will be checked.
+ *
+ *  @return  number of retriever threads (1 = serial)
+ *
+ *  @see dsproc_set_retriever_threads()
+ */
+int dsproc_get_retriever_threads(void)
+{
+    const char *env;
+
+    if (_RetrieverThreads < 0) {
+
+        env = getenv("DSPROC_RETRIEVER_THREADS");
+
+        if (env && *env) {
+            dsproc_set_retriever_threads(atoi(env));
+        }
+        else {
+            _RetrieverThreads = 1;
+        }
+    }
+
+    return(_RetrieverThreads);
+}
+
+/**
+ *  Set the number of threads used to read the input files.
+ *
+ *  When more than one thread is used, the input files needed by the
+ *  retriever for the current processing interval are read into the system
+ *  page cache by a pool of threads before they are opened. This is most
+ *  useful when the input datastreams are on network storage. The NetCDF
+ *  library is not thread safe so the files are still opened and the data
+ *  is still retrieved in the main thread.
+ *
+ *  @param  nthreads - number of threads to use, 1 for serial mode,
+ *                     or 0 to use the number of online processors
+ *
+ *  @see dsproc_get_retriever_threads()
+ */
+void dsproc_set_retriever_threads(int nthreads)
+{
+    long nprocs;
+
+    if (nthreads == 0) {
+        nprocs   = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (nprocs > 0) ? (int)nprocs : 1;
+    }
+    else if (nthreads < 0) {
+        nthreads = 1;
+    }
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "Setting number of retriever threads to: %d\n", nthreads);
+
+    _RetrieverThreads = nthreads;
+}
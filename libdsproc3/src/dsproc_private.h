@@ -34,6 +34,9 @@
 /** Macro to copy a string if the source string is not null. */
 #define STRDUP_FAILED(s1,s2) ( s2 && !( s1 = strdup(s2) ) )
 
+/** Length of the process status message buffer. */
+#define DSPROC_STATUS_LENGTH 512
+
 typedef struct DataStream DataStream;
 
 void _dsproc_trim_version(char *version);
@@ -59,7 +62,7 @@ typedef struct DSProc {
     const char  *facility;       /**< facility name                          */
     const char  *full_name;      /**< full process name including type       */
 
-    const char   status[512];    /**< process status message                 */
+    const char   status[DSPROC_STATUS_LENGTH]; /**< process status message   */
     const char   disable[512];   /**< process disable message                */
 
     time_t       start_time;     /**< process start time                     */
@@ -124,6 +127,8 @@ typedef struct DSProc {
 
 const char *_dsproc_get_command_line(void);
 
+void    _dsproc_set_thread_status(char *buffer);
+
 void    _dsproc_ingest_parse_args(
             int          argc,
             char       **argv,
@@ -169,12 +174,47 @@ int     _dsproc_run_process_file_hook(
             const char *input_dir,
             const char *file_name);
 
+int     _dsproc_has_parse_file_hook(void);
+void    _dsproc_free_file_data(void *file_data);
+
+int     _dsproc_run_parse_file_hook(
+            const char  *input_dir,
+            const char  *file_name,
+            void       **file_data);
+
+int     _dsproc_run_store_file_hook(
+            const char *input_dir,
+            const char *file_name,
+            int         parse_status,
+            int         parse_errno,
+            void       *file_data);
+
 int     _dsproc_custom_qc_hook(
             int       ds_id,
             CDSGroup *dataset);
 
 /*@}*/
 
+/******************************************************************************/
+/**
+ *  @defgroup PRIVATE_DSPROC_CSV_PARSER Private: CSV Parser
+ */
+/*@{*/
+
+off_t   _dsproc_csv_line_offset(CSVParser *csv, int linenum);
+int     _dsproc_read_csv_checkpoint(CSVParser *csv);
+
+void    _dsproc_free_csv_columns(CSVParser *csv);
+int     _dsproc_realloc_csv_columns(CSVParser *csv, int nrecs);
+int     _dsproc_reset_csv_columns(CSVParser *csv);
+
+void    _dsproc_set_csv_column_value(
+            CSVColumn  *column,
+            const char *strval,
+            int         ri);
+
+/*@}*/
+
 /******************************************************************************/
 /*
  *  @defgroup PRIVATE_DSPROC_VARTAG Private: Variable Tag
@@ -277,6 +317,11 @@ typedef struct {
 
 } DSFile;
 
+/**
+ *  Datastream Directory Time Index (see dsproc_datastream_index.c).
+ */
+typedef struct DSIndex DSIndex;
+
 /**
  *  Datastream Directory Structure.
  */
@@ -298,6 +343,8 @@ struct DSDir {
     int         nopen;       /**< number of open files                 */
     int         max_open;    /**< maximum number of open files         */
 
+    DSIndex    *index;       /**< persistent file time index           */
+
     /** function used by qsort to sort the file list */
     int  (*file_name_compare)(const void *, const void *);
 
@@ -332,6 +379,18 @@ int     _dsproc_get_dsdir_files(DSDir *dir, char ***files);
 
 int     _dsproc_open_dsfile(DSFile *file, int mode);
 
+void    _dsproc_free_dsdir_index(DSDir *dir);
+
+int     _dsproc_get_dsdir_index_times(
+            DSDir       *dir,
+            const char  *name,
+            struct stat *stats,
+            int         *ntimes,
+            timeval_t   *begin_time,
+            timeval_t   *end_time);
+
+void    _dsproc_update_dsdir_index(DSFile *dsfile);
+
 /*@}*/
 
 /******************************************************************************/
@@ -364,6 +423,18 @@ typedef struct {
                                  in this file. */
 } RetDsFile;
 
+/**
+ *  Retriever Dimension Subset Structure.
+ */
+typedef struct {
+
+    char     *dim_name;     /**< name of the dimension in the input files     */
+    size_t    start;        /**< start index along the dimension              */
+    size_t    count;        /**< number of indexes to read (0 = to the end)   */
+    ptrdiff_t stride;       /**< stride along the dimension                   */
+
+} RetDimSubset;
+
 /**
  *  Retriever DataStream Cache Structure.
  */
@@ -384,6 +455,10 @@ typedef struct {
     int         nfiles;         /**< number of files in the list           */
     RetDsFile **files;          /**< list of files found within the
                                      current processing interval           */
+
+    int           nsubsets;     /**< number of dimension subsets           */
+    RetDimSubset *subsets;      /**< dimension subsets to retrieve         */
+
 } RetDsCache;
 
 void            _dsproc_free_ret_ds_cache(RetDsCache *cache);
@@ -396,6 +471,10 @@ const char     *_dsproc_get_ret_data_time_units(void);
 int             _dsproc_get_ret_group_ds_id(CDSGroup *ret_ds_group);
 int             _dsproc_init_retriever();
 
+void            _dsproc_fetch_interval_files(time_t begin, time_t end);
+void            _dsproc_free_prefetch(void);
+void            _dsproc_prefetch_next_intervals(void);
+
 /*@}*/
 
 /******************************************************************************/
@@ -450,6 +529,7 @@ struct DataStream {
     /* output dataset */
 
     CDSGroup   *out_cds;        /**< pointer to the output dataset            */
+    CDSGroup   *recycled_cds;   /**< stored output dataset kept for reuse     */
 
     /* output file splitting mode */
 
@@ -457,6 +537,11 @@ struct DataStream {
     double      split_start;    /**< the start of the split interval          */
     double      split_interval; /**< split interval                           */
 
+    /* output file storage policy */
+
+    int         storage_flags;  /**< NetCDF-4 storage policy flags (see ncds) */
+    int         deflate_level;  /**< deflate level for the storage policy     */
+
     /* additional rename raw options */
 
     int         preserve_dots;  /**< portion of original name to preserve     */
@@ -477,6 +562,7 @@ struct DataStream {
 
 void _dsproc_free_datastream_fetched_cds(DataStream *ds);
 void _dsproc_free_datastream_out_cds(DataStream *ds);
+void _dsproc_free_datastream_recycled_cds(DataStream *ds);
 void _dsproc_free_datastream_metadata(DataStream *ds);
 void _dsproc_free_datastream(DataStream *ds);
 
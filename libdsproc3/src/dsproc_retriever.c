@@ -46,6 +46,8 @@ static timeval_t _RetData_EndTime;
 static char      _RetData_TimeDesc[64];
 static char      _RetData_TimeUnits[64];
 
+static int _CDSArenaMode = -1; /**< -1 = not set yet */
+
 /**
  *  Static: Add a CDS variable to a CDS variable group.
  *
@@ -1053,6 +1055,108 @@ static int _dsproc_get_ret_file_var_info(
     return(1);
 }
 
+/**
+ *  Static: Apply the dimension subsets to the dimensions of a variable.
+ *
+ *  For each variable dimension that has a subset set using
+ *  dsproc_set_retriever_dim_subset(), the dimension is defined in the
+ *  obs_group with the length of the subset (if it has not already been
+ *  defined), and the dimension length in var_dim_lengths is updated.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  cache           - pointer to the RetDsCache
+ *  @param  ret_file        - pointer to the RetDsFile
+ *  @param  var_ndims       - number of variable dimensions
+ *  @param  var_dim_names   - names of the dimensions in the input file
+ *  @param  var_dim_lengths - input:  lengths of the dimensions in the file
+ *                            output: lengths of the dimension subsets
+ *  @param  ret_dim_names   - names of the dimensions in the obs_group
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if an error occurred
+ */
+static int _dsproc_subset_ret_var_dims(
+    RetDsCache   *cache,
+    RetDsFile    *ret_file,
+    int           var_ndims,
+    const char  **var_dim_names,
+    size_t       *var_dim_lengths,
+    const char  **ret_dim_names)
+{
+    RetDimSubset *subset;
+    CDSDim       *dim;
+    size_t        length;
+    size_t        start;
+    ptrdiff_t     stride;
+    int           di, si;
+
+    for (di = 0; di < var_ndims; di++) {
+
+        subset = (RetDimSubset *)NULL;
+
+        for (si = 0; si < cache->nsubsets; si++) {
+            if (strcmp(cache->subsets[si].dim_name, var_dim_names[di]) == 0) {
+                subset = &(cache->subsets[si]);
+                break;
+            }
+        }
+
+        if (!subset) continue;
+
+        /* Use the existing dimension if it has already been defined */
+
+        dim = cds_get_dim(ret_file->obs_group, ret_dim_names[di]);
+
+        if (dim) {
+            if (ncds_get_dim_subset(dim, &start, &stride)) {
+                var_dim_lengths[di] = dim->length;
+            }
+            continue;
+        }
+
+        if (subset->start >= var_dim_lengths[di]) {
+
+            ERROR( DSPROC_LIB_NAME,
+                "Invalid retriever subset for dimension: %s->%s\n"
+                " -> start index (%d) >= dimension length (%d)\n",
+                ret_file->dsfile->name, var_dim_names[di],
+                (int)subset->start, (int)var_dim_lengths[di]);
+
+            dsproc_set_status(DSPROC_ERETRIEVER);
+            return(0);
+        }
+
+        length = (var_dim_lengths[di] - subset->start + subset->stride - 1)
+               / subset->stride;
+
+        if (subset->count && subset->count < length) {
+            length = subset->count;
+        }
+
+        DEBUG_LV1( DSPROC_LIB_NAME,
+            "%s: Retrieving %d of %d indexes from dimension: %s\n",
+            ret_file->dsfile->name, (int)length,
+            (int)var_dim_lengths[di], var_dim_names[di]);
+
+        dim = cds_define_dim(
+            ret_file->obs_group, ret_dim_names[di], length, 0);
+
+        if (!dim ||
+            !ncds_set_dim_subset(dim, subset->start, subset->stride)) {
+
+            dsproc_set_status(DSPROC_ERETRIEVER);
+            return(0);
+        }
+
+        var_dim_lengths[di] = length;
+    }
+
+    return(1);
+}
+
 /**
  *  Static: Retrieve variable data from a NetCDF file.
  *
@@ -1278,6 +1382,38 @@ static int _dsproc_retrieve_variable(
         }
     }
 
+    /**********************************************************************
+    * Get the user defined dimension names from the retriever definition.
+    * Dimension names that are not specified in the retriever will default
+    * to the names found in the input file.
+    **********************************************************************/
+
+    for (di = 0; di < ret_var->ndim_names; di++) {
+        ret_dim_names[di] = ret_var->dim_names[di];
+        ret_dim_types[di] = 0;
+        ret_dim_units[di] = (char *)NULL;
+    }
+
+    for (; di < var_ndims; di++) {
+        ret_dim_names[di] = var_dim_names[di];
+        ret_dim_types[di] = 0;
+        ret_dim_units[di] = (char *)NULL;
+    }
+
+    /**********************************************************************
+    * Define the dimensions that only a subset will be retrieved for.
+    **********************************************************************/
+
+    if (in_ds->ret_cache->nsubsets) {
+
+        if (!_dsproc_subset_ret_var_dims(
+            in_ds->ret_cache, ret_file,
+            var_ndims, var_dim_names, var_dim_lengths, ret_dim_names)) {
+
+            return(-1);
+        }
+    }
+
     /**********************************************************************
     * Check if a variable with this name already exists in the obs_group.
     * This can happen if a coordinate variable with this name was auto-loaded.
@@ -1340,24 +1476,6 @@ static int _dsproc_retrieve_variable(
 
     } /* end if obs_var exists */
 
-    /**********************************************************************
-    * Get the user defined dimension names from the retriever definition.
-    * Dimension names that are not specified in the retriever will default
-    * to the names found in the input file.
-    **********************************************************************/
-
-    for (di = 0; di < ret_var->ndim_names; di++) {
-        ret_dim_names[di] = ret_var->dim_names[di];
-        ret_dim_types[di] = 0;
-        ret_dim_units[di] = (char *)NULL;
-    }
-
-    for (; di < var_ndims; di++) {
-        ret_dim_names[di] = var_dim_names[di];
-        ret_dim_types[di] = 0;
-        ret_dim_units[di] = (char *)NULL;
-    }
-
     /**********************************************************************
     * Search the coordinate system dimensions for any
     * coordinate variable data type and/or unit conversions.
@@ -1811,7 +1929,7 @@ static int _dsproc_retrieve_group(
  */
 void _dsproc_free_ret_ds_cache(RetDsCache *cache)
 {
-    int fi;
+    int fi, si;
 
     if (cache) {
 
@@ -1821,6 +1939,12 @@ void _dsproc_free_ret_ds_cache(RetDsCache *cache)
 
         if (cache->files) free(cache->files);
 
+        for (si = 0; si < cache->nsubsets; si++) {
+            free(cache->subsets[si].dim_name);
+        }
+
+        if (cache->subsets) free(cache->subsets);
+
         free(cache);
     }
 }
@@ -2147,6 +2271,13 @@ int dsproc_retrieve_data(
         return(-1);
     }
 
+    if (dsproc_get_cds_arena_mode()) {
+        if (!cds_enable_arena(_DSProc->ret_data)) {
+            dsproc_set_status(DSPROC_ENOMEM);
+            return(-1);
+        }
+    }
+
     *ret_data = _DSProc->ret_data;
 
     /* Set the base_time, and time units and long_name
@@ -2167,6 +2298,11 @@ int dsproc_retrieve_data(
 
     strcpy(_RetData_TimeDesc, "Time offset from midnight");
 
+    /* Read the input files in parallel if more than one retriever
+     * thread is being used. */
+
+    _dsproc_fetch_interval_files(begin_time, end_time);
+
     /* Initialize all input datastreams for this processing interval */
 
     for (in_dsid = 0; in_dsid < _DSProc->ndatastreams; in_dsid++) {
@@ -2439,10 +2575,173 @@ int dsproc_retrieve_data(
     return(1);
 }
 
+/**
+ *  Get the CDS arena mode.
+ *
+ *  If the mode has not been set using dsproc_set_cds_arena_mode(),
+ *  the DSPROC_CDS_ARENA environment variable will be checked.
+ *
+ *  @return
+ *    - 1 if CDS arenas are enabled
+ *    - 0 if CDS arenas are disabled
+ *
+ *  @see dsproc_set_cds_arena_mode()
+ */
+int dsproc_get_cds_arena_mode(void)
+{
+    const char *env;
+
+    if (_CDSArenaMode < 0) {
+
+        env = getenv("DSPROC_CDS_ARENA");
+
+        if (env && *env) {
+            _CDSArenaMode = (atoi(env) > 0) ? 1 : 0;
+        }
+        else {
+            _CDSArenaMode = 0;
+        }
+    }
+
+    return(_CDSArenaMode);
+}
+
+/**
+ *  Set the CDS arena mode.
+ *
+ *  When enabled, the definitions and metadata in the retrieved and
+ *  transformed data groups are allocated from per-tree arenas (see
+ *  cds_enable_arena()). This makes building and freeing the large trees
+ *  created for every processing interval considerably cheaper. The memory
+ *  used by variables and attributes that are deleted is not reused until
+ *  the whole tree is freed at the end of the processing interval.
+ *
+ *  @param  mode - 1 to enable, or 0 to disable
+ *
+ *  @see dsproc_get_cds_arena_mode()
+ */
+void dsproc_set_cds_arena_mode(int mode)
+{
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "Setting CDS arena mode to: %d\n", mode);
+
+    _CDSArenaMode = (mode > 0) ? 1 : 0;
+}
+
 /*******************************************************************************
  *  Public Functions
  */
 
+/**
+ *  Set the subset of a dimension to retrieve from an input datastream.
+ *
+ *  By default all indexes of the non-time dimensions are retrieved. This
+ *  function can be used to only retrieve the indexes from start to
+ *  start + (count - 1) * stride along a dimension, i.e. a few height levels
+ *  or a band of a spectral dimension. Only the requested subset of the data
+ *  will be read from the input files. The subset applies to all retrieved
+ *  variables that use the dimension, including its coordinate variable,
+ *  and should be set in the pre-retrieval hook function.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  ds_id    - input datastream ID
+ *  @param  dim_name - name of the dimension in the input files
+ *  @param  start    - start index along the dimension
+ *  @param  count    - number of indexes to retrieve, or 0 to retrieve
+ *                     all indexes from start to the end of the dimension
+ *  @param  stride   - stride along the dimension (1 = every index)
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if an error occurred
+ */
+int dsproc_set_retriever_dim_subset(
+    int         ds_id,
+    const char *dim_name,
+    size_t      start,
+    size_t      count,
+    ptrdiff_t   stride)
+{
+    DataStream   *ds    = _DSProc->datastreams[ds_id];
+    RetDsCache   *cache = ds->ret_cache;
+    RetDimSubset *subset;
+    RetDimSubset *new_subsets;
+    int           si;
+
+    if (!cache) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not set retriever subset for dimension: %s\n"
+            " -> %s is not a valid input datastream\n",
+            dim_name, ds->name);
+
+        dsproc_set_status(DSPROC_EBADRETRIEVER);
+        return(0);
+    }
+
+    if (stride <= 0 || strcmp(dim_name, "time") == 0) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not set retriever subset for dimension: %s->%s\n"
+            " -> %s\n", ds->name, dim_name,
+            (stride <= 0) ? "stride must be greater than zero"
+                          : "use the retriever time offsets for the time dimension");
+
+        dsproc_set_status(DSPROC_EBADRETRIEVER);
+        return(0);
+    }
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "%s: Setting retriever subset for dimension: %s\n"
+        " - start:  %d\n"
+        " - count:  %d\n"
+        " - stride: %d\n",
+        ds->name, dim_name, (int)start, (int)count, (int)stride);
+
+    /* Replace the existing subset for this dimension if there is one */
+
+    subset = (RetDimSubset *)NULL;
+
+    for (si = 0; si < cache->nsubsets; si++) {
+        if (strcmp(cache->subsets[si].dim_name, dim_name) == 0) {
+            subset = &(cache->subsets[si]);
+            break;
+        }
+    }
+
+    if (!subset) {
+
+        new_subsets = (RetDimSubset *)realloc(cache->subsets,
+            (cache->nsubsets + 1) * sizeof(RetDimSubset));
+
+        if (!new_subsets) goto MEMORY_ERROR;
+
+        cache->subsets = new_subsets;
+        subset = &(cache->subsets[cache->nsubsets]);
+
+        if (!(subset->dim_name = strdup(dim_name))) goto MEMORY_ERROR;
+
+        cache->nsubsets += 1;
+    }
+
+    subset->start  = start;
+    subset->count  = count;
+    subset->stride = stride;
+
+    return(1);
+
+MEMORY_ERROR:
+
+    ERROR( DSPROC_LIB_NAME,
+        "Could not set retriever subset for dimension: %s->%s\n"
+        " -> memory allocation error\n", ds->name, dim_name);
+
+    dsproc_set_status(DSPROC_ENOMEM);
+    return(0);
+}
+
 /**
  *  Set the time offsets to use when retrieving data.
  *
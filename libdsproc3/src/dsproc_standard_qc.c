@@ -28,6 +28,8 @@
 
 #include "dsproc3.h"
 #include "dsproc_private.h"
+#include <pthread.h>
+#include <unistd.h>
 
 extern DSProc *_DSProc; /**< Internal DSProc structure */
 
@@ -43,6 +45,9 @@ static char **ExQcVars;
 /** Number of variables that should be excluded from the QC checks. */
 static int    NumExQcVars;
 
+/** Number of threads used by the standard QC checks, -1 = not set yet. */
+static int    _QCThreads = -1;
+
 /**
  *  Static: Check if a variable has been exculded from the QC checks.
  *
@@ -164,6 +169,501 @@ static int _dsproc_get_prev_dsfile_time_index(
     return(1);
 }
 
+/**
+ *  Static: Get the last sample of the previous dataset for the delta checks.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  var            - pointer to the variable
+ *  @param  prev_var       - pointer to the variable from the previous dataset
+ *  @param  prev_qc_var    - pointer to the QC variable from the previous
+ *                           dataset, or NULL
+ *  @param  prev_sample_vp - output: pointer to the previous sample values,
+ *                           or NULL if the previous variable can not be used
+ *  @param  prev_qc_flags  - output: pointer to the previous sample QC flags
+ *  @param  free_prev_qc   - output: 1 if the memory used by prev_qc_flags
+ *                           was allocated and must be freed by the caller
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if a memory allocation error occurred
+ */
+static int _dsproc_get_prev_qc_sample(
+    CDSVar  *var,
+    CDSVar  *prev_var,
+    CDSVar  *prev_qc_var,
+    void   **prev_sample_vp,
+    int    **prev_qc_flags,
+    int     *free_prev_qc)
+{
+    size_t  sample_size = dsproc_var_sample_size(var);
+    size_t  sample_start;
+
+    *prev_sample_vp = (void *)NULL;
+    *prev_qc_flags  = (int *)NULL;
+    *free_prev_qc   = 0;
+
+    if (!prev_var ||
+        !prev_var->sample_count ||
+        dsproc_var_sample_size(prev_var) != sample_size) {
+
+        return(1);
+    }
+
+    sample_start = (prev_var->sample_count - 1) * sample_size;
+
+    if (prev_qc_var &&
+        prev_qc_var->type == CDS_INT &&
+        prev_qc_var->sample_count >= prev_var->sample_count &&
+        dsproc_var_sample_size(prev_qc_var) == sample_size) {
+
+        *prev_qc_flags = &(prev_qc_var->data.ip[sample_start]);
+    }
+    else {
+
+        *prev_qc_flags = (int *)calloc(sample_size, sizeof(int));
+
+        if (!*prev_qc_flags) {
+
+            ERROR( DSPROC_LIB_NAME,
+                "Could not perform standard QC delta checks\n"
+                " -> memory allocation error\n");
+
+            dsproc_set_status(DSPROC_ENOMEM);
+            return(0);
+        }
+
+        *free_prev_qc = 1;
+    }
+
+    sample_start   *= cds_data_type_size(prev_var->type);
+    *prev_sample_vp = (void *)(prev_var->data.bp + sample_start);
+
+    return(1);
+}
+
+/**
+ *  Standard QC checks for a single variable.
+ *
+ *  Everything the checks need is looked up in the main thread, so the
+ *  cds_qc_limit_delta_checks() calls can be made in parallel without
+ *  touching anything but the variable's own QC flags.
+ */
+typedef struct {
+
+    CDSVar  *var;            /**< pointer to the variable                    */
+    CDSVar  *qc_var;         /**< pointer to the QC variable                 */
+    size_t  *dim_lengths;    /**< dimension lengths of the variable          */
+    int      nmissings;      /**< number of missing values                   */
+    void    *missings_vp;    /**< array of missing values                    */
+    void    *min_vp;         /**< valid_min value, or NULL                   */
+    void    *max_vp;         /**< valid_max value, or NULL                   */
+    size_t   ndeltas;        /**< number of valid_delta values               */
+    void    *deltas_vp;      /**< valid_delta values, or NULL                */
+    void    *prev_sample_vp; /**< last sample from the previous dataset      */
+    int     *prev_qc_flags;  /**< QC flags of the previous sample            */
+    int      free_prev_qc;   /**< 1 if prev_qc_flags needs to be freed       */
+    int      status;         /**< 1 if successful, 0 if an error occurred    */
+
+} QCVarCheck;
+
+/**
+ *  List of variable QC checks shared by the QC worker threads.
+ */
+typedef struct {
+
+    QCVarCheck      *checks;  /**< array of variable QC checks              */
+    int              nchecks; /**< number of variable QC checks             */
+    int              next;    /**< index of the next check to run           */
+    pthread_mutex_t  mutex;   /**< mutex protecting the next index          */
+
+} QCCheckList;
+
+/**
+ *  Static: Initialize the QC limit checks for a variable.
+ *
+ *  This function validates the QC variable, initializes the QC flags for
+ *  any samples that have not been set yet, and gets the valid_min and
+ *  valid_max attributes of the variable. If the variable has data, the
+ *  missing values used by the variable are also retrieved. This is the
+ *  setup shared by dsproc_qc_limit_checks() and the standard QC checks.
+ *
+ *  The memory used by the QCVarCheck structure must be freed using
+ *  _dsproc_free_qc_var_check(), even if an error occurred.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  var        - pointer to the variable
+ *  @param  qc_var     - pointer to the QC variable
+ *  @param  check_name - name of the checks used in the error messages
+ *  @param  check      - pointer to the QCVarCheck structure to initialize
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if an error occurred
+ */
+static int _dsproc_init_qc_limit_check(
+    CDSVar     *var,
+    CDSVar     *qc_var,
+    const char *check_name,
+    QCVarCheck *check)
+{
+    size_t  sample_size;
+    CDSAtt *att;
+    int     found;
+
+    memset(check, 0, sizeof(QCVarCheck));
+
+    check->var    = var;
+    check->qc_var = qc_var;
+
+    /* Make sure the QC variable has integer data type */
+
+    if (qc_var->type != CDS_INT) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not perform %s\n"
+            " -> invalid data type for QC variable: %s\n",
+            check_name, cds_get_object_path(qc_var));
+
+        dsproc_set_status(DSPROC_EQCVARTYPE);
+        return(0);
+    }
+
+    /* Make sure the sample sizes match */
+
+    sample_size = dsproc_var_sample_size(var);
+    if (!sample_size) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not perform %s\n"
+            " -> found zero length dimension for variable: %s\n",
+            check_name, cds_get_object_path(var));
+
+        dsproc_set_status(DSPROC_ESAMPLESIZE);
+        return(0);
+    }
+
+    if (dsproc_var_sample_size(qc_var) != sample_size) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not perform %s\n"
+            " -> QC variable dimensions do not match variable dimensions:\n"
+            " -> variable    %s has sample size: %d\n"
+            " -> qc variable %s has sample size: %d\n",
+            check_name,
+            cds_get_object_path(var), sample_size,
+            cds_get_object_path(qc_var), dsproc_var_sample_size(qc_var));
+
+        dsproc_set_status(DSPROC_EQCVARDIMS);
+        return(0);
+    }
+
+    /* Check if we need to initialize memory for the QC flags */
+
+    if (qc_var->sample_count < var->sample_count) {
+
+        if (!dsproc_init_var_data(
+            qc_var, qc_var->sample_count,
+            (var->sample_count - qc_var->sample_count), 0)) {
+
+            return(0);
+        }
+    }
+
+    /* Get the valid_min and valid_max attributes */
+
+    found = _dsproc_get_data_att(var, "valid_min", &att);
+    if (found < 0) return(0);
+    if (found) check->min_vp = att->value.vp;
+
+    found = _dsproc_get_data_att(var, "valid_max", &att);
+    if (found < 0) return(0);
+    if (found) check->max_vp = att->value.vp;
+
+    /* Make sure we actually have data in the variable */
+
+    if (var->sample_count == 0) {
+        return(1);
+    }
+
+    /* Get the missing values used by this variable */
+
+    check->nmissings = dsproc_get_var_missing_values(var, &check->missings_vp);
+    if (check->nmissings < 0) {
+        check->nmissings = 0;
+        return(0);
+    }
+
+    if (msngr_debug_level || msngr_provenance_level) {
+
+        char   string_value[128];
+        size_t string_length;
+
+        DEBUG_LV2( DSPROC_LIB_NAME,
+            " - %s\n",
+            var->name);
+
+        if (check->min_vp) {
+            string_length = 128;
+            cds_array_to_string(var->type, 1, check->min_vp, &string_length, string_value);
+            DEBUG_LV2( DSPROC_LIB_NAME, "    - min:     %s\n", string_value);
+        }
+
+        if (check->max_vp) {
+            string_length = 128;
+            cds_array_to_string(var->type, 1, check->max_vp, &string_length, string_value);
+            DEBUG_LV2( DSPROC_LIB_NAME, "    - max:     %s\n", string_value);
+        }
+
+        if (check->missings_vp) {
+            string_length = 128;
+            cds_array_to_string(var->type, check->nmissings, check->missings_vp, &string_length, string_value);
+            DEBUG_LV2( DSPROC_LIB_NAME, "    - missing: %s\n", string_value);
+        }
+    }
+
+    return(1);
+}
+
+/**
+ *  Static: Initialize the standard QC checks for a variable.
+ *
+ *  This function does the setup for the limit checks (see
+ *  _dsproc_init_qc_limit_check()), and gets the valid_delta attribute
+ *  and dimension lengths of the variable used by the delta checks.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  var    - pointer to the variable
+ *  @param  qc_var - pointer to the QC variable
+ *  @param  check  - pointer to the QCVarCheck structure to initialize
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if an error occurred
+ */
+static int _dsproc_init_qc_var_check(
+    CDSVar     *var,
+    CDSVar     *qc_var,
+    QCVarCheck *check)
+{
+    CDSAtt *att;
+    int     found;
+    int     di;
+
+    if (!_dsproc_init_qc_limit_check(
+        var, qc_var, "standard QC checks", check)) {
+
+        return(0);
+    }
+
+    /* The worker threads skip checks for variables without data,
+     * so mark it as done here. */
+
+    if (var->sample_count == 0) {
+        check->status = 1;
+        return(1);
+    }
+
+    /* Get the valid_delta attribute */
+
+    found = _dsproc_get_data_att(var, "valid_delta", &att);
+    if (found < 0) return(0);
+    if (found) {
+        check->ndeltas   = att->length;
+        check->deltas_vp = att->value.vp;
+    }
+
+    /* Create the array of dimension lengths */
+
+    if (var->ndims) {
+
+        check->dim_lengths = (size_t *)malloc(var->ndims * sizeof(size_t));
+
+        if (!check->dim_lengths) {
+
+            ERROR( DSPROC_LIB_NAME,
+                "Could not perform standard QC checks\n"
+                " -> memory allocation error\n");
+
+            dsproc_set_status(DSPROC_ENOMEM);
+            return(0);
+        }
+
+        check->dim_lengths[0] = var->sample_count;
+        for (di = 1; di < var->ndims; di++) {
+            check->dim_lengths[di] = var->dims[di]->length;
+        }
+    }
+
+    check->status = 1;
+
+    return(1);
+}
+
+/**
+ *  Static: Free the memory used by a variable QC check.
+ *
+ *  @param  check - pointer to the QCVarCheck structure
+ */
+static void _dsproc_free_qc_var_check(QCVarCheck *check)
+{
+    if (check->dim_lengths)  free(check->dim_lengths);
+    if (check->missings_vp)  free(check->missings_vp);
+    if (check->free_prev_qc) free(check->prev_qc_flags);
+
+    memset(check, 0, sizeof(QCVarCheck));
+}
+
+/**
+ *  Static: QC worker thread.
+ *
+ *  Pulls variable QC checks off the list until there are none left.
+ *  Only the data and QC flags of the variable being checked are accessed,
+ *  and no messages are generated here.
+ *
+ *  @param  arg - pointer to the QCCheckList
+ *
+ *  @return  NULL
+ */
+static void *_dsproc_qc_check_worker(void *arg)
+{
+    QCCheckList *list = (QCCheckList *)arg;
+    QCVarCheck  *check;
+    int          ci;
+
+    for (;;) {
+
+        pthread_mutex_lock(&list->mutex);
+        ci = list->next++;
+        pthread_mutex_unlock(&list->mutex);
+
+        if (ci >= list->nchecks) break;
+
+        check = &(list->checks[ci]);
+
+        if (!check->var->sample_count) {
+            continue;
+        }
+
+        if (!cds_qc_limit_delta_checks(
+            check->var->type,
+            check->var->ndims,
+            check->dim_lengths,
+            check->var->data.vp,
+            check->nmissings,
+            check->missings_vp,
+            0x1,
+            check->min_vp,
+            0x2,
+            check->max_vp,
+            0x4,
+            check->ndeltas,
+            check->deltas_vp,
+            0x8,
+            check->prev_sample_vp,
+            check->prev_qc_flags,
+            0x1 | 0x2 | 0x4,
+            check->qc_var->data.ip)) {
+
+            check->status = 0;
+        }
+    }
+
+    return((void *)NULL);
+}
+
+/**
+ *  Static: Run the variable QC checks.
+ *
+ *  The checks are run using up to nthreads threads (including the main
+ *  thread). Each variable is only read once, and the QC flags are written
+ *  directly into the QC variable.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  nchecks  - number of variable QC checks
+ *  @param  checks   - array of variable QC checks
+ *  @param  nthreads - maximum number of threads to use
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if an error occurred
+ */
+static int _dsproc_run_qc_var_checks(
+    int         nchecks,
+    QCVarCheck *checks,
+    int         nthreads)
+{
+    QCCheckList  list;
+    pthread_t   *threads  = (pthread_t *)NULL;
+    int          nstarted = 0;
+    int          ci, ti;
+
+    if (nthreads > nchecks) {
+        nthreads = nchecks;
+    }
+
+    list.checks  = checks;
+    list.nchecks = nchecks;
+    list.next    = 0;
+
+    pthread_mutex_init(&list.mutex, NULL);
+
+    if (nthreads > 1) {
+
+        DEBUG_LV1( DSPROC_LIB_NAME,
+            "Applying QC checks to %d variables using %d threads\n",
+            nchecks, nthreads);
+
+        threads = (pthread_t *)calloc(nthreads - 1, sizeof(pthread_t));
+
+        if (threads) {
+            for (ti = 0; ti < nthreads - 1; ti++) {
+                if (pthread_create(&threads[ti], NULL,
+                    _dsproc_qc_check_worker, &list) != 0) {
+                    break;
+                }
+                nstarted++;
+            }
+        }
+    }
+
+    /* The main thread works the list too, so all checks get done even if
+     * none of the threads could be started. */
+
+    _dsproc_qc_check_worker(&list);
+
+    for (ti = 0; ti < nstarted; ti++) {
+        pthread_join(threads[ti], NULL);
+    }
+
+    if (threads) free(threads);
+
+    pthread_mutex_destroy(&list.mutex);
+
+    for (ci = 0; ci < nchecks; ci++) {
+
+        if (!checks[ci].status) {
+
+            ERROR( DSPROC_LIB_NAME,
+                "Could not perform standard QC checks for: %s\n"
+                " -> memory allocation error\n",
+                cds_get_object_path(checks[ci].var));
+
+            dsproc_set_status(DSPROC_ENOMEM);
+            return(0);
+        }
+    }
+
+    return(1);
+}
+
 /*******************************************************************************
  *  Private Functions Visible Only To This Library
  */
@@ -284,6 +784,10 @@ MEMORY_ERROR:
  *    - bit 3 = "Value is greater than the valid_max."
  *    - bit 4 = "Difference between current and previous values exceeds valid_delta."
  *
+ *  The missing, min, max, and delta checks are done in a single pass over
+ *  the data of each variable, and the variables are checked in parallel if
+ *  more than one thread has been set using dsproc_set_qc_threads().
+ *
  *  If an error occurs in this function it will be appended to the log and
  *  error mail messages, and the process status will be set appropriately.
  *
@@ -310,18 +814,18 @@ int dsproc_standard_qc_checks(
     int         prior_sample_flag = 0;
     int         is_base_time;
     size_t      length;
-    int         found;
 
+    int         nchecks      = 0;
+    QCVarCheck *checks       = (QCVarCheck *)NULL;
+    QCVarCheck *check;
     int         dc_nvars     = 0;
-    CDSVar    **dc_vars      = (CDSVar **)NULL;
-    CDSVar    **dc_qc_vars   = (CDSVar **)NULL;
     char      **dc_var_names = (char **)NULL;
     CDSGroup   *dc_dataset   = (CDSGroup *)NULL;
 
     CDSVar     *prev_var;
     CDSVar     *prev_qc_var;
-    int         bad_flags    = 0x1 | 0x2 | 0x4;
-    int         vi;
+    int         retval       = 0;
+    int         ci, vi;
 
     DEBUG_LV1( DSPROC_LIB_NAME,
         "%s: Applying standard QC checks\n",
@@ -373,11 +877,27 @@ int dsproc_standard_qc_checks(
     }
 
     /************************************************************
-    * Loop over all variables, applying the QC limit checks and
+    * Loop over all variables, setting up the QC checks and
     * looking for variables that have delta checks defined.
     *************************************************************/
 
-    dc_nvars = 0;
+    if (!dataset->nvars) {
+        return(1);
+    }
+
+    checks       = (QCVarCheck *)calloc(dataset->nvars, sizeof(QCVarCheck));
+    dc_var_names = (char **)calloc(2 * dataset->nvars, sizeof(char *));
+
+    if (!checks || !dc_var_names) {
+
+        ERROR( DSPROC_LIB_NAME,
+            "Could not create list of variables that require QC checks in dataset: %s\n"
+            " -> memory allocation error\n",
+            dataset->name);
+
+        dsproc_set_status(DSPROC_ENOMEM);
+        goto RETURN;
+    }
 
     for (vi = 0; vi < dataset->nvars; ++vi) {
 
@@ -401,118 +921,95 @@ int dsproc_standard_qc_checks(
             continue;
         }
 
-        /* Do the QC limit checks */
-
-        if (!dsproc_qc_limit_checks(var, qc_var, 0x1, 0x2, 0x4)) {
-            return(0);
-        }
-
-        /* Check for a valid delta attribute */
+        /* Set up the QC checks for this variable */
 
-        found = _dsproc_get_data_att(var, "valid_delta", &att);
+        check = &(checks[nchecks++]);
 
-        if (found < 0) {
-            return(0);
+        if (!_dsproc_init_qc_var_check(var, qc_var, check)) {
+            goto RETURN;
         }
 
-        if (found) {
-
-            /* Check if we need to allocate memory for the delta check lists */
-
-            if (dc_nvars == 0) {
-
-                dc_vars      = (CDSVar **)calloc(dataset->nvars, sizeof(CDSVar *));
-                dc_qc_vars   = (CDSVar **)calloc(dataset->nvars, sizeof(CDSVar *));
-                dc_var_names = (char **)calloc(dataset->nvars, sizeof(char *));
-
-                if (!dc_vars || !dc_var_names) {
-
-                    ERROR( DSPROC_LIB_NAME,
-                        "Could not create list of variables that require delta checks in dataset: %s\n"
-                        " -> memory allocation error\n",
-                        dataset->name);
-
-                    if (dc_vars)      free(dc_vars);
-                    if (dc_var_names) free(dc_var_names);
-
-                    dsproc_set_status(DSPROC_ENOMEM);
-                    return(0);
-                }
-            }
-
-            dc_vars[dc_nvars]          = var;
-            dc_qc_vars[dc_nvars]       = qc_var;
+        if (check->ndeltas && check->deltas_vp) {
             dc_var_names[2*dc_nvars]   = var->name;
             dc_var_names[2*dc_nvars+1] = qc_var->name;
-
             dc_nvars += 1;
         }
     }
 
     /************************************************************
-    * Check if any delta checks were found
+    * Get the previously stored values for all variables that
+    * have a delta check if the first sample needs to be checked.
     *************************************************************/
 
-    if (dc_nvars) {
+    if (dc_nvars && prior_sample_flag) {
 
-        if (prior_sample_flag) {
+        if (!dsfile) {
 
-            /* Get the previously stored values for all
-             * variables that have a delta check */
+            if (!_dsproc_get_prev_dsfile_time_index(
+                ds, dataset, &dsfile, &index)) {
 
-            if (!dsfile) {
-
-                if (!_dsproc_get_prev_dsfile_time_index(
-                    ds, dataset, &dsfile, &index)) {
-
-                    return(0);
-                }
+                goto RETURN;
             }
+        }
 
-            if (dsfile && index >= 0) {
-                dc_dataset = _dsproc_fetch_dsfile_dataset(
-                    dsfile, (size_t)index, 1,
-                    2 * dc_nvars, (const char **)dc_var_names, NULL);
-            }
+        if (dsfile && index >= 0) {
+            dc_dataset = _dsproc_fetch_dsfile_dataset(
+                dsfile, (size_t)index, 1,
+                2 * dc_nvars, (const char **)dc_var_names, NULL);
         }
 
-        /* Loop over all variables that need delta checks */
+        if (dc_dataset) {
 
-        for (vi = 0; vi < dc_nvars; ++vi) {
+            for (ci = 0; ci < nchecks; ++ci) {
 
-            var    = dc_vars[vi];
-            qc_var = dc_qc_vars[vi];
+                check = &(checks[ci]);
+
+                if (!check->ndeltas || !check->deltas_vp) {
+                    continue;
+                }
 
-            if (dc_dataset) {
-                prev_var    = dsproc_get_var(dc_dataset, var->name);
+                prev_var    = dsproc_get_var(dc_dataset, check->var->name);
                 prev_qc_var = (prev_var) ? dsproc_get_qc_var(prev_var) : NULL;
-            }
-            else {
-                prev_var    = (CDSVar *)NULL;
-                prev_qc_var = (CDSVar *)NULL;
-            }
 
-            if (!dsproc_qc_delta_checks(
-                var,
-                qc_var,
-                prev_var,
-                prev_qc_var,
-                0x8,
-                bad_flags)) {
+                if (!_dsproc_get_prev_qc_sample(
+                    check->var, prev_var, prev_qc_var,
+                    &check->prev_sample_vp,
+                    &check->prev_qc_flags,
+                    &check->free_prev_qc)) {
 
-                return(0);
+                    goto RETURN;
+                }
             }
         }
+    }
+
+    /************************************************************
+    * Apply the QC limit and delta checks
+    *************************************************************/
 
-        /* Free up the memory allocated for the delta checks */
+    if (nchecks) {
+        if (!_dsproc_run_qc_var_checks(
+            nchecks, checks, dsproc_get_qc_threads())) {
 
-        if (dc_vars)      free(dc_vars);
-        if (dc_qc_vars)   free(dc_qc_vars);
-        if (dc_var_names) free(dc_var_names);
-        if (dc_dataset)   cds_delete_group(dc_dataset);
+            goto RETURN;
+        }
     }
 
-    return(1);
+    retval = 1;
+
+RETURN:
+
+    if (checks) {
+        for (ci = 0; ci < nchecks; ++ci) {
+            _dsproc_free_qc_var_check(&(checks[ci]));
+        }
+        free(checks);
+    }
+
+    if (dc_var_names) free(dc_var_names);
+    if (dc_dataset)   cds_delete_group(dc_dataset);
+
+    return(retval);
 }
 
 /**
@@ -560,7 +1057,6 @@ int dsproc_qc_delta_checks(
     void   *prev_sample_vp;
     int    *prev_qc_flags;
     int     free_prev_qc = 0;
-    size_t  sample_start;
     int     retval;
     int     di;
 
@@ -679,43 +1175,13 @@ int dsproc_qc_delta_checks(
 
     /* Check if a previous variable was specified */
 
-    prev_sample_vp = (void *)NULL;
-    prev_qc_flags  = (void *)NULL;
-    free_prev_qc   = 0;
-
-    if (prev_var &&
-        dsproc_var_sample_size(prev_var) == sample_size) {
-
-        sample_start = (prev_var->sample_count - 1) * sample_size;
-
-        if (prev_qc_var &&
-            prev_qc_var->type == CDS_INT &&
-            prev_qc_var->sample_count >= prev_var->sample_count &&
-            dsproc_var_sample_size(prev_qc_var) == sample_size) {
-
-            prev_qc_flags = &(prev_qc_var->data.ip[sample_start]);
-        }
-        else {
-
-            prev_qc_flags = (int *)calloc(sample_size, sizeof(int));
+    if (!_dsproc_get_prev_qc_sample(
+        var, prev_var, prev_qc_var,
+        &prev_sample_vp, &prev_qc_flags, &free_prev_qc)) {
 
-            if (prev_qc_flags) {
-
-                ERROR( DSPROC_LIB_NAME,
-                    "Could not perform standard QC delta checks\n"
-                    " -> memory allocation error\n");
-
-                dsproc_set_status(DSPROC_ENOMEM);
-                free(delta_flags);
-                if (dim_lengths) free(dim_lengths);
-                return(0);
-            }
-
-            free_prev_qc = 1;
-        }
-
-        sample_start  *= cds_data_type_size(prev_var->type);
-        prev_sample_vp = (void *)(prev_var->data.bp + sample_start);
+        free(delta_flags);
+        if (dim_lengths) free(dim_lengths);
+        return(0);
     }
 
     /* Do the QC checks */
@@ -780,109 +1246,29 @@ int dsproc_qc_limit_checks(
     int     min_flag,
     int     max_flag)
 {
-    size_t  sample_size;
-    size_t  nvalues;
-    int     nmissings;
-    void   *missings_vp;
-    int    *missing_flags;
-    CDSAtt *att;
-    void   *min_vp;
-    void   *max_vp;
-    int     found;
-    int     mi;
+    QCVarCheck check;
+    size_t     nvalues;
+    int       *missing_flags;
+    int        mi;
 
-    /* Make sure the QC variable has integer data type */
-
-    if (qc_var->type != CDS_INT) {
-
-        ERROR( DSPROC_LIB_NAME,
-            "Could not perform QC limit checks\n"
-            " -> invalid data type for QC variable: %s\n",
-            cds_get_object_path(qc_var));
-
-        dsproc_set_status(DSPROC_EQCVARTYPE);
-        return(0);
-    }
-
-    /* Make sure the sample sizes match */
-
-    sample_size = dsproc_var_sample_size(var);
-    if (!sample_size) {
-
-        ERROR( DSPROC_LIB_NAME,
-            "Could not perform QC limit checks\n"
-            " -> found zero length dimension for variable: %s\n",
-            cds_get_object_path(var));
-
-        dsproc_set_status(DSPROC_ESAMPLESIZE);
-        return(0);
-    }
-
-    if (dsproc_var_sample_size(qc_var) != sample_size) {
-
-        ERROR( DSPROC_LIB_NAME,
-            "Could not perform QC limit checks\n"
-            " -> QC variable dimensions do not match variable dimensions:\n"
-            " -> variable    %s has sample size: %d\n"
-            " -> qc variable %s has sample size: %d\n",
-            cds_get_object_path(var), sample_size,
-            cds_get_object_path(qc_var), dsproc_var_sample_size(qc_var));
-
-        dsproc_set_status(DSPROC_EQCVARDIMS);
+    if (!_dsproc_init_qc_limit_check(var, qc_var, "QC limit checks", &check)) {
+        _dsproc_free_qc_var_check(&check);
         return(0);
     }
 
-    /* Check if we need to initialize memory for the QC flags */
-
-    if (qc_var->sample_count < var->sample_count) {
-
-        if (!dsproc_init_var_data(
-            qc_var, qc_var->sample_count,
-            (var->sample_count - qc_var->sample_count), 0)) {
-
-            return(0);
-        }
-    }
-
-    /* Check for a valid_min attribute */
-
-    found = _dsproc_get_data_att(var, "valid_min", &att);
-
-    if (found < 0) {
-        return(0);
-    }
-
-    min_vp = (found) ? att->value.vp : (void *)NULL;
-
-    /* Check for a valid_max attribute */
-
-    found = _dsproc_get_data_att(var, "valid_max", &att);
-
-    if (found < 0) {
-        return(0);
-    }
-
-    max_vp = (found) ? att->value.vp : (void *)NULL;
-
     /* Make sure we actually have data in the variable */
 
     if (var->sample_count == 0) {
         return(1);
     }
 
-    /* Get the missing values used by this variable */
-
-    missings_vp = (void *)NULL;
-    nmissings   = dsproc_get_var_missing_values(var, &missings_vp);
+    /* Create the array of QC flags for the missing values */
 
-    if (nmissings < 0) {
-        return(0);
-    }
-    else if (nmissings == 0) {
+    if (check.nmissings == 0) {
         missing_flags = (int *)NULL;
     }
     else {
-        missing_flags = (int *)malloc(nmissings * sizeof(int));
+        missing_flags = (int *)malloc(check.nmissings * sizeof(int));
 
         if (!missing_flags) {
 
@@ -891,62 +1277,36 @@ int dsproc_qc_limit_checks(
                 " -> memory allocation error\n");
 
             dsproc_set_status(DSPROC_ENOMEM);
+            _dsproc_free_qc_var_check(&check);
             return(0);
         }
 
-        for (mi = 0; mi < nmissings; mi++) {
+        for (mi = 0; mi < check.nmissings; mi++) {
             missing_flags[mi] = missing_flag;
         }
     }
 
-    if (msngr_debug_level || msngr_provenance_level) {
-
-        char   string_value[128];
-        size_t string_length;
-
-        DEBUG_LV2( DSPROC_LIB_NAME,
-            " - %s\n",
-            var->name);
-
-        if (min_vp) {
-            string_length = 128;
-            cds_array_to_string(var->type, 1, min_vp, &string_length, string_value);
-            DEBUG_LV2( DSPROC_LIB_NAME, "    - min:     %s\n", string_value);
-        }
-
-        if (max_vp) {
-            string_length = 128;
-            cds_array_to_string(var->type, 1, max_vp, &string_length, string_value);
-            DEBUG_LV2( DSPROC_LIB_NAME, "    - max:     %s\n", string_value);
-        }
-
-        if (missings_vp) {
-            string_length = 128;
-            cds_array_to_string(var->type, nmissings, missings_vp, &string_length, string_value);
-            DEBUG_LV2( DSPROC_LIB_NAME, "    - missing: %s\n", string_value);
-        }
-    }
-
     /* Do the QC checks */
 
-    nvalues = var->sample_count * sample_size;
+    nvalues = var->sample_count * dsproc_var_sample_size(var);
 
     cds_qc_limit_checks(
             var->type,
             nvalues,
             var->data.vp,
-            nmissings,
-            missings_vp,
+            check.nmissings,
+            check.missings_vp,
             missing_flags,
-            min_vp,
+            check.min_vp,
             min_flag,
-            max_vp,
+            check.max_vp,
             max_flag,
             qc_var->data.ip);
 
-    if (missings_vp)   free(missings_vp);
     if (missing_flags) free(missing_flags);
 
+    _dsproc_free_qc_var_check(&check);
+
     return(1);
 }
 
@@ -1101,3 +1461,62 @@ int dsproc_qc_time_checks(
 
     return(1);
 }
+
+/**
+ *  Get the number of threads used by the standard QC checks.
+ *
+ *  If the number of threads has not been set using dsproc_set_qc_threads(),
+ *  the DSPROC_QC_THREADS environment variable will be checked.
+ *
+ *  @return  number of QC threads (1 = serial)
+ *
+ *  @see dsproc_set_qc_threads()
+ */
+int dsproc_get_qc_threads(void)
+{
+    const char *env;
+
+    if (_QCThreads < 0) {
+
+        env = getenv("DSPROC_QC_THREADS");
+
+        if (env && *env) {
+            dsproc_set_qc_threads(atoi(env));
+        }
+        else {
+            _QCThreads = 1;
+        }
+    }
+
+    return(_QCThreads);
+}
+
+/**
+ *  Set the number of threads used by the standard QC checks.
+ *
+ *  The QC checks for each variable only depend on the variable's own data
+ *  and QC flags, so when more than one thread is used the variables are set
+ *  up in the main thread and the QC checks are applied in parallel.
+ *
+ *  @param  nthreads - number of threads to use, 1 for serial mode,
+ *                     or 0 to use the number of online processors
+ *
+ *  @see dsproc_get_qc_threads()
+ */
+void dsproc_set_qc_threads(int nthreads)
+{
+    long nprocs;
+
+    if (nthreads == 0) {
+        nprocs   = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (nprocs > 0) ? (int)nprocs : 1;
+    }
+    else if (nthreads < 0) {
+        nthreads = 1;
+    }
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "Setting number of QC threads to: %d\n", nthreads);
+
+    _QCThreads = nthreads;
+}
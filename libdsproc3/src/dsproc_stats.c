@@ -34,10 +34,240 @@
  *  Private Functions
  */
 
+/***************************************************************************************
+ *  Add the values at good sample indexes [lo, hi) to a rolling statistics window.
+ ****************************************************************************************/
+static void _dsproc_rolling_add_range(RollingStats *stats, const double *data,
+                                      const size_t *good, size_t lo, size_t hi)
+{
+  for(; lo < hi; lo++) dsproc_rolling_stats_add(stats, data[good[lo]]);
+}
+
+/***************************************************************************************
+ *  Remove the values at good sample indexes [lo, hi) from a rolling statistics window.
+ ****************************************************************************************/
+static void _dsproc_rolling_remove_range(RollingStats *stats, const double *data,
+                                         const size_t *good, size_t lo, size_t hi)
+{
+  for(; lo < hi; lo++) dsproc_rolling_stats_remove(stats, data[good[lo]]);
+}
+
 /*******************************************************************************
  *  Internal Functions Visible To The Public
  */
 
+/***************************************************************************************
+ *  Initialize a rolling statistics window.
+ *
+ *  The window keeps a running sum and sum of squares of the values added to it,
+ *  so values can be added and removed in constant time as the window slides along
+ *  a variable. The values are shifted by the first value added to an empty window
+ *  to avoid the loss of precision of the textbook sum of squares formula.
+ *
+ *  @param  input:stats - pointer to the RollingStats structure
+ ****************************************************************************************/
+void dsproc_rolling_stats_init(RollingStats *stats)
+{
+  stats->shift = 0;
+  stats->sum   = 0;
+  stats->sumsq = 0;
+  stats->count = 0;
+}
+
+/***************************************************************************************
+ *  Add a value to a rolling statistics window.
+ *
+ *  @param  input:stats - pointer to the RollingStats structure
+ *  @param  input:value - value to add
+ ****************************************************************************************/
+void dsproc_rolling_stats_add(RollingStats *stats, double value)
+{
+  double shifted;
+
+  if(stats->count == 0) {
+    stats->shift = value;
+    stats->sum   = 0;
+    stats->sumsq = 0;
+  }
+
+  shifted = value - stats->shift;
+
+  stats->sum   += shifted;
+  stats->sumsq += shifted * shifted;
+  stats->count ++;
+}
+
+/***************************************************************************************
+ *  Remove a value that was previously added to a rolling statistics window.
+ *
+ *  @param  input:stats - pointer to the RollingStats structure
+ *  @param  input:value - value to remove
+ ****************************************************************************************/
+void dsproc_rolling_stats_remove(RollingStats *stats, double value)
+{
+  double shifted;
+
+  if(stats->count <= 1) {
+    dsproc_rolling_stats_init(stats);
+    return;
+  }
+
+  shifted = value - stats->shift;
+
+  stats->sum   -= shifted;
+  stats->sumsq -= shifted * shifted;
+  stats->count --;
+}
+
+/***************************************************************************************
+ *  Get the mean and sample standard deviation of the values in a rolling
+ *  statistics window.
+ *
+ *  @param  input:stats - pointer to the RollingStats structure
+ *  @param  output:mean - the mean of the values in the window, or NULL
+ *  @param  output:stdev - the standard deviation of the values in the window,
+ *                   0 if the window only contains one value, or NULL
+ *
+ *  @return
+ *    The number of values in the window, the mean and stdev are not set if
+ *    the window is empty.
+ ****************************************************************************************/
+size_t dsproc_rolling_stats_get(RollingStats *stats, double *mean, double *stdev)
+{
+  double n = (double)stats->count;
+  double var;
+
+  if(stats->count == 0) return(0);
+
+  if(mean) *mean = stats->shift + stats->sum / n;
+
+  if(stdev) {
+    if(stats->count == 1) {
+      *stdev = 0;
+    }
+    else {
+      /* differences smaller than the rounding error accumulated by */
+      /* adding and removing values are treated as no variance */
+      var = (stats->sumsq - stats->sum * stats->sum / n) / (n - 1);
+      *stdev = (var > stats->sumsq * 1e-12 / (n - 1)) ? sqrt(var) : 0;
+    }
+  }
+
+  return(stats->count);
+}
+
+/***************************************************************************************
+ *  This function calculates the mean and standard deviation of a window of good
+ *  values around every sample of a variable in linear time.
+ *
+ *  The window around each sample is either (1) all good samples within window
+ *  seconds of the sample (ROLLING_WINDOW_SECONDS), or (2) window good samples
+ *  before and window good samples after the sample (ROLLING_WINDOW_SAMPLES).
+ *  The current sample is included in its own window if it is good and
+ *  exclude_current is 0.
+ *
+ *  @param  input:nsamples - number of samples in data array
+ *  @param  input:data - an array of values for which to calculate mean and stdev
+ *  @param  input:missing_value - missing value for variable
+ *  @param  input:times - sample times in seconds, only used for time windows
+ *  @param  input:window - number of seconds or good samples before and after each sample
+ *  @param  input:window_type - ROLLING_WINDOW_SECONDS or ROLLING_WINDOW_SAMPLES
+ *  @param  input:exclude_current - flag to indicate whether or not to exclude the current
+ *                   sample from its window, = 1 to exclude, = 0 to include.
+ *  @param  output:mean - the mean for each sample, missing_value if the window is empty,
+ *                   or NULL
+ *  @param  output:stdev - the stdev for each sample, missing_value if the window is empty,
+ *                   or NULL
+ *  @param  output:counts - number of good values in each window, or NULL
+ *
+ *  @return
+ *    -  1 if successful
+ *    -  0 if a memory allocation error occurred
+ ****************************************************************************************/
+int dsproc_rolling_mean_stdev(size_t nsamples, const double *data, double missing_value,
+          const double *times, double window, int window_type, int exclude_current,
+          double *mean, double *stdev, size_t *counts)
+{
+  RollingStats  stats, current;
+  size_t       *good, ngood;
+  size_t        samp, pos, lo, hi, new_lo, new_hi, half;
+  int           is_good;
+
+  /* Get the indexes of the good samples */
+  good = (size_t *)malloc((nsamples ? nsamples : 1) * sizeof(size_t));
+  if(!good) {
+    ERROR(DSPROC_LIB_NAME, "Could not calculate rolling statistics\n -> memory allocation error\n");
+    dsproc_set_status(DSPROC_ENOMEM);
+    return(0);
+  }
+
+  ngood = 0;
+  for(samp = 0; samp < nsamples; samp++) {
+    if(data[samp] != missing_value) good[ngood++] = samp;
+  }
+
+  half = (window > 0) ? (size_t)window : 0;
+
+  /* The window is always the good samples good[lo] to good[hi - 1], */
+  /* and both ends only move forward, so every good sample is added */
+  /* and removed once. */
+  dsproc_rolling_stats_init(&stats);
+  lo  = 0;
+  hi  = 0;
+  pos = 0;
+
+  for(samp = 0; samp < nsamples; samp++) {
+
+    /* pos is the number of good samples before this sample */
+    is_good = (pos < ngood && good[pos] == samp);
+
+    if(window_type == ROLLING_WINDOW_SECONDS) {
+      new_lo = lo;
+      while(new_lo < ngood && times[good[new_lo]] < times[samp] - window) new_lo++;
+      new_hi = (hi > new_lo) ? hi : new_lo;
+      while(new_hi < ngood && times[good[new_hi]] <= times[samp] + window) new_hi++;
+    }
+    else {
+      new_lo = (pos > half) ? pos - half : 0;
+      new_hi = pos + is_good + half;
+      if(new_hi > ngood) new_hi = ngood;
+    }
+
+    /* Slide the window */
+    if(new_lo >= hi) {
+      dsproc_rolling_stats_init(&stats);
+      _dsproc_rolling_add_range(&stats, data, good, new_lo, new_hi);
+    }
+    else {
+      _dsproc_rolling_add_range(&stats, data, good, hi, new_hi);
+      _dsproc_rolling_remove_range(&stats, data, good, lo, new_lo);
+    }
+    lo = new_lo;
+    hi = new_hi;
+
+    current = stats;
+    if(exclude_current && is_good && lo <= pos && pos < hi) {
+      dsproc_rolling_stats_remove(&current, data[samp]);
+    }
+
+    if(counts) counts[samp] = current.count;
+
+    if(current.count == 0) {
+      if(mean)  mean[samp]  = missing_value;
+      if(stdev) stdev[samp] = missing_value;
+    }
+    else {
+      dsproc_rolling_stats_get(&current, (mean) ? &mean[samp] : NULL, (stdev) ? &stdev[samp] : NULL);
+    }
+
+    if(is_good) pos++;
+  }
+
+  free(good);
+
+  return(1);
+}
+
 
 /***************************************************************************************
  *  This function calculates the mean and standard deviation 
@@ -241,22 +471,26 @@ int get_mean_and_stdev(double *data, int nsamples, double missing_value, time_t
 int stat_time_variability_check(CDSVar *var, CDSVar *qc_var, int half_window, 
                            int time_variability_min, int qc_time_variability_bit)
 {  
-  int iter, samp, nsamples; 
-  size_t att_length;
-  int *qc_data, nsamples_stats;
-  double *data, *tmp_missing, missing_value, stdev_all, mean_all, stdev, mean; 
+  int iter, nsamples, retval; 
+  size_t att_length, k, ngood, nwin, nkept, head, fifo_size, samp;
+  int *qc_data, flag;
+  double *data, *tmp_missing, missing_value, value, stdev_all, stdev; 
+  double *fifo;
+  size_t *good;
   CDSVar *time_var;
   CDSAtt *missing_att;
-  time_t *time;
-
-
-/* KLG Check all return values and insert error handling */
+  RollingStats win, all;
 
   qc_data = NULL;
+  fifo    = NULL;
+  good    = NULL;
+
   /* Get the time var */
   time_var = dsproc_get_time_var((void *)var);
-  time = cds_copy_array(time_var->type, time_var->sample_count, time_var->data.vp, CDS_DOUBLE, NULL,
-                        0, NULL, NULL, NULL, NULL, NULL,NULL); 
+  if(!time_var) {
+    ERROR(DSPROC_LIB_NAME, "Could not get time variable for variable %s\n", var->name);
+    return(0);
+  }
 
   /* Copy the variable's data to an array of doubles */
   /* use the time var length to ensure proper value independent of number of dimensions*/
@@ -268,6 +502,17 @@ int stat_time_variability_check(CDSVar *var, CDSVar *qc_var, int half_window,
   if(qc_var) qc_data = cds_copy_array(qc_var->type, nsamples, qc_var->data.vp, CDS_INT, NULL,  
                         0, NULL, NULL, NULL, NULL, NULL,NULL); 
 
+  fifo_size = (half_window > 0) ? (size_t)half_window : 0;
+  fifo = (double *)malloc((fifo_size + 1) * sizeof(double));
+  good = (size_t *)malloc((nsamples + 1) * sizeof(size_t));
+
+  if(!data || (qc_var && !qc_data) || !fifo || !good) {
+    ERROR(DSPROC_LIB_NAME, "Could not apply time variability check to var %s\n -> memory allocation error\n", var->name);
+    dsproc_set_status(DSPROC_ENOMEM);
+    retval = 0;
+    goto CLEANUP;
+  }
+
   /* get the missing value of the variable as type double*/
   missing_att = cds_get_att(var, "missing_value");
 
@@ -278,56 +523,97 @@ int stat_time_variability_check(CDSVar *var, CDSVar *qc_var, int half_window,
     free(tmp_missing);
   }
 
+  /* The window around each good sample is half_window good samples before */
+  /* and after it. Samples flagged earlier in the same iteration are already */
+  /* missing, so the samples before the current one are kept in a fifo of the */
+  /* last half_window samples that passed, and the samples after it are the */
+  /* next half_window good samples. Both sides share one rolling window that */
+  /* is updated as the current sample moves, so each iteration is O(n). */
   for(iter = 0; iter < 3; iter++) {
 
-     /* Loop over samples */
-     for(samp = 0; samp < nsamples; samp++) {
+     ngood = 0;
+     for(samp = 0; samp < (size_t)nsamples; samp++) {
+       if(data[samp] != missing_value) good[ngood++] = samp;
+     }
 
-       /* Only test good samples */
-       if(data[samp] != missing_value) {
-         /* find mean and stdev for this sample, including this sample */
-         /* for this function the window is in number of good samples */   
-         nsamples_stats = get_mean_and_stdev(data, nsamples, missing_value, time, 
-                   samp, half_window,0, 1, 3, &mean_all, &stdev_all);
+     dsproc_rolling_stats_init(&win);
+     nkept = 0;
+     head  = 0;
 
-         /* find mean and stdev for this sample, including this sample */
-         if(nsamples_stats > 3) { 
-           nsamples_stats = get_mean_and_stdev(data, nsamples, missing_value, time, 
-                    samp, half_window,0, 0, 3, &mean, &stdev);
-         }
+     for(k = 1; k <= fifo_size && k < ngood; k++) {
+       dsproc_rolling_stats_add(&win, data[good[k]]);
+     }
 
-  /* KLG make sure this works for cases when stdev is returned as zero */
-         if(nsamples_stats >= 2 * (half_window)) {
-            /* If absolute value of stdev of all samples minus stdev excluding current sample */
-            /* is greater than or equal to the minimum time variability allowed for this variable */
-            /* then set value of the data to  missing and update its qc flag*/
-            if(stdev_all != missing_value && stdev != missing_value && (fabs(stdev_all - stdev) >= time_variability_min) ) {
-                data[samp] = missing_value;
-                if(qc_var)qc_data[samp] = qc_data[samp] | qc_time_variability_bit;
-            }
+     /* Loop over good samples */
+     for(k = 0; k < ngood; k++) {
+
+       samp  = good[k];
+       value = data[samp];
+       flag  = 0;
+
+       /* find stdev for this sample, including this sample */
+       all = win;
+       dsproc_rolling_stats_add(&all, value);
+
+       /* then excluding this sample, both need more than 3 samples */
+       nwin = win.count;
+       if(all.count > 3 && nwin > 3 && nwin >= 2 * fifo_size) {
+
+          dsproc_rolling_stats_get(&all, NULL, &stdev_all);
+          dsproc_rolling_stats_get(&win, NULL, &stdev);
+
+          /* If absolute value of stdev of all samples minus stdev excluding current sample */
+          /* is greater than or equal to the minimum time variability allowed for this variable */
+          /* then set value of the data to  missing and update its qc flag*/
+          if(fabs(stdev_all - stdev) >= time_variability_min) {
+             data[samp] = missing_value;
+             if(qc_var)qc_data[samp] = qc_data[samp] | qc_time_variability_bit;
+             flag = 1;
+          }
+       }
+
+       /* Move the current sample into the fifo of samples before the next one */
+       if(!flag && fifo_size > 0) {
+         if(nkept == fifo_size) {
+           dsproc_rolling_stats_remove(&win, fifo[head]);
+         }
+         else {
+           nkept++;
          }
-      } /* end sample not missing */
+         fifo[head] = value;
+         head = (head + 1) % fifo_size;
+         dsproc_rolling_stats_add(&win, value);
+       }
 
+       /* The next sample is no longer in the window after it */
+       if(k + 1 < ngood && fifo_size > 0) {
+         dsproc_rolling_stats_remove(&win, data[good[k + 1]]);
+       }
+       if(k + 1 + fifo_size < ngood && fifo_size > 0) {
+         dsproc_rolling_stats_add(&win, data[good[k + 1 + fifo_size]]);
+       }
      }
   } /* end 3 iteration loop */
 
   /* Load the updated data to var and qc_var */
-/* KLG make sure data and qc_data are not null bvefore calling cds_put_var_data */
-/* KLG also update to use set_var_data instead of put_var_data */
+  retval = 1;
+
   if(cds_put_var_data(var, 0, nsamples, CDS_DOUBLE, data) == NULL) { 
          ERROR(DSPROC_LIB_NAME, "Problem updating var %s with time variability results\n", var->name);
-         return(0);
+         retval = 0;
   }
-  if(cds_put_var_data(qc_var, 0, nsamples, CDS_INT, qc_data) == NULL) {
+  else if(qc_var && cds_put_var_data(qc_var, 0, nsamples, CDS_INT, qc_data) == NULL) {
          ERROR(DSPROC_LIB_NAME, "Problem updating qc_var %s with time variability results\n", qc_var->name);
-         return(0);
+         retval = 0;
   }
 
-  free(time);
-  free(data);
-  free(qc_data);
+CLEANUP:
+  if(data)    free(data);
+  if(qc_data) free(qc_data);
+  if(fifo)    free(fifo);
+  if(good)    free(good);
 
-  return(1);
+  return(retval);
 }
 
 /***************************************************************************************
@@ -351,19 +637,22 @@ int stat_time_variability_check(CDSVar *var, CDSVar *qc_var, int half_window,
  ****************************************************************************************/
 int stat_outlier_check(CDSVar *var, CDSVar *qc_var, int min_samples, int qc_outlier_bit, int n_stdev_outlier)
 {  
-  int  samp, nsamples, *qc_data, count=0, status;
+  int  samp, nsamples, *qc_data, count=0;
   size_t att_length;
-  double *data, missing_value, *tmp_missing, diff, stdev=0, mean=0, sum=0; 
+  double *data, missing_value, *tmp_missing, stdev=0, mean=0; 
   CDSVar *time_var;
   CDSAtt *missing_att;
   double var_missing;
   int qc_missing;
+  RollingStats stats;
+
+  qc_data = NULL;
 
   /* Get the time var */
   time_var = dsproc_get_time_var((void *)var);
   if(!time_var) {
      WARNING( DSPROC_LIB_NAME,
-            "Could not get time variable for varaible %s= %d\n", var->name);
+            "Could not get time variable for variable %s\n", var->name);
     return(-1);
   }
 
@@ -371,38 +660,24 @@ int stat_outlier_check(CDSVar *var, CDSVar *qc_var, int min_samples, int qc_outl
   nsamples = time_var->sample_count;
 
   /* Copy the variable's data and qc_data to an array of doubles and int respectively */
-/*  status = cds_get_var_missing_values(var, (void *)&missing); */
   data = cds_get_var_data(var, CDS_DOUBLE, 0, NULL, &var_missing, NULL);
   if(!data) {
      WARNING( DSPROC_LIB_NAME,
-            "Could not data for varaible %s= %d\n", var->name);
+            "Could not get data for variable %s\n", var->name);
     return(-1);
   }
 
-/*  status = cds_get_var_missing_values(var, (void *)&missing); */
   if(qc_var) {
      qc_data = cds_get_var_data(qc_var, CDS_INT, 0, NULL, &qc_missing, NULL);
     if(!qc_data) {
        WARNING( DSPROC_LIB_NAME,
-            "Could not qc data for varaible %s= %d\n", var->name);
+            "Could not get qc data for variable %s\n", var->name);
+      free(data);
       return(-1);
      }
   }
 
   /* get the missing value of the variable as type double*/
-/* KLG not working 
-  if(var) {
-    status = cds_get_var_missing_values(var,(void *)&tmp_missing); 
-    if(status < 0) {
-       WARNING( DSPROC_LIB_NAME,
-           "Error in getting missing value for variable %s= %d\n", var->name);
-       return(-1);
-    }
-    else if(status == 0) missing_value = -9999;
-    else missing_value = (double) *tmp_missing;
-  }
-*/
-
   missing_att = cds_get_att(var, "missing_value");
 
   if(!missing_att) missing_value = -9999.0;
@@ -412,45 +687,20 @@ int stat_outlier_check(CDSVar *var, CDSVar *qc_var, int min_samples, int qc_outl
     free(tmp_missing);
   }
 
-  /* Find mean */
-  count = 0;
+  /* Find mean and stdev of the good samples in a single pass */
+  dsproc_rolling_stats_init(&stats);
   for(samp = 0; samp < nsamples; samp++) {
-
-    /* Only use good samples */
-    if(data[samp] != missing_value) {
-      sum = sum + data[samp];
-      count ++;
-    }
+    if(data[samp] != missing_value) dsproc_rolling_stats_add(&stats, data[samp]);
   }
 
-  if(count <=  min_samples) {
-    mean = missing_value;
-    stdev = missing_value;
+  if((int)stats.count <=  min_samples) {
+    free(data);
+    if(qc_data) free(qc_data);
     return(0);
   }
-  else if(count == 1) {
-    mean = sum;
-    stdev = 0;
-  }
-  else {
-    mean = sum/count;
-
-    /* Loop over samples finding the standard deviation*/
-    diff = 0;
-    count = 0;
-    sum = 0;
-    for(samp = 0; samp < nsamples; samp++) {
-
-       /* Only test good samples */
-       if(data[samp] != missing_value) {
-          diff = fabs(data[samp] - mean);
-          sum += diff * diff;
-          count ++;
-        }
-    }
-    stdev = sqrt(sum/((double)count-1.));
 
-  } /* end else count > 1 */
+  dsproc_rolling_stats_get(&stats, &mean, &stdev);
+
   /* Loop over the samples again and test whether the actual minus mean is */
   /* greather than 'x' times the standard deviation. If it is replace the value*/  
   /* with missing and set the appropriate qc bit */
@@ -458,10 +708,10 @@ int stat_outlier_check(CDSVar *var, CDSVar *qc_var, int min_samples, int qc_outl
   for(samp = 0; samp < nsamples; samp++) {
      if(data[samp] != missing_value) {
         if( fabs(data[samp] - mean) > n_stdev_outlier*stdev) {
-/* KLG debug */
-printf("var %s fails outlier test %f, on sample %d\n", var->name, data[samp], samp);
+           DEBUG_LV2(DSPROC_LIB_NAME,
+               "var %s fails outlier test %f, on sample %d\n", var->name, data[samp], samp);
            data[samp] = missing_value; 
-           qc_data[samp] = qc_data[samp] | qc_outlier_bit;
+           if(qc_data) qc_data[samp] = qc_data[samp] | qc_outlier_bit;
            count ++;
  
         }
@@ -469,22 +719,24 @@ printf("var %s fails outlier test %f, on sample %d\n", var->name, data[samp], sa
   } /* end samp < nsamples */
 
   /* Load the updated data to var and qc_var */
-/*KLG update  make sure not null before calling put_var_data also update to use set_var_data */
   if(count > 0) { 
     if(cds_put_var_data(var, 0, nsamples, CDS_DOUBLE, data) == NULL) { 
          ERROR(DSPROC_LIB_NAME, "Problem updating var %s with outlier test results\n", var->name);
+         free(data);
+         if(qc_data) free(qc_data);
          return(-1);
     }
-    if(cds_put_var_data(qc_var, 0, nsamples, CDS_INT, qc_data) == NULL) {
+    if(qc_var && cds_put_var_data(qc_var, 0, nsamples, CDS_INT, qc_data) == NULL) {
          ERROR(DSPROC_LIB_NAME, "Problem updating qc_var %s with outlier test results\n", qc_var->name);
+         free(data);
+         free(qc_data);
          return(-1);
     }
   }
 
   free(data);
-  free(qc_data);
+  if(qc_data) free(qc_data);
 
   return(1);
 
 }
-
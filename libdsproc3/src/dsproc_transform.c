@@ -34,6 +34,8 @@
 #include "dsproc_private.h"
 #include "trans.h"
 #include <math.h>
+#include <pthread.h>
+#include <unistd.h>
 
 extern DSProc *_DSProc; /**< Internal DSProc structure */
 
@@ -203,6 +205,238 @@ static int _dsproc_get_trans_qc_rollup_bits(
     return(0);
 }
 
+/**
+ *  Static: Transformation job for a variable.
+ *
+ *  When more than one transform thread is used, the transformation variables
+ *  are still created in the main thread, but the call to the transform
+ *  driver is deferred until all variables have been set up. The data for all
+ *  jobs is then computed by the worker threads, and stored back in the
+ *  transformation group in the main thread in the order the jobs were
+ *  queued.
+ */
+typedef struct {
+
+    CDSGroup     *ret_ds_group;   /**< retrieved datastream group     */
+    CDSVar       *ret_var;        /**< retrieved variable             */
+    CDSGroup     *trans_coordsys; /**< transformation coordsys group  */
+    TRANScontext  ctx;            /**< transform driver context       */
+    int           status;         /**< status returned by the compute */
+
+} TransformJob;
+
+static int           _TransformThreads   = -1; /**< -1 = not set yet      */
+static int           _QueueTransforms    = 0;  /**< defer driver calls    */
+static TransformJob *_TransformJobs      = (TransformJob *)NULL;
+static int           _NumTransformJobs   = 0;
+static int           _MaxTransformJobs   = 0;
+static int           _NextTransformJob   = 0;
+static pthread_mutex_t _TransformJobMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ *  Static: Free all queued transformation jobs.
+ */
+static void _dsproc_free_transform_jobs(void)
+{
+    int ji;
+
+    for (ji = 0; ji < _NumTransformJobs; ji++) {
+        trans_free_context(&(_TransformJobs[ji].ctx));
+    }
+
+    _NumTransformJobs = 0;
+    _NextTransformJob = 0;
+}
+
+/**
+ *  Static: Queue a transformation job.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  ret_ds_group   - pointer to the retrieved datastream group
+ *  @param  trans_coordsys - pointer to the transformation coordsys group
+ *  @param  ret_var        - pointer to the retrieved variable
+ *  @param  ret_qc_var     - pointer to the retrieved QC variable, or NULL
+ *  @param  trans_var      - pointer to the transformation variable
+ *  @param  trans_qc_var   - pointer to the transformation QC variable
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if a memory allocation error occurred
+ */
+static int _dsproc_queue_transform_job(
+    CDSGroup *ret_ds_group,
+    CDSGroup *trans_coordsys,
+    CDSVar   *ret_var,
+    CDSVar   *ret_qc_var,
+    CDSVar   *trans_var,
+    CDSVar   *trans_qc_var)
+{
+    TransformJob *new_jobs;
+    TransformJob *job;
+    int           new_max;
+
+    if (_NumTransformJobs == _MaxTransformJobs) {
+
+        new_max  = _MaxTransformJobs + 64;
+        new_jobs = (TransformJob *)realloc(
+            _TransformJobs, new_max * sizeof(TransformJob));
+
+        if (!new_jobs) {
+
+            ERROR( DSPROC_LIB_NAME,
+                "Could not queue transformation job for: %s->%s\n"
+                " -> memory allocation error\n",
+                ret_ds_group->name, ret_var->name);
+
+            dsproc_set_status(DSPROC_ENOMEM);
+            return(0);
+        }
+
+        _TransformJobs    = new_jobs;
+        _MaxTransformJobs = new_max;
+    }
+
+    job = &(_TransformJobs[_NumTransformJobs++]);
+
+    job->ret_ds_group   = ret_ds_group;
+    job->ret_var        = ret_var;
+    job->trans_coordsys = trans_coordsys;
+    job->status         = 0;
+
+    trans_init_context(&(job->ctx),
+        ret_var, ret_qc_var, trans_var, trans_qc_var);
+
+    return(1);
+}
+
+/**
+ *  Static: Transform worker thread.
+ *
+ *  Pulls jobs off the queue until there are none left. Only the read-only
+ *  compute step of the transform driver is done here, nothing in the CDS
+ *  tree is changed until all of the worker threads have finished.
+ *
+ *  @param  arg - not used
+ *
+ *  @return  NULL
+ */
+static void *_dsproc_transform_worker(void *arg)
+{
+    TransformJob *job;
+    int           ji;
+
+    (void)arg;
+
+    for (;;) {
+
+        pthread_mutex_lock(&_TransformJobMutex);
+        ji = _NextTransformJob++;
+        pthread_mutex_unlock(&_TransformJobMutex);
+
+        if (ji >= _NumTransformJobs) break;
+
+        job = &(_TransformJobs[ji]);
+        job->status = cds_transform_compute(&(job->ctx));
+    }
+
+    return((void *)NULL);
+}
+
+/**
+ *  Static: Run all queued transformation jobs.
+ *
+ *  The jobs are computed using up to nthreads threads (including the main
+ *  thread), and the results are then stored in the order the jobs were
+ *  queued so the output does not depend on the number of threads used.
+ *
+ *  If an error occurs in this function it will be appended to the log and
+ *  error mail messages, and the process status will be set appropriately.
+ *
+ *  @param  nthreads - maximum number of threads to use
+ *
+ *  @return
+ *    -  1 if successful
+ *    - -1 if an error occurred
+ */
+static int _dsproc_run_transform_jobs(int nthreads)
+{
+    pthread_t    *threads  = (pthread_t *)NULL;
+    int           nstarted = 0;
+    TransformJob *job;
+    int           retval   = 1;
+    int           ji, ti;
+
+    if (_NumTransformJobs == 0) {
+        return(1);
+    }
+
+    if (nthreads > _NumTransformJobs) {
+        nthreads = _NumTransformJobs;
+    }
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "Transforming %d variables using %d threads\n",
+        _NumTransformJobs, nthreads);
+
+    _NextTransformJob = 0;
+
+    if (nthreads > 1) {
+
+        threads = (pthread_t *)calloc(nthreads - 1, sizeof(pthread_t));
+
+        if (threads) {
+            for (ti = 0; ti < nthreads - 1; ti++) {
+                if (pthread_create(&threads[ti], NULL,
+                    _dsproc_transform_worker, NULL) != 0) {
+                    break;
+                }
+                nstarted++;
+            }
+        }
+    }
+
+    /* The main thread works the queue too, so all jobs get done even if
+     * none of the threads could be started. */
+
+    _dsproc_transform_worker(NULL);
+
+    for (ti = 0; ti < nstarted; ti++) {
+        pthread_join(threads[ti], NULL);
+    }
+
+    if (threads) free(threads);
+
+    /* Store the results in the order the jobs were queued */
+
+    for (ji = 0; ji < _NumTransformJobs; ji++) {
+
+        job = &(_TransformJobs[ji]);
+
+        if (job->status == 0) {
+            job->status = cds_transform_store(&(job->ctx));
+        }
+
+        if (job->status < 0) {
+
+            ERROR( DSPROC_LIB_NAME,
+                "Could not transform variable %s->%s into coordinate system: %s\n"
+                " -> call to cds_transform_driver failed\n",
+                job->ret_ds_group->name, job->ret_var->name,
+                job->trans_coordsys->name);
+
+            dsproc_set_status(DSPROC_ETRANSFORM);
+            retval = -1;
+            break;
+        }
+    }
+
+    _dsproc_free_transform_jobs();
+
+    return(retval);
+}
+
 /**
  *  Static: Cleanup previously transformed data.
  *
@@ -211,6 +445,8 @@ static int _dsproc_get_trans_qc_rollup_bits(
  */
 static void _dsproc_cleanup_transformed_data(void)
 {
+    _dsproc_free_transform_jobs();
+
     if (_DSProc->trans_data) {
         cds_set_definition_lock(_DSProc->trans_data, 0);
         cds_delete_group(_DSProc->trans_data);
@@ -2098,6 +2334,20 @@ trans_obs_group = trans_ds_group;
         snprintf(ret_qc_var_name, NC_MAX_NAME, "qc_%s", ret_var->name);
         ret_qc_var = cds_get_var(ret_obs_group, ret_qc_var_name);
 
+        /* Queue the transform if we are using multiple threads. */
+
+        if (_QueueTransforms) {
+
+            if (!_dsproc_queue_transform_job(
+                ret_ds_group, trans_coordsys,
+                ret_var, ret_qc_var, *trans_var, trans_qc_var)) {
+
+                return(-1);
+            }
+
+            return(1);
+        }
+
         /* Call the transform. */
 
         status = cds_transform_driver(
@@ -2476,6 +2726,7 @@ int dsproc_transform_data(
 
     CDSGroup   *trans_coordsys;
     CDSGroup   *trans_ds_group;
+    int         nthreads;
 
     *trans_data = (CDSGroup *)NULL;
 
@@ -2503,8 +2754,30 @@ int dsproc_transform_data(
         return(-1);
     }
 
+    if (dsproc_get_cds_arena_mode()) {
+        if (!cds_enable_arena(_DSProc->trans_data)) {
+            dsproc_set_status(DSPROC_ENOMEM);
+            return(-1);
+        }
+    }
+
     *trans_data = _DSProc->trans_data;
 
+    /* Check if the variables should be transformed in parallel */
+
+    nthreads = dsproc_get_transform_threads();
+
+    if (nthreads > 1 && trans_has_user_functions()) {
+
+        DEBUG_LV1( DSPROC_LIB_NAME,
+            "User transform or QC mapping functions are assigned,\n"
+            " -> transforming variables serially\n");
+
+        nthreads = 1;
+    }
+
+    _QueueTransforms = (nthreads > 1) ? 1 : 0;
+
     /* Loop over each datastream group in the retrieved data  */
 
     for (dsi = 0; dsi < ret_data->ngroups; dsi++) {
@@ -2655,6 +2928,17 @@ ret_obs_group = ret_ds_group->groups[0];
 
     } /* end ds loop */
 
+    /* Run the queued transformations */
+
+    if (_QueueTransforms) {
+
+        _QueueTransforms = 0;
+
+        if (_dsproc_run_transform_jobs(nthreads) < 0) {
+            return(-1);
+        }
+    }
+
     /* Remove empty coordinate systems. This can happen if all variables
      * in a coordinate system are optional and were not found. */
 
@@ -2681,6 +2965,72 @@ ret_obs_group = ret_ds_group->groups[0];
     return(1);
 }
 
+/**
+ *  Get the number of threads used to transform the retrieved data.
+ *
+ *  If the number of threads has not been set using the -j command line
+ *  option or dsproc_set_transform_threads(), the DSPROC_TRANSFORM_THREADS
+ *  environment variable will be checked.
+ *
+ *  @return  number of transform threads (1 = serial)
+ *
+ *  @see dsproc_set_transform_threads()
+ */
+int dsproc_get_transform_threads(void)
+{
+    const char *env;
+
+    if (_TransformThreads < 0) {
+
+        env = getenv("DSPROC_TRANSFORM_THREADS");
+
+        if (env && *env) {
+            dsproc_set_transform_threads(atoi(env));
+        }
+        else {
+            _TransformThreads = 1;
+        }
+    }
+
+    return(_TransformThreads);
+}
+
+/**
+ *  Set the number of threads used to transform the retrieved data.
+ *
+ *  Each retrieved variable is transformed independently, so when more than
+ *  one thread is used the variables are set up in the main thread, the
+ *  transformations are computed in parallel, and the results are stored in
+ *  the transformed data in the same order they would have been in serial
+ *  mode.
+ *
+ *  User functions assigned with assign_transform_function() or
+ *  assign_qc_mapping_function() are not assumed to be thread safe, so the
+ *  transformations are done serially when any have been assigned.
+ *
+ *  @param  nthreads - number of threads to use, 1 for serial mode,
+ *                     or 0 to use the number of online processors
+ *
+ *  @see dsproc_get_transform_threads()
+ */
+void dsproc_set_transform_threads(int nthreads)
+{
+    long nprocs;
+
+    if (nthreads == 0) {
+        nprocs   = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (nprocs > 0) ? (int)nprocs : 1;
+    }
+    else if (nthreads < 0) {
+        nthreads = 1;
+    }
+
+    DEBUG_LV1( DSPROC_LIB_NAME,
+        "Setting number of transform threads to: %d\n", nthreads);
+
+    _TransformThreads = nthreads;
+}
+
 /*******************************************************************************
  *  Public Functions
  */
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
 
 #include "messenger.h"
 
@@ -61,6 +62,11 @@ static struct
 
 } gDebug;
 
+/**
+ *  PRIVATE: Serializes messages sent from worker threads.
+ */
+static pthread_mutex_t gSendMutex = PTHREAD_MUTEX_INITIALIZER;
+
 /**
  *  PRIVATE: Get the string name of a MessageType.
  *
@@ -762,6 +768,9 @@ void msngr_send(
  *  @param  type   - mesage type
  *  @param  format - format string (see printf)
  *  @param  args   - arguments for the format string
+ *
+ *  This function is thread safe; messages from different threads will not
+ *  be interleaved in the log, mail, or debug output.
  */
 void msngr_vsend(
     const char  *sender,
@@ -780,6 +789,8 @@ void msngr_vsend(
     if (!func)   func   = "null";
     if (!file)   file   = "null";
 
+    pthread_mutex_lock(&gSendMutex);
+
     /* Log and Mail messages */
 
     switch (type) {
@@ -932,6 +943,8 @@ void msngr_vsend(
                 sender, func, file, line, msg_prov_level, type, format, args);
         }
     }
+
+    pthread_mutex_unlock(&gSendMutex);
 }
 
 /**
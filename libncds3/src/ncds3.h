@@ -71,6 +71,16 @@ int     ncds_read_dims(
             int       nc_grpid,
             CDSGroup *cds_group);
 
+int     ncds_set_dim_subset(
+            CDSDim    *dim,
+            size_t     start,
+            ptrdiff_t  stride);
+
+int     ncds_get_dim_subset(
+            CDSDim    *dim,
+            size_t    *start,
+            ptrdiff_t *stride);
+
 CDSAtt *ncds_read_att(
             int         nc_grpid,
             int         nc_attid,
@@ -107,6 +117,15 @@ void   *ncds_read_var_data(
             CDSVar *cds_var,
             size_t  cds_sample_start);
 
+void   *ncds_read_var_hyperslab(
+            int        nc_grpid,
+            int        nc_varid,
+            size_t    *nc_start,
+            size_t    *nc_count,
+            ptrdiff_t *nc_stride,
+            CDSVar    *cds_var,
+            size_t     cds_sample_start);
+
 void   *ncds_read_var_samples(
             int     nc_grpid,
             int     nc_varid,
@@ -133,6 +152,9 @@ int     ncds_read_group_data(
             int       recursive,
             CDSGroup *cds_group,
             size_t    cds_record_start);
+
+int     ncds_get_mmap_mode(void);
+void    ncds_set_mmap_mode(int mode);
 /*@}*/
 
 /******************************************************************************/
@@ -141,6 +163,25 @@ int     ncds_read_group_data(
  */
 /*@{*/
 
+/**
+ *  NetCDF-4 Storage Policy Flags.
+ */
+#define NCDS_CHUNK_TIME_SERIES  0x1 /**< chunk record variables for time series reads    */
+#define NCDS_CHUNK_PROFILES     0x2 /**< chunk record variables for whole sample reads   */
+#define NCDS_DEFLATE_FLOATS     0x4 /**< deflate and shuffle large floating point vars   */
+
+/**
+ *  NetCDF-4 Storage Policy.
+ */
+typedef struct NCDSStoragePolicy {
+
+    int     flags;          /**< storage policy flags (see above)           */
+    int     deflate_level;  /**< deflate level used by NCDS_DEFLATE_FLOATS  */
+    size_t  nrecords;       /**< expected number of records in the file,
+                                 or 0 if not known                          */
+
+} NCDSStoragePolicy;
+
 int     ncds_create_file(
             CDSGroup   *cds_group,
             const char *file,
@@ -148,6 +189,14 @@ int     ncds_create_file(
             int         recursive,
             int         header_only);
 
+int     ncds_create_file_with_policy(
+            CDSGroup                *cds_group,
+            const char              *file,
+            int                      cmode,
+            int                      recursive,
+            int                      header_only,
+            const NCDSStoragePolicy *policy);
+
 int     ncds_write_dim(
             CDSDim *cds_dim,
             int     nc_grpid,
@@ -0,0 +1,928 @@
+/*******************************************************************************
+*
+*  COPYRIGHT (C) 2016 Battelle Memorial Institute.  All Rights Reserved.
+*
+********************************************************************************
+*
+*  Author:
+*     name:  Brian Ermold
+*     phone: (509) 375-2277
+*     email: brian.ermold@pnl.gov
+*
+********************************************************************************
+*
+*  REPOSITORY INFORMATION:
+*    $Revision$
+*    $Author$
+*    $Date$
+*
+********************************************************************************
+*
+*  NOTE: DOXYGEN is used to generate documentation for this file.
+*
+*******************************************************************************/
+
+/**
+ *  @file ncds_mmap.c
+ *  Memory Mapped NetCDF-3 Read Functions.
+ *
+ *  The data in classic and 64-bit offset NetCDF files is stored
+ *  uncompressed in big-endian order at offsets that are recorded in the
+ *  file header. When the mmap mode is enabled, files opened read-only
+ *  with ncds_open() are mapped into memory the first time data is read
+ *  from them, and the variable offsets are computed from the header. The
+ *  requested values are then byte swapped directly from the mapping into
+ *  the output buffer in a single pass, instead of being read into the
+ *  NetCDF library buffers and copied from there.
+ *
+ *  Anything the mapped read path does not handle (other file formats,
+ *  out of range requests, negative strides) falls back to the NetCDF
+ *  library so the error handling is unchanged.
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ncds3.h"
+#include "ncds_private.h"
+
+/*******************************************************************************
+ *  Private Data and Functions
+ */
+/** @privatesection */
+
+/** Tag for the dimension list in the NetCDF-3 header. */
+#define NCMAP_DIMENSION  0x0A
+
+/** Tag for the variable list in the NetCDF-3 header. */
+#define NCMAP_VARIABLE   0x0B
+
+/** Tag for the attribute list in the NetCDF-3 header. */
+#define NCMAP_ATTRIBUTE  0x0C
+
+/** Round a size up to a four byte boundary. */
+#define NCMAP_RNDUP(n)   (((n) + 3) & ~((size_t)3))
+
+/**
+ *  Variable in a memory mapped NetCDF file.
+ */
+typedef struct {
+
+    size_t   type_size;  /**< size of the external data type              */
+    int      ndims;      /**< number of dimensions                        */
+    int      is_record;  /**< the first dimension is the record dimension */
+    size_t  *shape;      /**< dimension lengths                           */
+    size_t   length;     /**< size of the data, or one record of the data */
+    size_t   begin;      /**< offset of the data in the file              */
+    int      valid;      /**< the data is completely inside the file      */
+
+} NCMapVar;
+
+/**
+ *  Memory mapped NetCDF file.
+ */
+typedef struct NCMapFile {
+
+    int                  ncid;     /**< NetCDF id of the open file              */
+    char                *path;     /**< path the file was opened with           */
+    int                  mapped;   /**< 1 = mapped, 0 = not yet, -1 = failed    */
+    const unsigned char *base;     /**< start of the mapping                    */
+    size_t               size;     /**< size of the mapping                     */
+    int                  recdimid; /**< id of the record dimension, or -1       */
+    size_t               recsize;  /**< size of one record of all record vars   */
+    int                  nvars;    /**< number of variables                     */
+    NCMapVar            *vars;     /**< variables indexed by NetCDF variable id */
+
+    struct NCMapFile    *next;     /**< next file in the list                   */
+
+} NCMapFile;
+
+/**
+ *  Cursor used to parse a NetCDF-3 header.
+ */
+typedef struct {
+
+    const unsigned char *p;       /**< current position */
+    const unsigned char *end;     /**< end of the file  */
+    int                  version; /**< 1 = classic, 2 = 64-bit offset */
+
+} NCMapCursor;
+
+static int        _MMapMode  = -1;   /**< -1 = not set yet      */
+static NCMapFile *_MMapFiles = NULL; /**< list of registered files */
+
+/**
+ *  Private: Read a 32 bit big-endian value from the header.
+ */
+static int _ncmap_get_u32(NCMapCursor *cur, size_t *value)
+{
+    if (cur->end - cur->p < 4) return(0);
+
+    *value = ((size_t)cur->p[0] << 24) | ((size_t)cur->p[1] << 16)
+           | ((size_t)cur->p[2] <<  8) |  (size_t)cur->p[3];
+
+    cur->p += 4;
+    return(1);
+}
+
+/**
+ *  Private: Read a variable begin offset from the header.
+ */
+static int _ncmap_get_offset(NCMapCursor *cur, size_t *value)
+{
+    size_t hi, lo;
+
+    if (cur->version == 1) {
+        return(_ncmap_get_u32(cur, value));
+    }
+
+    if (!_ncmap_get_u32(cur, &hi) ||
+        !_ncmap_get_u32(cur, &lo)) {
+
+        return(0);
+    }
+
+    if (sizeof(size_t) < 8 && hi) return(0);
+
+    *value = (size_t)(((uint64_t)hi << 32) | lo);
+    return(1);
+}
+
+/**
+ *  Private: Skip a padded name in the header.
+ */
+static int _ncmap_skip_name(NCMapCursor *cur)
+{
+    size_t length;
+
+    if (!_ncmap_get_u32(cur, &length)) return(0);
+
+    length = NCMAP_RNDUP(length);
+    if ((size_t)(cur->end - cur->p) < length) return(0);
+
+    cur->p += length;
+    return(1);
+}
+
+/**
+ *  Private: Get the size of a NetCDF-3 external data type.
+ */
+static size_t _ncmap_type_size(size_t type)
+{
+    switch (type) {
+        case NC_BYTE:
+        case NC_CHAR:   return(1);
+        case NC_SHORT:  return(2);
+        case NC_INT:
+        case NC_FLOAT:  return(4);
+        case NC_DOUBLE: return(8);
+        default:        return(0);
+    }
+}
+
+/**
+ *  Private: Skip an attribute list in the header.
+ */
+static int _ncmap_skip_atts(NCMapCursor *cur)
+{
+    size_t tag, natts, type, nelems, length;
+    size_t ai;
+
+    if (!_ncmap_get_u32(cur, &tag) ||
+        !_ncmap_get_u32(cur, &natts)) {
+
+        return(0);
+    }
+
+    if (tag != NCMAP_ATTRIBUTE && (tag != 0 || natts != 0)) return(0);
+
+    for (ai = 0; ai < natts; ++ai) {
+
+        if (!_ncmap_skip_name(cur)       ||
+            !_ncmap_get_u32(cur, &type)  ||
+            !_ncmap_get_u32(cur, &nelems)) {
+
+            return(0);
+        }
+
+        length = _ncmap_type_size(type);
+        if (!length) return(0);
+
+        length = NCMAP_RNDUP(nelems * length);
+        if ((size_t)(cur->end - cur->p) < length) return(0);
+
+        cur->p += length;
+    }
+
+    return(1);
+}
+
+/**
+ *  Private: Free the variables of a memory mapped file.
+ */
+static void _ncmap_free_vars(NCMapFile *file)
+{
+    int vi;
+
+    if (file->vars) {
+
+        for (vi = 0; vi < file->nvars; ++vi) {
+            if (file->vars[vi].shape) free(file->vars[vi].shape);
+        }
+
+        free(file->vars);
+    }
+
+    file->vars  = (NCMapVar *)NULL;
+    file->nvars = 0;
+}
+
+/**
+ *  Private: Parse the NetCDF-3 header of a memory mapped file.
+ *
+ *  @param  file - pointer to the NCMapFile
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if this is not a classic or 64-bit offset file,
+ *        or the header could not be parsed
+ */
+static int _ncmap_parse_header(NCMapFile *file)
+{
+    NCMapCursor  cur;
+    size_t       tag, count, value;
+    size_t       ndims;
+    size_t      *dim_lengths;
+    NCMapVar    *var;
+    size_t       nrecvars;
+    size_t       di, vi;
+
+    cur.p   = file->base;
+    cur.end = file->base + file->size;
+
+    if (file->size < 8 ||
+        memcmp(cur.p, "CDF", 3) != 0 ||
+        (cur.p[3] != 1 && cur.p[3] != 2)) {
+
+        return(0);
+    }
+
+    cur.version = cur.p[3];
+    cur.p += 4;
+
+    /* Skip the number of records, the current value is
+     * always taken from the NetCDF library */
+
+    if (!_ncmap_get_u32(&cur, &value)) return(0);
+
+    /* Dimensions */
+
+    dim_lengths = (size_t *)NULL;
+    ndims       = 0;
+
+    file->recdimid = -1;
+
+    if (!_ncmap_get_u32(&cur, &tag) ||
+        !_ncmap_get_u32(&cur, &ndims)) {
+
+        return(0);
+    }
+
+    if (tag != NCMAP_DIMENSION && (tag != 0 || ndims != 0)) return(0);
+    if (ndims > NC_MAX_DIMS) return(0);
+
+    if (ndims) {
+        dim_lengths = (size_t *)calloc(ndims, sizeof(size_t));
+        if (!dim_lengths) return(0);
+    }
+
+    for (di = 0; di < ndims; ++di) {
+
+        if (!_ncmap_skip_name(&cur) ||
+            !_ncmap_get_u32(&cur, &dim_lengths[di])) {
+
+            goto PARSE_ERROR;
+        }
+
+        if (dim_lengths[di] == 0) {
+            file->recdimid = (int)di;
+        }
+    }
+
+    /* Global attributes */
+
+    if (!_ncmap_skip_atts(&cur)) goto PARSE_ERROR;
+
+    /* Variables */
+
+    if (!_ncmap_get_u32(&cur, &tag) ||
+        !_ncmap_get_u32(&cur, &count)) {
+
+        goto PARSE_ERROR;
+    }
+
+    if (tag != NCMAP_VARIABLE && (tag != 0 || count != 0)) goto PARSE_ERROR;
+    if (count > NC_MAX_VARS) goto PARSE_ERROR;
+
+    if (count) {
+        file->vars = (NCMapVar *)calloc(count, sizeof(NCMapVar));
+        if (!file->vars) goto PARSE_ERROR;
+    }
+
+    file->nvars   = (int)count;
+    file->recsize = 0;
+    nrecvars      = 0;
+
+    for (vi = 0; vi < count; ++vi) {
+
+        var = &(file->vars[vi]);
+
+        if (!_ncmap_skip_name(&cur) ||
+            !_ncmap_get_u32(&cur, &value)) {
+
+            goto PARSE_ERROR;
+        }
+
+        if (value > NC_MAX_VAR_DIMS) goto PARSE_ERROR;
+
+        var->ndims = (int)value;
+
+        if (var->ndims) {
+            var->shape = (size_t *)calloc(var->ndims, sizeof(size_t));
+            if (!var->shape) goto PARSE_ERROR;
+        }
+
+        var->length = 1;
+
+        for (di = 0; di < (size_t)var->ndims; ++di) {
+
+            if (!_ncmap_get_u32(&cur, &value) || value >= ndims) {
+                goto PARSE_ERROR;
+            }
+
+            var->shape[di] = dim_lengths[value];
+
+            if ((int)value == file->recdimid) {
+                if (di != 0) goto PARSE_ERROR;
+                var->is_record = 1;
+            }
+            else {
+                var->length *= var->shape[di];
+            }
+        }
+
+        if (!_ncmap_skip_atts(&cur)         ||
+            !_ncmap_get_u32(&cur, &value)    ||
+            !(var->type_size = _ncmap_type_size(value))) {
+
+            goto PARSE_ERROR;
+        }
+
+        /* The vsize in the header is not used because it
+         * is not valid for variables larger than 4 GiB */
+
+        if (!_ncmap_get_u32(&cur, &value) ||
+            !_ncmap_get_offset(&cur, &var->begin)) {
+
+            goto PARSE_ERROR;
+        }
+
+        var->length *= var->type_size;
+
+        if (var->is_record) {
+            file->recsize += NCMAP_RNDUP(var->length);
+            nrecvars      += 1;
+        }
+        else {
+            var->valid = (var->begin <= file->size &&
+                          var->length <= file->size - var->begin);
+        }
+    }
+
+    /* The records are not padded if there is only one record variable */
+
+    if (nrecvars == 1) {
+        for (vi = 0; vi < count; ++vi) {
+            if (file->vars[vi].is_record) {
+                file->recsize = file->vars[vi].length;
+                break;
+            }
+        }
+    }
+
+    for (vi = 0; vi < count; ++vi) {
+        if (file->vars[vi].is_record) {
+            file->vars[vi].valid = (file->vars[vi].begin <= file->size);
+        }
+    }
+
+    if (dim_lengths) free(dim_lengths);
+
+    return(1);
+
+PARSE_ERROR:
+
+    if (dim_lengths) free(dim_lengths);
+    _ncmap_free_vars(file);
+
+    return(0);
+}
+
+/**
+ *  Private: Map a registered file into memory and parse the header.
+ *
+ *  @param  file - pointer to the NCMapFile
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if the file could not be mapped
+ */
+static int _ncmap_map_file(NCMapFile *file)
+{
+    struct stat  stats;
+    void        *base;
+    int          fd;
+
+    file->mapped = -1;
+
+    fd = open(file->path, O_RDONLY);
+    if (fd < 0) return(0);
+
+    if (fstat(fd, &stats) < 0 || stats.st_size <= 0) {
+        close(fd);
+        return(0);
+    }
+
+    base = mmap(NULL, (size_t)stats.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED) return(0);
+
+    file->base = (const unsigned char *)base;
+    file->size = (size_t)stats.st_size;
+
+    if (!_ncmap_parse_header(file)) {
+
+        munmap((void *)file->base, file->size);
+
+        file->base = (const unsigned char *)NULL;
+        file->size = 0;
+
+        return(0);
+    }
+
+    file->mapped = 1;
+
+    return(1);
+}
+
+/**
+ *  Private: Free a registered file.
+ */
+static void _ncmap_free_file(NCMapFile *file)
+{
+    if (file->base) munmap((void *)file->base, file->size);
+    if (file->path) free(file->path);
+
+    _ncmap_free_vars(file);
+
+    free(file);
+}
+
+/**
+ *  Private: Get the registered file for a NetCDF id.
+ *
+ *  The file is mapped the first time it is used. The path of the open
+ *  file is checked in case the file was closed using nc_close() and the
+ *  NetCDF id was reused by another file.
+ *
+ *  @param  ncid - NetCDF id of the open file
+ *
+ *  @return
+ *    - pointer to the NCMapFile
+ *    - NULL if the file is not registered or could not be mapped
+ */
+static NCMapFile *_ncmap_get_file(int ncid)
+{
+    NCMapFile *file;
+    char       path[PATH_MAX];
+    size_t     length;
+
+    for (file = _MMapFiles; file; file = file->next) {
+        if (file->ncid == ncid) break;
+    }
+
+    if (!file || file->mapped < 0) return((NCMapFile *)NULL);
+
+    if (nc_inq_path(ncid, &length, NULL) != NC_NOERR ||
+        length >= PATH_MAX                             ||
+        nc_inq_path(ncid, NULL, path) != NC_NOERR      ||
+        strcmp(path, file->path) != 0) {
+
+        return((NCMapFile *)NULL);
+    }
+
+    if (!file->mapped && !_ncmap_map_file(file)) {
+        return((NCMapFile *)NULL);
+    }
+
+    return(file);
+}
+
+/**
+ *  Private: Copy big-endian values from the file mapping.
+ *
+ *  @param  src       - pointer to the first value in the mapping
+ *  @param  type_size - size of the data type
+ *  @param  count     - number of values to copy
+ *  @param  stride    - stride between the values
+ *  @param  dst       - output buffer
+ */
+static void _ncmap_copy(
+    const unsigned char *src,
+    size_t               type_size,
+    size_t               count,
+    size_t               stride,
+    void                *dst)
+{
+    size_t step = stride * type_size;
+    size_t i;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+
+    /* No byte swapping is needed on big-endian hosts */
+
+    if (stride == 1) {
+        memcpy(dst, src, count * type_size);
+        return;
+    }
+
+    for (i = 0; i < count; ++i, src += step) {
+        memcpy((char *)dst + i * type_size, src, type_size);
+    }
+
+    return;
+#endif
+
+    switch (type_size) {
+
+        case 2: {
+
+            uint16_t *out = (uint16_t *)dst;
+            uint16_t  v;
+
+            for (i = 0; i < count; ++i, src += step) {
+                memcpy(&v, src, 2);
+                out[i] = (uint16_t)((v >> 8) | (v << 8));
+            }
+
+            break;
+        }
+
+        case 4: {
+
+            uint32_t *out = (uint32_t *)dst;
+            uint32_t  v;
+
+            for (i = 0; i < count; ++i, src += step) {
+                memcpy(&v, src, 4);
+                out[i] = ((v >> 24) & 0x000000ffu)
+                       | ((v >>  8) & 0x0000ff00u)
+                       | ((v <<  8) & 0x00ff0000u)
+                       | ((v << 24) & 0xff000000u);
+            }
+
+            break;
+        }
+
+        case 8: {
+
+            uint64_t *out = (uint64_t *)dst;
+            uint64_t  v;
+
+            for (i = 0; i < count; ++i, src += step) {
+                memcpy(&v, src, 8);
+                v = ((v >> 8) & 0x00ff00ff00ff00ffull)
+                  | ((v & 0x00ff00ff00ff00ffull) << 8);
+                v = ((v >> 16) & 0x0000ffff0000ffffull)
+                  | ((v & 0x0000ffff0000ffffull) << 16);
+                out[i] = (v >> 32) | (v << 32);
+            }
+
+            break;
+        }
+
+        case 1: {
+
+            unsigned char *out = (unsigned char *)dst;
+
+            for (i = 0; i < count; ++i, src += step) {
+                out[i] = *src;
+            }
+
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/*******************************************************************************
+ *  Private Functions Visible Only To This Library
+ */
+
+/**
+ *  Private: Read a hyperslab from a memory mapped NetCDF-3 file.
+ *
+ *  The values are returned in native byte order and the external data
+ *  type of the variable, exactly as they would be by nc_get_vars().
+ *
+ *  @param  ncid      - NetCDF id of the root group
+ *  @param  varid     - NetCDF variable id
+ *  @param  start     - start indexes
+ *  @param  count     - number of values to read along each dimension
+ *  @param  stride    - stride along each dimension, or NULL
+ *  @param  datap     - output buffer
+ *
+ *  @return
+ *    - 1 if the data was read from the mapping
+ *    - 0 if the data must be read using the NetCDF library
+ */
+int _ncds_mmap_read(
+    int              ncid,
+    int              varid,
+    const size_t    *start,
+    const size_t    *count,
+    const ptrdiff_t *stride,
+    void            *datap)
+{
+    NCMapFile     *file;
+    NCMapVar      *var;
+    size_t         shape[NC_MAX_VAR_DIMS];
+    size_t         step[NC_MAX_VAR_DIMS];
+    size_t         index[NC_MAX_VAR_DIMS];
+    size_t         elems[NC_MAX_VAR_DIMS];
+    size_t         nrecs;
+    size_t         offset;
+    size_t         run, run_stride, nruns;
+    size_t         nbytes;
+    unsigned char *out;
+    int            ndims, rec, inner;
+    int            di;
+
+    if (_MMapMode <= 0 || !_MMapFiles) return(0);
+
+    if (!(file = _ncmap_get_file(ncid)))  return(0);
+    if (varid < 0 || varid >= file->nvars) return(0);
+
+    var   = &(file->vars[varid]);
+    ndims = var->ndims;
+    rec   = var->is_record;
+
+    if (!var->valid) return(0);
+
+    /* Scalar variables */
+
+    if (ndims == 0) {
+        _ncmap_copy(file->base + var->begin, var->type_size, 1, 1, datap);
+        return(1);
+    }
+
+    /* Check the requested hyperslab */
+
+    memcpy(shape, var->shape, ndims * sizeof(size_t));
+
+    if (rec) {
+
+        if (nc_inq_dimlen(ncid, file->recdimid, &nrecs) != NC_NOERR) {
+            return(0);
+        }
+
+        shape[0] = nrecs;
+    }
+
+    for (di = 0; di < ndims; ++di) {
+
+        step[di] = (stride) ? (size_t)stride[di] : 1;
+
+        if ((stride && stride[di] <= 0) || count[di] == 0 ||
+            start[di] >= shape[di] ||
+            (count[di] - 1) * step[di] >= shape[di] - start[di]) {
+
+            return(0);
+        }
+    }
+
+    if (rec) {
+
+        nrecs = start[0] + (count[0] - 1) * step[0] + 1;
+
+        if (var->begin + (nrecs - 1) * file->recsize > file->size ||
+            var->length > file->size - var->begin - (nrecs - 1) * file->recsize) {
+
+            return(0);
+        }
+    }
+
+    /* Number of values between successive indexes of each dimension */
+
+    elems[ndims - 1] = 1;
+
+    for (di = ndims - 2; di >= rec; --di) {
+        elems[di] = elems[di + 1] * shape[di + 1];
+    }
+
+    out = (unsigned char *)datap;
+
+    /* Variables with only the record dimension */
+
+    if (ndims == 1 && rec) {
+
+        offset = var->begin + start[0] * file->recsize;
+
+        for (nruns = 0; nruns < count[0]; ++nruns) {
+            _ncmap_copy(file->base + offset, var->type_size, 1, 1, out);
+            offset += step[0] * file->recsize;
+            out    += var->type_size;
+        }
+
+        return(1);
+    }
+
+    /* Combine the trailing dimensions that are read completely into
+     * a single contiguous run of values */
+
+    inner = ndims - 1;
+    run   = count[inner];
+
+    while (inner > rec && step[inner] == 1 && step[inner - 1] == 1 &&
+           count[inner] == shape[inner]) {
+
+        inner -= 1;
+        run   *= count[inner];
+    }
+
+    run_stride = (stride) ? (size_t)stride[inner] : 1;
+    nbytes     = run * var->type_size;
+
+    /* Copy the runs of values */
+
+    nruns = 1;
+    for (di = 0; di < inner; ++di) {
+        nruns    *= count[di];
+        index[di] = 0;
+    }
+
+    while (nruns--) {
+
+        offset = var->begin
+               + start[inner] * elems[inner] * var->type_size;
+
+        for (di = 0; di < inner; ++di) {
+
+            if (di == 0 && rec) {
+                offset += (start[0] + index[0] * step[0]) * file->recsize;
+            }
+            else {
+                offset += (start[di] + index[di] * step[di])
+                        * elems[di] * var->type_size;
+            }
+        }
+
+        _ncmap_copy(file->base + offset, var->type_size, run, run_stride, out);
+        out += nbytes;
+
+        /* Increment the indexes of the outer dimensions */
+
+        for (di = inner - 1; di >= 0; --di) {
+            if (++index[di] < count[di]) break;
+            index[di] = 0;
+        }
+    }
+
+    return(1);
+}
+
+/**
+ *  Private: Register a file opened read-only for memory mapped reads.
+ *
+ *  This function is called by ncds_open(), the file will not be mapped
+ *  until data is read from it.
+ *
+ *  @param  ncid - NetCDF id of the open file
+ *  @param  path - path the file was opened with
+ */
+void _ncds_mmap_register(int ncid, const char *path)
+{
+    NCMapFile *file;
+    int        format;
+
+    if (!ncds_get_mmap_mode()) return;
+
+    if (nc_inq_format(ncid, &format) != NC_NOERR ||
+        (format != NC_FORMAT_CLASSIC && format != NC_FORMAT_64BIT)) {
+
+        return;
+    }
+
+    _ncds_mmap_unregister(ncid);
+
+    file = (NCMapFile *)calloc(1, sizeof(NCMapFile));
+    if (!file) return;
+
+    file->ncid     = ncid;
+    file->path     = strdup(path);
+    file->recdimid = -1;
+
+    if (!file->path) {
+        free(file);
+        return;
+    }
+
+    file->next = _MMapFiles;
+    _MMapFiles = file;
+}
+
+/**
+ *  Private: Unregister a file and unmap it.
+ *
+ *  This function is called by ncds_close().
+ *
+ *  @param  ncid - NetCDF id of the file
+ */
+void _ncds_mmap_unregister(int ncid)
+{
+    NCMapFile **filep;
+    NCMapFile  *file;
+
+    for (filep = &_MMapFiles; (file = *filep); filep = &file->next) {
+
+        if (file->ncid == ncid) {
+            *filep = file->next;
+            _ncmap_free_file(file);
+            return;
+        }
+    }
+}
+
+/*******************************************************************************
+ *  Public Functions
+ */
+/** @publicsection */
+
+/**
+ *  Get the mmap mode.
+ *
+ *  If the mmap mode has not been set using ncds_set_mmap_mode(), the
+ *  NCDS_MMAP environment variable will be checked.
+ *
+ *  @return
+ *    - 1 if data is read from memory mapped NetCDF-3 files
+ *    - 0 if all data is read using the NetCDF library
+ *
+ *  @see ncds_set_mmap_mode()
+ */
+int ncds_get_mmap_mode(void)
+{
+    const char *env;
+
+    if (_MMapMode < 0) {
+
+        env = getenv("NCDS_MMAP");
+
+        if (env && *env) {
+            _MMapMode = (atoi(env) > 0) ? 1 : 0;
+        }
+        else {
+            _MMapMode = 0;
+        }
+    }
+
+    return(_MMapMode);
+}
+
+/**
+ *  Set the mmap mode.
+ *
+ *  When the mmap mode is enabled, classic and 64-bit offset NetCDF files
+ *  opened read-only using ncds_open() are memory mapped, and the data
+ *  read by ncds_read_var_data() and the functions that use it is copied
+ *  directly from the mapping. This avoids the extra buffer copies done
+ *  by the NetCDF library for uncompressed files. Files opened before the
+ *  mmap mode is enabled will still be read using the NetCDF library.
+ *
+ *  A memory mapped file must not be truncated by another process while
+ *  it is open.
+ *
+ *  @param  mode - 1 to enable the mmap mode, 0 to disable it
+ *
+ *  @see ncds_get_mmap_mode()
+ */
+void ncds_set_mmap_mode(int mode)
+{
+    _MMapMode = (mode) ? 1 : 0;
+}
@@ -46,6 +46,19 @@ CDSAtt *_ncds_read_att(
             void       *cds_object,
             const char *cds_att_name);
 
+/*****  Memory Mapped Read Functions  *****/
+
+int     _ncds_mmap_read(
+            int              ncid,
+            int              varid,
+            const size_t    *start,
+            const size_t    *count,
+            const ptrdiff_t *stride,
+            void            *datap);
+
+void    _ncds_mmap_register(int ncid, const char *path);
+void    _ncds_mmap_unregister(int ncid);
+
 /*****  Write Functions  *****/
 
 int     _ncds_write_att(
@@ -53,6 +66,18 @@ int     _ncds_write_att(
             int     nc_grpid,
             int     nc_varid);
 
+int     _ncds_write_var(
+            CDSVar                  *cds_var,
+            int                      nc_grpid,
+            int                     *nc_varid,
+            const NCDSStoragePolicy *policy);
+
+int     _ncds_write_group(
+            CDSGroup                *cds_group,
+            int                      nc_grpid,
+            int                      recursive,
+            const NCDSStoragePolicy *policy);
+
 /*****  DataStream Functions  *****/
 
 NCDatastream *_ncds_create_datastream(
@@ -150,6 +150,19 @@ CDSAtt *_ncds_read_att(
     return(att);
 }
 
+/**
+ *  User data key used to attach a dimension subset to a CDS dimension.
+ */
+#define NCDS_DIM_SUBSET_KEY "__ncds_dim_subset"
+
+/**
+ *  PRIVATE: Dimension subset attached to a CDS dimension.
+ */
+typedef struct {
+    size_t    start;   /**< start index along the NetCDF dimension */
+    ptrdiff_t stride;  /**< stride along the NetCDF dimension      */
+} NCDSDimSubset;
+
 /*******************************************************************************
  *  Public Functions
  */
@@ -343,6 +356,95 @@ int ncds_read_dims(
     return(ndims);
 }
 
+/**
+ *  Set the subset of a NetCDF dimension to read into a CDS dimension.
+ *
+ *  The length of the CDS dimension is the number of indexes that will be
+ *  read along the NetCDF dimension, starting at the specified start index
+ *  and stepping by the specified stride. The ncds_read_var_samples()
+ *  function, and all functions that use it, will then only read the
+ *  subset of the variable data along this dimension.
+ *
+ *  The subset is not supported for unlimited dimensions.
+ *
+ *  Error messages from this function are sent to the message handler
+ *  (see msngr_init_log() and msngr_init_mail()).
+ *
+ *  @param  dim    - pointer to the CDS dimension
+ *  @param  start  - start index along the NetCDF dimension
+ *  @param  stride - stride along the NetCDF dimension (must be > 0)
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if an error occurred
+ */
+int ncds_set_dim_subset(CDSDim *dim, size_t start, ptrdiff_t stride)
+{
+    NCDSDimSubset *subset;
+
+    if (dim->is_unlimited || stride <= 0) {
+
+        ERROR( NCDS_LIB_NAME,
+            "Could not set subset for dimension: %s\n"
+            " -> %s\n", dim->name,
+            (dim->is_unlimited) ? "unlimited dimensions can not be subset"
+                                : "stride must be greater than zero");
+
+        return(0);
+    }
+
+    subset = (NCDSDimSubset *)malloc(sizeof(NCDSDimSubset));
+    if (!subset) {
+
+        ERROR( NCDS_LIB_NAME,
+            "Could not set subset for dimension: %s\n"
+            " -> memory allocation error\n", dim->name);
+
+        return(0);
+    }
+
+    subset->start  = start;
+    subset->stride = stride;
+
+    if (!cds_set_user_data(dim, NCDS_DIM_SUBSET_KEY, subset, free)) {
+        free(subset);
+        return(0);
+    }
+
+    return(1);
+}
+
+/**
+ *  Get the subset of a NetCDF dimension that is read into a CDS dimension.
+ *
+ *  @param  dim    - pointer to the CDS dimension
+ *  @param  start  - output: start index along the NetCDF dimension
+ *  @param  stride - output: stride along the NetCDF dimension
+ *
+ *  @return
+ *    - 1 if a subset has been set for the dimension
+ *    - 0 if the whole dimension is read
+ *
+ *  @see ncds_set_dim_subset()
+ */
+int ncds_get_dim_subset(CDSDim *dim, size_t *start, ptrdiff_t *stride)
+{
+    NCDSDimSubset *subset;
+
+    subset = (NCDSDimSubset *)cds_get_user_data(dim, NCDS_DIM_SUBSET_KEY);
+
+    if (!subset) {
+        if (start)  *start  = 0;
+        if (stride) *stride = 1;
+        return(0);
+    }
+
+    if (start)  *start  = subset->start;
+    if (stride) *stride = subset->stride;
+
+    return(1);
+}
+
 /**
  *  Read an attribute definition from a NetCDF group into a CDS group.
  *
@@ -734,6 +836,44 @@ void *ncds_read_var_data(
     size_t *nc_count,
     CDSVar *cds_var,
     size_t  cds_sample_start)
+{
+    return(ncds_read_var_hyperslab(
+        nc_grpid, nc_varid, nc_start, nc_count, NULL,
+        cds_var, cds_sample_start));
+}
+
+/**
+ *  Read a strided hyperslab from a NetCDF variable into a CDS variable.
+ *
+ *  This is the same as ncds_read_var_data() except that a stride can be
+ *  specified for each dimension. Only the requested values are read from
+ *  the file, so this can be used to read a subset of the levels or bins
+ *  of a large multi-dimensional variable without reading the whole thing.
+ *
+ *  Error messages from this function are sent to the message handler
+ *  (see msngr_init_log() and msngr_init_mail()).
+ *
+ *  @param  nc_grpid         - NetCDF group id
+ *  @param  nc_varid         - NetCDF variable id
+ *  @param  nc_start         - NetCDF dimension start indexes
+ *  @param  nc_count         - number of values to read along each dimension
+ *  @param  nc_stride        - stride along each dimension,
+ *                             or NULL for a stride of 1
+ *  @param  cds_var          - pointer to the CDS variable
+ *  @param  cds_sample_start - CDS variable start sample
+ *
+ *  @return
+ *    - pointer to the specifed start sample in the variable's data array
+ *    - NULL if a NetCDF or CDS error occurred
+ */
+void *ncds_read_var_hyperslab(
+    int        nc_grpid,
+    int        nc_varid,
+    size_t    *nc_start,
+    size_t    *nc_count,
+    ptrdiff_t *nc_stride,
+    CDSVar    *cds_var,
+    size_t     cds_sample_start)
 {
     nc_type           nc_var_type;
     CDSDataType       nc_cds_type;
@@ -910,7 +1050,19 @@ void *ncds_read_var_data(
 
     /* Read the data from the NetCDF group */
 
-    status = nc_get_vara(nc_grpid, nc_varid, nc_start, nc_count, nc_datap);
+    if (_ncds_mmap_read(
+        nc_grpid, nc_varid, nc_start, nc_count, nc_stride, nc_datap)) {
+
+        status = NC_NOERR;
+    }
+    else if (nc_stride) {
+        status = nc_get_vars(
+            nc_grpid, nc_varid, nc_start, nc_count, nc_stride, nc_datap);
+    }
+    else {
+        status = nc_get_vara(
+            nc_grpid, nc_varid, nc_start, nc_count, nc_datap);
+    }
 
     if (status != NC_NOERR) {
 
@@ -987,15 +1139,20 @@ void *ncds_read_var_samples(
     CDSVar *cds_var,
     size_t  cds_sample_start)
 {
-    int     ndims;
-    int     dimids[NC_MAX_DIMS];
-    int     dim_index;
-    int     dimid;
-    CDSDim *dim;
-    size_t  dim_length;
-    size_t  start[NC_MAX_DIMS];
-    size_t  count[NC_MAX_DIMS];
-    void   *datap;
+    int        ndims;
+    int        dimids[NC_MAX_DIMS];
+    int        dim_index;
+    int        dimid;
+    CDSDim    *dim;
+    size_t     dim_length;
+    size_t     start[NC_MAX_DIMS];
+    size_t     count[NC_MAX_DIMS];
+    ptrdiff_t  stride[NC_MAX_DIMS];
+    size_t     sub_start;
+    ptrdiff_t  sub_stride;
+    int        is_subset;
+    int        is_strided;
+    void      *datap;
 
     /* Get the number of NetCDF variable dimensions */
 
@@ -1039,7 +1196,9 @@ void *ncds_read_var_samples(
         return((void *)NULL);
     }
 
-    /* Create start and count arrays */
+    /* Create start, count, and stride arrays */
+
+    is_strided = 0;
 
     for (dim_index = 0; dim_index < ndims; dim_index++) {
 
@@ -1052,6 +1211,61 @@ void *ncds_read_var_samples(
             return((void *)NULL);
         }
 
+        /* Check if only a subset of this dimension is being read */
+
+        is_subset = ncds_get_dim_subset(dim, &sub_start, &sub_stride);
+
+        stride[dim_index] = sub_stride;
+        if (sub_stride != 1) is_strided = 1;
+
+        if (is_subset) {
+
+            if (sub_start >= dim_length ||
+                (dim->length &&
+                 sub_start + (dim->length - 1) * sub_stride >= dim_length)) {
+
+                ERROR( NCDS_LIB_NAME,
+                    "Invalid dimension subset\n"
+                    " -> nc_grpid = %d, nc_varid = %d, cds_var = '%s', dim_index = %d\n"
+                    " -> subset start %d, count %d, stride %d exceeds netcdf dim length (%d)\n",
+                    nc_grpid, nc_varid, cds_var->name, dim_index,
+                    (int)sub_start, (int)dim->length, (int)sub_stride,
+                    (int)dim_length);
+
+                return((void *)NULL);
+            }
+
+            if (dim_index == 0) {
+
+                /* The variable samples are the subset indexes */
+
+                if (cds_sample_start >= dim->length ||
+                    nc_sample_start  >= dim->length) {
+
+                    ERROR( NCDS_LIB_NAME,
+                        "Invalid start sample for subset dimension\n"
+                        " -> var_name = '%s', dim_name = '%s'\n"
+                        " -> start sample >= subset length (%d)\n",
+                        cds_var->name, dim->name, (int)dim->length);
+
+                    return((void *)NULL);
+                }
+
+                start[dim_index] = sub_start + nc_sample_start * sub_stride;
+                count[dim_index] = dim->length - nc_sample_start;
+
+                if (count[dim_index] > dim->length - cds_sample_start) {
+                    count[dim_index] = dim->length - cds_sample_start;
+                }
+            }
+            else {
+                start[dim_index] = sub_start;
+                count[dim_index] = dim->length;
+            }
+
+            continue;
+        }
+
         if (dim_index == 0) {
 
             if (nc_sample_start >= dim_length) {
@@ -1124,8 +1338,9 @@ void *ncds_read_var_samples(
 
     /* Read in the data */
 
-    datap = ncds_read_var_data(
-        nc_grpid, nc_varid, start, count, cds_var, cds_sample_start);
+    datap = ncds_read_var_hyperslab(
+        nc_grpid, nc_varid, start, count, (is_strided) ? stride : NULL,
+        cds_var, cds_sample_start);
 
     return(datap);
 }
@@ -359,6 +359,725 @@ NETCDF_ERROR:
     return(0);
 }
 
+/*******************************************************************************
+ *  Write Planner
+ */
+
+/** Maximum total chunk cache size the write planner will set for a plan. */
+#define NCDS_WRITE_CACHE_BUDGET  (256 * 1024 * 1024)
+
+/**
+ *  Variable in a write plan.
+ */
+typedef struct {
+
+    CDSVar *var;          /**< pointer to the CDS variable                */
+    int     varid;        /**< NetCDF variable id                         */
+
+    int     cache_changed; /**< 1 if the plan changed the chunk cache     */
+    size_t  cache_size;    /**< original chunk cache size                 */
+    size_t  cache_nelems;  /**< original number of chunk cache slots      */
+    float   preemption;    /**< original chunk cache preemption           */
+
+} NCWriteItem;
+
+/**
+ *  Conversion buffer shared by the variables written by a write plan.
+ */
+static struct {
+
+    void   *data;    /**< conversion buffer                       */
+    size_t  size;    /**< size of the conversion buffer           */
+    int     depth;   /**< number of write plans currently running */
+
+} _WriteArena;
+
+/**
+ *  PRIVATE: Start a write plan.
+ *
+ *  While a write plan is running the conversion buffer used by
+ *  ncds_write_var_data() is kept and reused for the next variable.
+ */
+static void _ncds_begin_write_plan(void)
+{
+    _WriteArena.depth += 1;
+}
+
+/**
+ *  PRIVATE: Finish a write plan.
+ *
+ *  The conversion buffer is freed when the outermost write plan finishes.
+ */
+static void _ncds_end_write_plan(void)
+{
+    if (--_WriteArena.depth > 0) return;
+
+    if (_WriteArena.data) free(_WriteArena.data);
+
+    _WriteArena.data  = (void *)NULL;
+    _WriteArena.size  = 0;
+    _WriteArena.depth = 0;
+}
+
+/**
+ *  PRIVATE: Get a buffer for the converted variable data.
+ *
+ *  @param  size - required size of the buffer
+ *
+ *  @return
+ *    - pointer to the buffer
+ *    - NULL if a memory allocation error occurred
+ */
+static void *_ncds_get_write_buffer(size_t size)
+{
+    if (!_WriteArena.depth) {
+        return(malloc(size));
+    }
+
+    if (size > _WriteArena.size) {
+
+        if (_WriteArena.data) free(_WriteArena.data);
+
+        _WriteArena.size = size + (size >> 2);
+        _WriteArena.data = malloc(_WriteArena.size);
+
+        if (!_WriteArena.data) {
+            _WriteArena.size = 0;
+        }
+    }
+
+    return(_WriteArena.data);
+}
+
+/**
+ *  PRIVATE: Release a buffer returned by _ncds_get_write_buffer().
+ *
+ *  @param  buffer - pointer to the buffer
+ */
+static void _ncds_release_write_buffer(void *buffer)
+{
+    if (buffer != _WriteArena.data) free(buffer);
+}
+
+/**
+ *  PRIVATE: Compare two write plan items by NetCDF variable id.
+ */
+static int _ncds_compare_write_items(const void *p1, const void *p2)
+{
+    const NCWriteItem *i1 = (const NCWriteItem *)p1;
+    const NCWriteItem *i2 = (const NCWriteItem *)p2;
+
+    return((i1->varid > i2->varid) - (i1->varid < i2->varid));
+}
+
+/**
+ *  PRIVATE: Get the chunk cache size a NetCDF-4 variable needs for a write.
+ *
+ *  The chunk cache needs to be large enough to hold all the chunks that
+ *  are only partially written by one ncds_write_var_data() call, so they
+ *  do not have to be read back from disk by the next write. For record
+ *  variables this is one row of chunks along the unlimited dimension,
+ *  for static variables it is the entire variable.
+ *
+ *  The current chunk cache settings of the variable are saved in the
+ *  write plan item.
+ *
+ *  @param  nc_grpid   - NetCDF group id
+ *  @param  item       - pointer to the write plan item
+ *  @param  chunk_size - output: size of one chunk in bytes
+ *
+ *  @return
+ *    - chunk cache size needed, in bytes
+ *    - 0 if the variable is not chunked or already has a large enough cache
+ */
+static size_t _ncds_chunk_cache_needed(
+    int          nc_grpid,
+    NCWriteItem *item,
+    size_t      *chunk_size)
+{
+    CDSVar  *var = item->var;
+    size_t   chunks[NC_MAX_VAR_DIMS];
+    size_t   nchunks;
+    size_t   length;
+    size_t   cache_size;
+    nc_type  nc_var_type;
+    int      storage;
+    int      di;
+
+    if (var->ndims == 0 || var->ndims > NC_MAX_VAR_DIMS) return(0);
+
+    if (nc_inq_var_chunking(
+        nc_grpid, item->varid, &storage, chunks) != NC_NOERR ||
+        storage != NC_CHUNKED) {
+
+        return(0);
+    }
+
+    if (nc_inq_vartype(nc_grpid, item->varid, &nc_var_type) != NC_NOERR) {
+        return(0);
+    }
+
+    *chunk_size = cds_data_type_size(ncds_cds_type(nc_var_type));
+    nchunks     = 1;
+
+    for (di = 0; di < var->ndims; ++di) {
+
+        if (!chunks[di]) return(0);
+
+        *chunk_size *= chunks[di];
+
+        if (di == 0 && var->dims[0]->is_unlimited) continue;
+
+        length   = (di == 0) ? var->sample_count : var->dims[di]->length;
+        nchunks *= (length) ? (length + chunks[di] - 1) / chunks[di] : 1;
+    }
+
+    if (!*chunk_size) return(0);
+
+    cache_size = (nchunks > NCDS_WRITE_CACHE_BUDGET / *chunk_size)
+               ? NCDS_WRITE_CACHE_BUDGET : nchunks * *chunk_size;
+
+    if (nc_get_var_chunk_cache(nc_grpid, item->varid,
+        &item->cache_size, &item->cache_nelems,
+        &item->preemption) != NC_NOERR) {
+
+        return(0);
+    }
+
+    if (cache_size <= item->cache_size) {
+        return(0);
+    }
+
+    return(cache_size);
+}
+
+/**
+ *  PRIVATE: Size the chunk caches of the variables in a NetCDF-4 write plan.
+ *
+ *  Each variable gets the chunk cache size returned by
+ *  _ncds_chunk_cache_needed(), unless the total for the plan would exceed
+ *  NCDS_WRITE_CACHE_BUDGET bytes. In that case the budget is split across
+ *  the variables in proportion to the sizes they need, and variables whose
+ *  share is less than one chunk keep their current chunk cache. The chunk
+ *  caches are restored by _ncds_restore_chunk_caches() when the plan is
+ *  finished.
+ *
+ *  @param  nc_grpid - NetCDF group id
+ *  @param  plan     - pointer to the array of write plan items
+ *  @param  nitems   - number of items in the write plan
+ */
+static void _ncds_size_chunk_caches(
+    int          nc_grpid,
+    NCWriteItem *plan,
+    int          nitems)
+{
+    size_t *needed;
+    size_t *chunk_sizes;
+    size_t  total;
+    size_t  cache_size;
+    size_t  cache_nelems;
+    size_t  nchunks;
+    double  scale;
+    int     index;
+
+    needed = (size_t *)calloc(2 * nitems, sizeof(size_t));
+    if (!needed) return;
+
+    chunk_sizes = needed + nitems;
+
+    total = 0;
+
+    for (index = 0; index < nitems; index++) {
+
+        plan[index].cache_changed = 0;
+
+        needed[index] = _ncds_chunk_cache_needed(
+            nc_grpid, &plan[index], &chunk_sizes[index]);
+
+        total += needed[index];
+    }
+
+    scale = (total > NCDS_WRITE_CACHE_BUDGET)
+          ? (double)NCDS_WRITE_CACHE_BUDGET / (double)total : 1.0;
+
+    for (index = 0; index < nitems; index++) {
+
+        if (!needed[index]) continue;
+
+        cache_size = (size_t)(needed[index] * scale);
+
+        if (cache_size < chunk_sizes[index] ||
+            cache_size <= plan[index].cache_size) {
+
+            continue;
+        }
+
+        /* HDF5 recommends about 100 hash table slots per cached chunk */
+
+        nchunks      = cache_size / chunk_sizes[index];
+        cache_nelems = plan[index].cache_nelems;
+
+        if (cache_nelems < nchunks * 100 + 1) {
+            cache_nelems = nchunks * 100 + 1;
+        }
+
+        if (nc_set_var_chunk_cache(
+            nc_grpid, plan[index].varid, cache_size, cache_nelems,
+            plan[index].preemption) == NC_NOERR) {
+
+            plan[index].cache_changed = 1;
+        }
+    }
+
+    free(needed);
+}
+
+/**
+ *  PRIVATE: Restore the chunk caches changed by a NetCDF-4 write plan.
+ *
+ *  Setting the chunk cache flushes the cached chunks of the variable,
+ *  so the memory used by the larger caches is released as soon as the
+ *  write plan is finished.
+ *
+ *  @param  nc_grpid - NetCDF group id
+ *  @param  plan     - pointer to the array of write plan items
+ *  @param  nitems   - number of items in the write plan
+ */
+static void _ncds_restore_chunk_caches(
+    int          nc_grpid,
+    NCWriteItem *plan,
+    int          nitems)
+{
+    int index;
+
+    for (index = 0; index < nitems; index++) {
+
+        if (!plan[index].cache_changed) continue;
+
+        nc_set_var_chunk_cache(
+            nc_grpid, plan[index].varid, plan[index].cache_size,
+            plan[index].cache_nelems, plan[index].preemption);
+
+        plan[index].cache_changed = 0;
+    }
+}
+
+/**
+ *  PRIVATE: Create a write plan for the variables in a CDS group.
+ *
+ *  The write plan contains the variables that have data and are defined
+ *  in both the CDS and NetCDF groups, sorted by NetCDF variable id. This
+ *  is the order the variables are laid out in NetCDF-3 files and the
+ *  order the datasets are created in NetCDF-4 files. For NetCDF-4 files
+ *  the chunk caches of the variables are also sized for the write, and
+ *  must be restored with _ncds_restore_chunk_caches() when the writes
+ *  are done.
+ *
+ *  The memory used by the returned array is dynamically allocated and
+ *  must be freed by the calling process.
+ *
+ *  @param  cds_group   - pointer to the CDS group
+ *  @param  nc_grpid    - NetCDF group id
+ *  @param  record_vars - 1 = plan the record variables,
+ *                        0 = plan the static variables
+ *  @param  items       - output: pointer to the array of write plan items
+ *
+ *  @return
+ *    - number of variables in the write plan
+ *    - -1 if a NetCDF error or memory allocation error occurred
+ */
+static int _ncds_plan_writes(
+    CDSGroup     *cds_group,
+    int           nc_grpid,
+    int           record_vars,
+    NCWriteItem **items)
+{
+    NCWriteItem *plan;
+    CDSVar      *var;
+    int          nitems;
+    int          is_record;
+    int          format;
+    int          index;
+    int          status;
+    int          varid;
+
+    *items = (NCWriteItem *)NULL;
+
+    if (!cds_group->nvars) return(0);
+
+    plan = (NCWriteItem *)malloc(cds_group->nvars * sizeof(NCWriteItem));
+    if (!plan) {
+
+        ERROR( NCDS_LIB_NAME,
+            "Could not create write plan for group: %s\n"
+            " -> memory allocation error\n",
+            cds_group->name);
+
+        return(-1);
+    }
+
+    nitems = 0;
+
+    for (index = 0; index < cds_group->nvars; index++) {
+
+        var = cds_group->vars[index];
+
+        if (!var->sample_count) continue;
+
+        is_record = (var->ndims && var->dims[0]->is_unlimited) ? 1 : 0;
+        if (is_record != record_vars) continue;
+
+        status = ncds_inq_varid(nc_grpid, var->name, &varid);
+
+        if (status == 1) {
+            plan[nitems].var           = var;
+            plan[nitems].varid         = varid;
+            plan[nitems].cache_changed = 0;
+            nitems += 1;
+        }
+        else if (status < 0) {
+            free(plan);
+            return(-1);
+        }
+    }
+
+    if (nitems > 1) {
+        qsort(plan, nitems, sizeof(NCWriteItem), _ncds_compare_write_items);
+    }
+
+    if (nc_inq_format(nc_grpid, &format) == NC_NOERR &&
+        (format == NC_FORMAT_NETCDF4 || format == NC_FORMAT_NETCDF4_CLASSIC)) {
+
+        _ncds_size_chunk_caches(nc_grpid, plan, nitems);
+    }
+
+    *items = plan;
+
+    return(nitems);
+}
+
+/*******************************************************************************
+ *  Storage Policy
+ */
+
+/** Target size of the chunks created by the storage policy. */
+#define NCDS_CHUNK_BYTES        (1024 * 1024)
+
+/** Minimum size of the floating point variables the storage policy deflates. */
+#define NCDS_DEFLATE_MIN_BYTES  (64 * 1024)
+
+/** Minimum number of records in a chunk when the expected number is not known. */
+#define NCDS_MIN_CHUNK_RECORDS  1024
+
+/**
+ *  PRIVATE: Apply the storage policy to a NetCDF-4 variable.
+ *
+ *  Chunk shapes are only set for variables with an unlimited first
+ *  dimension and without a _ChunkSizes attribute, and deflate is only
+ *  enabled for variables without a _DeflateLevel attribute. The record
+ *  dimension of a chunk is capped at the expected number of records in
+ *  the file so small files do not get mostly empty chunks. If that is not
+ *  known, the length of the CDS unlimited dimension is used, but never
+ *  less than NCDS_MIN_CHUNK_RECORDS, because later appends to the file
+ *  keep the chunk shape.
+ *
+ *  @param  cds_var  - pointer to the CDS variable
+ *  @param  nc_grpid - NetCDF group id
+ *  @param  nc_varid - NetCDF variable id
+ *  @param  policy   - pointer to the storage policy, or NULL
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if a NetCDF error occurred
+ */
+static int _ncds_apply_storage_policy(
+    CDSVar                  *cds_var,
+    int                      nc_grpid,
+    int                      nc_varid,
+    const NCDSStoragePolicy *policy)
+{
+    size_t  chunks[NC_MAX_VAR_DIMS];
+    size_t  type_size;
+    size_t  max_elems;
+    size_t  nrecs;
+    size_t  length;
+    size_t  inner;
+    size_t  nbytes;
+    int     format;
+    int     status;
+    int     di;
+
+    if (!policy || !policy->flags || cds_var->ndims == 0) return(1);
+
+    status = nc_inq_format(nc_grpid, &format);
+    if (status != NC_NOERR) goto NETCDF_ERROR;
+
+    if (format != NC_FORMAT_NETCDF4 &&
+        format != NC_FORMAT_NETCDF4_CLASSIC) {
+
+        return(1);
+    }
+
+    type_size = cds_data_type_size(cds_var->type);
+    max_elems = NCDS_CHUNK_BYTES / type_size;
+
+    if (policy->nrecords) {
+        nrecs = policy->nrecords;
+    }
+    else {
+        nrecs = cds_var->dims[0]->length;
+        if (nrecs < NCDS_MIN_CHUNK_RECORDS) nrecs = NCDS_MIN_CHUNK_RECORDS;
+    }
+
+    /* Chunk shapes */
+
+    if ((policy->flags & (NCDS_CHUNK_TIME_SERIES | NCDS_CHUNK_PROFILES)) &&
+        cds_var->dims[0]->is_unlimited &&
+        !cds_get_att(cds_var, "_ChunkSizes")) {
+
+        inner = 1;
+
+        for (di = cds_var->ndims - 1; di > 0; --di) {
+
+            length = cds_var->dims[di]->length;
+            if (!length) length = 1;
+
+            if (policy->flags & NCDS_CHUNK_PROFILES) {
+                chunks[di] = max_elems / inner;
+                if (chunks[di] < 1)      chunks[di] = 1;
+                if (chunks[di] > length) chunks[di] = length;
+            }
+            else {
+                chunks[di] = 1;
+            }
+
+            inner *= chunks[di];
+        }
+
+        chunks[0] = max_elems / inner;
+        if (chunks[0] < 1)     chunks[0] = 1;
+        if (chunks[0] > nrecs) chunks[0] = nrecs;
+
+        status = nc_def_var_chunking(nc_grpid, nc_varid, NC_CHUNKED, chunks);
+        if (status != NC_NOERR) goto NETCDF_ERROR;
+    }
+
+    /* Compression */
+
+    if ((policy->flags & NCDS_DEFLATE_FLOATS) &&
+        (cds_var->type == CDS_FLOAT || cds_var->type == CDS_DOUBLE) &&
+        !cds_get_att(cds_var, "_DeflateLevel")) {
+
+        nbytes = type_size;
+
+        for (di = 0; di < cds_var->ndims; ++di) {
+            length  = (di == 0) ? nrecs : cds_var->dims[di]->length;
+            nbytes *= length;
+        }
+
+        if (nbytes >= NCDS_DEFLATE_MIN_BYTES) {
+
+            status = nc_def_var_deflate(
+                nc_grpid, nc_varid, 1, 1, policy->deflate_level);
+
+            if (status != NC_NOERR) goto NETCDF_ERROR;
+        }
+    }
+
+    return(1);
+
+NETCDF_ERROR:
+
+    ERROR( NCDS_LIB_NAME,
+        "Could not apply storage policy to variable\n"
+        " -> nc_grpid = %d, var_name = '%s'\n"
+        " -> %s\n",
+        nc_grpid, cds_var->name, nc_strerror(status));
+
+    return(0);
+}
+
+/**
+ *  PRIVATE: Write a variable definition from a CDS group into a NetCDF group.
+ *
+ *  This function will define any dimensions used by the variable
+ *  that have not already been defined. It will also define all
+ *  the variable attributes.
+ *
+ *  Error messages from this function are sent to the message
+ *  handler (see msngr_init_log() and msngr_init_mail()).
+ *
+ *  @param  cds_var  - pointer to the CDS variable
+ *  @param  nc_grpid - NetCDF group id
+ *  @param  nc_varid - output: the NetCDF variable id if not NULL
+ *  @param  policy   - pointer to the storage policy to apply to NetCDF-4
+ *                     variables, or NULL to use the NetCDF library defaults
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if a NetCDF error occurred
+ */
+int _ncds_write_var(
+    CDSVar                  *cds_var,
+    int                      nc_grpid,
+    int                     *nc_varid,
+    const NCDSStoragePolicy *policy)
+{
+    int      status;
+    int      dim_index;
+    CDSDim  *dim;
+    int      dimids[NC_MAX_DIMS];
+    nc_type  nctype;
+    int      varid;
+    int      attid;
+
+    if (nc_varid) {
+        *nc_varid = -1;
+    }
+
+    /* Create the dimids array */
+
+    for (dim_index = 0; dim_index < cds_var->ndims; dim_index++) {
+
+        dim = cds_var->dims[dim_index];
+
+        /* Make sure the dimension is defined in the NetCDF file */
+
+        status = ncds_inq_dimid(nc_grpid, dim->name, &dimids[dim_index]);
+        if (status == 0) {
+            if (!ncds_write_dim(dim, nc_grpid, &dimids[dim_index])) {
+                return(0);
+            }
+        }
+        else if (status < 0) {
+            return(0);
+        }
+    }
+
+    /* Define the variable in the NetCDF group */
+
+    nctype = ncds_nc_type(cds_var->type);
+
+    status = nc_def_var(
+        nc_grpid, cds_var->name, nctype, cds_var->ndims, dimids, &varid);
+
+    if (status != NC_NOERR) {
+
+        ERROR( NCDS_LIB_NAME,
+            "Could not define variable\n"
+            " -> nc_grpid = %d, var_name = '%s'\n"
+            " -> %s\n",
+            nc_grpid, cds_var->name, nc_strerror(status));
+
+        return(0);
+    }
+
+    if (nc_varid) {
+        *nc_varid = varid;
+    }
+
+    /* Set the chunking and compression from the storage policy */
+
+    if (!_ncds_apply_storage_policy(cds_var, nc_grpid, varid, policy)) {
+        return(0);
+    }
+
+    /* Define the variable attributes */
+
+    for (attid = 0; attid < cds_var->natts; attid++) {
+        if (!_ncds_write_att(cds_var->atts[attid], nc_grpid, varid)) {
+            return(0);
+        }
+    }
+
+    return(1);
+}
+
+/**
+ *  PRIVATE: Write a CDS group definition into a NetCDF group.
+ *
+ *  This function will write out all dimension, attribute, and variable
+ *  definitions from a CDS group into a NetCDF group.  It will also recurse
+ *  into subgroups if recursive is TRUE.
+ *
+ *  Error messages from this function are sent to the message
+ *  handler (see msngr_init_log() and msngr_init_mail()).
+ *
+ *  @param  cds_group - pointer to the CDS group
+ *  @param  nc_grpid  - NetCDF group id
+ *  @param  recursive - recurse into subroups (1 = TRUE, 0 = FALSE)
+ *  @param  policy    - pointer to the storage policy to apply to NetCDF-4
+ *                      variables, or NULL to use the NetCDF library defaults
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if a NetCDF error occurred
+ */
+int _ncds_write_group(
+    CDSGroup                *cds_group,
+    int                      nc_grpid,
+    int                      recursive,
+    const NCDSStoragePolicy *policy)
+{
+    int       status;
+    int       index;
+    int       id;
+    int       subgrpid;
+    CDSGroup *subgroup;
+
+    /* Write dimensions */
+
+    for (index = 0; index < cds_group->ndims; index++) {
+        if (!ncds_write_dim(cds_group->dims[index], nc_grpid, &id)) {
+            return(0);
+        }
+    }
+
+    /* Write attributes */
+
+    for (index = 0; index < cds_group->natts; index++) {
+        if (!ncds_write_att(cds_group->atts[index], nc_grpid)) {
+            return(0);
+        }
+    }
+
+    /* Write variables */
+
+    for (index = 0; index < cds_group->nvars; index++) {
+        if (!_ncds_write_var(cds_group->vars[index], nc_grpid, &id, policy)) {
+            return(0);
+        }
+    }
+
+    /* Write subgroups */
+
+    if (recursive) {
+
+        for (index = 0; index < cds_group->ngroups; index++) {
+
+            subgroup = cds_group->groups[index];
+
+            status = nc_def_grp(nc_grpid, subgroup->name, &subgrpid);
+            if (status != NC_NOERR) {
+
+                ERROR( NCDS_LIB_NAME,
+                    "Could not define group\n"
+                    " -> nc_grpid = %d, group_name = '%s'\n"
+                    " -> %s\n",
+                    nc_grpid, subgroup->name, nc_strerror(status));
+
+                return(0);
+            }
+
+            if (!_ncds_write_group(subgroup, subgrpid, recursive, policy)) {
+                return(0);
+            }
+        }
+    }
+
+    return(1);
+}
+
 /*******************************************************************************
  *  Public Functions
  */
@@ -406,6 +1125,62 @@ int ncds_create_file(
     int         cmode,
     int         recursive,
     int         header_only)
+{
+    return(ncds_create_file_with_policy(
+        cds_group, nc_file, cmode, recursive, header_only, NULL));
+}
+
+/**
+ *  Create a new NetCDF file using a NetCDF-4 storage policy.
+ *
+ *  This function is the same as ncds_create_file() except that the
+ *  specified storage policy is used to set the chunking and compression
+ *  of the variables in NetCDF-4 files. The storage policy is ignored for
+ *  all other file formats, and the _ChunkSizes and _DeflateLevel
+ *  attributes of a variable take precedence over it. Possible flags
+ *  include:
+ *
+ *    - NCDS_CHUNK_TIME_SERIES = Use chunks that span as many records as
+ *                               possible and one value along all other
+ *                               dimensions, so the time series of a
+ *                               single value can be read efficiently.
+ *
+ *    - NCDS_CHUNK_PROFILES    = Use chunks that span the full length of
+ *                               all other dimensions, so complete samples
+ *                               (i.e. profiles) can be read efficiently.
+ *
+ *    - NCDS_DEFLATE_FLOATS    = Enable the shuffle filter and deflate
+ *                               compression for float and double
+ *                               variables larger than 64 KiB.
+ *
+ *  If both chunking flags are set NCDS_CHUNK_PROFILES is used. Chunk
+ *  shapes are only set for variables with an unlimited first dimension,
+ *  and chunks are limited to about 1 MiB. The nrecords member should be
+ *  set to the number of records the file is expected to hold when it is
+ *  complete, so the chunks still fit the data after later appends.
+ *
+ *  Error messages from this function are sent to the message
+ *  handler (see msngr_init_log() and msngr_init_mail()).
+ *
+ *  @param  cds_group   - pointer to the CDS group
+ *  @param  nc_file     - full path to the NetCDF file
+ *  @param  cmode       - creation mode flag (see ncds_create_file())
+ *  @param  recursive   - recurse into all subroups (1 = TRUE, 0 = FALSE)
+ *  @param  header_only - only write out the NetCDF header (1 = TRUE, 0 = FALSE)
+ *  @param  policy      - pointer to the storage policy, or NULL to use
+ *                        the NetCDF library defaults
+ *
+ *  @return
+ *    - NetCDF id of the root group in the file
+ *    - 0 if an error occurred
+ */
+int ncds_create_file_with_policy(
+    CDSGroup                *cds_group,
+    const char              *nc_file,
+    int                      cmode,
+    int                      recursive,
+    int                      header_only,
+    const NCDSStoragePolicy *policy)
 {
     int     ncid;
     char   *nc_dir;
@@ -487,7 +1262,7 @@ int ncds_create_file(
 
     /* Write the NetCDF header */
 
-    if (!ncds_write_group(cds_group, ncid, recursive)) {
+    if (!_ncds_write_group(cds_group, ncid, recursive, policy)) {
         ncds_close(ncid);
         unlink(nc_file);
         return(0);
@@ -685,68 +1460,7 @@ int ncds_write_var(
     int     nc_grpid,
     int    *nc_varid)
 {
-    int      status;
-    int      dim_index;
-    CDSDim  *dim;
-    int      dimids[NC_MAX_DIMS];
-    nc_type  nctype;
-    int      varid;
-    int      attid;
-
-    if (nc_varid) {
-        *nc_varid = -1;
-    }
-
-    /* Create the dimids array */
-
-    for (dim_index = 0; dim_index < cds_var->ndims; dim_index++) {
-
-        dim = cds_var->dims[dim_index];
-
-        /* Make sure the dimension is defined in the NetCDF file */
-
-        status = ncds_inq_dimid(nc_grpid, dim->name, &dimids[dim_index]);
-        if (status == 0) {
-            if (!ncds_write_dim(dim, nc_grpid, &dimids[dim_index])) {
-                return(0);
-            }
-        }
-        else if (status < 0) {
-            return(0);
-        }
-    }
-
-    /* Define the variable in the NetCDF group */
-
-    nctype = ncds_nc_type(cds_var->type);
-
-    status = nc_def_var(
-        nc_grpid, cds_var->name, nctype, cds_var->ndims, dimids, &varid);
-
-    if (status != NC_NOERR) {
-
-        ERROR( NCDS_LIB_NAME,
-            "Could not define variable\n"
-            " -> nc_grpid = %d, var_name = '%s'\n"
-            " -> %s\n",
-            nc_grpid, cds_var->name, nc_strerror(status));
-
-        return(0);
-    }
-
-    if (nc_varid) {
-        *nc_varid = varid;
-    }
-
-    /* Define the variable attributes */
-
-    for (attid = 0; attid < cds_var->natts; attid++) {
-        if (!_ncds_write_att(cds_var->atts[attid], nc_grpid, varid)) {
-            return(0);
-        }
-    }
-
-    return(1);
+    return(_ncds_write_var(cds_var, nc_grpid, nc_varid, NULL));
 }
 
 /**
@@ -805,63 +1519,7 @@ int ncds_write_group(
     int       nc_grpid,
     int       recursive)
 {
-    int       status;
-    int       index;
-    int       id;
-    int       subgrpid;
-    CDSGroup *subgroup;
-
-    /* Write dimensions */
-
-    for (index = 0; index < cds_group->ndims; index++) {
-        if (!ncds_write_dim(cds_group->dims[index], nc_grpid, &id)) {
-            return(0);
-        }
-    }
-
-    /* Write attributes */
-
-    for (index = 0; index < cds_group->natts; index++) {
-        if (!ncds_write_att(cds_group->atts[index], nc_grpid)) {
-            return(0);
-        }
-    }
-
-    /* Write variables */
-
-    for (index = 0; index < cds_group->nvars; index++) {
-        if (!ncds_write_var(cds_group->vars[index], nc_grpid, &id)) {
-            return(0);
-        }
-    }
-
-    /* Write subgroups */
-
-    if (recursive) {
-
-        for (index = 0; index < cds_group->ngroups; index++) {
-
-            subgroup = cds_group->groups[index];
-
-            status = nc_def_grp(nc_grpid, subgroup->name, &subgrpid);
-            if (status != NC_NOERR) {
-
-                ERROR( NCDS_LIB_NAME,
-                    "Could not define group\n"
-                    " -> nc_grpid = %d, group_name = '%s'\n"
-                    " -> %s\n",
-                    nc_grpid, subgroup->name, nc_strerror(status));
-
-                return(0);
-            }
-
-            if (!ncds_write_group(subgroup, subgrpid, recursive)) {
-                return(0);
-            }
-        }
-    }
-
-    return(1);
+    return(_ncds_write_group(cds_group, nc_grpid, recursive, NULL));
 }
 
 /**
@@ -1040,7 +1698,7 @@ int ncds_write_var_data(
 
         length = cds_sample_count * cds_sample_size;
 
-        nc_datap = malloc(length * nc_type_size);
+        nc_datap = _ncds_get_write_buffer(length * nc_type_size);
 
         if (!nc_datap) {
 
@@ -1080,7 +1738,7 @@ int ncds_write_var_data(
     if (cds_nmv)   free(cds_mv);
     if (nc_nmv)    free(nc_mv);
 
-    if (nc_datap != cds_datap) free(nc_datap);
+    if (nc_datap != cds_datap) _ncds_release_write_buffer(nc_datap);
 
     if (status != NC_NOERR) {
 
@@ -1313,32 +1971,36 @@ int ncds_write_static_data(
     CDSGroup *cds_group,
     int       nc_grpid)
 {
-    CDSVar *var;
-    int     index;
-    int     status;
-    int     varid;
+    NCWriteItem *plan;
+    int          nitems;
+    int          index;
+    int          retval;
+
+    nitems = _ncds_plan_writes(cds_group, nc_grpid, 0, &plan);
+    if (nitems <= 0) {
+        return((nitems == 0) ? 1 : 0);
+    }
 
-    for (index = 0; index < cds_group->nvars; index++) {
+    _ncds_begin_write_plan();
 
-        var = cds_group->vars[index];
+    retval = 1;
 
-        if (var->sample_count &&
-           (var->ndims == 0 || var->dims[0]->is_unlimited == 0)) {
+    for (index = 0; index < nitems; index++) {
 
-            status = ncds_inq_varid(nc_grpid, var->name, &varid);
+        if (!ncds_write_var_samples(
+            plan[index].var, 0, nc_grpid, plan[index].varid, 0, NULL)) {
 
-            if (status == 1) {
-                if (!ncds_write_var_samples(var, 0, nc_grpid, varid, 0, NULL)) {
-                    return(0);
-                }
-            }
-            else if (status < 0) {
-                return(0);
-            }
+            retval = 0;
+            break;
         }
     }
 
-    return(1);
+    _ncds_end_write_plan();
+    _ncds_restore_chunk_caches(nc_grpid, plan, nitems);
+
+    free(plan);
+
+    return(retval);
 }
 
 /**
@@ -1371,40 +2033,40 @@ int ncds_write_records(
     size_t    nc_record_start,
     size_t    record_count)
 {
-    CDSVar *var;
-    int     index;
-    int     status;
-    int     varid;
-    size_t  count;
-
-    for (index = 0; index < cds_group->nvars; index++) {
-
-        var = cds_group->vars[index];
+    NCWriteItem *plan;
+    int          nitems;
+    int          index;
+    int          retval;
+    size_t       count;
+
+    nitems = _ncds_plan_writes(cds_group, nc_grpid, 1, &plan);
+    if (nitems <= 0) {
+        return((nitems == 0) ? 1 : 0);
+    }
 
-        if (var->sample_count &&
-            var->ndims        &&
-            var->dims[0]->is_unlimited) {
+    _ncds_begin_write_plan();
 
-            status = ncds_inq_varid(nc_grpid, var->name, &varid);
+    retval = 1;
 
-            if (status == 1) {
+    for (index = 0; index < nitems; index++) {
 
-                count = record_count;
+        count = record_count;
 
-                if (!ncds_write_var_samples(
-                    var, cds_record_start,
-                    nc_grpid, varid, nc_record_start, &count)) {
+        if (!ncds_write_var_samples(
+            plan[index].var, cds_record_start,
+            nc_grpid, plan[index].varid, nc_record_start, &count)) {
 
-                    return(0);
-                }
-            }
-            else if (status < 0) {
-                return(0);
-            }
+            retval = 0;
+            break;
         }
     }
 
-    return(1);
+    _ncds_end_write_plan();
+    _ncds_restore_chunk_caches(nc_grpid, plan, nitems);
+
+    free(plan);
+
+    return(retval);
 }
 
 /**
@@ -1442,15 +2104,22 @@ int ncds_write_group_data(
     int       status;
     CDSGroup *subgroup;
     int       subgrpid;
+    int       retval;
+
+    /* Share the conversion buffer with all variables in all groups */
+
+    _ncds_begin_write_plan();
+
+    retval = 0;
 
     if (!ncds_write_static_data(cds_group, nc_grpid)) {
-        return(0);
+        goto RETURN;
     }
 
     if (!ncds_write_records(
         cds_group, cds_record_start, nc_grpid, nc_record_start, record_count)) {
 
-        return(0);
+        goto RETURN;
     }
 
     if (recursive) {
@@ -1466,14 +2135,20 @@ int ncds_write_group_data(
                     subgroup, cds_record_start, subgrpid, nc_record_start,
                     record_count, recursive)) {
 
-                    return(0);
+                    goto RETURN;
                 }
             }
             else if (status < 0) {
-                return(0);
+                goto RETURN;
             }
         }
     }
 
-    return(1);
+    retval = 1;
+
+RETURN:
+
+    _ncds_end_write_plan();
+
+    return(retval);
 }
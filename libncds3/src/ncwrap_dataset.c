@@ -28,6 +28,7 @@
  */
 
 #include "ncds3.h"
+#include "ncds_private.h"
 
 /*******************************************************************************
  *  Private Functions
@@ -53,7 +54,11 @@
  */
 int ncds_close(int ncid)
 {
-    int status = nc_close(ncid);
+    int status;
+
+    _ncds_mmap_unregister(ncid);
+
+    status = nc_close(ncid);
 
     if (status != NC_NOERR) {
 
@@ -222,6 +227,10 @@ int ncds_open(const char *file, int omode, int *ncid)
         return(0);
     }
 
+    if (!(omode & NC_WRITE)) {
+        _ncds_mmap_register(*ncid, file);
+    }
+
     return(1);
 }
 
@@ -0,0 +1,383 @@
+/*******************************************************************************
+*
+*  COPYRIGHT (C) 2016 Battelle Memorial Institute.  All Rights Reserved.
+*
+********************************************************************************
+*
+*  Author:
+*     name:  Brian Ermold
+*     phone: (509) 375-2277
+*     email: brian.ermold@pnl.gov
+*
+********************************************************************************
+*
+*  REPOSITORY INFORMATION:
+*    $Revision$
+*    $Author$
+*    $Date$
+*
+********************************************************************************
+*
+*  NOTE: DOXYGEN is used to generate documentation for this file.
+*
+*******************************************************************************/
+
+/** @file ncds_write_roundtrip.c
+ *  NetCDF write round-trip test.
+ *
+ *  This writes a CDS group with record and static variables to a NetCDF
+ *  file in several calls to ncds_write_group_data(), with the CDS data
+ *  types different from the NetCDF data types so the values have to be
+ *  converted, and then reads the file back with the NetCDF library and
+ *  checks every value. For NetCDF-4 files it also checks that the chunk
+ *  caches changed by the write planner are restored afterwards, including
+ *  caches that were originally set to 0 bytes.
+ *
+ *  It is not part of the build. To run it:
+ *
+ *    cc -o ncds_write_roundtrip ncds_write_roundtrip.c -I$PREFIX/include \
+ *       -L$PREFIX/lib -lncds3 -lcds3 -larmutils -lmsngr -lnetcdf -lm
+ *
+ *    ./ncds_write_roundtrip [output directory]
+ *
+ *  The exit value is 0 if all checks pass.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ncds3.h"
+
+/** Number of data variables in the test group. */
+#define TEST_NVARS     20
+
+/** Number of records written to the test file. */
+#define TEST_NRECORDS  1000
+
+/** Number of records written by each call to ncds_write_group_data(). */
+#define TEST_NWRITE    100
+
+/** Length of the static dimension. */
+#define TEST_NX        50
+
+/**
+ *  Get the expected value of a test variable.
+ *
+ *  @param  vi    - index of the variable
+ *  @param  index - index of the value in the variable data
+ *
+ *  @return  the expected value
+ */
+static double _test_value(int vi, size_t index)
+{
+    return((double)((vi * 7 + index) % 1000));
+}
+
+/**
+ *  Get the number of values per record of a test variable.
+ *
+ *  @param  vi - index of the variable
+ *
+ *  @return  number of values per record
+ */
+static size_t _test_record_length(int vi)
+{
+    return((vi == 3) ? 1 : TEST_NX);
+}
+
+/**
+ *  Create the test group.
+ *
+ *  The variables are defined in reverse order so the write planner has
+ *  to sort them, and the odd variables are stored as floats and the even
+ *  variables as shorts.
+ *
+ *  @return
+ *    - pointer to the test group
+ *    - NULL if an error occurred
+ */
+static CDSGroup *_test_create_group(void)
+{
+    const char *dim_names[] = { "time", "x" };
+    CDSGroup   *group;
+    char        name[32];
+    int         vi;
+
+    group = cds_define_group(NULL, "roundtrip");
+    if (!group) return((CDSGroup *)NULL);
+
+    if (!cds_define_dim(group, "time", 0, 1) ||
+        !cds_define_dim(group, "x", TEST_NX, 0)) {
+
+        return((CDSGroup *)NULL);
+    }
+
+    for (vi = TEST_NVARS - 1; vi >= 0; --vi) {
+
+        snprintf(name, 32, "v%02d", vi);
+
+        if (!cds_define_var(group, name,
+            (vi % 2) ? CDS_FLOAT : CDS_SHORT,
+            (_test_record_length(vi) == 1) ? 1 : 2, dim_names)) {
+
+            return((CDSGroup *)NULL);
+        }
+    }
+
+    if (!cds_define_var(group, "static", CDS_DOUBLE, 1, dim_names + 1)) {
+        return((CDSGroup *)NULL);
+    }
+
+    return(group);
+}
+
+/**
+ *  Set the data of the test group.
+ *
+ *  The data types of the CDS variables are changed so the values have
+ *  to be converted when they are written.
+ *
+ *  @param  group - pointer to the test group
+ *
+ *  @return
+ *    - 1 if successful
+ *    - 0 if an error occurred
+ */
+static int _test_set_data(CDSGroup *group)
+{
+    CDSVar *var;
+    double *data;
+    size_t  nvalues;
+    size_t  index;
+    char    name[32];
+    int     vi;
+
+    for (vi = 0; vi < TEST_NVARS; ++vi) {
+
+        snprintf(name, 32, "v%02d", vi);
+
+        var     = cds_get_var(group, name);
+        nvalues = TEST_NRECORDS * _test_record_length(vi);
+        data    = (double *)malloc(nvalues * sizeof(double));
+
+        if (!var || !data) return(0);
+
+        for (index = 0; index < nvalues; ++index) {
+            data[index] = _test_value(vi, index);
+        }
+
+        if (!cds_change_var_type(var, (vi % 2) ? CDS_DOUBLE : CDS_INT) ||
+            !cds_set_var_data(var, CDS_DOUBLE, 0, TEST_NRECORDS, NULL, data)) {
+
+            free(data);
+            return(0);
+        }
+
+        free(data);
+    }
+
+    var  = cds_get_var(group, "static");
+    data = (double *)malloc(TEST_NX * sizeof(double));
+
+    if (!var || !data) return(0);
+
+    for (index = 0; index < TEST_NX; ++index) {
+        data[index] = _test_value(TEST_NVARS, index);
+    }
+
+    if (!cds_set_var_data(var, CDS_DOUBLE, 0, TEST_NX, NULL, data)) {
+        free(data);
+        return(0);
+    }
+
+    free(data);
+
+    return(1);
+}
+
+/**
+ *  Check the values read back from the test file.
+ *
+ *  @param  nc_file - full path to the test file
+ *
+ *  @return  number of variables with incorrect values
+ */
+static int _test_check_file(const char *nc_file)
+{
+    size_t  start[2] = { 0, 0 };
+    size_t  count[2];
+    double *data;
+    size_t  nvalues;
+    size_t  index;
+    char    name[32];
+    int     nerrors;
+    int     ncid;
+    int     varid;
+    int     vi;
+
+    if (nc_open(nc_file, NC_NOWRITE, &ncid) != NC_NOERR) {
+        fprintf(stderr, "Could not open: %s\n", nc_file);
+        return(TEST_NVARS + 1);
+    }
+
+    nerrors = 0;
+
+    for (vi = 0; vi <= TEST_NVARS; ++vi) {
+
+        if (vi < TEST_NVARS) {
+            snprintf(name, 32, "v%02d", vi);
+            count[0] = TEST_NRECORDS;
+            count[1] = _test_record_length(vi);
+            nvalues  = count[0] * count[1];
+        }
+        else {
+            strcpy(name, "static");
+            count[0] = TEST_NX;
+            nvalues  = count[0];
+        }
+
+        data = (double *)malloc(nvalues * sizeof(double));
+
+        if (!data ||
+            nc_inq_varid(ncid, name, &varid) != NC_NOERR ||
+            nc_get_vara_double(ncid, varid, start, count, data) != NC_NOERR) {
+
+            fprintf(stderr, "%s: could not read data\n", name);
+            if (data) free(data);
+            nerrors += 1;
+            continue;
+        }
+
+        for (index = 0; index < nvalues; ++index) {
+
+            if (data[index] != _test_value(vi, index)) {
+
+                fprintf(stderr, "%s[%lu]: got %g, expected %g\n",
+                    name, (unsigned long)index,
+                    data[index], _test_value(vi, index));
+
+                nerrors += 1;
+                break;
+            }
+        }
+
+        free(data);
+    }
+
+    nc_close(ncid);
+
+    return(nerrors);
+}
+
+/**
+ *  Run the round-trip test for one file format.
+ *
+ *  @param  out_dir - output directory
+ *  @param  cmode   - NetCDF creation mode
+ *  @param  label   - name of the file format
+ *
+ *  @return  number of failed checks
+ */
+static int _test_roundtrip(const char *out_dir, int cmode, const char *label)
+{
+    char       nc_file[1024];
+    CDSGroup  *group;
+    size_t     cache_size;
+    size_t     cache_nelems;
+    float      preemption;
+    int        nerrors;
+    int        ncid;
+    int        varid;
+    int        record;
+
+    snprintf(nc_file, 1024, "%s/ncds_write_roundtrip.%s.nc", out_dir, label);
+
+    group = _test_create_group();
+    if (!group) {
+        fprintf(stderr, "%s: could not create CDS group\n", label);
+        return(1);
+    }
+
+    /* Create the file header, and then write the data in pieces */
+
+    ncid = ncds_create_file(group, nc_file, cmode, 0, 1);
+    if (!ncid) {
+        fprintf(stderr, "%s: could not create file: %s\n", label, nc_file);
+        cds_delete_group(group);
+        return(1);
+    }
+
+    ncds_close(ncid);
+
+    if (!_test_set_data(group)) {
+        fprintf(stderr, "%s: could not set CDS data\n", label);
+        cds_delete_group(group);
+        return(1);
+    }
+
+    if (!ncds_open(nc_file, NC_WRITE, &ncid)) {
+        fprintf(stderr, "%s: could not open file: %s\n", label, nc_file);
+        cds_delete_group(group);
+        return(1);
+    }
+
+    nerrors = 0;
+
+    /* Give one variable an empty chunk cache, which the write planner
+     * has to restore after every write. */
+
+    if (cmode & NC_NETCDF4) {
+        nc_inq_varid(ncid, "v00", &varid);
+        nc_set_var_chunk_cache(ncid, varid, 0, 0, 0.75);
+    }
+
+    for (record = 0; record < TEST_NRECORDS; record += TEST_NWRITE) {
+
+        if (!ncds_write_group_data(
+            group, record, ncid, record, TEST_NWRITE, 0)) {
+
+            fprintf(stderr, "%s: could not write records %d - %d\n",
+                label, record, record + TEST_NWRITE - 1);
+
+            nerrors += 1;
+            break;
+        }
+
+        if (cmode & NC_NETCDF4) {
+
+            nc_get_var_chunk_cache(
+                ncid, varid, &cache_size, &cache_nelems, &preemption);
+
+            if (cache_size != 0) {
+
+                fprintf(stderr,
+                    "%s: chunk cache of v00 not restored: %lu bytes\n",
+                    label, (unsigned long)cache_size);
+
+                nerrors += 1;
+                break;
+            }
+        }
+    }
+
+    ncds_close(ncid);
+    cds_delete_group(group);
+
+    nerrors += _test_check_file(nc_file);
+
+    printf("%-10s %s\n", label, (nerrors) ? "FAILED" : "passed");
+
+    return(nerrors);
+}
+
+int main(int argc, char **argv)
+{
+    const char *out_dir = (argc > 1) ? argv[1] : ".";
+    int         nerrors = 0;
+
+    nerrors += _test_roundtrip(out_dir, 0,          "classic");
+    nerrors += _test_roundtrip(out_dir, NC_NETCDF4, "netcdf4");
+
+    return((nerrors) ? 1 : 0);
+}
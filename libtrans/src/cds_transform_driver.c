@@ -52,12 +52,16 @@ int QC_INDETERMINATE_SDEV=13;
 int QC_BAD_GOODFRAC=14;
 int QC_INDETERMINATE_GOODFRAC=15;
 
-static size_t _one=1;
-
 /* We'll be doing a lot of dynamic allocation, so let's make it easier */
 # define CALLOC(n,t)  (t*)calloc(n, sizeof(t))
 # define REALLOC(p,n,t)  (t*) realloc((char *) p, (n)*sizeof(t))
 
+// Target size of the tile of neighboring slices we gather at once when
+// transforming a dimension that isn't the fastest one; small enough to stay
+// in cache, with at least a cache line worth of slices per tile.
+# define TRANS_TILE_BYTES   65536
+# define TRANS_TILE_MIN     8
+
 
 // This depends on the interface_s literal struct, defined in trans.h so
 // the interface functions can understand it.  This lets me hide the
@@ -90,8 +94,6 @@ static int NumUserTransFuncs=0;
 
 // Allows for a user defined qc mapping from non-standard aqc
 static int (*qc_mapping_function)() = NULL;
-static int *qc_bad_values=NULL;
-static size_t num_qc_bad_values=0;
   
 // So, here is the dedicated function to allocate space for and assign the
 // user functions.  Incidentally, I have no idea how to prototype this...
@@ -153,17 +155,27 @@ void assign_qc_mapping_function(int (*fptr)(CDSVar *, double , int)) {
   qc_mapping_function=(void *) fptr;
 }
 
-// Default qc mapping func, for use when we list bad values in the qc_bad
-// transform param
-int default_qc_mapping_function(CDSVar *qc_var, double val, int qc_val) {
-  int k, qc=0;
+// Check if any user functions have been assigned.  The driver makes no
+// attempt to serialize calls to them, so callers that compute transforms
+// in several threads at once should fall back to serial mode when this is
+// true, unless they know the user functions are thread safe.
+int trans_has_user_functions(void) {
+  if (NumUserTransFuncs > 0) return(1);
+  if (qc_mapping_function &&
+      qc_mapping_function != (void *) default_qc_mapping_function) return(1);
+  return(0);
+}
 
-  // I'm not sure I like the use of globals here.  Oh well.
+// Map an integer qc state onto our bit-packed states, given a list of bad
+// values (from the qc_bad transform param).
+static int map_qc_bad_values(int *bad_values, size_t nbad, int qc_val) {
+  size_t k;
+  int qc=0;
 
-  // Scan up our list of bad values, set via transform params before this
-  // call.  If any match, set the QC_BAD bit and return.
-  for (k=0;k<num_qc_bad_values; k++) {
-    if (qc_val == qc_bad_values[k]) {
+  // Scan up our list of bad values.  If any match, set the QC_BAD bit and
+  // return.
+  for (k=0;k<nbad; k++) {
+    if (qc_val == bad_values[k]) {
       qc_set(qc, QC_BAD);
       return(qc);
     }
@@ -174,6 +186,14 @@ int default_qc_mapping_function(CDSVar *qc_var, double val, int qc_val) {
   }
   return(qc);
 }
+
+// Default qc mapping func.  When the qc_bad transform param is listed the
+// driver does this mapping itself with the per-call list of bad values (it
+// used to be kept in globals here, which isn't reentrant), so called on its
+// own all we can do is flag nonzero states as indeterminate.
+int default_qc_mapping_function(CDSVar *qc_var, double val, int qc_val) {
+  return(map_qc_bad_values(NULL, 0, qc_val));
+}
   
 
 // Now, here's the function to find and return the transform function.  I'm
@@ -225,10 +245,88 @@ TRANSfunc *get_transform(char *name) {
 *
 *  Upon successful output, outvar and qc_outvar will contain the
 *  transformed data and QC. 
+*
+*  This is just cds_transform_compute() followed by cds_transform_store();
+*  use those directly to do the computing for several variables at once.
 */
 
 int cds_transform_driver(CDSVar *invar, CDSVar *qc_invar, CDSVar *outvar, CDSVar *qc_outvar) {
-  int i, d, k, z, s, z0, m, Ndims;
+  TRANScontext ctx;
+  int status;
+
+  trans_init_context(&ctx, invar, qc_invar, outvar, qc_outvar);
+
+  status=cds_transform_compute(&ctx);
+  if (status == 0) {
+    status=cds_transform_store(&ctx);
+  }
+
+  trans_free_context(&ctx);
+  return(status);
+}
+
+/**
+*  Initialize a transform context for the given input and output vars.
+*
+*  @param  ctx - pointer to the context to initialize
+*  @param  invar, qc_invar, outvar, qc_outvar - see cds_transform_driver()
+*/
+void trans_init_context(TRANScontext *ctx, CDSVar *invar, CDSVar *qc_invar,
+			CDSVar *outvar, CDSVar *qc_outvar) {
+  memset(ctx, 0, sizeof(TRANScontext));
+  ctx->invar=invar;
+  ctx->qc_invar=qc_invar;
+  ctx->outvar=outvar;
+  ctx->qc_outvar=qc_outvar;
+}
+
+/**
+*  Free everything held by a transform context.  The context can be
+*  re-initialized and used again afterwards.
+*
+*  @param  ctx - pointer to the context
+*/
+void trans_free_context(TRANScontext *ctx) {
+  int i;
+
+  if (ctx->qc_bad_values) free(ctx->qc_bad_values);
+  if (ctx->odata) free(ctx->odata);
+  if (ctx->qc_odata) free(ctx->qc_odata);
+
+  for (i=0;i<ctx->nmetrics;i++) {
+    free_metric(&(ctx->metrics[i].met));
+  }
+  if (ctx->metrics) free(ctx->metrics);
+
+  memset(ctx, 0, sizeof(TRANScontext));
+}
+
+/**
+*  Do the transformation of a variable, without touching the output vars.
+*
+*  This only reads from the CDS tree (the one exception being the per
+*  variable user data flags set on invar and outvar, which are guarded by
+*  a mutex), so different contexts can be computed at the same time from
+*  different threads, as long as nobody is changing the CDS tree at the
+*  same time.  User functions assigned with assign_transform_function()
+*  and assign_qc_mapping_function() are called from here too, and must be
+*  thread safe if they are to be used this way (see
+*  trans_has_user_functions()).  Results are left in the context for
+*  cds_transform_store().
+*
+*  @param  ctx - pointer to a context set up by trans_init_context()
+*
+*  @return
+*    - 0 if successful
+*    - -1 if something failed, usually deeper in CDS
+*/
+int cds_transform_compute(TRANScontext *ctx) {
+  CDSVar *invar=ctx->invar;
+  CDSVar *qc_invar=ctx->qc_invar;
+  CDSVar *outvar=ctx->outvar;
+  int i, d, id, k, z, s, z0, m, Ndims;
+  int outer, nouter, inner, b, b0, nb, ntile, maxlen;
+  int fused=0, *order;
   TRANSfunc *trans=NULL;
   double *data, *odata=NULL,*tdata;
   int *qc_data, *qc_odata=NULL, *qc_tdata, *qc_temp;
@@ -240,31 +338,34 @@ int cds_transform_driver(CDSVar *invar, CDSVar *qc_invar, CDSVar *outvar, CDSVar
   double input_interval, output_interval;
   double input_missing_value, output_missing_value;
 
-  // To help freeing temp data without freeing original data.
-  int iter_count=0;
-
   char *transform_type;
 
   double trans_calculate_interval(CDSVar *, int);
 
-  // First, let's make sure that we want a serial 1D transform; if not,
-  // well, we'll have to deal with that later.
+  // First, see if we want a serial 1D transform, or the fused multi
+  // dimensional one.  The kernels are all 1D, so a multi dimensional
+  // transform is still a sweep of 1D transforms, one per dimension; the
+  // difference is that we are free to pick the order of the dimensions.
+  // So, we do the ones that shrink the data the most first, which keeps
+  // the intermediate arrays (and the work for the later dimensions) as
+  // small as possible.
   if ((transform_type = cds_get_transform_param(outvar, "transform_type",
-						      CDS_CHAR, &_one, NULL)) != NULL &&
-      (strcmp(transform_type, "Multi_Dimensional") == 0)) {
-    LOG(TRANS_LIB_NAME, "Multi D transforms not implemented yet\n");
-    return(-3);
+						      CDS_CHAR, &(size_t){1}, NULL)) != NULL) {
+    if (strcmp(transform_type, "Multi_Dimensional") == 0) {
+      LOG(TRANS_LIB_NAME, "Using fused multi dimensional transform for field %s\n",
+	  outvar->name);
+      fused=1;
+    }
+    free(transform_type);
   }
 
-  // Now, let's check for qc mapping in the flat files, and set the
-  // qc_mapping function to the default integer map, if it's not already
-  // set 
-  qc_bad_values=NULL;  // reset from last time
+  // Now, let's check for qc mapping in the flat files; if there is no
+  // qc_mapping function set, we'll map these values to our bit-packed
+  // states ourselves (see default_qc_mapping_function).
   if (qc_mapping_function == NULL &&
       qc_invar != NULL &&
-      (qc_bad_values=cds_get_transform_param(qc_invar,"qc_bad", CDS_INT, &num_qc_bad_values,NULL))) {
+      (ctx->qc_bad_values=cds_get_transform_param(qc_invar,"qc_bad", CDS_INT, &ctx->num_qc_bad_values,NULL))) {
     LOG(TRANS_LIB_NAME, "Using specified qc value mapping\n");
-    assign_qc_mapping_function(default_qc_mapping_function);
   }
 
   // Okay, proceed with serial 1D transform.  This means looping over dims
@@ -417,7 +518,15 @@ int cds_transform_driver(CDSVar *invar, CDSVar *qc_invar, CDSVar *outvar, CDSVar
     }
 
     // If we have a mapping function, we have to apply it here
-    if (qc_mapping_function) {
+    if (ctx->qc_bad_values) {
+      qc_data=CALLOC(size, int);
+      for (k=0;k<size;k++) {
+	qc_data[k]=map_qc_bad_values(ctx->qc_bad_values,
+				     ctx->num_qc_bad_values, qc_temp[k]);
+      }
+      free(qc_temp);
+      qc_temp=NULL;
+    } else if (qc_mapping_function) {
       qc_data=CALLOC(size, int);
       // Passing both data and qc values in, if they exist, just in
       // case there is some combo of both of these things that we need
@@ -467,8 +576,31 @@ int cds_transform_driver(CDSVar *invar, CDSVar *qc_invar, CDSVar *outvar, CDSVar
   for (d=0;d<Ndims;d++) {
     shape[d]=invar->dims[d]->length;
   }
+
+  // The order to transform the dimensions in.  Serial 1D goes slowest to
+  // fastest; fused goes by how much each dimension shrinks the data,
+  // biggest reduction first (insertion sort, so ties keep their order).
+  order=CALLOC(Ndims, int);
+  for (d=0;d<Ndims;d++) {
+    order[d]=d;
+  }
+
+  if (fused) {
+    for (id=1;id<Ndims;id++) {
+      d=order[id];
+      for (i=id-1; i>=0 &&
+	     (double) outvar->dims[order[i]]->length/len[order[i]] >
+	     (double) outvar->dims[d]->length/len[d]; i--) {
+	order[i+1]=order[i];
+      }
+      order[i+1]=d;
+    }
+  }
   
-  for (d=0; d<Ndims;d++) {
+  for (id=0; id<Ndims;id++) {
+
+    d=order[id];
+    trans=NULL;
 
     // First, find the size of our output data in this dimension.  This
     // keeps the other dims what they were, which is what we want - we
@@ -488,13 +620,6 @@ int cds_transform_driver(CDSVar *invar, CDSVar *qc_invar, CDSVar *outvar, CDSVar
       oNtot *= olen[i];
     }
      
-    // Now, allocate our output arrays for this iter.  The old odata
-    // pointers are still in use as the new tdata, so we never end up
-    // freeing these pointers; we'll have to do that when we reassign tdata
-    // at the end.
-    odata=CALLOC(oNtot, double);
-    qc_odata=CALLOC(oNtot, int);
-			     
     // get the CDSdims associated with this dimension, because sometimes we
     // use index, and sometimes not.  This is used mainly to get tranform
     // params, but who knows.
@@ -506,7 +631,7 @@ int cds_transform_driver(CDSVar *invar, CDSVar *qc_invar, CDSVar *outvar, CDSVar
     // needs to be by outvar and dimension name, like:
     // temp:time:transform = "TRANS_INTERPOLATE";
     char *transform_name = cds_get_transform_param_by_dim(outvar, odim, "transform",
-							  CDS_CHAR, &_one, NULL); 
+							  CDS_CHAR, &(size_t){1}, NULL); 
 
     if (transform_name != NULL) {
       trans=get_transform(transform_name);
@@ -521,13 +646,13 @@ int cds_transform_driver(CDSVar *invar, CDSVar *qc_invar, CDSVar *outvar, CDSVar
       if (incoord && outcoord) {
 
 	if (! cds_get_transform_param(incoord, "interval", CDS_DOUBLE,
-				      &_one, &input_interval)) {
+				      &(size_t){1}, &input_interval)) {
 	  // have to calculate it myself...
 	  input_interval = trans_calculate_interval(invar, d);
 	}
 
 	if (! cds_get_transform_param(outcoord, "interval", CDS_DOUBLE,
-				      &_one, &output_interval)) {
+				      &(size_t){1}, &output_interval)) {
 	  output_interval = trans_calculate_interval(outvar, d);
 	}
 	
@@ -558,111 +683,159 @@ int cds_transform_driver(CDSVar *invar, CDSVar *qc_invar, CDSVar *outvar, CDSVar
       
     // Make sure we have an actual transform
     if (trans == NULL) {
-      ERROR(TRANS_LIB_NAME,"No valid transform for dim %s in field %s; exiting transform code...\n"); 
+      ERROR(TRANS_LIB_NAME,"No valid transform for dim %s in field %s; exiting transform code...\n",
+	    odim->name, outvar->name); 
       return(-1);
     }
-    
-    // Allocate space to hold our input and output slices.  We have to have
-    // holding arrays, because our N-dimensional flattened array won't map
-    // pointers or anything.
-
-    // These will get overwritten with each iteration, which means the
-    // following loop is not thread safe.  We'll have to allocate inside
-    // the loop to make it that way.
-    double *data1d=CALLOC(tlen[d], double);  
-    int *qc1d=CALLOC(tlen[d], int);   // If no qc_invar, this will stay 0s,
-				     // so it's cool.
-    double *odata1d=CALLOC(olen[d], double);
-    int *oqc1d=CALLOC(olen[d], int);  
-
-    // Now, loop over all the slices, and pull out the input data and qc
-    // for that slice.  This is fun.
-    int nslice=tNtot/tlen[d];  
-    int oz0=z0=0;  // First slice *always* starts at origin in our
-		   // flattened array
+
+    // A passthrough doesn't change anything, so there's no point in
+    // copying the whole array just to get the same thing back.
+    if (trans->func == trans_passthrough_interface && tlen[d] == olen[d]) {
+      if (transform_name) free(transform_name);
+      continue;
+    }
+
+    // Now, allocate our output arrays for this iter.  The old odata
+    // pointers are still in use as the new tdata, so we never end up
+    // freeing these pointers; we'll have to do that when we reassign tdata
+    // at the end.
+    odata=CALLOC(oNtot, double);
+    qc_odata=CALLOC(oNtot, int);
+
+    // The slices along d come in nouter blocks of inner=tD[d] slices each,
+    // and the slices in a block start at consecutive elements (the other
+    // dims have the same length in input and output, so the same goes for
+    // the output slices with oD[d]==tD[d]).  Instead of gathering one slice
+    // at a time with a stride of tD[d], which is a cache miss per element
+    // for big arrays, we gather a tile of ntile neighboring slices at
+    // once, so every row of the tile is read from contiguous memory, and
+    // scatter the output tile back the same way.  If d is the fastest
+    // dimension, the slices are already contiguous, and we just hand the
+    // kernel pointers into tdata and odata.
+    inner=tD[d];
+    nouter=tNtot/(tlen[d]*inner);
+    maxlen=(tlen[d] > olen[d]) ? tlen[d] : olen[d];
+
+    ntile=TRANS_TILE_BYTES/(maxlen*(int)sizeof(double));
+    if (ntile < TRANS_TILE_MIN) ntile=TRANS_TILE_MIN;
+    if (ntile > inner) ntile=inner;
+
+    double *tile=NULL, *otile=NULL;
+    int *qc_tile=NULL, *oqc_tile=NULL, *qc_zero=NULL;
+
+    if (inner > 1) {
+      tile=CALLOC(ntile*tlen[d], double);
+      qc_tile=CALLOC(ntile*tlen[d], int);  // If no qc_invar, this will
+					   // stay 0s, so it's cool.
+      otile=CALLOC(ntile*olen[d], double);
+      oqc_tile=CALLOC(ntile*olen[d], int);
+    } else if (!qc_tdata) {
+      qc_zero=CALLOC(tlen[d], int);
+    }
 
     // Metric holders
     TRANSmetric *met1d=NULL, *metNd=NULL;
 
-    for (s=0;s<nslice;s++) {
+    // Grid plan, which the transform sets up on the first slice and then
+    // reuses for the rest of them
+    TRANSplan *plan=NULL;
 
-      // Now build up our input slice, which is k strides up from z0
-      for (k=0;k<tlen[d];k++) {
-	z=z0+k*tD[d];  // striding
-	data1d[k]=tdata[z];
-	if (qc_tdata) qc1d[k]=qc_tdata[z];
+    s=0;
+    for (outer=0;outer<nouter;outer++) {
 
-      }
-      // Great.  We now have our input and output arrays, so it's just a
-      // matter of calling the transform interface function.  This takes a
-      // mixture of 1D data arrays and CDS pointers; the latter are used to
-      // track down the various parameters used in the transformation,
-      // including such basic information as the size of the arrays and
-      // what not.
-      //int status = (*(trans->func))(data1d,qc1d,odata1d,oqc1d,invar,outvar,d, &met1d);
-      int status = do_transform(trans,
-				.input_data=data1d,
-				.input_qc=qc1d,
-				.input_missing_value=input_missing_value,
-				.output_data=odata1d,
-				.output_qc=oqc1d,
-				.output_missing_value=output_missing_value,
-				.invar=invar,
-				.outvar=outvar,
-				.d=d,
-				.met=&met1d); 
-
-      // We don't know how many metrics to fill until right here, so:
-      // Make sure to trap out met1==NULL, because that means this
-      // transform doesn't make metrics.
-      if (s==0 && met1d) { // again, not thread safe 
-	allocate_metric(&metNd, met1d->metricnames,met1d->metricunits,met1d->nmetrics, oNtot);
-      }
+      // First slice of this block, in the input and output arrays
+      z0=outer*tlen[d]*inner;
+      int oz0=outer*olen[d]*inner;
 
-      // Now that we've filled odata1d with our transformed data, fill in
-      // our output slice, using the exact process above.  Make sure
-      // we use output strides, z0s, and lens.
-      for (k=0;k<olen[d];k++) {
-	z=oz0+k*oD[d];
-	odata[z]=odata1d[k];
-	qc_odata[z]=oqc1d[k];
-
-	// Fill our metrics array, if we've got one
-	if (met1d && met1d->metrics) {
-	  for (m=0;m<met1d->nmetrics;m++) {
-	    metNd->metrics[m][z]=met1d->metrics[m][k];
+      for (b0=0;b0<inner;b0+=ntile) {
+
+	nb=(inner-b0 < ntile) ? inner-b0 : ntile;
+
+	// Gather the input tile; slice b of the tile is row b
+	if (inner > 1) {
+	  for (k=0;k<tlen[d];k++) {
+	    z=z0+k*inner+b0;
+	    for (b=0;b<nb;b++) {
+	      tile[b*tlen[d]+k]=tdata[z+b];
+	    }
+	    if (qc_tdata) {
+	      for (b=0;b<nb;b++) {
+		qc_tile[b*tlen[d]+k]=qc_tdata[z+b];
+	      }
+	    }
 	  }
 	}
-      }
 
-      // We need to free up met1d and point it back to null, so it will get
-      // properly allocated and not leave hangers.
-      free_metric(&met1d);
-
-      // Now, find our next slice, and reset our pointers.  The math behind
-      // this is non-trivial, but sound.  Qualitatively, the idea is that
-      // when we increment our faster indeces than d, we 
-      // increment z0 by just 1 (since the stride of our fastest dimension
-      // is always 1).  We can do that D[d] times, until we have to
-      // increment the slower dimensions than d; to do that, we stride in
-      // d-1, i.e. increment z0 by D[d-1].  We then subtract D[d]-1 to
-      // reset our faster indeces to 0, and begin the cycle again.  Hence,
-      // if z0+1 is a multiple of D[d], we set z0 += D[d-1] - (D[d] - 1);
-      // otherwise, z0 += 1.
-
-      // (Note the hidden +1 by doing ++z0 first).
-      if ((++z0 % tD[d]) == 0 && d > 0) {
-	z0 +=  tD[d-1] - tD[d];  
-      }
+	for (b=0;b<nb;b++,s++) {
+	  double *data1d, *odata1d;
+	  int *qc1d, *oqc1d;
 
-      // I don't know if oz0 will always be a multiple of oD whenever z0 is
-      // a multiple of D, so repeat the check just to be sure.
-      if ((++oz0 % oD[d]) == 0 && d > 0) {
-	oz0 +=  oD[d-1] - oD[d];  
-      }
+	  if (inner > 1) {
+	    data1d=tile+b*tlen[d];
+	    qc1d=qc_tile+b*tlen[d];
+	    odata1d=otile+b*olen[d];
+	    oqc1d=oqc_tile+b*olen[d];
+	  } else {
+	    data1d=tdata+z0;
+	    qc1d=qc_tdata ? qc_tdata+z0 : qc_zero;
+	    odata1d=odata+oz0;
+	    oqc1d=qc_odata+oz0;
+	  }
 
-      // That's it - ready for the next stride.  Our s index just counts,
-      // nothing else.
+	  // Great.  We now have our input and output arrays, so it's just a
+	  // matter of calling the transform interface function.  This takes a
+	  // mixture of 1D data arrays and CDS pointers; the latter are used to
+	  // track down the various parameters used in the transformation,
+	  // including such basic information as the size of the arrays and
+	  // what not.
+	  int status = do_transform(trans,
+				    .input_data=data1d,
+				    .input_qc=qc1d,
+				    .input_missing_value=input_missing_value,
+				    .output_data=odata1d,
+				    .output_qc=oqc1d,
+				    .output_missing_value=output_missing_value,
+				    .invar=invar,
+				    .outvar=outvar,
+				    .d=d,
+				    .met=&met1d,
+				    .plan=&plan); 
+	  (void) status;
+
+	  // We don't know how many metrics to fill until right here, so:
+	  // Make sure to trap out met1==NULL, because that means this
+	  // transform doesn't make metrics.
+	  if (s==0 && met1d) {
+	    allocate_metric(&metNd, met1d->metricnames,met1d->metricunits,met1d->nmetrics, oNtot);
+	  }
+
+	  // Fill our metrics array, if we've got one
+	  if (met1d && met1d->metrics && metNd) {
+	    for (k=0;k<olen[d];k++) {
+	      z=oz0+k*inner+b0+b;
+	      for (m=0;m<met1d->nmetrics;m++) {
+		metNd->metrics[m][z]=met1d->metrics[m][k];
+	      }
+	    }
+	  }
+
+	  // We need to free up met1d and point it back to null, so it will get
+	  // properly allocated and not leave hangers.
+	  free_metric(&met1d);
+	}
+
+	// Now scatter the output tile back, using the exact process above.
+	// Make sure we use output lens.
+	if (inner > 1) {
+	  for (k=0;k<olen[d];k++) {
+	    z=oz0+k*inner+b0;
+	    for (b=0;b<nb;b++) {
+	      odata[z+b]=otile[b*olen[d]+k];
+	      qc_odata[z+b]=oqc_tile[b*olen[d]+k];
+	    }
+	  }
+	}
+      }
     }
 
     // Hokay.  At this point we've gone through all the slices in this
@@ -705,151 +878,20 @@ int cds_transform_driver(CDSVar *invar, CDSVar *qc_invar, CDSVar *outvar, CDSVar
       }
 
       if (okshape) {
-
-	// Now loop over our metrics.  For each one, we first look for an
-	// existing CDSVar; if it exists, as a sibling to outvar, we'll try
-	// to use it, but it means we have to double check the shape and
-	// dimensions.  If it does not exist, we create one as a clone to
-	// outvar, to get the same shape and type.
-	for (m=0;m<metNd->nmetrics;m++) {
-
-	  char sibname[300];
-	  sprintf(sibname,"%s_%s",outvar->name, metNd->metricnames[m]);
-
-	  // Check to see if this sibling variable exists; if so, log that
-	  // fact, and escape.  This will trap out cases where the user has
-	  // already defined the field name in the PCM - the user wins over
-	  // default behavior when there is a  name collision.
-
-	  // But!  This is a little tricky - it means that we
-	  // will store the metric only for the very first dimension which
-	  // we transform that gives us the same shape as the outvar.
-	  // Thus, if we average time and then average onto a grid of the
-	  // same size (maybe a five-rolling mean), we'll only get metrics
-	  // for the time average.  I will probably add transform
-	  // parameters to control this behavior: avoid metrics when
-	  // transforming certain dimensions, or to modify the metric names
-	  // so we don't have a name collision.
-	  CDSVar *mvar = cds_get_var((CDSGroup *) (outvar->parent), sibname);
-
-	  if (mvar) {
-	    LOG(TRANS_LIB_NAME, 
-		"Metric field %s already exists; no metrics stored while transforming dimension %d (%s)\n", 
-		sibname, d, outvar->dims[d]->name);
-	    continue;
-	  }
-
-	  // Okay, mvar doesn't exist, so we have to create and fill it
-
-	  // I really think the metric is a clone - same type, same
-	  // dimensions, same dataset.  Variable mitosis.
-	  // The 0 means we don't copy data, which is good.
-	  
-	  // Fine, I'll clone it myself.  The only hassle is dim_names
-	  char **dim_names=CALLOC(outvar->ndims, char*);
-	  for (dm=0;dm<outvar->ndims;dm++) {
-	    dim_names[dm]=outvar->dims[dm]->name;
-	  }
-	  
-	  if ((mvar = cds_define_var((CDSGroup *) outvar->parent, sibname, outvar->type,
-				     outvar->ndims, (const char **) dim_names))) {
-	    // Very base attributes
-	    cds_define_att_text(mvar, "long_name", "Metric %s for field %s",
-				metNd->metricnames[m], outvar->name);
-
-	    // Now do units.  If set to SAME, then use same units as outvar
-	    if (strcmp(metNd->metricunits[m],"SAME") == 0) {
-	      size_t lu;
-	      CDSAtt *unit_att=cds_get_att(outvar,"units");
-	      char *outvar_units = unit_att ? cds_get_att_text(unit_att,&lu,NULL) : NULL;
-	      if (outvar_units == NULL) {
-		ERROR(TRANS_LIB_NAME,
-		      "Transformed variable %s does not have valid units attribute\n",
-		      outvar->name);
-		cds_define_att_text(mvar, "units", "unknown");
-	      } else {
-		cds_define_att_text(mvar, "units", "%s", outvar_units);
-		free(outvar_units);
-	      }
-	    } else {
-	      cds_define_att_text(mvar, "units", metNd->metricunits[m]); 
-	    }
-
-	    // Missing
-	    void *missing_value=NULL;
-	    int nms = cds_get_var_missing_values(outvar, &missing_value);
-
-	    if (nms > 0 && missing_value) {
-	      cds_define_att(mvar, "missing_value", outvar->type,
-			     nms, missing_value); 
-	    } else {
-	      // Great.  Now I have to make up my own missing value
-	      // Make sure this holds enough bytes for all data types
-	      if (! (missing_value = malloc(cds_data_type_size(outvar->type)))) {
-		ERROR(TRANS_LIB_NAME,
-		      "Cannot allocate %d bytes for missing value\n",
-		      cds_data_type_size(outvar->type));
-		return(-1);
-	      }
-
-	      cds_get_default_fill_value(mvar->type, missing_value);
-	      cds_define_att(mvar, "missing_value", mvar->type, 1,missing_value); 	      
-	    }
-	    
-	    // Either way, have to free up 
-	    free(missing_value);
-	  } else {
-	    LOG(TRANS_LIB_NAME,
-		"Warning: Cannot create metric field %s; continuing...\n", sibname);
-	  }
-	  
-	  free(dim_names);
-
-
-#ifdef notdef	  
-	  // This stuff, I think, is redundant, as I no longer need to
-	  // do checks for if mvar previously existed.  If it exists, then
-	  // we don't fill it, because it means the user wants it for
-	  // something else.  But I'm keeping this code in here in case we
-	  // change our mind and have upstream code create our metric vars
-	  // at some later date.
-
-	  // Now we idiot check everything.  A Null mvar or dimension
-	  // mismatch is an easy no go.  Should I log this?
-	  if (! mvar || mvar->ndims != Ndims) continue;
-
-	  // Double check mvar's shape, in case it pre-existed
-	  okshape=1;
-	  for (dm=0;dm<mvar->ndims;dm++) {
-	    if (shape[dm] != mvar->dims[dm]->length) {
-	      okshape=0;
-	      break;
-	    }
-	  }
-	  if (!okshape)  continue;
-#endif
-
-	  // Hooray!  We can finally store the metric
-	  if (! cds_set_var_data(mvar, CDS_DOUBLE, 0, msample,NULL, 
-				    metNd->metrics[m])) {
-	    LOG(TRANS_LIB_NAME,
-		"Warning: Could not write data to metric field %s\n",
-		mvar->name);
-	  }
-	  
-	  // Okay, now tag this variable in outvars user data, to make it
-	  // easier to find.
-	  if (!cds_set_user_data(outvar, metNd->metricnames[m], (void *) mvar, NULL)) {
-	  //if (!cds_set_user_data(outvar, metNd->metricnames[m], (void *) mvar, free)) {
-	    LOG(TRANS_LIB_NAME, "Warning: vould not attach metric field %s to user data for %s\n",
-		metNd->metricnames[m], outvar->name);
-	  }
-	} // m loop over metrics
-      } // okshape
+	// Save these for cds_transform_store(), which creates the sibling
+	// variables; we can't touch the CDS tree in here.
+	ctx->metrics=realloc(ctx->metrics,
+			     (ctx->nmetrics+1)*sizeof(TRANSsavedmetric));
+	ctx->metrics[ctx->nmetrics].d=d;
+	ctx->metrics[ctx->nmetrics].msample=msample;
+	ctx->metrics[ctx->nmetrics].met=metNd;
+	ctx->nmetrics++;
+	metNd=NULL;
+      }
     } // if metNd
 
     // Either way, we need to free metNd for the next iteration of our
-    // transform code
+    // transform code (if we saved it, it's NULL now)
     free_metric(&metNd);
 
     // Now that we've transformed all the slices, time to move on to the
@@ -857,14 +899,10 @@ int cds_transform_driver(CDSVar *invar, CDSVar *qc_invar, CDSVar *outvar, CDSVar
     // next, so reset our pointers and values.  This gets tricky.
 
     // First, free up - But! I don't want to free data and qc_data, the
-    // original input yet.  So'll I kludge a free only if it's not our
-    // first iteration.  And, I'll do it with a seperate counting variable,
-    // so we can change the order of dims later.
-
-    if (iter_count++ > 0) {
-      if (tdata) free(tdata);
-      if (qc_tdata) free(qc_tdata);
-    }
+    // original input yet, and since passthroughs are skipped that could
+    // still be what tdata points to.
+    if (tdata != data) free(tdata);
+    if (qc_tdata && qc_tdata != qc_data) free(qc_tdata);
 
     // This assign should work.
     tdata=odata;
@@ -874,51 +912,218 @@ int cds_transform_driver(CDSVar *invar, CDSVar *qc_invar, CDSVar *outvar, CDSVar
     tNtot=oNtot;
 
     // do some freeing of our working arrays
-    free(data1d);free(qc1d);free(odata1d);free(oqc1d);
+    trans_release_plan(&plan);
+    if (tile) free(tile);
+    if (qc_tile) free(qc_tile);
+    if (otile) free(otile);
+    if (oqc_tile) free(oqc_tile);
+    if (qc_zero) free(qc_zero);
 
     if (transform_name) free(transform_name);
   }
 
   // Great - we've transformed all the dimensions.  Our new data should be
-  // in odata and qc_odata, with dims set correctly.  So now we just need
-  // to copy to outvar and return happy.
-  if (cds_set_var_data(outvar, CDS_DOUBLE, 0, olen[0],
-			  &output_missing_value, odata) == NULL ||
-      cds_set_var_data(qc_outvar, CDS_INT, 0, olen[0],
-			  NULL, qc_odata) == NULL) {
-    ERROR(TRANS_LIB_NAME, "Problem writing output data for %s or %s\n",
-	  outvar->name, qc_outvar->name);
-    return(-1);
-  }
- 
-  // Old way - probably exactly the same
-  //if (cds_put_var_data(outvar, 0, olen[0], CDS_DOUBLE, odata) == NULL ||
-  //    cds_put_var_data(qc_outvar, 0, olen[0], CDS_INT, qc_odata) == NULL) {
-  //  ERROR(TRANS_LIB_NAME, "Problem writing output data for %s or %s",
-  //	  outvar->name, qc_outvar->name);
-  //  return(-1);
-  //  }
-
-  // I'll free stuff up down here, only if things go well.  Brian will
-  // probably hate that.
-  if (data) free(data);
-  if (qc_data) free(qc_data);
-  if (odata) free(odata);
-  if (qc_odata) free(qc_odata);
-  // if (qc_temp) free(qc_temp);
+  // in tdata and qc_tdata, with dims set correctly (if every dimension
+  // was a passthrough, that's still the input, and we may not have any qc
+  // yet).  So now we just need to hand them over to the context for
+  // storing.
+  odata=tdata;
+  qc_odata=qc_tdata ? qc_tdata : CALLOC(tNtot, int);
+
+  ctx->odata=odata;
+  ctx->qc_odata=qc_odata;
+  ctx->nsamples=olen[0];
+  ctx->output_missing_value=output_missing_value;
+
+  // Free up our input data; the output now belongs to the context.  If
+  // there were no dims to loop over, odata is still the input data.
+  if (data && data != odata) free(data);
+  if (qc_data && qc_data != qc_odata) free(qc_data);
 
   // Free our dimensional arrays
   free(D);free(tD);free(oD);
   free(len);free(tlen);free(olen);
-  free(shape);
+  free(shape);free(order);
+
+  return(0);
+}
+
+/**
+*  Store the results of cds_transform_compute() in the output vars, and
+*  create the metric sibling variables.  This changes the CDS tree, so it
+*  must not be run while any other context is being computed.
+*
+*  @param  ctx - pointer to a context filled in by cds_transform_compute()
+*
+*  @return
+*    - 0 if successful
+*    - -1 if something failed, usually deeper in CDS
+*/
+int cds_transform_store(TRANScontext *ctx) {
+  CDSVar *outvar=ctx->outvar;
+  CDSVar *qc_outvar=ctx->qc_outvar;
+  TRANSmetric *metNd;
+  int i, d, m, dm, msample;
+
+  // Hokay.  For every dimension whose transformation had the same shape as
+  // the output var, store its metrics in sibling variables: if a sibling
+  // with the proper metric name already exists, the user wins and we
+  // skip it, otherwise we create one as a clone of outvar.
+  for (i=0;i<ctx->nmetrics;i++) {
+    d=ctx->metrics[i].d;
+    msample=ctx->metrics[i].msample;
+    metNd=ctx->metrics[i].met;
+
+    // Now loop over our metrics.  For each one, we first look for an
+    // existing CDSVar; if it exists, as a sibling to outvar, we'll try
+    // to use it, but it means we have to double check the shape and
+    // dimensions.  If it does not exist, we create one as a clone to
+    // outvar, to get the same shape and type.
+    for (m=0;m<metNd->nmetrics;m++) {
+
+      char sibname[300];
+      sprintf(sibname,"%s_%s",outvar->name, metNd->metricnames[m]);
+
+      // Check to see if this sibling variable exists; if so, log that
+      // fact, and escape.  This will trap out cases where the user has
+      // already defined the field name in the PCM - the user wins over
+      // default behavior when there is a  name collision.
+
+      // But!  This is a little tricky - it means that we
+      // will store the metric only for the very first dimension which
+      // we transform that gives us the same shape as the outvar.
+      // Thus, if we average time and then average onto a grid of the
+      // same size (maybe a five-rolling mean), we'll only get metrics
+      // for the time average.  I will probably add transform
+      // parameters to control this behavior: avoid metrics when
+      // transforming certain dimensions, or to modify the metric names
+      // so we don't have a name collision.
+      CDSVar *mvar = cds_get_var((CDSGroup *) (outvar->parent), sibname);
+
+      if (mvar) {
+	LOG(TRANS_LIB_NAME, 
+	    "Metric field %s already exists; no metrics stored while transforming dimension %d (%s)\n", 
+	    sibname, d, outvar->dims[d]->name);
+	continue;
+      }
+
+      // Okay, mvar doesn't exist, so we have to create and fill it
+
+      // I really think the metric is a clone - same type, same
+      // dimensions, same dataset.  Variable mitosis.
+      // The 0 means we don't copy data, which is good.
+
+      // Fine, I'll clone it myself.  The only hassle is dim_names
+      char **dim_names=CALLOC(outvar->ndims, char*);
+      for (dm=0;dm<outvar->ndims;dm++) {
+	dim_names[dm]=outvar->dims[dm]->name;
+      }
+
+      if ((mvar = cds_define_var((CDSGroup *) outvar->parent, sibname, outvar->type,
+				 outvar->ndims, (const char **) dim_names))) {
+	// Very base attributes
+	cds_define_att_text(mvar, "long_name", "Metric %s for field %s",
+			    metNd->metricnames[m], outvar->name);
+
+	// Now do units.  If set to SAME, then use same units as outvar
+	if (strcmp(metNd->metricunits[m],"SAME") == 0) {
+	  size_t lu;
+	  CDSAtt *unit_att=cds_get_att(outvar,"units");
+	  char *outvar_units = unit_att ? cds_get_att_text(unit_att,&lu,NULL) : NULL;
+	  if (outvar_units == NULL) {
+	    ERROR(TRANS_LIB_NAME,
+		  "Transformed variable %s does not have valid units attribute\n",
+		  outvar->name);
+	    cds_define_att_text(mvar, "units", "unknown");
+	  } else {
+	    cds_define_att_text(mvar, "units", "%s", outvar_units);
+	    free(outvar_units);
+	  }
+	} else {
+	  cds_define_att_text(mvar, "units", metNd->metricunits[m]); 
+	}
+
+	// Missing
+	void *missing_value=NULL;
+	int nms = cds_get_var_missing_values(outvar, &missing_value);
+
+	if (nms > 0 && missing_value) {
+	  cds_define_att(mvar, "missing_value", outvar->type,
+			 nms, missing_value); 
+	} else {
+	  // Great.  Now I have to make up my own missing value
+	  // Make sure this holds enough bytes for all data types
+	  if (! (missing_value = malloc(cds_data_type_size(outvar->type)))) {
+	    ERROR(TRANS_LIB_NAME,
+		  "Cannot allocate %d bytes for missing value\n",
+		  cds_data_type_size(outvar->type));
+	    return(-1);
+	  }
+
+	  cds_get_default_fill_value(mvar->type, missing_value);
+	  cds_define_att(mvar, "missing_value", mvar->type, 1,missing_value);             
+	}
 
-  // Free up our default qc_mapping_function.  Note that the way I've coded
-  // this, you can only have one qc_mapping function for all input fields.
-  // That's no good - I need a lookup table kind of thing; foo.
-  if (qc_mapping_function == default_qc_mapping_function) {
-    qc_mapping_function=NULL;
+	// Either way, have to free up 
+	free(missing_value);
+      } else {
+	LOG(TRANS_LIB_NAME,
+	    "Warning: Cannot create metric field %s; continuing...\n", sibname);
+      }
+
+      free(dim_names);
+
+
+#ifdef notdef	  
+      // This stuff, I think, is redundant, as I no longer need to
+      // do checks for if mvar previously existed.  If it exists, then
+      // we don't fill it, because it means the user wants it for
+      // something else.  But I'm keeping this code in here in case we
+      // change our mind and have upstream code create our metric vars
+      // at some later date.
+
+      // Now we idiot check everything.  A Null mvar or dimension
+      // mismatch is an easy no go.  Should I log this?
+      if (! mvar || mvar->ndims != Ndims) continue;
+
+      // Double check mvar's shape, in case it pre-existed
+      okshape=1;
+      for (dm=0;dm<mvar->ndims;dm++) {
+	if (shape[dm] != mvar->dims[dm]->length) {
+	  okshape=0;
+	  break;
+	}
+      }
+      if (!okshape)  continue;
+#endif
+
+      // Hooray!  We can finally store the metric
+      if (! cds_set_var_data(mvar, CDS_DOUBLE, 0, msample,NULL, 
+				metNd->metrics[m])) {
+	LOG(TRANS_LIB_NAME,
+	    "Warning: Could not write data to metric field %s\n",
+	    mvar->name);
+      }
+
+      // Okay, now tag this variable in outvars user data, to make it
+      // easier to find.
+      if (!cds_set_user_data(outvar, metNd->metricnames[m], (void *) mvar, NULL)) {
+      //if (!cds_set_user_data(outvar, metNd->metricnames[m], (void *) mvar, free)) {
+	LOG(TRANS_LIB_NAME, "Warning: vould not attach metric field %s to user data for %s\n",
+	    metNd->metricnames[m], outvar->name);
+      }
+    } // m loop over metrics
   }
 
+  if (cds_set_var_data(outvar, CDS_DOUBLE, 0, ctx->nsamples,
+			  &ctx->output_missing_value, ctx->odata) == NULL ||
+      cds_set_var_data(qc_outvar, CDS_INT, 0, ctx->nsamples,
+			  NULL, ctx->qc_odata) == NULL) {
+    ERROR(TRANS_LIB_NAME, "Problem writing output data for %s or %s\n",
+	  outvar->name, qc_outvar->name);
+    return(-1);
+  }
+ 
   return(0);
 }
 
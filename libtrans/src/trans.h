@@ -103,6 +103,43 @@ typedef struct _TRANSmetric {
   double *ind_min;
 } TRANSmetric;
 
+// A transform plan holds the part of a 1D transformation that depends
+// only on the input and output grids: which input points go into each
+// output point, and with what fractional weights.  Every variable (and
+// every slice of a variable) on the same grids uses the same plan, so we
+// build it once and keep it in a small cache, keyed by the grids
+// themselves.  What's left to do per slice is just a sparse weighted sum,
+// plus the qc and missing value checks.
+#define TRANS_PLAN_BIN_AVERAGE 1
+#define TRANS_PLAN_INTERPOLATE 2
+
+typedef struct _TRANSplan {
+  int type;        // TRANS_PLAN_BIN_AVERAGE or TRANS_PLAN_INTERPOLATE
+  int status;      // 0, or the error code the core function should return
+  int sign;        // 1 for increasing grids, -1 for decreasing
+  int ni, nt;
+
+  // The grids: bin edges for bin averages (index_2 and target_2 hold the
+  // back edges), midpoints for interpolation (index_2, target_2 NULL)
+  double *index_1, *index_2;
+  double *target_1, *target_2;
+
+  // Bin average: the input bins overlapping output bin j are entries
+  // offset[j] to offset[j+1]-1 of input, frac and span.  nscan[j] is the
+  // number of input bins we ran up while looking, overlapping or not.
+  int *offset;
+  int *nscan;
+  int *input;
+  double *frac;    // fraction of the input bin inside the output bin
+  double *span;    // contribution to the total span, for coverage
+
+  // Interpolate: where the search for the bracketing points starts for
+  // output point j, or -1 if j is beyond the range of the input grid.
+  int *start;
+
+  int refcount;
+} TRANSplan;
+
 // The designated argument struct for the interface functions.  This lets
 // me easily modify the inputs and add stuff to or even modify them without
 // having to rewrite everything in all the interface functions.  It even
@@ -120,6 +157,8 @@ typedef struct {
   CDSVar *outvar;
   int d;
   TRANSmetric **met;
+  TRANSplan **plan;  // if not NULL, the driver keeps the plan here between
+		     // slices of the same dimension
 } interface_s;
 
 // This is a structure that links an trans interface function to a
@@ -151,10 +190,51 @@ typedef struct _TRANSfunc {
 int assign_transform_function(char *, int(*)());
 void assign_qc_mapping_function(int(*)());
 int default_qc_mapping_function(CDSVar *, double , int);
+int trans_has_user_functions(void);
 
 TRANSfunc *get_transform(char*);
 int cds_transform_driver(CDSVar *, CDSVar *, CDSVar *, CDSVar *);
 
+// Metrics saved by the compute step, one entry for each dimension whose
+// transformation produced an array the same shape as the output var.
+typedef struct {
+  int d;             // dimension the metrics came from
+  int msample;       // number of samples (length of time dim)
+  TRANSmetric *met;  // the metrics themselves
+} TRANSsavedmetric;
+
+// Per-call state for the transform driver.  Everything that used to live
+// in file statics is in here, so separate contexts can be computed at the
+// same time in different threads.  The driver is split in two:
+// cds_transform_compute() only reads from the CDS tree and does all the
+// number crunching, cds_transform_store() defines the metric fields and
+// writes the data into the output vars, and so must be called serially.
+// Assigned user functions are called from the compute step, so they must be
+// thread safe before contexts are computed in parallel.
+typedef struct {
+  CDSVar *invar;
+  CDSVar *qc_invar;
+  CDSVar *outvar;
+  CDSVar *qc_outvar;
+
+  // qc_bad transform param, used by the default qc mapping
+  int *qc_bad_values;
+  size_t num_qc_bad_values;
+
+  // results of the compute step
+  double output_missing_value;
+  int nsamples;     // length of the first output dimension
+  double *odata;
+  int *qc_odata;
+  int nmetrics;
+  TRANSsavedmetric *metrics;
+} TRANScontext;
+
+void trans_init_context(TRANScontext *, CDSVar *, CDSVar *, CDSVar *, CDSVar *);
+void trans_free_context(TRANScontext *);
+int cds_transform_compute(TRANScontext *);
+int cds_transform_store(TRANScontext *);
+
 // Default transform interface functions - they all need to be prototyped
 // this way.
 //int trans_interpolate_interface(double*, int*,double*,int*,CDSVar*,CDSVar*,int, TRANSmetric **); 
@@ -204,6 +284,10 @@ typedef struct {
   
   // And an auxilliary pointer, just in case
   void *aux;
+
+  // Precomputed plan for the grids; if NULL, the core function makes its
+  // own from the index and target arrays.
+  TRANSplan *plan;
 } core_s;
 
 // Macro to call the transformation?
@@ -248,4 +332,10 @@ int get_bin_edges(double **, double **, double *, int, CDSVar *, int);
 double *get_bin_midpoints(double *index, int nbins, CDSVar *var, int d);
 int set_estimated_bin_qc(int *qc_odata, CDSVar *invar, CDSVar *outvar, int d, int nt);
 
+// transform plans
+TRANSplan *trans_build_plan(int, double *, double *, int, double *, double *, int);
+TRANSplan *trans_get_plan(int, double *, double *, int, double *, double *, int);
+void trans_release_plan(TRANSplan **);
+void trans_free_plan_cache(void);
+
 #endif
@@ -39,8 +39,6 @@
 // tired of figurin it out, so here we go
 # define HUGE		3.40282347e+38F
 
-static size_t _one=1;
-
 #define NUM_METRICS 2
 static const char *metnames[] = {
   "std",
@@ -95,6 +93,7 @@ int trans_bin_average_interface(interface_s is)
   size_t len;
   CDSVar *incoord, *outcoord;
   TRANSmetric *met1d;
+  TRANSplan *plan=NULL;
 
   // Unlike other interfaces, these are just markers for the dimensions,
   // which we'll use to infer the bin edges.  
@@ -122,36 +121,42 @@ int trans_bin_average_interface(interface_s is)
   allocate_metric(met,metnames, metunits, NUM_METRICS, nt);
   met1d = (*met);
 
-  // These mostly work straight up because coord vars are always 1D, so we
-  // don't have to worry about indexing or casting correctly
-  incoord = cds_get_coord_var(invar, d);
-  index=(double *) cds_copy_array(incoord->type, ni,
-				  incoord->data.vp,
-				  CDS_DOUBLE, NULL,
-				  0, NULL, NULL, NULL, NULL, NULL, NULL); 
-
-  outcoord = cds_get_coord_var(outvar, d);
-  target=(double *) cds_copy_array(outcoord->type, nt,
-				  outcoord->data.vp,
-				  CDS_DOUBLE, NULL,
-				   0, NULL, NULL, NULL, NULL, NULL, NULL); 
+  // If the driver already has a plan for this dimension, we know the bin
+  // edges already; otherwise we have to work them out.
+  if (is.plan && *is.plan) {
+    plan=*is.plan;
+  } else {
+    // These mostly work straight up because coord vars are always 1D, so we
+    // don't have to worry about indexing or casting correctly
+    incoord = cds_get_coord_var(invar, d);
+    index=(double *) cds_copy_array(incoord->type, ni,
+				    incoord->data.vp,
+				    CDS_DOUBLE, NULL,
+				    0, NULL, NULL, NULL, NULL, NULL, NULL); 
+
+    outcoord = cds_get_coord_var(outvar, d);
+    target=(double *) cds_copy_array(outcoord->type, nt,
+				     outcoord->data.vp,
+				     CDS_DOUBLE, NULL,
+				     0, NULL, NULL, NULL, NULL, NULL, NULL); 
+  }
 
   // The easy lookups - override missing_Value by transform params.
   if (cds_get_transform_param_by_dim(invar, invar->dims[d],
 				     "missing_value", CDS_DOUBLE,
-				     &_one, &missing_value) != NULL) {
+				     &(size_t){1}, &missing_value) != NULL) {
     input_missing_value=missing_value;
   }
 
   if (cds_get_transform_param_by_dim(outvar, outvar->dims[d],
 				     "missing_value", CDS_DOUBLE,
-				     &_one, &missing_value) != NULL) {
+				     &(size_t){1}, &missing_value) != NULL) {
     output_missing_value=missing_value;
   }
 
   if (cds_get_transform_param_by_dim(invar, invar->dims[d],
 				     "qc_mask", CDS_INT,
-				     &_one, &qc_mask) == NULL) {
+				     &(size_t){1}, &qc_mask) == NULL) {
     qc_mask=get_qc_mask(invar);
     // I should now set the transform param so we don't have to calculate
     // it again.  Hmm.
@@ -181,25 +186,25 @@ int trans_bin_average_interface(interface_s is)
 
   if (cds_get_transform_param_by_dim(outvar, outvar->dims[d],
 				     "sdev_bad_max", CDS_DOUBLE,
-				     &_one, &sdev_bad_max) != NULL) {
+				     &(size_t){1}, &sdev_bad_max) != NULL) {
     limits[0]=sdev_bad_max;
   }
 
   if (cds_get_transform_param_by_dim(outvar, outvar->dims[d],
 				     "sdev_ind_max", CDS_DOUBLE,
-				     &_one, &sdev_ind_max) != NULL) {
+				     &(size_t){1}, &sdev_ind_max) != NULL) {
     limits[1]=sdev_ind_max;
   }
 
   if (cds_get_transform_param_by_dim(outvar, outvar->dims[d],
 				     "goodfrac_bad_min", CDS_DOUBLE,
-				     &_one, &goodfrac_bad_min) != NULL) {
+				     &(size_t){1}, &goodfrac_bad_min) != NULL) {
     limits[2]=goodfrac_bad_min;
   }
 
   if (cds_get_transform_param_by_dim(outvar, outvar->dims[d],
 				     "goodfrac_ind_min", CDS_DOUBLE,
-				     &_one, &goodfrac_ind_min) != NULL) {
+				     &(size_t){1}, &goodfrac_ind_min) != NULL) {
     limits[3]=goodfrac_ind_min;
   }
 
@@ -207,8 +212,17 @@ int trans_bin_average_interface(interface_s is)
   // it with both input and output edges.  We'll use Brian's trick of
   // passing in a pointer to our pointers, so we can set the addresses.
 
-  status = get_bin_edges(&index_start, &index_end, index, ni, invar, d);
-  status = get_bin_edges(&target_start, &target_end, target, nt, outvar, d);
+  if (plan == NULL) {
+    status = get_bin_edges(&index_start, &index_end, index, ni, invar, d);
+    status = get_bin_edges(&target_start, &target_end, target, nt, outvar, d);
+
+    // Every var on this grid will need the same plan, so get it from the
+    // cache, and hand it to the driver to use for the rest of the slices
+    plan = trans_get_plan(TRANS_PLAN_BIN_AVERAGE, index_start, index_end, ni,
+			  target_start, target_end, nt);
+    if (plan == NULL) return(-1);
+    if (is.plan) *is.plan=plan;
+  }
 
   // Now just call our core function
 
@@ -220,19 +234,20 @@ int trans_bin_average_interface(interface_s is)
 			      .input_data=data,
 			      .input_qc=qc_data,
 			      .qc_mask=qc_mask,
-			      .index_boundary_1=index_start,
-			      .index_boundary_2=index_end,
+			      .index_boundary_1=plan->index_1,
+			      .index_boundary_2=plan->index_2,
 			      .weights=weights,
 			      .nindex=ni,
 			      .output_data=odata,
 			      .output_qc=qc_odata,
-			      .target_boundary_1=target_start,
-			      .target_boundary_2=target_end,
+			      .target_boundary_1=plan->target_1,
+			      .target_boundary_2=plan->target_2,
 			      .ntarget=nt,
 			      .input_missing_value=input_missing_value,
 			      .output_missing_value=output_missing_value,
 			      .metrics=&metrics,
-			      .aux=limits);
+			      .aux=limits,
+			      .plan=plan);
 
   // Set the qc bits if we estimated the bin boundaries
   set_estimated_bin_qc(qc_odata, invar, outvar, d, nt); 
@@ -244,6 +259,7 @@ int trans_bin_average_interface(interface_s is)
   if (index_end) free(index_end);
   if (target_start) free(target_start);
   if (target_end) free(target_end);
+  if (is.plan == NULL) trans_release_plan(&plan);
 
   // Pass our metrics back to the driver.
   for (m=0; m < NUM_METRICS ; m++) {
@@ -278,28 +294,23 @@ int trans_bin_average_interface(interface_s is)
 
 int bin_average(core_s cs) {
 
-  int i,i0,j,qco,m;
-  double u, v, w, bin;
+  int i,e,j,qco,m;
+  double w;
   double sum_array, sum_weight, max_weight;
   double sum_array2,sum_weight2,total_span,good_span;
   double *stdev, *coverage;
   double **metrics;
-
-  int sign;
+  TRANSplan *plan;
 
   // Convert core_s elements to interior elements.  AGain, if I'd written
   // this with core_s in mind I wouldn't need to do this.
   double *array = cs.input_data;
   int *qc_array = cs.input_qc;
   unsigned int qc_mask = cs.qc_mask;
-  double *index_start = cs.index_boundary_1;
-  double *index_end = cs.index_boundary_2;
   double *weights = cs.weights;
   int ni = cs.nindex;
   double *output = cs.output_data;
   int *qc_output = cs.output_qc;
-  double *target_start = cs.target_boundary_1;
-  double *target_end = cs.target_boundary_2;
   int nt = cs.ntarget;
   double input_missing_value = cs.input_missing_value;
   double output_missing_value = cs.output_missing_value;
@@ -336,18 +347,20 @@ int bin_average(core_s cs) {
   stdev=metrics[0];
   coverage=metrics[1];
 
-  // Monotonically increasing or decreasing.  There are cleverer ways of
-  // doing this, but this is at least clear
+  // The search for which input bins overlap which output bins, and by how
+  // much, only depends on the bin edges, so that's done once in the plan
+  // (see trans_plan.c).  If we weren't given one, make our own.
+  if ((plan = cs.plan) == NULL) {
+    plan = trans_build_plan(TRANS_PLAN_BIN_AVERAGE,
+			    cs.index_boundary_1, cs.index_boundary_2, ni,
+			    cs.target_boundary_1, cs.target_boundary_2, nt);
+    if (plan == NULL) return(-1);
+  }
 
-  // The nt==1 deals with the case where we have only one output.  Only one
-  // input should probably have some kind of error somewhere.  Or not.
-  if (index_start[0] < index_start[1] && (nt == 1 || target_start[0] < target_start[1])) {
-    sign = 1;
-  } else if (index_start[0] > index_start[1] && (nt == 1 || target_start[0] > target_start[1])) {
-    sign = -1;
-  } else {
-    ERROR(TRANS_LIB_NAME, "Target and index are not monotonically aligned");
-    return(-5);
+  if (plan->status != 0) {
+    int status=plan->status;
+    if (plan != cs.plan) trans_release_plan(&plan);
+    return(status);
   }
 
   // Set our weights=1.0 if not given
@@ -359,91 +372,22 @@ int bin_average(core_s cs) {
   }
 
   // again, i indexes our input field, j indexes the target field
-  i0=0;
   for (j=0; j<nt; j++) {
     // reinit
     sum_array=sum_weight=max_weight=0.0;
     sum_array2=sum_weight2=0.0;
     total_span=good_span=0.0;
     qc_output[j]=qco=0;
-    i=i0;  // start with previous first input bin
 
-    // run up i until we find an input bin that overlaps our target bin;
-    // this means the upper index edge is at or above the lower target edge
-    while (i < ni && sign*index_end[i] < sign*target_start[j]) { i++;}
-
-    // Some idiot checking on i goes here
-
-    // So now we know that input bin i has an end greater than the start of
-    // output bin j.  Which is good - they (might) overlap.
-
-    // Save this as i0 to start the next iteration from; this will allow
-    // rolling averages and overlapping output bins, as long as the
-    // target_start[j] are monotonically increasing (and, possibly, equal)
-    i0=i;
-
-    // Alright, so now we continue to run up i until the lower index edge
-    // is at or above the upper target edge - this time, however, we also
-    // start doing the average
-    while (i < ni && sign*index_start[i] < sign*target_end[j]) {
-
-      // Idiot check our input binning - we know our start is before the
-      // end, now we need to know if our input end is after the target
-      // start as well.  
-
-      // Note that this is a rejection test, so the < means it passes if
-      // the end >= target start, which is what we want.
-      if (sign*index_end[i] < sign*target_start[j]) {
-	// This is a weird situation, probably involving oddly shaped input
-	// bins, so let's leave a log message just in case it's not expected.
-	LOG(TRANS_LIB_NAME,
-	    "Input bin %d [%f,%f] does not overlap output bin %d [%f,%f]; skipping...",
-	    i, index_start[i], index_end[i], j, target_start[j], target_end[j]);
-	i++;
-	continue;
-      }
-
-      // need to check the qc of each bin i; if any of them fail, set
-      // qcval=1 and don't use them in the average.  If we miss to many,
-      // we'll hcange qcval=2 later on
-      // ignore qc_array for now - we are revising the whole thing
-	
-      // Now we'll use the weights given on input, with u and v the
-      // fraction of an input bin that's outside our output bin.
-      //w=1.0;
-      w=1.0;
- 
-      // This is tricky for monotonic decreasing, but I think the negatives
-      // all cancel out correctly.  Even though negative bin size is weird.
-      bin=index_end[i]-index_start[i];
-
-      // Need to trap out zero bin widths - in that case, keep w = 1, and
-      // our fractional bin coverages are zero as well.
-      if (bin == 0.0) {  
-	u=v=0;
-      } else {
-	if ((u=(target_start[j]-index_start[i])/bin) > 0) w-=u;
-	if ((v=(index_end[i]-target_end[j])/bin) > 0) w-=v;
-      }
-
-      // These are weird circumstances if any of these happen, but I want to be
-      // sure we don't use negative weights or whatever.
-
-      if (u>1.0 || v>1.0 || u+v>1.0 || w < 0.0) {
-	ERROR(TRANS_LIB_NAME,
-	      "Problem with bin average: input bin %d [%f,%f], output bin %d [%f,%f]",
-		 i, index_start[i], index_end[i], j, target_start[j], target_end[j]);
-	return(-1);
-      }
+    // Run over the input bins that overlap our output bin; w is the
+    // fraction of input bin i inside the output bin
+    for (e=plan->offset[j]; e<plan->offset[j+1]; e++) {
+      i=plan->input[e];
+      w=plan->frac[e];
 
       // Before we trap out bad points, use the above w to calculate our
       // total input span, for determining coverage
-      if (fabs(bin) > 0) { 
-	//total_span += w*sign*(index_end[i]-index_start[i]);
-	total_span += w*sign*bin;
-      } else {
-	total_span += 1;
-      }
+      total_span += plan->span[e];
 
       // Set our maximum input weight down here, so we can make sure we are
       // using an overlapping bin (i.e. w>0).  If max_weight > 0 but 
@@ -456,39 +400,12 @@ int bin_average(core_s cs) {
       if (w>0 &&
 	  (array[i] == input_missing_value || (qc_array[i] & qc_mask) || ! isfinite(array[i]))) {
 	qc_set(qc_output[j], QC_SOME_BAD_INPUTS);
-	i++;
 	continue;
-#ifdef notdef
-      } else if (qc_array[i] != 0) {
-	if (fabs(bin) > 0) { 
-	  //yellow_span += w*sign*(index_end[i]-index_start[i]);
-	  yellow_span += w*sign*bin;
-	} else {
-	  yellow_span += 1;
-	}
-#endif
       } else {
 	// We are going to use this point, so add it to our good_span.
-	if (fabs(bin) > 0) {
-	  good_span += w*sign*bin;
-	} else {
-	  good_span += 1;
-	}
+	good_span += plan->span[e];
       }
 
-
-#ifdef notdef	
-      // Don't think this is right - we want to figure out the fraction of
-      // input bin that is within the output bin boundaries - it's hard to
-      // do this generically, because we might have larger input bins than
-      // output bins, or two huge input bins that are nevertheless
-      // straddled by the output bin.  Weird.
-
-      // DEFINITELY NOT RIGHT!
-      //if ((u=(target_end[j]-index_end[i])/bin) < 1) w=u;
-      // if ((v=(index_start[i]-target_start[j])/bin) < 1) w=v;
-#endif
-	
       // now mult by the actual weight of this bin
       w *= weights[i];
 	
@@ -503,15 +420,11 @@ int bin_average(core_s cs) {
       if (w > 0) {
 	qco |= qc_array[i];
       }
-	
-      // Finally, don't forget to increment
-      i++;
-
     }
 
 
     // So our average value is what it is
-    if (max_weight==0 && i > i0) {
+    if (max_weight==0 && plan->nscan[j] > 0) {
       // This means that (a) we had one or more overlapping points and (b)
       // all the weights were zero.  In this case we prescribe an output
       // value of zero.
@@ -519,7 +432,7 @@ int bin_average(core_s cs) {
       stdev[j]=0;
       coverage[j]=0;
       qc_set(qc_output[j], QC_ZERO_WEIGHT);
-    } else if (i == i0) {
+    } else if (plan->nscan[j] == 0) {
       // This means that none of our inputs overlapped our output bin;
       // either the dimensions are wonky or the data is missing (NOT bad,
       // but actually missing).  Most likely this will happen when we have
@@ -608,6 +521,9 @@ int bin_average(core_s cs) {
     }
   } // output samples: j
 
+  if (weights != cs.weights) free(weights);
+  if (plan != cs.plan) trans_release_plan(&plan);
+
   return(0);
 }
 
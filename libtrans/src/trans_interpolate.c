@@ -35,8 +35,6 @@
 # include "cds3.h"
 # include "trans.h"
 
-static size_t _one=1;
-
 /* We'll be doing a lot of dynamic allocation, so let's make it easier */
 # define CALLOC(n,t)  (t*)calloc(n, sizeof(t))
 # define REALLOC(p,n,t)  (t*) realloc((char *) p, (n)*sizeof(t));
@@ -63,6 +61,8 @@ int trans_interpolate_interface(interface_s is)
   CDSVar *incoord, *outcoord;
   double **metrics=NULL;
   TRANSmetric *met1d;
+  TRANSplan *plan=NULL;
+  double *index_mid=NULL, *target_mid=NULL;
 
   // Assign from interface struct - if I had written it this way to begin
   // with I would just is the is elements, but I didn't.
@@ -89,52 +89,67 @@ int trans_interpolate_interface(interface_s is)
   allocate_metric(met,metnames, metunits, NUM_METRICS, nt);
   met1d = (*met);
 
-  // These mostly work straight up because coord vars are always 1D, so we
-  // don't have to worry about indexing or casting correctly
-  incoord = cds_get_coord_var(invar, d);
-  index=(double *) cds_copy_array(incoord->type, ni,
-				  incoord->data.vp,
-				  CDS_DOUBLE, NULL,
-				  0, NULL, NULL, NULL, NULL, NULL, NULL); 
-
-  outcoord = cds_get_coord_var(outvar, d);
-  target=(double *) cds_copy_array(outcoord->type, nt,
-				  outcoord->data.vp,
-				  CDS_DOUBLE, NULL,
-				   0, NULL, NULL, NULL, NULL, NULL, NULL); 
+  // If the driver already has a plan for this dimension, we know the
+  // midpoints already; otherwise we have to work them out.
+  if (is.plan && *is.plan) {
+    plan=*is.plan;
+  } else {
+    // These mostly work straight up because coord vars are always 1D, so we
+    // don't have to worry about indexing or casting correctly
+    incoord = cds_get_coord_var(invar, d);
+    index=(double *) cds_copy_array(incoord->type, ni,
+				    incoord->data.vp,
+				    CDS_DOUBLE, NULL,
+				    0, NULL, NULL, NULL, NULL, NULL, NULL); 
+
+    outcoord = cds_get_coord_var(outvar, d);
+    target=(double *) cds_copy_array(outcoord->type, nt,
+				     outcoord->data.vp,
+				     CDS_DOUBLE, NULL,
+				     0, NULL, NULL, NULL, NULL, NULL, NULL); 
+  }
 
   // Here's our lookup parameters
   if ((cds_get_transform_param_by_dim(invar, invar->dims[d],
 				      "range", CDS_DOUBLE,
-				      &_one, &range) == NULL) &&
+				      &(size_t){1}, &range) == NULL) &&
       (cds_get_transform_param_by_dim(outvar, outvar->dims[d],
 				     "range", CDS_DOUBLE,
-				      &_one, &range) == NULL)) {
+				      &(size_t){1}, &range) == NULL)) {
     range=CDS_MAX_DOUBLE;
   }
 
   // Override var missing values with transform params
   if (cds_get_transform_param_by_dim(invar, invar->dims[d],
 				     "missing_value", CDS_DOUBLE,
-				     &_one, &missing_value) != NULL) {
+				     &(size_t){1}, &missing_value) != NULL) {
     input_missing_value=missing_value;
   }
 
   if (cds_get_transform_param_by_dim(outvar, outvar->dims[d],
 				     "missing_value", CDS_DOUBLE,
-				     &_one, &missing_value) != NULL) {
+				     &(size_t){1}, &missing_value) != NULL) {
     output_missing_value=missing_value;
   }
 
   if (cds_get_transform_param_by_dim(invar, invar->dims[d],
 				     "qc_mask", CDS_INT,
-				     &_one, &qc_mask) == NULL) {
+				     &(size_t){1}, &qc_mask) == NULL) {
     qc_mask=get_qc_mask(invar);
   }
 
-  // Translate our grid to midpoints for the interpolation.  
-  double *index_mid = get_bin_midpoints(index, ni, invar, d);
-  double *target_mid = get_bin_midpoints(target, nt, outvar, d);
+  if (plan == NULL) {
+    // Translate our grid to midpoints for the interpolation.  
+    index_mid = get_bin_midpoints(index, ni, invar, d);
+    target_mid = get_bin_midpoints(target, nt, outvar, d);
+
+    // Every var on this grid will need the same plan, so get it from the
+    // cache, and hand it to the driver to use for the rest of the slices
+    plan = trans_get_plan(TRANS_PLAN_INTERPOLATE, index_mid, NULL, ni,
+			  target_mid, NULL, nt);
+    if (plan == NULL) return(-1);
+    if (is.plan) *is.plan=plan;
+  }
 
   // Now just call our core function
   //status=bilinear_interpolate(data, qc_data, qc_mask, index_mid, ni, range,
@@ -145,16 +160,17 @@ int trans_interpolate_interface(interface_s is)
 			    .input_data=data,
 			    .input_qc=qc_data,
 			    .qc_mask=qc_mask,
-			    .index=index_mid,
+			    .index=plan->index_1,
 			    .nindex=ni,
 			    .range=range,
 			    .output_data=odata,
 			    .output_qc=qc_odata,
-			    .target=target_mid,
+			    .target=plan->target_1,
 			    .ntarget=nt,
 			    .input_missing_value=input_missing_value,
 			    .output_missing_value=output_missing_value,
-			    .metrics=&metrics);
+			    .metrics=&metrics,
+			    .plan=plan);
 
   // Set the qc bits if we estimated the bin boundaries
   set_estimated_bin_qc(qc_odata, invar, outvar, d, nt); 
@@ -175,6 +191,7 @@ int trans_interpolate_interface(interface_s is)
   if (target) free(target);
   if (index_mid) free(index_mid);
   if (target_mid) free(target_mid);
+  if (is.plan == NULL) trans_release_plan(&plan);
 
 
   return(status);
@@ -197,10 +214,10 @@ int trans_interpolate_interface(interface_s is)
 int bilinear_interpolate(core_s cs) {
   int i,j,k, n1, n2;
   double u, x, y1, y2, x1, x2;
-  int sign;
   int m;
   double **metrics;
   double *dist_1, *dist_2;
+  TRANSplan *plan;
 
   // Convert core_s elements to interior elements.  AGain, if I'd written
   // this with core_s in mind I wouldn't need to do this.
@@ -245,24 +262,26 @@ int bilinear_interpolate(core_s cs) {
   dist_1=metrics[0];
   dist_2=metrics[1];
 
-  // First, find whether we are monotonically increasing or decreasing;
-  // this is important as we scan up to find what index is in our target
-  // bin.  Take advantage of the fact that "a < b" is the same as "-a >
-  // -b". 
-  if (index[0] < index[1] && target[0] < target[1]) {
-    sign = 1;
-  } else if (index[0] > index[1] && target[0] > target[1]) {
-    sign = -1;
-  } else {
-    ERROR(TRANS_LIB_NAME, "Target and index are not monotonically aligned");
-    return(-5);
+  // Whether we are monotonically increasing or decreasing, and where each
+  // target falls in the index field, only depends on the grids, so that's
+  // worked out once in the plan (see trans_plan.c).  If we weren't given
+  // one, make our own.
+  if ((plan = cs.plan) == NULL) {
+    plan = trans_build_plan(TRANS_PLAN_INTERPOLATE, index, NULL, ni,
+			    target, NULL, nt);
+    if (plan == NULL) return(-1);
+  }
+
+  if (plan->status != 0) {
+    k=plan->status;
+    if (plan != cs.plan) trans_release_plan(&plan);
+    return(k);
   }
 
   // Now just run up the flag pole, interpolating as we go.  I don't know
   // what to do about edge effects yet.  i goes up the input index field, j
   // goes up the target field.
 
-  i=0;
   for (j=0; j<nt; j++) {
 
     // we will modify this as conditions warrant
@@ -272,9 +291,9 @@ int bilinear_interpolate(core_s cs) {
     // just silly.
     // ACtually, we are going to be fuzzy about this - extrapolate no more
     // than half an input bin beyond our input range.  This will allow us
-    // to extrapolate from 318m to 316m, for example.
-    if (sign*target[j] < sign*(index[0]-((index[1]-index[0])/2.0)) ||
-	sign*target[j] > sign*(index[ni-1]+((index[ni-1]-index[ni-2])/2.0))) {
+    // to extrapolate from 318m to 316m, for example.  The plan marks
+    // these with a -1.
+    if (plan->start[j] < 0) {
       output[j]=output_missing_value; // we used to set it to 0, but that was
 			       // RIPBE specific
       dist_1[j]=dist_2[j]=output_missing_value;
@@ -283,10 +302,8 @@ int bilinear_interpolate(core_s cs) {
       continue;
     }
 
-    // run up until we find the next index that's just above this target
-    // Note that this requires target values that are monotonically
-    // increasing. 
-    while (i < ni && sign*index[i] < sign*target[j]) { i++;}
+    // the next index that's just above this target
+    i=plan->start[j];
 
     // This shortcircuits all the bracketting nonsense below for the case
     // where our coordinate target matches our coordinate index exactly.
@@ -370,6 +387,7 @@ int bilinear_interpolate(core_s cs) {
 	qc_set(qc_output[k], QC_ALL_BAD_INPUTS);
 	qc_set(qc_output[k], QC_BAD);
       }
+      if (plan != cs.plan) trans_release_plan(&plan);
       return(2);
     }
 
@@ -402,6 +420,7 @@ int bilinear_interpolate(core_s cs) {
 	qc_set(qc_output[k], QC_ALL_BAD_INPUTS);
 	qc_set(qc_output[k], QC_BAD);
       }
+      if (plan != cs.plan) trans_release_plan(&plan);
       return(2);
     }
 
@@ -458,6 +477,8 @@ int bilinear_interpolate(core_s cs) {
     }
 
   }
+
+  if (plan != cs.plan) trans_release_plan(&plan);
   return(0);
 }
     
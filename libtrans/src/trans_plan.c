@@ -0,0 +1,366 @@
+/*******************************************************************************
+*
+*  Your copyright notice
+*
+********************************************************************************
+*
+*  Author:
+*     name:  Tim Shippert
+*     phone: 5093755997
+*     email: tim.shippert@pnl.gov
+*
+********************************************************************************
+*
+*  REPOSITORY INFORMATION:
+*    $Revision$
+*    $Author$
+*    $Date$
+*    $State: $
+*
+********************************************************************************
+*
+*  NOTE: DOXYGEN is used to generate documentation for this file.
+*
+*******************************************************************************/
+
+/** @file trans_plan.c
+ *  Precomputed grid plans for the bin average and interpolate transforms
+ */
+# include <stdio.h>
+# include <stdlib.h>
+# include <math.h>
+# include <string.h>
+# include <pthread.h>
+# include <cds3.h>
+# include "trans.h"
+
+/* We'll be doing a lot of dynamic allocation, so let's make it easier */
+# define CALLOC(n,t)  (t*)calloc(n, sizeof(t))
+
+// How many plans we keep around.  A VAP usually only has a handful of
+// distinct grids per dimension, so this doesn't need to be big.
+# define TRANS_PLAN_CACHE_SIZE 32
+
+static TRANSplan *plan_cache[TRANS_PLAN_CACHE_SIZE];
+static int plan_cache_next=0;
+static pthread_mutex_t plan_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Copy a grid array, so the plan doesn't depend on anybody else's memory
+static double *copy_grid(double *grid, int n) {
+  double *copy;
+
+  if (grid == NULL) return(NULL);
+
+  copy=CALLOC(n, double);
+  if (copy) memcpy(copy, grid, n*sizeof(double));
+  return(copy);
+}
+
+// Does this grid match the one in a plan?  Both NULL counts as a match.
+static int same_grid(double *grid, double *plan_grid, int n) {
+  if (grid == NULL || plan_grid == NULL) return(grid == plan_grid);
+  return(memcmp(grid, plan_grid, n*sizeof(double)) == 0);
+}
+
+static void free_plan(TRANSplan *plan) {
+  if (plan->index_1) free(plan->index_1);
+  if (plan->index_2) free(plan->index_2);
+  if (plan->target_1) free(plan->target_1);
+  if (plan->target_2) free(plan->target_2);
+  if (plan->offset) free(plan->offset);
+  if (plan->nscan) free(plan->nscan);
+  if (plan->input) free(plan->input);
+  if (plan->frac) free(plan->frac);
+  if (plan->span) free(plan->span);
+  if (plan->start) free(plan->start);
+  free(plan);
+}
+
+// Work out the overlapping input bins and fractional weights for every
+// output bin.  This is the search that bin_average() used to do for every
+// call; see there for the gory details.
+static void build_bin_average_plan(TRANSplan *plan) {
+  int i, i0, j, n, nalloc;
+  double u, v, w, bin;
+  double *index_start=plan->index_1, *index_end=plan->index_2;
+  double *target_start=plan->target_1, *target_end=plan->target_2;
+  int ni=plan->ni, nt=plan->nt;
+  int sign;
+
+  // Monotonically increasing or decreasing.  The nt==1 deals with the case
+  // where we have only one output.
+  if (index_start[0] < index_start[1] && (nt == 1 || target_start[0] < target_start[1])) {
+    sign = 1;
+  } else if (index_start[0] > index_start[1] && (nt == 1 || target_start[0] > target_start[1])) {
+    sign = -1;
+  } else {
+    ERROR(TRANS_LIB_NAME, "Target and index are not monotonically aligned");
+    plan->status=-5;
+    return;
+  }
+  plan->sign=sign;
+
+  plan->offset=CALLOC(nt+1, int);
+  plan->nscan=CALLOC(nt, int);
+
+  // Most output bins overlap a bin or two beyond their share of the
+  // inputs, so start there and grow as needed
+  nalloc=ni+2*nt;
+  plan->input=CALLOC(nalloc, int);
+  plan->frac=CALLOC(nalloc, double);
+  plan->span=CALLOC(nalloc, double);
+
+  if (!plan->offset || !plan->nscan ||
+      !plan->input || !plan->frac || !plan->span) {
+    ERROR(TRANS_LIB_NAME, "Memory allocation error building bin average plan");
+    plan->status=-1;
+    return;
+  }
+
+  n=0;
+  i0=0;
+  for (j=0; j<nt; j++) {
+    plan->offset[j]=n;
+    i=i0;  // start with previous first input bin
+
+    // run up i until we find an input bin that overlaps our target bin
+    while (i < ni && sign*index_end[i] < sign*target_start[j]) { i++;}
+    i0=i;
+
+    // and keep going until the lower index edge is at or above the upper
+    // target edge, saving the overlapping bins as we go
+    while (i < ni && sign*index_start[i] < sign*target_end[j]) {
+
+      if (sign*index_end[i] < sign*target_start[j]) {
+	LOG(TRANS_LIB_NAME,
+	    "Input bin %d [%f,%f] does not overlap output bin %d [%f,%f]; skipping...",
+	    i, index_start[i], index_end[i], j, target_start[j], target_end[j]);
+	i++;
+	continue;
+      }
+
+      // u and v are the fractions of the input bin outside our output bin
+      w=1.0;
+      bin=index_end[i]-index_start[i];
+
+      if (bin == 0.0) {
+	u=v=0;
+      } else {
+	if ((u=(target_start[j]-index_start[i])/bin) > 0) w-=u;
+	if ((v=(index_end[i]-target_end[j])/bin) > 0) w-=v;
+      }
+
+      if (u>1.0 || v>1.0 || u+v>1.0 || w < 0.0) {
+	ERROR(TRANS_LIB_NAME,
+	      "Problem with bin average: input bin %d [%f,%f], output bin %d [%f,%f]",
+		 i, index_start[i], index_end[i], j, target_start[j], target_end[j]);
+	plan->status=-1;
+	return;
+      }
+
+      if (n == nalloc) {
+	int *new_input;
+	double *new_frac, *new_span;
+
+	nalloc*=2;
+
+	// Keep each old buffer in the plan until its realloc succeeds, so
+	// free_plan() still releases everything on failure
+	if ((new_input=(int *) realloc(plan->input, nalloc*sizeof(int))))
+	  plan->input=new_input;
+	if ((new_frac=(double *) realloc(plan->frac, nalloc*sizeof(double))))
+	  plan->frac=new_frac;
+	if ((new_span=(double *) realloc(plan->span, nalloc*sizeof(double))))
+	  plan->span=new_span;
+
+	if (!new_input || !new_frac || !new_span) {
+	  ERROR(TRANS_LIB_NAME, "Memory allocation error building bin average plan");
+	  plan->status=-1;
+	  return;
+	}
+      }
+
+      plan->input[n]=i;
+      plan->frac[n]=w;
+      plan->span[n]=(fabs(bin) > 0) ? w*sign*bin : 1;
+      n++;
+      i++;
+    }
+
+    plan->nscan[j]=i-i0;
+  }
+  plan->offset[nt]=n;
+}
+
+// Work out where the search for the bracketing points starts for every
+// output point, as in bilinear_interpolate().
+static void build_interpolate_plan(TRANSplan *plan) {
+  int i, j;
+  double *index=plan->index_1, *target=plan->target_1;
+  int ni=plan->ni, nt=plan->nt;
+  int sign;
+
+  if (index[0] < index[1] && target[0] < target[1]) {
+    sign = 1;
+  } else if (index[0] > index[1] && target[0] > target[1]) {
+    sign = -1;
+  } else {
+    ERROR(TRANS_LIB_NAME, "Target and index are not monotonically aligned");
+    plan->status=-5;
+    return;
+  }
+  plan->sign=sign;
+
+  plan->start=CALLOC(nt, int);
+
+  if (!plan->start) {
+    ERROR(TRANS_LIB_NAME, "Memory allocation error building interpolation plan");
+    plan->status=-1;
+    return;
+  }
+
+  i=0;
+  for (j=0; j<nt; j++) {
+    // Don't extrapolate more than half an input bin beyond the input grid
+    if (sign*target[j] < sign*(index[0]-((index[1]-index[0])/2.0)) ||
+	sign*target[j] > sign*(index[ni-1]+((index[ni-1]-index[ni-2])/2.0))) {
+      plan->start[j]=-1;
+      continue;
+    }
+
+    // run up until we find the next index that's just above this target
+    while (i < ni && sign*index[i] < sign*target[j]) { i++;}
+    plan->start[j]=i;
+  }
+}
+
+/**
+*  Build a plan for the given grids.  The grids are copied into the plan.
+*
+*  @param  type - TRANS_PLAN_BIN_AVERAGE or TRANS_PLAN_INTERPOLATE
+*  @param  index_1, index_2 - input bin front and back edges for bin
+*            averages, or input midpoints and NULL for interpolation
+*  @param  ni - number of input points
+*  @param  target_1, target_2 - same, for the output grid
+*  @param  nt - number of output points
+*
+*  @return
+*    - pointer to the new plan, with a reference count of 1; check
+*      plan->status for errors in the grids
+*    - NULL if we couldn't allocate it
+*/
+TRANSplan *trans_build_plan(int type, double *index_1, double *index_2, int ni,
+			    double *target_1, double *target_2, int nt) {
+  TRANSplan *plan=CALLOC(1, TRANSplan);
+
+  if (plan == NULL) {
+    ERROR(TRANS_LIB_NAME, "Cannot allocate transform plan\n");
+    return(NULL);
+  }
+
+  plan->type=type;
+  plan->ni=ni;
+  plan->nt=nt;
+  plan->refcount=1;
+
+  plan->index_1=copy_grid(index_1, ni);
+  plan->index_2=copy_grid(index_2, ni);
+  plan->target_1=copy_grid(target_1, nt);
+  plan->target_2=copy_grid(target_2, nt);
+
+  if ((index_1 && !plan->index_1) || (index_2 && !plan->index_2) ||
+      (target_1 && !plan->target_1) || (target_2 && !plan->target_2)) {
+    ERROR(TRANS_LIB_NAME, "Memory allocation error copying transform grids");
+    plan->status=-1;
+  } else if (type == TRANS_PLAN_BIN_AVERAGE) {
+    build_bin_average_plan(plan);
+  } else {
+    build_interpolate_plan(plan);
+  }
+
+  return(plan);
+}
+
+/**
+*  Get a plan for the given grids, from the cache if we've already built
+*  one for exactly the same grids.  Arguments are as for
+*  trans_build_plan().  This is safe to call from multiple threads.
+*
+*  @return
+*    - pointer to the plan; release it with trans_release_plan()
+*    - NULL if we couldn't allocate it
+*/
+TRANSplan *trans_get_plan(int type, double *index_1, double *index_2, int ni,
+			  double *target_1, double *target_2, int nt) {
+  TRANSplan *plan;
+  int c;
+
+  pthread_mutex_lock(&plan_cache_mutex);
+
+  for (c=0;c<TRANS_PLAN_CACHE_SIZE;c++) {
+    plan=plan_cache[c];
+    if (plan && plan->type == type && plan->ni == ni && plan->nt == nt &&
+	same_grid(index_1, plan->index_1, ni) &&
+	same_grid(index_2, plan->index_2, ni) &&
+	same_grid(target_1, plan->target_1, nt) &&
+	same_grid(target_2, plan->target_2, nt)) {
+      plan->refcount++;
+      pthread_mutex_unlock(&plan_cache_mutex);
+      return(plan);
+    }
+  }
+
+  // Not there, so build it and bump out the oldest one.  Don't cache a
+  // plan that ran out of memory, so the next call gets to try again.
+  plan=trans_build_plan(type, index_1, index_2, ni, target_1, target_2, nt);
+
+  if (plan && plan->status != -1) {
+    c=plan_cache_next;
+    plan_cache_next=(plan_cache_next+1) % TRANS_PLAN_CACHE_SIZE;
+
+    if (plan_cache[c] && --(plan_cache[c]->refcount) == 0) {
+      free_plan(plan_cache[c]);
+    }
+
+    plan->refcount++;  // one for the cache, one for the caller
+    plan_cache[c]=plan;
+  }
+
+  pthread_mutex_unlock(&plan_cache_mutex);
+  return(plan);
+}
+
+/**
+*  Release a plan from trans_build_plan() or trans_get_plan(), and set the
+*  pointer to NULL.
+*
+*  @param  plan - pointer to the plan pointer
+*/
+void trans_release_plan(TRANSplan **plan) {
+  if (plan == NULL || *plan == NULL) return;
+
+  pthread_mutex_lock(&plan_cache_mutex);
+  if (--((*plan)->refcount) == 0) {
+    free_plan(*plan);
+  }
+  pthread_mutex_unlock(&plan_cache_mutex);
+
+  *plan=NULL;
+}
+
+/**
+*  Empty the plan cache.  Plans still in use are freed when released.
+*/
+void trans_free_plan_cache(void) {
+  int c;
+
+  pthread_mutex_lock(&plan_cache_mutex);
+  for (c=0;c<TRANS_PLAN_CACHE_SIZE;c++) {
+    if (plan_cache[c] && --(plan_cache[c]->refcount) == 0) {
+      free_plan(plan_cache[c]);
+    }
+    plan_cache[c]=NULL;
+  }
+  plan_cache_next=0;
+  pthread_mutex_unlock(&plan_cache_mutex);
+}
@@ -35,8 +35,6 @@
 # include <cds3.h>
 # include "trans.h"
 
-static size_t _one=1;
-
 /* We'll be doing a lot of dynamic allocation, so let's make it easier */
 # define CALLOC(n,t)  (t*)calloc(n, sizeof(t))
 # define REALLOC(p,n,t)  (t*) realloc((char *) p, (n)*sizeof(t));
@@ -118,13 +116,13 @@ int trans_quadrature_interface
   // The easy lookups
   if (cds_get_transform_param_by_dim(invar, invar->dims[d],
 				     "missing_value", CDS_DOUBLE,
-				     &_one, &missing_value) == NULL) {
+				     &(size_t){1}, &missing_value) == NULL) {
     missing_value=-9999.;
   }
 
   if (cds_get_transform_param_by_dim(invar, invar->dims[d],
 				     "qc_mask", CDS_INT,
-				     &_one, &qc_mask) == NULL) {
+				     &(size_t){1}, &qc_mask) == NULL) {
     qc_mask=get_qc_mask(invar);
     // I should now set the transform param so we don't have to calculate
     // it again.  Hmm.
@@ -35,8 +35,6 @@
 # include <cds3.h>
 # include "trans.h"
 
-static size_t _one=1;
-
 /* We'll be doing a lot of dynamic allocation, so let's make it easier */
 # define CALLOC(n,t)  (t*)calloc(n, sizeof(t))
 # define REALLOC(p,n,t)  (t*) realloc((char *) p, (n)*sizeof(t));
@@ -104,28 +102,28 @@ int trans_subsample_interface(interface_s is)
   // Here's our lookup parameters
   if ((cds_get_transform_param_by_dim(invar, invar->dims[d],
 				      "range", CDS_DOUBLE,
-				      &_one, &range) == NULL) &&
+				      &(size_t){1}, &range) == NULL) &&
       (cds_get_transform_param_by_dim(outvar, outvar->dims[d],
 				     "range", CDS_DOUBLE,
-				      &_one, &range) == NULL)) {
+				      &(size_t){1}, &range) == NULL)) {
     range=CDS_MAX_DOUBLE;
   }
 
   if (cds_get_transform_param_by_dim(invar, invar->dims[d],
 				     "missing_value", CDS_DOUBLE,
-				     &_one, &missing_value) != NULL) {
+				     &(size_t){1}, &missing_value) != NULL) {
     input_missing_value=missing_value;
   }
 
   if (cds_get_transform_param_by_dim(outvar, invar->dims[d],
 				     "missing_value", CDS_DOUBLE,
-				     &_one, &missing_value) != NULL) {
+				     &(size_t){1}, &missing_value) != NULL) {
     output_missing_value=missing_value;
   }
 
   if (cds_get_transform_param_by_dim(invar, invar->dims[d],
 				     "qc_mask", CDS_INT,
-				     &_one, &qc_mask) == NULL) {
+				     &(size_t){1}, &qc_mask) == NULL) {
     qc_mask=get_qc_mask(invar);
   }
 
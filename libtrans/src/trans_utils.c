@@ -4,11 +4,15 @@
 # include <time.h>
 # include <getopt.h>
 # include <regex.h>
+# include <pthread.h>
 # include "cds3.h"
 # include "trans.h"
 # include "netcdf.h"
 
-static size_t _one=1;
+// Guards the estimated_boundaries user data flags.  These are set and read
+// from cds_transform_compute(), which can be running in several threads at
+// once, and two transforms can share the same input variable.
+static pthread_mutex_t estimated_bin_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 # define CALLOC(n,t)  (t*)calloc(n, sizeof(t))
 
@@ -269,7 +273,7 @@ int get_bin_edges(double **front_edge, double **back_edge, double *index,
   // value of 0.5 to indicate we assume we are in the middle of the bin
   if (cds_get_transform_param_by_dim(var, var->dims[d],
 				     "alignment", CDS_DOUBLE,
-				     &_one, &alignment) == NULL) {
+				     &(size_t){1}, &alignment) == NULL) {
     alignment = 0.5;
   }
 
@@ -324,7 +328,9 @@ int get_bin_edges(double **front_edge, double **back_edge, double *index,
   // Set a user tag so we know we had to fake the bin information
   char key[30];
   sprintf(key,"estimated_boundaries_%d",d);
+  pthread_mutex_lock(&estimated_bin_mutex);
   cds_set_user_data(var, key,"true",NULL);
+  pthread_mutex_unlock(&estimated_bin_mutex);
 
   // Return a different status to indicate we had to guess our bin edges
   return(1);
@@ -368,6 +374,8 @@ int set_estimated_bin_qc(int *qc_odata, CDSVar *invar, CDSVar *outvar, int d, in
 
   sprintf(key,"estimated_boundaries_%d",d);
 
+  pthread_mutex_lock(&estimated_bin_mutex);
+
   if ((val=cds_get_user_data(invar, key)) &&
       (strcmp(val,"true")==0)) {
     qc_set(qc_bin,QC_ESTIMATED_INPUT_BIN);
@@ -378,6 +386,8 @@ int set_estimated_bin_qc(int *qc_odata, CDSVar *invar, CDSVar *outvar, int d, in
     qc_set(qc_bin,QC_ESTIMATED_OUTPUT_BIN);
   }
 
+  pthread_mutex_unlock(&estimated_bin_mutex);
+
   if (qc_bin) {
     for (i=0;i<nt;i++) {
       qc_odata[i] |= qc_bin;